@@ -0,0 +1,120 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of the convergence of the auto_scheduler on the tasks of the tutorials.
+
+Each task is tuned with and without the crossover of the evolutionary search,
+and the best latency found so far is printed against the number of trials.
+
+.. code-block:: bash
+
+  python3 auto_scheduler_convergence_bench.py --trials 512
+  python3 auto_scheduler_convergence_bench.py --target cuda --trials 512
+"""
+import argparse
+import os
+import tempfile
+
+import numpy as np
+
+import tvm
+from tvm import auto_scheduler, te, topi
+
+
+@auto_scheduler.register_workload
+def matmul_add(N, L, M, dtype):
+    A = te.placeholder((N, L), name="A", dtype=dtype)
+    B = te.placeholder((L, M), name="B", dtype=dtype)
+    C = te.placeholder((N, M), name="C", dtype=dtype)
+    k = te.reduce_axis((0, L), name="k")
+    matmul = te.compute((N, M), lambda i, j: te.sum(A[i, k] * B[k, j], axis=k), name="matmul")
+    out = te.compute((N, M), lambda i, j: matmul[i, j] + C[i, j], name="out")
+    return [A, B, C, out]
+
+
+@auto_scheduler.register_workload
+def conv2d_layer(N, H, W, CO, CI, KH, KW, stride, padding):
+    data = te.placeholder((N, CI, H, W), name="data")
+    kernel = te.placeholder((CO, CI, KH, KW), name="kernel")
+    bias = te.placeholder((1, CO, 1, 1), name="bias")
+    conv = topi.nn.conv2d_nchw(data, kernel, stride, padding, dilation=1, out_dtype="float32")
+    out = topi.nn.relu(conv + bias)
+    return [data, kernel, bias, out]
+
+
+TASKS = {
+    "matmul_add": (matmul_add, (1024, 1024, 1024, "float32")),
+    "conv2d": (conv2d_layer, (1, 7, 7, 512, 512, 3, 3, (1, 1), (1, 1))),
+}
+
+
+def best_latency_curve(log_file, checkpoints):
+    """Get the best latency in ms found within each number of trials."""
+    costs = []
+    for _, res in auto_scheduler.load_records(log_file):
+        if res.error_no == 0:
+            costs.append(np.mean([v.value for v in res.costs]) * 1e3)
+        else:
+            costs.append(float("inf"))
+    best = np.minimum.accumulate(costs)
+    return [best[min(n, len(best)) - 1] for n in checkpoints]
+
+
+def tune(name, target, trials, crossover_ratio, log_file):
+    func, args = TASKS[name]
+    task = auto_scheduler.SearchTask(func=func, args=args, target=tvm.target.Target(target))
+    params = auto_scheduler.SketchPolicy.DEFAULT_PARAMS.copy()
+    params["evolutionary_search_crossover_ratio"] = crossover_ratio
+    policy = auto_scheduler.SketchPolicy(
+        task, program_cost_model=auto_scheduler.XGBModel(), params=params, verbose=0
+    )
+    measure_ctx = None
+    if target == "cuda":
+        measure_ctx = auto_scheduler.LocalRPCMeasureContext(min_repeat_ms=300)
+        runner = measure_ctx.runner
+    else:
+        runner = auto_scheduler.LocalRunner(repeat=3, min_repeat_ms=100)
+    tune_option = auto_scheduler.TuningOptions(
+        num_measure_trials=trials,
+        runner=runner,
+        measure_callbacks=[auto_scheduler.RecordToFile(log_file)],
+        verbose=0,
+    )
+    task.tune(tune_option, search_policy=policy)
+    del measure_ctx
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--target", type=str, default="llvm")
+    parser.add_argument("--trials", type=int, default=512)
+    parser.add_argument("--tasks", type=str, default=",".join(TASKS))
+    parser.add_argument("--crossover-ratio", type=float, default=0.05)
+    args = parser.parse_args()
+
+    step = max(args.trials // 8, 1)
+    checkpoints = list(range(step, args.trials + 1, step))
+    tmpdir = tempfile.mkdtemp()
+    for name in args.tasks.split(","):
+        print("Task %s, best latency (ms) vs trials" % name)
+        print("%-12s" % "Crossover" + "".join("%10d" % n for n in checkpoints))
+        for ratio in [0.0, args.crossover_ratio]:
+            log_file = os.path.join(tmpdir, "%s_%g.json" % (name, ratio))
+            tune(name, args.target, args.trials, ratio, log_file)
+            curve = best_latency_curve(log_file, checkpoints)
+            print("%-12g" % ratio + "".join("%10.3f" % v for v in curve))
+            os.remove(log_file)
+    os.rmdir(tmpdir)
@@ -0,0 +1,115 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of the auto_scheduler feature extraction on a conv2d task.
+
+It extracts the features of a sampled population, then the ones of several
+generations of the evolutionary search as the search policy does, and reports
+the features of states extracted per second. Each run is in a fresh process,
+with the feature extraction caches disabled by TVM_AUTO_SCHEDULER_FEATURE_CACHE=0,
+as before the caches were added, then enabled.
+
+.. code-block:: bash
+
+  python3 auto_scheduler_feature_bench.py --population 512 --generations 4
+"""
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+import tvm
+from tvm import auto_scheduler, te, topi
+
+
+@auto_scheduler.register_workload
+def conv2d_layer(N, H, W, CO, CI, KH, KW, stride, padding):
+    data = te.placeholder((N, CI, H, W), name="data")
+    kernel = te.placeholder((CO, CI, KH, KW), name="kernel")
+    bias = te.placeholder((1, CO, 1, 1), name="bias")
+    conv = topi.nn.conv2d_nchw(data, kernel, stride, padding, dilation=1, out_dtype="float32")
+    out = topi.nn.relu(conv + bias)
+    return [data, kernel, bias, out]
+
+
+def run(target, population, generations):
+    """Print the features per second of the first and of the later extractions."""
+    # The 3x3 conv2d of the last stage of ResNet-50.
+    task = auto_scheduler.SearchTask(
+        func=conv2d_layer, args=(1, 7, 7, 512, 512, 3, 3, (1, 1), (1, 1)), target=target
+    )
+    policy = auto_scheduler.SketchPolicy(task, verbose=0)
+    states = policy.sample_initial_population()[:population]
+    generation_states = [states]
+    for _ in range(generations):
+        states = policy.evolutionary_search(states, population)
+        generation_states.append(states)
+
+    results = []
+    for states in generation_states:
+        tbegin = time.perf_counter()
+        auto_scheduler.feature.get_per_store_features_from_states(states, task)
+        results.append(len(states) / (time.perf_counter() - tbegin))
+    print("%f %f" % (results[0], sum(results[1:]) / len(results[1:])))
+
+
+def measure(cache, args):
+    env = dict(os.environ, TVM_AUTO_SCHEDULER_FEATURE_CACHE="1" if cache else "0")
+    out = subprocess.check_output(
+        [
+            sys.executable,
+            __file__,
+            "--run",
+            "--target",
+            args.target,
+            "--population",
+            str(args.population),
+            "--generations",
+            str(args.generations),
+        ],
+        env=env,
+    )
+    first, later = out.decode().split()[-2:]
+    return float(first), float(later)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--target", type=str, default="llvm")
+    parser.add_argument("--population", type=int, default=512)
+    parser.add_argument("--generations", type=int, default=4)
+    parser.add_argument("--run", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.run:
+        run(tvm.target.Target(args.target), args.population, args.generations)
+        sys.exit(0)
+
+    print("%-10s %-24s %-24s" % ("Cache", "Population (features/s)", "Generations (features/s)"))
+    results = {}
+    for cache in [False, True]:
+        results[cache] = measure(cache, args)
+        first, later = results[cache]
+        print("%-10s %-24s %-24s" % ("on" if cache else "off", "%.1f" % first, "%.1f" % later))
+    print(
+        "%-10s %-24s %-24s"
+        % (
+            "speedup",
+            "%.2fx" % (results[True][0] / results[False][0]),
+            "%.2fx" % (results[True][1] / results[False][1]),
+        )
+    )
@@ -0,0 +1,79 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of the evolutionary search of the auto_scheduler on a conv2d task.
+
+It prints the iterations of the evolutionary search per second, with the random
+cost model so that the time is spent in the search itself, and the time to
+print a state compared to the time to compute its fingerprint, which replaced
+the printed states in the redundancy checks.
+
+.. code-block:: bash
+
+  python3 auto_scheduler_search_bench.py --population 2048 --iterations 4
+"""
+import argparse
+import time
+
+import tvm
+from tvm import auto_scheduler, te, topi
+
+
+@auto_scheduler.register_workload
+def conv2d_layer(N, H, W, CO, CI, KH, KW, stride, padding):
+    data = te.placeholder((N, CI, H, W), name="data")
+    kernel = te.placeholder((CO, CI, KH, KW), name="kernel")
+    bias = te.placeholder((1, CO, 1, 1), name="bias")
+    conv = topi.nn.conv2d_nchw(data, kernel, stride, padding, dilation=1, out_dtype="float32")
+    out = topi.nn.relu(conv + bias)
+    return [data, kernel, bias, out]
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--target", type=str, default="llvm")
+    parser.add_argument("--population", type=int, default=2048)
+    parser.add_argument("--iterations", type=int, default=4)
+    args = parser.parse_args()
+
+    # The 3x3 conv2d of the last stage of ResNet-50.
+    task = auto_scheduler.SearchTask(
+        func=conv2d_layer,
+        args=(1, 7, 7, 512, 512, 3, 3, (1, 1), (1, 1)),
+        target=tvm.target.Target(args.target),
+    )
+    params = auto_scheduler.SketchPolicy.DEFAULT_PARAMS.copy()
+    params["evolutionary_search_population"] = args.population
+    params["evolutionary_search_num_iters"] = args.iterations
+    policy = auto_scheduler.SketchPolicy(task, params=params, verbose=0)
+    population = policy.sample_initial_population()
+
+    tbegin = time.perf_counter()
+    states = policy.evolutionary_search(population, args.population)
+    elapsed = time.perf_counter() - tbegin
+    print("Evolutionary search: %.2f iterations/s" % (args.iterations / elapsed))
+
+    tbegin = time.perf_counter()
+    for state in states:
+        str(state)
+    print_time = (time.perf_counter() - tbegin) / len(states)
+    tbegin = time.perf_counter()
+    for state in states:
+        state.fingerprint()
+    fingerprint_time = (time.perf_counter() - tbegin) / len(states)
+    print(
+        "Per state: print %.1f us, fingerprint %.1f us" % (print_time * 1e6, fingerprint_time * 1e6)
+    )
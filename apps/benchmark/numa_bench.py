@@ -0,0 +1,142 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Memory bandwidth benchmark of the NUMA thread pool mode on Linux.
+
+It first reports the copy bandwidth of every (memory node, worker node) pair,
+then compares the whole machine with the default big-core affinity and with
+the NUMA affinity (config_threadpool mode 2) plus first touch allocation.
+
+.. code-block:: bash
+
+  python3 numa_bench.py --size-mb 512
+"""
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+import tvm
+from tvm import te
+
+AFFINITY_MODES = {"big": 1, "numa": 2}
+
+
+def numa_nodes():
+    """Return the list of CPU ids of each NUMA node."""
+    nodes = []
+    while os.path.exists("/sys/devices/system/node/node%d" % len(nodes)):
+        with open("/sys/devices/system/node/node%d/cpulist" % len(nodes)) as f:
+            cpus = []
+            for rng in f.read().strip().split(","):
+                begin, _, end = rng.partition("-")
+                cpus.extend(range(int(begin), int(end or begin) + 1))
+            nodes.append(cpus)
+    return nodes
+
+
+def build_copy(n):
+    A = te.placeholder((n,), name="A")
+    B = te.compute((n,), lambda i: A[i] + 1.0, name="B")
+    s = te.create_schedule(B.op)
+    outer, inner = s[B].split(B.op.axis[0], factor=1 << 14)
+    s[B].parallel(outer)
+    _, vec = s[B].split(inner, factor=16)
+    s[B].vectorize(vec)
+    return tvm.build(s, [A, B], "llvm")
+
+
+def measure(func, a, b, repeat):
+    func(a, b)
+    tic = time.time()
+    for _ in range(repeat):
+        func(a, b)
+    cost = (time.time() - tic) / repeat
+    nbytes = a.shape[0] * 4 * 2
+    return nbytes / cost / 1e9
+
+
+def child_pair(args):
+    """Touch the buffers on one node, then copy them with the workers of another node."""
+    nodes = numa_nodes()
+    n = args.size_mb * (1 << 20) // 4
+    func = build_copy(n)
+    os.sched_setaffinity(0, nodes[args.mem_node])
+    ctx = tvm.cpu(0)
+    a = tvm.nd.empty((n,), "float32", ctx)
+    b = tvm.nd.empty((n,), "float32", ctx)
+    a.copyfrom(np.ones(n, "float32"))
+    b.copyfrom(np.zeros(n, "float32"))
+    # The thread pool is created at the first launch and inherits this affinity.
+    os.sched_setaffinity(0, nodes[args.cpu_node])
+    print(json.dumps({"bandwidth": measure(func, a, b, args.repeat)}))
+
+
+def child_machine(args):
+    """Let the workers of the whole machine touch and copy the buffers."""
+    n = args.size_mb * (1 << 20) // 4
+    func = build_copy(n)
+    tvm.get_global_func("runtime.config_threadpool")(AFFINITY_MODES[args.mode], 0)
+    ctx = tvm.cpu(0)
+    a = tvm.nd.empty((n,), "float32", ctx)
+    b = tvm.nd.empty((n,), "float32", ctx)
+    # The first run places the pages of both buffers with the workers.
+    func(b, a)
+    print(json.dumps({"bandwidth": measure(func, a, b, args.repeat)}))
+
+
+def run_child(extra_args, env):
+    cmd = [sys.executable, os.path.abspath(__file__)] + extra_args
+    out = subprocess.check_output(cmd, env=dict(os.environ, **env))
+    return json.loads(out.decode().strip().splitlines()[-1])["bandwidth"]
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--size-mb", type=int, default=512, help="Size of each buffer")
+    parser.add_argument("--repeat", type=int, default=10)
+    parser.add_argument("--mem-node", type=int, help=argparse.SUPPRESS)
+    parser.add_argument("--cpu-node", type=int, help=argparse.SUPPRESS)
+    parser.add_argument("--mode", type=str, help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.mem_node is not None:
+        child_pair(args)
+        sys.exit(0)
+    if args.mode is not None:
+        child_machine(args)
+        sys.exit(0)
+
+    all_nodes = numa_nodes()
+    common_args = ["--size-mb", str(args.size_mb), "--repeat", str(args.repeat)]
+    print("Copy bandwidth in GB/s, rows are memory nodes, columns are worker nodes")
+    print("%-8s" % "" + "".join("%-10s" % ("node%d" % i) for i in range(len(all_nodes))))
+    for mem_node in range(len(all_nodes)):
+        row = []
+        for cpu_node, cpus in enumerate(all_nodes):
+            env = {"TVM_BIND_THREADS": "0", "TVM_NUM_THREADS": str(len(cpus))}
+            pair_args = ["--mem-node", str(mem_node), "--cpu-node", str(cpu_node)]
+            row.append(run_child(common_args + pair_args, env))
+        print("%-8s" % ("node%d" % mem_node) + "".join("%-10.2f" % x for x in row))
+
+    print("\nWhole machine copy bandwidth in GB/s")
+    for mode in ["big", "numa"]:
+        env = {"TVM_NUMA_FIRST_TOUCH": "1" if mode == "numa" else "0"}
+        print("%-8s %.2f" % (mode, run_child(common_args + ["--mode", mode], env)))
@@ -0,0 +1,128 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Throughput of the RPC array copies.
+
+Arrays of several sizes are uploaded to and downloaded from an RPC server,
+a local one by default, and the throughput of each direction is reported.
+With --channel pipe, the server is a minrpc executable talking over a pipe
+instead of a socket. With --compress, the channel is compressed and the
+bytes on the wire are reported too; minrpc does not negotiate a codec, so
+it only applies to sockets.
+
+.. code-block:: bash
+
+  python3 rpc_transfer_bench.py
+  python3 rpc_transfer_bench.py --channel pipe
+  python3 rpc_transfer_bench.py --host 10.0.0.2 --port 9090 --compress --data zeros
+"""
+import argparse
+import os
+import time
+
+import numpy as np
+
+import tvm
+from tvm import rpc
+from tvm.contrib import cc, utils
+
+
+def measure(func, repeat):
+    """Return the mean time of func over repeat runs, after a warm up run."""
+    func()
+    tbegin = time.perf_counter()
+    for _ in range(repeat):
+        func()
+    return (time.perf_counter() - tbegin) / repeat
+
+
+def make_data(kind, size):
+    """Make size bytes of float32 data."""
+    if kind == "zeros":
+        return np.zeros(size // 4, dtype="float32")
+    if kind == "ints":
+        return np.random.randint(0, 8, size=size // 4).astype("float32")
+    return np.random.uniform(size=size // 4).astype("float32")
+
+
+def connect(args):
+    """Connect to the server over the channel in args."""
+    if args.channel == "pipe":
+        temp = utils.tempdir()
+        minrpc_exec = temp.relpath("minrpc")
+        rpc.with_minrpc(cc.create_executable)(minrpc_exec, [])
+        return rpc.PopenSession(minrpc_exec), temp
+    if args.host is None:
+        server = rpc.Server("localhost")
+        return rpc.connect(server.host, server.port), server
+    return rpc.connect(args.host, args.port), None
+
+
+def evaluate(remote, sizes, repeat, data):
+    ctx = remote.cpu(0)
+    print("%-12s %-16s %-16s" % ("Size", "Upload", "Download"))
+    for size in sizes:
+        x_np = make_data(data, size)
+        x = tvm.nd.empty(x_np.shape, "float32", ctx)
+        upload = measure(lambda: x.copyfrom(x_np), repeat)
+        download = measure(x.asnumpy, repeat)
+        np.testing.assert_equal(x.asnumpy(), x_np)
+        mbytes = x_np.nbytes / 1e6
+        print(
+            "%-12s %-16s %-16s"
+            % (
+                "%.3f MB" % mbytes,
+                "%.1f MB/s" % (mbytes / upload),
+                "%.1f MB/s" % (mbytes / download),
+            )
+        )
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--host", type=str, default=None, help="Server host, local if unset")
+    parser.add_argument("--port", type=int, default=9090)
+    parser.add_argument("--channel", type=str, default="socket", choices=["socket", "pipe"])
+    parser.add_argument(
+        "--sizes",
+        type=int,
+        nargs="+",
+        default=[1 << 12, 1 << 16, 1 << 20, 1 << 24, 1 << 27],
+        help="Array sizes in bytes",
+    )
+    parser.add_argument("--repeat", type=int, default=10)
+    parser.add_argument("--data", type=str, default="random", choices=["random", "ints", "zeros"])
+    parser.add_argument("--compress", action="store_true", help="Compress the channel")
+    args = parser.parse_args()
+
+    if args.compress:
+        if args.channel == "pipe":
+            parser.error("--compress is not supported by the minrpc pipe server")
+        os.environ["TVM_RPC_COMPRESSION"] = "lz"
+    # Keep the server or the directory of the minrpc executable alive.
+    remote, keep_alive = connect(args)
+    evaluate(remote, args.sizes, args.repeat, args.data)
+    stats = remote.compression_stats()
+    if stats:
+        print(
+            "Sent %.1f MB as %.1f MB, received %.1f MB as %.1f MB"
+            % (
+                stats["raw_bytes_sent"] / 1e6,
+                stats["wire_bytes_sent"] / 1e6,
+                stats["raw_bytes_received"] / 1e6,
+                stats["wire_bytes_received"] / 1e6,
+            )
+        )
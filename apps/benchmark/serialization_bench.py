@@ -0,0 +1,137 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Benchmark of the json and binary serialization of a large Relay module.
+
+The parameters of the model are bound as constants, as in the modules of the
+frontends, so most of the bytes are tensors. Each save and load runs in a
+fresh process to measure its peak resident memory.
+
+.. code-block:: bash
+
+  python3 serialization_bench.py --network resnet-50
+"""
+import argparse
+import os
+import resource
+import subprocess
+import sys
+import tempfile
+import time
+
+import tvm
+from tvm import relay
+from tvm.relay import testing
+
+
+def get_module(network):
+    """Get a Relay module with its parameters bound as constants."""
+    if network.startswith("resnet-"):
+        num_layers = int(network.split("-")[1])
+        mod, params = testing.resnet.get_workload(num_layers=num_layers, batch_size=1)
+    elif network == "vgg-16":
+        mod, params = testing.vgg.get_workload(num_layers=16, batch_size=1)
+    elif network == "mobilenet":
+        mod, params = testing.mobilenet.get_workload(batch_size=1)
+    else:
+        raise ValueError("Unsupported network: " + network)
+    func = relay.build_module.bind_params_by_name(mod["main"], params)
+    return tvm.IRModule.from_expr(func)
+
+
+def peak_rss_mb():
+    # ru_maxrss is in kilobytes on Linux.
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss / 1024.0
+
+
+def run_phase(phase, fmt, network, path):
+    """Run one save or load and print its time and peak memory."""
+    if phase == "save":
+        mod = get_module(network)
+        base = peak_rss_mb()
+        tbegin = time.perf_counter()
+        if fmt == "json":
+            with open(path, "w") as f:
+                f.write(tvm.ir.save_json(mod))
+        else:
+            tvm.ir.save_binary(mod, path)
+    else:
+        base = peak_rss_mb()
+        tbegin = time.perf_counter()
+        if fmt == "json":
+            with open(path) as f:
+                mod = tvm.ir.load_json(f.read())
+        else:
+            mod = tvm.ir.load_binary(file_name=path)
+    elapsed = time.perf_counter() - tbegin
+    print("%f %f" % (elapsed, peak_rss_mb() - base))
+
+
+def measure(phase, fmt, network, path):
+    out = subprocess.check_output(
+        [
+            sys.executable,
+            __file__,
+            "--phase",
+            phase,
+            "--format",
+            fmt,
+            "--network",
+            network,
+            "--path",
+            path,
+        ]
+    )
+    elapsed, rss = out.decode().split()[-2:]
+    return float(elapsed), float(rss)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument(
+        "--network", type=str, default="resnet-50", help="resnet-<n>, vgg-16 or mobilenet"
+    )
+    parser.add_argument("--phase", type=str, choices=["save", "load"], help=argparse.SUPPRESS)
+    parser.add_argument("--format", type=str, choices=["json", "binary"], help=argparse.SUPPRESS)
+    parser.add_argument("--path", type=str, help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.phase:
+        run_phase(args.phase, args.format, args.network, args.path)
+        sys.exit(0)
+
+    tmpdir = tempfile.mkdtemp()
+    print(
+        "%-8s %-10s %-10s %-14s %-10s %-14s"
+        % ("Format", "Size", "Save", "Save peak RSS", "Load", "Load peak RSS")
+    )
+    for fmt in ["json", "binary"]:
+        path = os.path.join(tmpdir, "mod." + fmt)
+        save_time, save_rss = measure("save", fmt, args.network, path)
+        load_time, load_rss = measure("load", fmt, args.network, path)
+        print(
+            "%-8s %-10s %-10s %-14s %-10s %-14s"
+            % (
+                fmt,
+                "%.1f MB" % (os.path.getsize(path) / 2**20),
+                "%.3f s" % save_time,
+                "+%.0f MB" % save_rss,
+                "%.3f s" % load_time,
+                "+%.0f MB" % load_rss,
+            )
+        )
+        os.remove(path)
+    os.rmdir(tmpdir)
@@ -0,0 +1,75 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Microbenchmark of the CPU thread pool kinds behind TVMBackendParallelLaunch.
+
+The kernel is a parallel loop whose iteration i does work proportional to i,
+so a static partition of the loop gives the last worker most of the work.
+
+.. code-block:: bash
+
+  python3 thread_pool_bench.py --n 4096 --work 64
+"""
+import argparse
+
+import numpy as np
+
+import tvm
+from tvm import te
+
+
+def build_imbalanced_kernel(n, work):
+    """Build a kernel with a triangular amount of work per parallel iteration."""
+    A = te.placeholder((n,), name="A")
+
+    def gen(ins, outs):
+        ib = tvm.tir.ir_builder.create()
+        a = ib.buffer_ptr(ins[0])
+        b = ib.buffer_ptr(outs[0])
+        with ib.for_range(0, n, name="i", kind="parallel") as i:
+            b[i] = tvm.tir.const(0, "float32")
+            with ib.for_range(0, (i + 1) * work, name="j") as j:
+                b[i] = b[i] + a[(i + j) % n]
+        return ib.get()
+
+    B = te.extern((n,), [A], lambda ins, outs: gen(ins, outs), dtype="float32", name="B")
+    s = te.create_schedule(B.op)
+    return tvm.build(s, [A, B], "llvm")
+
+
+def evaluate(func, kind, n, repeat):
+    tvm.get_global_func("runtime.config_threadpool_kind")(kind)
+    ctx = tvm.cpu(0)
+    a = tvm.nd.array(np.random.uniform(size=(n,)).astype("float32"), ctx)
+    b = tvm.nd.empty((n,), "float32", ctx)
+    ftimer = func.time_evaluator(func.entry_name, ctx, number=10, repeat=repeat)
+    prof_res = np.array(ftimer(a, b).results) * 1000  # multiply 1000 for converting to millisecond
+    print("%-16s %-19s (%s)" % (kind, "%.3f ms" % np.mean(prof_res), "%.3f ms" % np.std(prof_res)))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--n", type=int, default=4096, help="Number of parallel iterations")
+    parser.add_argument("--work", type=int, default=64, help="Work per iteration unit")
+    parser.add_argument("--repeat", type=int, default=5)
+    args = parser.parse_args()
+
+    f = build_imbalanced_kernel(args.n, args.work)
+    print("%-16s %-19s (%s)" % ("Pool", "Mean Time", "Std"))
+    print("--------------------------------------------------")
+    for pool_kind in ["spsc", "work_stealing"]:
+        evaluate(f, pool_kind, args.n, args.repeat)
+    tvm.get_global_func("runtime.config_threadpool_kind")("spsc")
@@ -0,0 +1,107 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Cold start of a Relay VM executable saved in the two formats.
+
+The executable is saved with `Executable.save`, which is read and copied as
+a whole, and with `Executable.save_to_file`, which is memory mapped and
+decoded lazily. Every load runs in a fresh process, which reports the time
+to load the executable, the time of the first inference and the growth of
+its resident memory.
+
+.. code-block:: bash
+
+  python3 vm_load_bench.py --network resnet-50
+"""
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+import numpy as np
+
+import tvm
+from tvm import relay
+from tvm.contrib import utils
+from tvm.relay import testing
+
+
+def rss_bytes():
+    with open("/proc/self/statm") as f:
+        return int(f.read().split()[1]) * os.sysconf("SC_PAGE_SIZE")
+
+
+def load_and_run(fmt, path, lib_path, shape):
+    """Load the executable in this process and print the measurements."""
+    lib = tvm.runtime.load_module(lib_path)
+    data = tvm.nd.array(np.random.uniform(size=shape).astype("float32"))
+    rss = rss_bytes()
+    tbegin = time.perf_counter()
+    if fmt == "bytes":
+        with open(path, "rb") as f:
+            exe = tvm.runtime.vm.Executable.load_exec(f.read(), lib)
+    else:
+        exe = tvm.runtime.vm.Executable.load_exec_from_file(path, lib)
+    vm = tvm.runtime.vm.VirtualMachine(exe, tvm.cpu())
+    tload = time.perf_counter()
+    vm.run(data)
+    trun = time.perf_counter()
+    print("%f %f %d" % (tload - tbegin, trun - tload, rss_bytes() - rss))
+
+
+def benchmark(network, repeat):
+    if network == "mobilenet":
+        mod, params = testing.mobilenet.get_workload()
+    else:
+        mod, params = testing.resnet.get_workload(num_layers=50)
+    shape = [int(x) for x in mod["main"].checked_type.arg_types[0].shape]
+    exe = relay.vm.compile(mod, target="llvm", params=params)
+    tmp = utils.tempdir()
+    lib_path = tmp.relpath("lib.so")
+    exe.mod["get_lib"]().export_library(lib_path)
+    code, _ = exe.save()
+    paths = {"bytes": tmp.relpath("exec.ro"), "mapped": tmp.relpath("exec.vmx")}
+    with open(paths["bytes"], "wb") as f:
+        f.write(code)
+    exe.save_to_file(paths["mapped"])
+
+    print("%-8s %-14s %-14s %-14s" % ("Format", "Load (ms)", "First run (ms)", "RSS (MB)"))
+    for fmt, path in paths.items():
+        results = []
+        for _ in range(repeat):
+            child = [fmt, path, lib_path, ",".join(map(str, shape))]
+            out = subprocess.check_output([sys.executable, __file__, "--child"] + child)
+            results.append([float(x) for x in out.split()])
+        mean = np.mean(np.array(results), axis=0)
+        print(
+            "%-8s %-14.3f %-14.3f %-14.1f"
+            % (fmt, mean[0] * 1e3, mean[1] * 1e3, mean[2] / (1 << 20))
+        )
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--network", choices=["resnet-50", "mobilenet"], default="resnet-50")
+    parser.add_argument("--repeat", type=int, default=5)
+    parser.add_argument("--child", nargs=4, help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.child:
+        child_fmt, child_path, child_lib, child_shape = args.child
+        load_and_run(child_fmt, child_path, child_lib, [int(x) for x in child_shape.split(",")])
+    else:
+        benchmark(args.network, args.repeat)
@@ -0,0 +1,81 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+"""Microbenchmark of the Relay VM interpreter on a loop-heavy model.
+
+The model is a while loop over a tiny tensor, like the loop of an RNN
+decoder, so the run time is dominated by the dispatch of the VM instructions
+rather than by the kernels.
+
+.. code-block:: bash
+
+  python3 vm_loop_bench.py --iters 10000
+"""
+import argparse
+import time
+
+import numpy as np
+
+import tvm
+from tvm import relay
+from tvm.relay.loops import while_loop
+
+
+def build_loop(iters, width):
+    """Build a VM executable running `iters` iterations of an elementwise update."""
+    i = relay.var("i", shape=(), dtype="int32")
+    acc = relay.var("acc", shape=(width,), dtype="float32")
+    x = relay.var("x", shape=(width,), dtype="float32")
+
+    def cond(i, acc):
+        return relay.less(i, relay.const(iters, "int32"))
+
+    def body(i, acc):
+        return [i + relay.const(1, "int32"), acc * relay.const(0.5) + x]
+
+    loop = while_loop(cond, [i, acc], body)
+    res = relay.TupleGetItem(loop(relay.const(0, "int32"), x), 1)
+    mod = tvm.IRModule.from_expr(relay.Function([x], res))
+    return relay.vm.compile(mod, target="llvm")
+
+
+def evaluate(exe, iters, width, repeat):
+    ctx = tvm.cpu(0)
+    vm = tvm.runtime.vm.VirtualMachine(exe, ctx)
+    x = tvm.nd.array(np.random.uniform(size=(width,)).astype("float32"), ctx)
+    vm.run(x)  # warm up the constant pool and the allocator.
+    times = []
+    for _ in range(repeat):
+        tbegin = time.perf_counter()
+        vm.run(x)
+        times.append(time.perf_counter() - tbegin)
+    times = np.array(times)
+    print("%-16s %-19s (%s)" % ("Iterations/s", "%.0f" % (iters / np.mean(times)), "mean"))
+    print("%-16s %-19s (%s)" % ("us/iteration", "%.3f" % (np.mean(times) / iters * 1e6), "mean"))
+    print(
+        "%-16s %-19s (%s)"
+        % ("Run time", "%.3f ms" % (np.mean(times) * 1e3), "%.3f ms" % (np.std(times) * 1e3))
+    )
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--iters", type=int, default=10000, help="Number of loop iterations")
+    parser.add_argument("--width", type=int, default=4, help="Size of the loop tensor")
+    parser.add_argument("--repeat", type=int, default=10)
+    args = parser.parse_args()
+
+    evaluate(build_loop(args.iters, args.width), args.iters, args.width, args.repeat)
@@ -30,6 +30,8 @@
 #include <tvm/node/node.h>
 #include <tvm/runtime/packed_func.h>
 
+#include <random>
+#include <string>
 #include <vector>
 
 namespace tvm {
@@ -159,6 +161,95 @@ class PythonBasedModel : public CostModel {
   TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(PythonBasedModel, CostModel, PythonBasedModelNode);
 };
 
+/*!
+ * \brief A cost model of gradient boosted trees, trained and evaluated in C++.
+ *  As XGBModel, it predicts the score of a state as the sum of the predictions for its stores.
+ *  The trees are trained with a pairwise ranking loss between the measured states of the same
+ *  task, so the search never calls into Python.
+ */
+class GBDTModelNode : public CostModelNode {
+ public:
+  /*! \brief The maximum depth of a tree. */
+  int max_depth;
+  /*! \brief The maximum number of trees. */
+  int max_num_trees;
+  /*! \brief The learning rate. */
+  double learning_rate;
+  /*! \brief The minimum number of measured states to start to use the trees. */
+  int num_warmup_sample;
+  /*! \brief Whether to train less often when there are many measured states. */
+  bool adaptive_training;
+  /*! \brief If not empty, the model is saved to this file after every update. */
+  String model_file;
+
+  /*! \brief The number of features of a store. */
+  int num_features{0};
+  /*! \brief The first node of each tree. */
+  std::vector<int32_t> tree_begin;
+  /*! \brief The depth of each tree. */
+  std::vector<int32_t> tree_depth;
+  /*!
+   * \brief The nodes of all trees. A store goes from a node to its child when its feature is not
+   *  larger than the threshold, and to the child + 1 otherwise. The leaves are their own child
+   *  with an infinite threshold, so all stores walk a tree for the same number of steps.
+   */
+  std::vector<int32_t> split_feature;
+  std::vector<float> split_threshold;
+  std::vector<int32_t> child;
+  std::vector<float> leaf_value;
+
+  /*! \brief The measured states, the features of the first ones are kept over updates. */
+  Array<MeasureInput> inputs;
+  Array<MeasureResult> results;
+  std::vector<std::vector<float>> features;
+  /*! \brief The number of measured states at the last training. */
+  size_t last_train_length{0};
+  /*! \brief The random generator of the pairs and of the predictions during warmup. */
+  std::mt19937 rand_gen;
+
+  void Update(const Array<MeasureInput>& inputs, const Array<MeasureResult>& results) final;
+
+  void Predict(const SearchTask& task, const Array<State>& states,
+               std::vector<float>* scores) final;
+
+  /*!
+   * \brief Save the trees to a binary file.
+   * \param file_name The name of the file.
+   */
+  void Save(const std::string& file_name) const;
+
+  /*!
+   * \brief Load the trees from a binary file and use them without warmup.
+   * \param file_name The name of the file.
+   */
+  void Load(const std::string& file_name);
+
+  static constexpr const char* _type_key = "auto_scheduler.GBDTModel";
+  TVM_DECLARE_FINAL_OBJECT_INFO(GBDTModelNode, CostModelNode);
+};
+
+/*!
+ * \brief Managed reference to GBDTModelNode.
+ * \sa GBDTModelNode
+ */
+class GBDTModel : public CostModel {
+ public:
+  /*!
+   * \brief The constructor.
+   * \param max_depth The maximum depth of a tree.
+   * \param max_num_trees The maximum number of trees.
+   * \param learning_rate The learning rate.
+   * \param num_warmup_sample The minimum number of measured states to start to use the trees.
+   * \param seed The random seed.
+   * \param adaptive_training Whether to train less often when there are many measured states.
+   * \param model_file If not empty, the model is saved to this file after every update.
+   */
+  GBDTModel(int max_depth, int max_num_trees, double learning_rate, int num_warmup_sample,
+            int seed, bool adaptive_training, String model_file);
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(GBDTModel, CostModel, GBDTModelNode);
+};
+
 }  // namespace auto_scheduler
 }  // namespace tvm
 
@@ -286,6 +286,16 @@ class State : public ObjectRef {
    */
   String ToStr(bool delete_trivial_loop = true) const;
 
+  /*!
+   * \brief A 64-bit fingerprint of the transform steps, to find the states seen before without
+   * printing them. It is computed step by step with StepFingerprint, from kInitialFingerprint.
+   * \return The fingerprint.
+   */
+  uint64_t Fingerprint() const;
+
+  /*! \brief The fingerprint of a state without transform steps. */
+  static constexpr uint64_t kInitialFingerprint = 0xcbf29ce484222325ULL;
+
   /********** Step APIs working on a single stage **********/
   /*!
    * \brief The schedule primitive corresponding to `te::Stage::bind`.
@@ -32,7 +32,9 @@
  *
  * The core functions is implemented in python to utilize python's multiprocessing
  * and error handling (see also `python/tvm/auto_scheduler/measure.py`).
- * This c++ file is just a wrapper for the python functions.
+ * This c++ file is just a wrapper for the python functions, except for the CPU
+ * programs built for the host by LocalBuilder and LocalRunner, which are measured
+ * natively in forked processes (see src/auto_scheduler/local_measure.h).
  */
 
 #ifndef TVM_AUTO_SCHEDULER_MEASURE_H_
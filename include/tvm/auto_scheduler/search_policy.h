@@ -180,10 +180,10 @@ class SearchPolicyNode : public Object {
  protected:
   /*!
    * \brief The set of already measured states.
-   * We store the string format of a state for redundancy check. This is used to make sure a
+   * We store the fingerprint of a state for redundancy check. This is used to make sure a
    * measured state will never be measured again.
    */
-  std::unordered_set<std::string> measured_states_set_;
+  std::unordered_set<uint64_t> measured_states_set_;
   /*! \brief The array of already measured states.
    *  The good states can be used as the initial population in evolutionary search. */
   std::vector<State> measured_states_vector_;
@@ -31,7 +31,8 @@
  * 3. Implement `FuseStepNode::ApplyToState` and the state API `State::fuse`.
  *    - In these two functions you need to incrementally update all data structures in State with
  *      CopyOnWrite style.
- * 4. Add your step to `StepApplyToState`, `StepApplyToSchedule`, and `StepPrintAsPythonAPI`.
+ * 4. Add your step to `StepApplyToState`, `StepApplyToSchedule`, `StepPrintAsPythonAPI` and
+ *    `StepWriteToBinary`.
  * 5. Log record serialization support:
  *    - Add `FuseStepNode::WriteToRecord` which takes a mutable JSONWriter pointer as input and
  *      output the record to it.
@@ -50,6 +51,7 @@
 #include <tvm/node/node.h>
 #include <tvm/te/schedule.h>
 
+#include <string>
 #include <vector>
 
 namespace tvm {
@@ -243,6 +245,23 @@ String StepPrintAsPythonAPI(const Step& step, Array<te::Stage>* stages,
                             StageToAxesMap* stage_to_axes, te::Schedule* schedule,
                             const Array<Step>& transform_steps);
 
+/*!
+ * \brief Write a step in a compact binary encoding with runtime dynamic dispatching.
+ * The encoding is the kind of the step followed by the fields of its record, as zigzag varints
+ * and length-prefixed strings and arrays.
+ * \param step The step to be encoded.
+ * \param out The string to append the encoding to.
+ */
+void StepWriteToBinary(const Step& step, std::string* out);
+
+/*!
+ * \brief Continue the fingerprint of a list of steps with one more step.
+ * \param prefix The fingerprint of the steps before this one.
+ * \param step The appended step.
+ * \return The fingerprint of the steps including this one.
+ */
+uint64_t StepFingerprint(uint64_t prefix, const Step& step);
+
 /********** Steps working on single stage **********/
 
 /*!
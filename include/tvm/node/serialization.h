@@ -24,6 +24,7 @@
 #ifndef TVM_NODE_SERIALIZATION_H_
 #define TVM_NODE_SERIALIZATION_H_
 
+#include <dmlc/io.h>
 #include <tvm/runtime/c_runtime_api.h>
 #include <tvm/runtime/object.h>
 
@@ -47,5 +48,43 @@ TVM_DLL std::string SaveJSON(const runtime::ObjectRef& node);
  */
 TVM_DLL runtime::ObjectRef LoadJSON(std::string json_str);
 
+/*!
+ * \brief Save the node as well as all the nodes it depends on in the binary format.
+ *
+ *  The objects are written to the stream as they are visited and the tensors
+ *  are stored raw, aligned to kAllocAlignment. The attributes are not named, so
+ *  the result can only be loaded by the same TVM version, SaveJSON is the
+ *  portable format.
+ *
+ * \param strm The stream to write to.
+ * \param node The node to save.
+ */
+TVM_DLL void SaveBinary(dmlc::Stream* strm, const runtime::ObjectRef& node);
+
+/*!
+ * \brief Load a node saved by SaveBinary.
+ * \param strm The stream to read from.
+ * \return The loaded node, the tensors are on CPU.
+ */
+TVM_DLL runtime::ObjectRef LoadBinary(dmlc::Stream* strm);
+
+/*!
+ * \brief Save a node to a file in the binary format.
+ * \param file_name The name of the file.
+ * \param node The node to save.
+ */
+TVM_DLL void SaveBinaryFile(const std::string& file_name, const runtime::ObjectRef& node);
+
+/*!
+ * \brief Load a node from a file saved by SaveBinaryFile.
+ *
+ *  The file is memory mapped and the tensors are views of the mapping, which
+ *  stays alive as long as one of the tensors does.
+ *
+ * \param file_name The name of the file.
+ * \return The loaded node.
+ */
+TVM_DLL runtime::ObjectRef LoadBinaryFile(const std::string& file_name);
+
 }  // namespace tvm
 #endif  // TVM_NODE_SERIALIZATION_H_
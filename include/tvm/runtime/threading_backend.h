@@ -64,21 +64,27 @@ class ThreadGroup {
   enum AffinityMode : int {
     kBig = 1,
     kLittle = -1,
+    /*! \brief Spread the workers over the NUMA nodes, each bound to the cores of its node. */
+    kNuma = 2,
   };
 
   /*!
    * \brief configure the CPU id affinity
    *
-   * \param mode The preferred CPU type (1 = big, -1 = little).
+   * \param mode The preferred CPU type (1 = big, -1 = little, 2 = NUMA grouped).
    * \param nthreads The number of threads to use (0 = use all).
    * \param exclude_worker0 Whether to use the main thread as a worker.
    *        If  `true`, worker0 will not be launched in a new thread and
    *        `worker_callback` will only be called for values >= 1. This
    *        allows use of the main thread as a worker.
+   * \param first_core The index, in the order of preference of the mode, of the
+   *        first core to bind to, -1 for the default binding. When set, the group
+   *        and the calling thread are confined to the nthreads cores starting
+   *        there, so that several groups can split the cores between them.
    *
    * \return The number of workers to use.
    */
-  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0);
+  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0, int first_core = -1);
 
  private:
   Impl* impl_;
@@ -94,6 +100,26 @@ void Yield();
  */
 int MaxConcurrency();
 
+/*!
+ * \return the number of NUMA nodes of this system, 1 if it cannot be detected.
+ */
+int NumNumaNodes();
+
+/*!
+ * \return the NUMA node of the CPU the calling thread runs on, 0 if it cannot be detected.
+ */
+int CurrentNumaNode();
+
+/*!
+ * \brief Drop the thread pools inherited by a forked child process.
+ *
+ *  fork() only copies the calling thread, so the workers of the pools created
+ *  before the fork do not exist in the child. The pools are leaked rather than
+ *  joined, the next parallel launch creates new ones.
+ *  Only call it in the child right after fork(), while it is single threaded.
+ */
+void ResetThreadPoolAfterFork();
+
 }  // namespace threading
 }  // namespace runtime
 }  // namespace tvm
@@ -29,6 +29,7 @@
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/vm/bytecode.h>
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -50,6 +51,11 @@ struct VMFunction;
  *  - Primitive name section, containing the function name of the primitive ops
  *  used by the virtual machine.
  *  - Code section, handling the VM functions and bytecode.
+ *
+ *  The executable can also be saved to a file with a versioned section table,
+ *  where the data of the constants is aligned. Such a file is memory mapped
+ *  when loaded, the constants are loaded on first use and the bytecode of a
+ *  function is decoded when it is first invoked.
  */
 class Executable : public ModuleNode {
  public:
@@ -81,6 +87,50 @@ class Executable : public ModuleNode {
    */
   static runtime::Module Load(const std::string& code, const runtime::Module lib);
 
+  /*!
+   * \brief Save the executable to a file with a section table.
+   *
+   * \param path The path of the file.
+   * \param alignment The alignment of the constant data in the file, a power of
+   *  two that is at least kAllocAlignment.
+   */
+  void SaveToFile(const std::string& path, size_t alignment);
+
+  /*!
+   * \brief Load an executable saved by SaveToFile, mapping the file.
+   *
+   *  The constants on CPU are views of the mapping, so the processes serving
+   *  the same executable share the pages of the weights.
+   *
+   * \param path The path of the file.
+   * \param lib The compiled runtime library.
+   *
+   * \return exe The constructed executable.
+   */
+  static runtime::Module LoadFromFile(const std::string& path, const runtime::Module lib);
+
+  /*!
+   * \brief Get a constant, loading it on first use for a lazily loaded executable.
+   * \param const_index The index of the constant.
+   * \return The constant.
+   */
+  ObjectRef GetConstant(Index const_index) const;
+
+  /*!
+   * \brief Get a function, decoding its bytecode on first use for a lazily loaded executable.
+   * \param func_index The index of the function.
+   * \return The function.
+   */
+  const VMFunction& GetVMFunction(Index func_index) const;
+
+  /*!
+   * \brief Whether the instructions of a function are decoded. The instructions of a
+   *  function not loaded yet may be written concurrently and must not be read.
+   * \param func_index The index of the function.
+   * \return True if `functions[func_index].instructions` can be read.
+   */
+  bool IsFunctionLoaded(Index func_index) const;
+
   /*!
    * \brief Get the serialized form of the `functions`. This is
    * essentially bytecode serialization.
@@ -151,7 +201,7 @@ class Executable : public ModuleNode {
   /*! \brief The runtime module/library that contains both the host and also the device
    * code when executing on non-CPU devices. */
   runtime::Module lib;
-  /*! \brief The global constant pool. */
+  /*! \brief The global constant pool, see GetConstant for lazily loaded executables. */
   std::vector<ObjectRef> constants;
   /*! \brief A map from globals (as strings) to their index in the function map. */
   std::unordered_map<std::string, Index> global_map;
@@ -159,7 +209,8 @@ class Executable : public ModuleNode {
    * corresponds to the position of the `packed_funcs` list in a `VirtualMachine` object.
    */
   std::unordered_map<std::string, Index> primitive_map;
-  /*! \brief The virtual machine's function table. */
+  /*! \brief The virtual machine's function table, see GetVMFunction for lazily loaded
+   * executables. */
   std::vector<VMFunction> functions;
   /*! \brief The device type for each constant. */
   std::vector<Index> const_device_type;
@@ -221,8 +272,23 @@ class Executable : public ModuleNode {
    */
   void LoadCodeSection(dmlc::Stream* strm);
 
+  class LazySections;
+
+  /*!
+   * \brief Load the executable from the sections of a file saved by SaveToFile.
+   *
+   * \param sections The content of the file.
+   * \param lib The compiled runtime library.
+   *
+   * \return exe The constructed executable.
+   */
+  static runtime::Module LoadSections(std::shared_ptr<LazySections> sections,
+                                      const runtime::Module lib);
+
   /*! \brief The serialized bytecode. */
   std::string code_;
+  /*! \brief The sections not loaded yet, nullptr when everything is loaded. */
+  std::shared_ptr<LazySections> lazy_;
 };
 
 }  // namespace vm
@@ -33,7 +33,9 @@
 #include <tvm/runtime/vm/executable.h>
 #include <tvm/runtime/vm/memory_manager.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -132,6 +134,44 @@ struct VMFrame {
         caller_return_register(0) {}
 };
 
+/*!
+ * \brief The constants of an executable copied to their devices on first use.
+ *
+ *  The pool is shared by the execution contexts of a virtual machine, so
+ *  concurrent invocations keep a single device copy of the weights.
+ */
+class VMConstantPool {
+ public:
+  explicit VMConstantPool(size_t num_constants)
+      : constants_(num_constants), loaded_(new std::atomic<bool>[num_constants]) {
+    for (size_t i = 0; i < num_constants; ++i) loaded_[i] = false;
+  }
+
+  /*!
+   * \brief Get a constant, loading it the first time.
+   * \param const_index The index of the constant.
+   * \param load The function copying the constant to its device.
+   * \return The constant on its device.
+   */
+  template <typename FLoad>
+  const ObjectRef& Get(Index const_index, FLoad load) {
+    ICHECK_LT(static_cast<size_t>(const_index), constants_.size());
+    if (!loaded_[const_index].load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!loaded_[const_index].load(std::memory_order_relaxed)) {
+        constants_[const_index] = load();
+        loaded_[const_index].store(true, std::memory_order_release);
+      }
+    }
+    return constants_[const_index];
+  }
+
+ private:
+  std::vector<ObjectRef> constants_;
+  std::unique_ptr<std::atomic<bool>[]> loaded_;
+  std::mutex mutex_;
+};
+
 /*!
  * \brief The virtual machine.
  *
@@ -176,7 +216,55 @@ class VirtualMachine : public runtime::ModuleNode {
    */
   virtual void LoadExecutable(const Executable* exec);
 
+  /*!
+   * \brief Overlap the kernels and the device copies of an invocation.
+   *
+   *  The kernels whose arguments are on CPU run on worker threads and the
+   *  device copies on a copy thread with its own streams, each one as soon as
+   *  the kernels and copies touching the same buffers before it are done. The
+   *  VM waits for them when it reads a tensor on host, e.g. for control flow
+   *  and dynamic shapes, and at the end of the invocation.
+   *
+   * \param num_workers The number of worker threads running kernels, 0 restores
+   *  the synchronous execution.
+   * \param intra_op_threads The number of threads each kernel may use in its
+   *  parallel loops, 0 splits the cores evenly among the workers.
+   * \note The debug VM overrides it to stay synchronous, it times each kernel on the VM thread.
+   */
+  virtual void SetAsyncExecution(int num_workers, int intra_op_threads);
+
  protected:
+  /*!
+   * \brief Create an execution context of this virtual machine.
+   *
+   *  The context shares the executable, the packed functions, the allocators
+   *  and the constant pool, and has its own frames and registers.
+   *
+   * \return The context.
+   */
+  ObjectPtr<VirtualMachine> CreateContext() const;
+
+  /*!
+   * \brief Invoke a function on an idle execution context.
+   *
+   *  Unlike set_input and invoke, this can be called from several threads at
+   *  once. A context is created when all of them are busy.
+   *
+   * \param func The function.
+   * \param args The arguments to the function.
+   * \return The object representing the result.
+   */
+  ObjectRef InvokeOnContext(const VMFunction& func, const std::vector<ObjectRef>& args);
+
+  /*!
+   * \brief Copy the arguments of a function to the devices of its parameters.
+   * \param vm_func The function.
+   * \param args The packed arguments.
+   * \param offset The position of the first argument of the function in args.
+   * \return The arguments of the function.
+   */
+  std::vector<ObjectRef> ConvertInputs(const VMFunction& vm_func, TVMArgs args, int offset) const;
+
   /*! \brief Push a call frame on to the call stack. */
   void PushFrame(Index arg_count, Index ret_pc, const VMFunction& vm_func);
 
@@ -207,6 +295,25 @@ class VirtualMachine : public runtime::ModuleNode {
    */
   inline int64_t LoadScalarInt(RegName reg) const;
 
+  /*!
+   * \brief Wait for the pending asynchronous writes of a tensor or storage, if any.
+   * \param obj The object to be read on host.
+   */
+  void WaitForData(const ObjectRef& obj) const;
+
+  /*!
+   * \brief Get a CPU tensor holding an integer scalar.
+   *
+   *  The tensors are cached per value, the instructions producing scalars
+   *  only feed them to shape computations and control flow, which never
+   *  write them.
+   *
+   * \param value The scalar.
+   * \param dtype The type of the scalar, int32 or int64.
+   * \return The tensor.
+   */
+  NDArray GetScalarConst(int64_t value, DLDataType dtype);
+
   /*!
    * \brief Invoke a VM function.
    * \param func The function.
@@ -248,6 +355,18 @@ class VirtualMachine : public runtime::ModuleNode {
   /*! \brief Run VM dispatch loop. */
   void RunLoop();
 
+  /*!
+   * \brief Called by the dispatch loop before each instruction while trace_instructions_ is set.
+   * \param instr The instruction, its operands are in the registers of the current frame.
+   */
+  virtual void BeginInstruction(const Instruction& instr) {}
+
+  /*!
+   * \brief Called when the dispatch loop exits, by a return or an exception, while
+   *  trace_instructions_ is set.
+   */
+  virtual void EndRunLoop() {}
+
   /*! \brief Get context from the context list based on a given device type. */
   TVMContext GetContext(Index device_type) const;
 
@@ -283,7 +402,22 @@ class VirtualMachine : public runtime::ModuleNode {
    * \brief The constant pool for runtime. It caches the device dependent
    * object to avoid rellocation of constants during inference.
    */
-  std::vector<ObjectRef> const_pool_;
+  std::shared_ptr<VMConstantPool> const_pool_;
+  /*! \brief The cached int64 scalar tensors of LoadConsti. */
+  std::unordered_map<int64_t, NDArray> scalar_i64_cache_;
+  /*! \brief The cached int32 scalar tensors of GetTag. */
+  std::unordered_map<int64_t, NDArray> scalar_i32_cache_;
+  /*! \brief The argument buffer of the call instructions, reused across calls. */
+  std::vector<ObjectRef> call_args_;
+  /*! \brief Guards the idle execution contexts. */
+  std::mutex context_mutex_;
+  /*! \brief The execution contexts not running any invocation. */
+  std::vector<ObjectPtr<VirtualMachine>> idle_contexts_;
+  class AsyncExecutor;
+  /*! \brief The asynchronous executor, nullptr for synchronous execution. */
+  std::shared_ptr<AsyncExecutor> async_;
+  /*! \brief Whether the dispatch loop calls BeginInstruction and EndRunLoop. */
+  bool trace_instructions_{false};
 };
 
 }  // namespace vm
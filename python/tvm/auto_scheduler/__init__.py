@@ -32,7 +32,7 @@ from . import workload_registry
 
 # Shortcut
 from .compute_dag import ComputeDAG, LayoutRewriteOption, get_shape_from_rewritten_layout
-from .cost_model import RandomModel, XGBModel
+from .cost_model import RandomModel, XGBModel, GBDTModel
 from .dispatcher import DispatchContext, ApplyHistoryBest, ApplyHistoryBestOrSample
 from .measure import (
     MeasureInput,
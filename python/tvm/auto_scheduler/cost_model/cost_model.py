@@ -66,6 +66,122 @@ class RandomModel(CostModel):
         return [x.value for x in _ffi_api.CostModelPredict(self, search_task, states)]
 
 
+@tvm._ffi.register_object("auto_scheduler.GBDTModel")
+class GBDTModel(CostModel):
+    """A model of gradient boosted trees, trained and evaluated in C++.
+
+    As XGBModel, it predicts the score of a program as the sum of the scores of its stores.
+    The trees are trained with a pairwise ranking loss between the measured programs of the
+    same task, so the search does not call into python to predict the scores.
+
+    Parameters
+    ----------
+    max_depth: int = 6
+        The maximum depth of a tree.
+    max_num_trees: int = 200
+        The maximum number of trees. The training stops earlier when the loss does not decrease.
+    learning_rate: float = 0.3
+        The learning rate.
+    num_warmup_sample: int = 100
+        The minimum number of samples to start to use the trained model.
+        If the number of samples is less than this number, the model outputs random predictions.
+    seed: Optional[int]
+        The random seed
+    model_file: Optional[str]
+        If is not None, save model to this file after every update.
+    adapative_training: bool = False
+        Whether to use adapatie training, which reduces the training frequency when there are
+        too many logs.
+    """
+
+    def __init__(
+        self,
+        max_depth=6,
+        max_num_trees=200,
+        learning_rate=0.3,
+        num_warmup_sample=100,
+        seed=None,
+        model_file=None,
+        adapative_training=False,
+    ):
+        self.__init_handle_by_constructor__(
+            _ffi_api.GBDTModel,
+            max_depth,
+            max_num_trees,
+            learning_rate,
+            num_warmup_sample,
+            seed or 43,
+            adapative_training,
+            model_file or "",
+        )
+
+    def update(self, inputs, results):
+        """Update the cost model according to new measurement results (training data).
+
+        Parameters
+        ----------
+        inputs : List[auto_scheduler.measure.MeasureInput]
+            The measurement inputs
+        results : List[auto_scheduler.measure.MeasureResult]
+            The measurement results
+        """
+        _ffi_api.CostModelUpdate(self, inputs, results)
+
+    def predict(self, search_task, states):
+        """Predict the scores of states
+
+        Parameters
+        ----------
+        search_task : SearchTask
+            The search task of states
+        states : List[State]
+            The input states
+
+        Returns
+        -------
+        scores: List[float]
+            The predicted scores for all states
+        """
+        return [x.value for x in _ffi_api.CostModelPredict(self, search_task, states)]
+
+    def update_from_file(self, file_name, n_lines=None):
+        """Load measure records from a log file to update the cost model.
+        This function can be used to pre-train the cost model with history log files.
+
+        Parameters
+        ----------
+        file_name: str
+            The filename
+        n_lines: Optional[int]
+            Only load first n lines of the log file
+        """
+        # pylint: disable=import-outside-toplevel
+        from ..measure_record import RecordReader
+
+        inputs, results = RecordReader(file_name).read_lines(n_lines)
+        self.update(inputs, results)
+
+    def save(self, file_name: str):
+        """Save the model to a binary file
+
+        Parameters
+        ----------
+        file_name: str
+            The filename
+        """
+        _ffi_api.GBDTModelSave(self, file_name)
+
+    def load(self, file_name: str):
+        """Load the model from a binary file, the loaded model is used without warmup
+
+        Parameters
+        ----------
+        file_name: str
+            The filename
+        """
+        _ffi_api.GBDTModelLoad(self, file_name)
+
+
 @tvm._ffi.register_func("auto_scheduler.cost_model.random_fill_float")
 def random_fill_float(size, return_ptr):
     """Fills a c++ float array with random numbers in [0, 1]
@@ -135,6 +135,16 @@ class State:
         """
         return [stage.op for stage in self.stages]
 
+    def fingerprint(self):
+        """Get the 64-bit fingerprint of the transform steps.
+        The states built with the same steps have the same fingerprint.
+
+        Returns
+        -------
+        fingerprint : int
+        """
+        return _ffi_api.StateFingerprint(self.state_object)
+
     def bind(self, stage, iterator, thread_name):
         """Schedule primitive corresponding to `te.Stage.bind`.
         See also the `te.Stage` for more details.
@@ -319,6 +319,13 @@ class LocalBuilder(ProgramBuilder):
         If is 'default', use default build function
         If is 'ndk', use function for android ndk
         If is callable, use it as custom build function, expect lib_format field.
+
+    Note
+    ----
+    When the environment variable TVM_AUTO_SCHEDULER_NATIVE_MEASURE=1 is set, the CPU
+    programs built for the host with the default build function are built natively
+    to shared libraries, in processes forked from C++ rather than through Python
+    multiprocessing.
     """
 
     def __init__(self, timeout=15, n_parallel=multiprocessing.cpu_count(), build_func="default"):
@@ -372,6 +379,11 @@ class LocalRunner(ProgramRunner):
         its actual latency during end-to-end inference.
         To make this option effective, the argument `number` should also be set to 1.
         This is only has effect on CPU task.
+
+    Note
+    ----
+    The shared libraries of the native LocalBuilder, enabled by
+    TVM_AUTO_SCHEDULER_NATIVE_MEASURE=1, are loaded and timed in processes forked from C++.
     """
 
     def __init__(
@@ -184,6 +184,7 @@ class SketchPolicy(SearchPolicy):
         "evolutionary_search_population": 2048,
         "evolutionary_search_num_iters": 4,
         "evolutionary_search_mutation_prob": 0.85,
+        "evolutionary_search_crossover_ratio": 0.05,
         "cpu_multi_level_tiling_structure": "SSRSRS",
         "gpu_multi_level_tiling_structure": "SSSRRSRS",
         # Notice: the default thread bind policy of GPU assumes the tiling structure to have at
@@ -30,7 +30,7 @@ import logging
 import numpy as np
 
 from .search_policy import SearchPolicy, SketchPolicy, PreloadMeasuredStates
-from .cost_model import RandomModel, XGBModel
+from .cost_model import RandomModel, XGBModel, GBDTModel
 from .utils import array_mean
 from .measure import ProgramMeasurer
 from .measure_record import RecordReader
@@ -85,8 +85,9 @@ def make_search_policies(
 
     if isinstance(search_policy, str):
         policy_type, model_type = search_policy.split(".")
-        if model_type == "xgb":
-            cost_model = XGBModel(
+        if model_type in ("xgb", "gbdt"):
+            model_cls = XGBModel if model_type == "xgb" else GBDTModel
+            cost_model = model_cls(
                 num_warmup_sample=len(tasks) * num_measures_per_round,
                 model_file=load_model_file,
                 adapative_training=adapative_training,
@@ -297,6 +298,7 @@ class TaskScheduler:
             If it is str,
             "default" for the default policy (SketchPolicy + XGBModel),
             "sketch.xgb" for SketchPolicy + XGBModel,
+            "sketch.gbdt" for SketchPolicy + GBDTModel,
             "sketch.random" for SketchPolicy + RandomModel.
         search_policy_params : Optional[Dict[str, Any]]
             The parameters of the search policy
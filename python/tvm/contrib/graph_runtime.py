@@ -282,6 +282,19 @@ class GraphModule(object):
         """
         self._load_params(bytearray(params_bytes))
 
+    def load_params_from_file(self, file_name):
+        """Load parameters from a file.
+
+        The parameters of a file saved by :py:func:`tvm.relay.save_param_file`
+        are memory mapped, the ones on CPU are used without a copy.
+
+        Parameters
+        ----------
+        file_name : str
+            The name of the parameter file.
+        """
+        self.module["load_params_from_file"](file_name)
+
     def share_params(self, other, params_bytes):
         """Share parameters from pre-existing GraphRuntime instance.
 
@@ -295,6 +308,47 @@ class GraphModule(object):
         """
         self._share_params(other.module, bytearray(params_bytes))
 
+    def set_inter_op_parallelism(self, num_executors, intra_op_threads=0):
+        """Run the independent nodes of the graph concurrently.
+
+        Parameters
+        ----------
+        num_executors : int
+            The maximum number of nodes running at the same time,
+            1 restores the sequential execution.
+
+        intra_op_threads : int
+            The number of threads each node may use in its parallel loops,
+            0 splits the cores evenly among the executors.
+        """
+        self.module["set_inter_op_parallelism"](num_executors, intra_op_threads)
+
+    def create_shared_instance(self):
+        """Create an instance sharing the graph, the module and the parameters.
+
+        The instance takes its activation memory from a pool shared by all the
+        instances of this module when it is first used, and gives it back on
+        :py:meth:`release_activations`. The parameters must be set with
+        `load_params`, `share_params` or the graph runtime factory before.
+
+        Returns
+        -------
+        instance : GraphModule
+            The new instance.
+        """
+        return GraphModule(self.module["create_shared_instance"]())
+
+    def release_activations(self):
+        """Give the activation memory of a shared instance back to the pool.
+
+        The outputs must be copied out before, as another instance may reuse the memory.
+        """
+        self.module["release_activations"]()
+
+    def get_num_activation_arenas(self):
+        """Get the number of activation arenas allocated for the shared instances."""
+        return self.module["get_num_activation_arenas"]()
+
     def __getitem__(self, key):
         """Get internal module function
 
@@ -304,3 +358,70 @@ class GraphModule(object):
             The key to the module.
         """
         return self.module[key]
+
+
+class GraphBatcher(object):
+    """Serving wrapper that coalesces concurrent requests into the batch of a graph.
+
+    The graph must be compiled for a batch size N, as the first dimension of
+    its non-parameter inputs and of its outputs. Each call to :py:meth:`infer`
+    may come from a different thread and blocks until its rows are computed.
+
+    Parameters
+    ----------
+    module : tvm.runtime.Module
+        The internal batcher module created by :py:func:`create_batcher`.
+    """
+
+    def __init__(self, module):
+        self.module = module
+        self._infer = module["infer"]
+        self._get_batch_size = module["get_batch_size"]
+        self._get_stats = module["get_stats"]
+
+    @property
+    def batch_size(self):
+        """The batch size the graph was compiled for."""
+        return self._get_batch_size()
+
+    def infer(self, *inputs):
+        """Run one request of n <= batch_size rows.
+
+        Parameters
+        ----------
+        inputs : list of NDArray
+            The non-parameter inputs of the graph, in graph order.
+
+        Returns
+        -------
+        outputs : list of NDArray
+            The rows of each output belonging to this request.
+        """
+        return list(self._infer(*inputs))
+
+    def stats(self):
+        """Return the request and batch counters as a JSON string."""
+        return self._get_stats()
+
+
+def create_batcher(factory_module, ctx, max_latency_us=1000):
+    """Create a batching front end from a module built by relay.build.
+
+    Parameters
+    ----------
+    factory_module : GraphRuntimeFactoryModule or tvm.runtime.Module
+        The graph runtime factory module.
+
+    ctx : TVMContext
+        The local context to run the graph on.
+
+    max_latency_us : int
+        The time the oldest queued request may wait for the batch to fill.
+
+    Returns
+    -------
+    batcher : GraphBatcher
+        The batching front end.
+    """
+    ctx = ctx if isinstance(ctx, (list, tuple)) else [ctx]
+    return GraphBatcher(factory_module["batcher_create"](max_latency_us, *ctx))
@@ -157,6 +157,55 @@ def save_json(node):
     return tvm.runtime._ffi_node_api.SaveJSON(node)
 
 
+def save_binary(node, file_name=None):
+    """Save tvm object in the binary format.
+
+    The binary format stores the tensors raw and is much faster to save and
+    load than json for large modules with constants. It can only be loaded
+    by the same TVM version, use :py:func:`save_json` to exchange objects.
+
+    Parameters
+    ----------
+    node : Object
+        A TVM object to be saved.
+
+    file_name : Optional[str]
+        The file to stream the object to.
+
+    Returns
+    -------
+    blob : Optional[bytearray]
+        The saved bytes, when file_name is None.
+    """
+    if file_name is not None:
+        tvm.runtime._ffi_node_api.SaveBinaryFile(file_name, node)
+        return None
+    return tvm.runtime._ffi_node_api.SaveBinary(node)
+
+
+def load_binary(blob=None, file_name=None):
+    """Load tvm object saved by :py:func:`save_binary`.
+
+    A file is memory mapped, and the loaded tensors are views of the mapping.
+
+    Parameters
+    ----------
+    blob : Optional[bytearray]
+        The saved bytes.
+
+    file_name : Optional[str]
+        The saved file.
+
+    Returns
+    -------
+    node : Object
+        The loaded tvm node.
+    """
+    if file_name is not None:
+        return tvm.runtime._ffi_node_api.LoadBinaryFile(file_name)
+    return tvm.runtime._ffi_node_api.LoadBinary(bytearray(blob))
+
+
 def structural_equal(lhs, rhs, map_free_vars=False):
     """Check structural equality of lhs and rhs.
 
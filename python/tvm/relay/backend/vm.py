@@ -81,6 +81,7 @@ class VMCompiler(object):
         self._set_params_func = self.mod["set_params"]
         self._get_params_func = self.mod["get_params"]
         self._optimize = self.mod["optimize"]
+        self._get_storage_stats = self.mod["get_storage_stats"]
 
     def set_params(self, params):
         """Set constant parameters for the model.
@@ -181,6 +182,23 @@ class VMCompiler(object):
         """
         return vm_rt.Executable(self._get_exec())
 
+    def get_storage_stats(self):
+        """Get the statistics of the storage coalescing of the last lowering.
+
+        The coalescing is enabled by the ``relay.vm.coalesce_storage``
+        PassContext option. The peaks only count the storages of constant
+        size and are the largest peak of a single function. The VM holds the
+        storages of a function until it returns, so a peak is the sum of the
+        sizes of the storages the function allocates.
+
+        Returns
+        -------
+        stats : dict of str to int
+            The number of storages, the number of storages reusing a dead one,
+            and the peak bytes before and after the coalescing.
+        """
+        return {k: v.value for k, v in self._get_storage_stats().items()}
+
     def _update_target(self, target):
         """Update target."""
         target = target if target else tvm.target.Target.current()
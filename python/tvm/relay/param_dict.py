@@ -22,6 +22,8 @@ import tvm._ffi
 
 _save_param_dict = tvm._ffi.get_global_func("tvm.relay._save_param_dict")
 _load_param_dict = tvm._ffi.get_global_func("tvm.relay._load_param_dict")
+_save_param_file = tvm._ffi.get_global_func("runtime.SaveParamsToFile")
+_load_param_file = tvm._ffi.get_global_func("runtime.LoadParamsFromFile")
 
 
 def save_param_dict(params):
@@ -76,3 +78,57 @@ def load_param_dict(param_bytes):
         param_bytes = bytearray(param_bytes)
     load_arr = _load_param_dict(param_bytes)
     return {v.name: v.array for v in load_arr}
+
+
+def save_param_file(params, file_name, alignment=128):
+    """Save parameter dictionary to a file that can be memory mapped.
+
+    The data of every parameter starts at an aligned offset of the file, so
+    the file can be loaded without copying the parameters.
+
+    Parameters
+    ----------
+    params : dict of str to NDArray
+        The parameter dictionary.
+
+    file_name : str
+        The name of the file.
+
+    alignment : int
+        The alignment of the parameter data in the file, a power of two of at least 128,
+        the alignment of the runtime allocations.
+
+    Examples
+    --------
+    .. code-block:: python
+
+       relay.save_param_file(params, "deploy_param.bin")
+       # The parameters on CPU are views of the mapped file.
+       graph_runtime_mod.load_params_from_file("deploy_param.bin")
+    """
+    args = [file_name, alignment]
+    for k, v in params.items():
+        args.append(k)
+        args.append(tvm.nd.array(v))
+    _save_param_file(*args)
+
+
+def load_param_file(file_name):
+    """Load parameter dictionary from a file.
+
+    Files written by :py:func:`save_param_file` are memory mapped and the
+    returned arrays are views of the mapping, files written from the bytes of
+    :py:func:`save_param_dict` are copied.
+
+    Parameters
+    ----------
+    file_name : str
+        The name of the file.
+
+    Returns
+    -------
+    params : dict of str to NDArray
+        The parameter dictionary.
+    """
+    items = _load_param_file(file_name)
+    return {str(items[i]): items[i + 1] for i in range(0, len(items), 2)}
@@ -15,6 +15,7 @@
 # specific language governing permissions and limitations
 # under the License.
 """RPC client tools"""
+import json
 import os
 import stat
 import socket
@@ -197,6 +198,18 @@ class RPCSession(object):
             )
         return self._remote_funcs["download_linked_module"](path)
 
+    def compression_stats(self):
+        """Get the counters of the compressed channel of the session.
+
+        Returns
+        -------
+        stats : dict
+            The bytes sent and received before and after compression and the
+            number of blocks sent compressed and raw, empty when the channel
+            is not compressed.
+        """
+        return json.loads(_ffi_api.GetCompressionStats(self._sess))
+
     def cpu(self, dev_id=0):
         """Construct CPU device."""
         return self.context(1, dev_id)
@@ -491,6 +504,16 @@ def connect(url, port, key="", session_timeout=0, session_constructor_args=None)
             session_constructor_args=[
                 "rpc.Connect", internal_url, internal_port, internal_key])
 
+    With ``TVM_RPC_COMPRESSION=lz`` set in the client environment, the bytes
+    exchanged with a server that supports it are compressed, except the blocks
+    that do not compress such as random float tensors. A comma separated list
+    of codecs picks the first one the server supports. See
+    :py:meth:`RPCSession.compression_stats` for the saving.
+
+    With ``TVM_RPC_MULTIPLEX=1`` set in the client environment, the connection
+    to a server that supports it is multiplexed: the requests of different
+    threads, such as uploading the next module while timing the current one,
+    are in flight at the same time instead of one after the other.
     """
     try:
         if session_timeout:
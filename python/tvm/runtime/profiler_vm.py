@@ -60,3 +60,43 @@ class VirtualMachineProfiler(vm.VirtualMachine):
 
     def reset(self):
         self._reset()
+
+    def start_trace(self):
+        """Start recording a timeline of every instruction executed.
+
+        Each instruction is recorded with its start, its duration, the shapes
+        of its arguments and, for allocations and device copies, its bytes.
+        The kernels are synchronized with their device when they complete, so
+        trace with the synchronous execution of the VM.
+        """
+        self.module["start_trace"]()
+
+    def stop_trace(self):
+        """Stop recording the timeline, the recorded events are kept."""
+        self.module["stop_trace"]()
+
+    def get_trace(self):
+        """Get the recorded timeline in the Chrome trace event format.
+
+        The result can be saved to a file and opened in chrome://tracing or
+        Perfetto. The instructions and the functions are complete events, the
+        bytes allocated and copied since the trace started are counters.
+
+        Returns
+        -------
+        trace : str
+            The trace as a JSON array of events.
+        """
+        return self.module["get_trace"]()
+
+    def get_trace_summary(self):
+        """Get the total duration of the recorded instructions per category and name.
+
+        The categories are kernel, shape_func, alloc, copy, call and interpreter.
+
+        Returns
+        -------
+        summary : str
+            The summary table.
+        """
+        return self.module["get_trace_summary"]()
@@ -170,6 +170,46 @@ class Executable(object):
 
         return Executable(_ffi_api.Load_Executable(bytecode, lib))
 
+    def save_to_file(self, path, alignment=128):
+        """Save the Relay VM Executable to a file that can be memory mapped.
+
+        The constants start at aligned offsets of the file and every function
+        has its own code section, so :py:meth:`load_exec_from_file` maps the
+        file and decodes each function when it is first invoked.
+
+        Parameters
+        ----------
+        path : str
+            The name of the file.
+
+        alignment : int
+            The alignment of the constants in the file, a power of two of at
+            least 128, the alignment of the runtime allocations.
+        """
+        self.mod["save_to_file"](path, alignment)
+
+    @staticmethod
+    def load_exec_from_file(path, lib):
+        """Load an executable saved by :py:meth:`save_to_file`.
+
+        The constants on CPU are views of the mapped file, so the processes
+        serving the same executable share its pages.
+
+        Parameters
+        ----------
+        path : str
+            The name of the file.
+
+        lib : :py:class:`~tvm.runtime.Module`
+            The runtime module that contains the generated code.
+
+        Returns
+        -------
+        exec: Executable
+            The lazily loaded executable.
+        """
+        return Executable(_ffi_api.Load_ExecutableFromFile(path, lib))
+
     @property
     def lib(self):
         """Get the library that contains hardware dependent code.
@@ -309,6 +349,7 @@ class VirtualMachine(object):
         self._init = self.module["init"]
         self._invoke = self.module["invoke"]
         self._set_input = self.module["set_input"]
+        self._invoke_with_args = self.module["invoke_with_args"]
         self._setup_ctx(ctx, memory_cfg)
 
     def _setup_ctx(self, ctx, memory_cfg):
@@ -347,20 +388,8 @@ class VirtualMachine(object):
             init_args.append(alloc_type)
         self._init(*init_args)
 
-    def set_input(self, func_name, *args, **kwargs):
-        """Set the input to a function.
-
-        Parameters
-        ----------
-        func_name : str
-            The name of the function.
-
-        args : list[tvm.runtime.NDArray] or list[np.ndarray]
-            The arguments to the function.
-
-        kwargs: dict of str to tvm.runtime.NDArray or np.ndarray
-            Named arguments to the function.
-        """
+    def _convert_args(self, func_name, args, kwargs):
+        """Order the positional and named arguments as the function parameters."""
         if kwargs:
             # kwargs is a super set of the required function parameters. We
             # only find the ones that are needed.
@@ -379,7 +408,23 @@ class VirtualMachine(object):
                     new_args[i] = args[idx]
                     idx += 1
             args = new_args
-        cargs = convert(args)
+        return convert(args)
+
+    def set_input(self, func_name, *args, **kwargs):
+        """Set the input to a function.
+
+        Parameters
+        ----------
+        func_name : str
+            The name of the function.
+
+        args : list[tvm.runtime.NDArray] or list[np.ndarray]
+            The arguments to the function.
+
+        kwargs: dict of str to tvm.runtime.NDArray or np.ndarray
+            Named arguments to the function.
+        """
+        cargs = self._convert_args(func_name, args, kwargs)
         self._set_input(func_name, *cargs)
 
     def invoke(self, func_name, *args, **kwargs):
@@ -405,6 +450,52 @@ class VirtualMachine(object):
             self.set_input(func_name, *args, **kwargs)
         return self._invoke(func_name)
 
+    def invoke_with_args(self, func_name, *args, **kwargs):
+        """Invoke a function with its arguments, safe to call from several threads.
+
+        The invocations run on execution contexts that share the constants
+        and the compiled functions of this virtual machine, so concurrent
+        requests keep a single copy of the weights.
+
+        Parameters
+        ----------
+        func_name : str
+            The name of the function.
+
+        args : list[tvm.runtime.NDArray] or list[np.ndarray]
+            The arguments to the function.
+
+        kwargs: dict of str to tvm.runtime.NDArray or np.ndarray
+            Named arguments to the function.
+
+        Returns
+        -------
+        result : Object
+            The output.
+        """
+        cargs = self._convert_args(func_name, args, kwargs)
+        return self._invoke_with_args(func_name, *cargs)
+
+    def set_async_execution(self, num_workers, intra_op_threads=0):
+        """Overlap the kernels and the device copies of the invocations.
+
+        The kernels on CPU run on worker threads and the device copies on a
+        copy thread, each one as soon as the kernels and copies touching the
+        same buffers before it are done. :py:meth:`invoke_with_args` keeps the
+        synchronous execution.
+
+        Parameters
+        ----------
+        num_workers : int
+            The number of worker threads running kernels, 0 restores the
+            synchronous execution.
+
+        intra_op_threads : int
+            The number of threads each kernel may use in its parallel loops,
+            0 splits the cores evenly among the workers.
+        """
+        self.module["set_async_execution"](num_workers, intra_op_threads)
+
     def run(self, *args, **kwargs):
         """Run the main function.
 
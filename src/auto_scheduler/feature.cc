@@ -37,8 +37,13 @@
 
 #include <algorithm>
 #include <cmath>
+#include <list>
+#include <mutex>
 #include <numeric>
+#include <sstream>
+#include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "search_policy/utils.h"
@@ -1262,12 +1267,291 @@ void GetPerStoreFeatureName(int max_n_bufs, std::vector<std::string>* ret) {
   // section total : 3
 }
 
+/*!
+ * \brief A least recently used map bounded by the bytes of its entries, safe to share between
+ *  threads.
+ */
+template <typename V>
+class LRUCache {
+ public:
+  explicit LRUCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+  bool Get(const std::string& key, V* value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return false;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    *value = it->second->value;
+    return true;
+  }
+
+  /*!
+   * \brief Put an entry, evicting the least recently used ones beyond the byte budget.
+   * \param key The key.
+   * \param value The value.
+   * \param bytes The bytes held by the entry, with its key.
+   */
+  void Put(const std::string& key, V value, size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      total_bytes_ -= it->second->bytes;
+      entries_.erase(it->second);
+      index_.erase(it);
+    }
+    entries_.push_front(Entry{key, std::move(value), bytes});
+    index_[key] = entries_.begin();
+    total_bytes_ += bytes;
+    while (total_bytes_ > max_bytes_ && !entries_.empty()) {
+      total_bytes_ -= entries_.back().bytes;
+      index_.erase(entries_.back().key);
+      entries_.pop_back();
+    }
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    V value;
+    size_t bytes;
+  };
+  size_t max_bytes_;
+  size_t total_bytes_{0};
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, typename std::list<Entry>::iterator> index_;
+  std::mutex mutex_;
+};
+
+/*!
+ * \brief Whether the first n steps of two step arrays are the same.
+ *  The step objects shared by the states are the same, the others are compared by their binary
+ *  encoding, so that a collision of the fingerprints in the cache keys is never taken as a hit.
+ */
+bool SameStepPrefix(const Array<Step>& a, const Array<Step>& b, size_t n) {
+  if (a.size() < n || b.size() < n) {
+    return false;
+  }
+  std::string lhs, rhs;
+  for (size_t i = 0; i < n; ++i) {
+    if (a[i].same_as(b[i])) {
+      continue;
+    }
+    lhs.clear();
+    rhs.clear();
+    StepWriteToBinary(a[i], &lhs);
+    StepWriteToBinary(b[i], &rhs);
+    if (lhs != rhs) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * \brief The schedule of a task after some of the transform steps of a state.
+ *  It is never modified once cached, users apply their steps to a copy.
+ */
+struct ScheduleCheckpoint {
+  /*! \brief The task, held to keep its address unique while cached. */
+  SearchTask task;
+  /*! \brief The steps applied, checked against the state on a hit. */
+  Array<Step> steps;
+  te::Schedule schedule;
+  Array<te::Stage> stages;
+  StageToAxesMap stage_to_axes;
+
+  /*! \brief An estimate of the bytes held by the schedule, from the number of its nodes. */
+  size_t EstimateBytes() const {
+    // The typical size of an IterVar or a relation with the expressions it refers to.
+    constexpr size_t kNodeBytes = 256;
+    size_t num_nodes = 0;
+    for (const auto& stage : schedule->stages) {
+      num_nodes += 1 + stage->all_iter_vars.size() + stage->relations.size() +
+                   stage->iter_var_attrs.size();
+    }
+    // The steps are mostly shared with the states, only their references are counted.
+    return num_nodes * kNodeBytes + steps.size() * sizeof(Step);
+  }
+};
+
+/*! \brief The features of a state, with its task and steps held as in ScheduleCheckpoint. */
+struct CachedFeature {
+  SearchTask task;
+  Array<Step> steps;
+  std::vector<float> feature;
+};
+
+/*!
+ * \brief Caches of feature extraction.
+ *  The states of a search are mutations of each other, so they share long prefixes of steps and
+ *  the same states are often extracted again. The schedule after every kCheckpointInterval steps
+ *  is kept, a state replays its steps from the longest cached prefix. The features of the whole
+ *  states are kept too, they skip the lowering. Both caches are bounded by bytes, the tasks they
+ *  hold are released with their last entries. Setting TVM_AUTO_SCHEDULER_FEATURE_CACHE=0
+ *  disables both.
+ */
+class FeatureExtractionCache {
+ public:
+  static constexpr int kCheckpointInterval = 4;
+  /*! \brief The byte budget of the schedule checkpoints, as estimated by EstimateBytes. */
+  static constexpr size_t kMaxScheduleBytes = 256 << 20;
+  /*! \brief The byte budget of the features. */
+  static constexpr size_t kMaxFeatureBytes = 64 << 20;
+
+  static FeatureExtractionCache* Global() {
+    static FeatureExtractionCache* inst = new FeatureExtractionCache();
+    return inst;
+  }
+
+  bool enabled() const { return enabled_; }
+
+  /*!
+   * \brief Get the key of each prefix of the steps of a state.
+   *  The keys chain the fingerprints of the steps, so they take time linear in the steps. The
+   *  fingerprints may collide, the entries keep their steps and a hit compares them.
+   * \return keys[i] locates the first i steps of the state on the task.
+   */
+  static std::vector<std::string> PrefixKeys(const SearchTask& task, const State& state) {
+    std::ostringstream os;
+    os << static_cast<const void*>(task.get()) << '/';
+    const std::string task_key = os.str();
+    uint64_t fingerprint = State::kInitialFingerprint;
+    std::vector<std::string> keys;
+    keys.reserve(state->transform_steps.size() + 1);
+    keys.push_back(task_key + "0/" + std::to_string(fingerprint));
+    for (const auto& step : state->transform_steps) {
+      fingerprint = StepFingerprint(fingerprint, step);
+      keys.push_back(task_key + std::to_string(keys.size()) + "/" + std::to_string(fingerprint));
+    }
+    return keys;
+  }
+
+  bool GetFeature(const std::string& key, const State& state, std::vector<float>* feature) {
+    CachedFeature entry;
+    const Array<Step>& steps = state->transform_steps;
+    if (!features_.Get(key, &entry) || entry.steps.size() != steps.size() ||
+        !SameStepPrefix(entry.steps, steps, steps.size())) {
+      return false;
+    }
+    *feature = std::move(entry.feature);
+    return true;
+  }
+
+  void PutFeature(const std::string& key, const SearchTask& task, const State& state,
+                  const std::vector<float>& feature) {
+    const Array<Step>& steps = state->transform_steps;
+    size_t bytes = key.size() + steps.size() * sizeof(Step) + feature.size() * sizeof(float);
+    features_.Put(key, CachedFeature{task, steps, feature}, bytes);
+  }
+
+  /*!
+   * \brief Apply the steps of a state as ComputeDAG::ApplySteps without layout rewrite, starting
+   *  from the longest cached prefix and caching the checkpoints it passes.
+   */
+  std::pair<te::Schedule, Array<te::Tensor>> ApplySteps(const SearchTask& task,
+                                                        const State& state,
+                                                        const std::vector<std::string>& keys) {
+    const Array<Step>& steps = state->transform_steps;
+    te::Schedule schedule;
+    Array<te::Stage> stages;
+    StageToAxesMap stage_to_axes;
+    size_t begin = 0;
+    for (size_t i = steps.size() / kCheckpointInterval * kCheckpointInterval; i > 0;
+         i -= kCheckpointInterval) {
+      ScheduleCheckpoint checkpoint;
+      if (schedules_.Get(keys[i], &checkpoint) && SameStepPrefix(checkpoint.steps, steps, i) &&
+          CopySchedule(checkpoint.schedule, checkpoint.stages, checkpoint.stage_to_axes,
+                       &schedule, &stages, &stage_to_axes)) {
+        begin = i;
+        break;
+      }
+    }
+    if (begin == 0) {
+      schedule = task->compute_dag.ApplySteps({}, &stages, &stage_to_axes).first;
+    }
+    for (size_t i = begin; i < steps.size(); ++i) {
+      StepApplyToSchedule(steps[i], &stages, &stage_to_axes, &schedule, steps);
+      if ((i + 1) % kCheckpointInterval == 0 && i + 1 < steps.size()) {
+        ScheduleCheckpoint checkpoint;
+        checkpoint.task = task;
+        checkpoint.steps = Array<Step>(steps.begin(), steps.begin() + i + 1);
+        if (CopySchedule(schedule, stages, stage_to_axes, &checkpoint.schedule,
+                         &checkpoint.stages, &checkpoint.stage_to_axes)) {
+          size_t bytes = keys[i + 1].size() + checkpoint.EstimateBytes();
+          schedules_.Put(keys[i + 1], std::move(checkpoint), bytes);
+        }
+      }
+    }
+    return std::make_pair(schedule, task->compute_dag->tensors);
+  }
+
+ private:
+  FeatureExtractionCache() : schedules_(kMaxScheduleBytes), features_(kMaxFeatureBytes) {
+    const char* env = getenv("TVM_AUTO_SCHEDULER_FEATURE_CACHE");
+    enabled_ = env == nullptr || std::string(env) != "0";
+  }
+
+  // Copy a schedule and point the stages and the axes map to the stages of the copy.
+  // Return false if a stage is not in the schedule.
+  static bool CopySchedule(const te::Schedule& schedule, const Array<te::Stage>& stages,
+                           const StageToAxesMap& stage_to_axes, te::Schedule* out_schedule,
+                           Array<te::Stage>* out_stages, StageToAxesMap* out_stage_to_axes) {
+    te::Schedule copy = schedule.copy();
+    // The copy keeps the order of the stages.
+    std::unordered_map<const Object*, te::Stage> stage_map;
+    for (size_t i = 0; i < schedule->stages.size(); ++i) {
+      stage_map[schedule->stages[i].get()] = copy->stages[i];
+    }
+    Array<te::Stage> new_stages;
+    for (const auto& stage : stages) {
+      auto it = stage_map.find(stage.get());
+      if (it == stage_map.end()) {
+        return false;
+      }
+      new_stages.push_back(it->second);
+    }
+    StageToAxesMap new_stage_to_axes;
+    for (const auto& kv : stage_to_axes) {
+      // Stages removed from the schedule can not be reached any more.
+      auto it = stage_map.find(kv.first.get());
+      if (it != stage_map.end()) {
+        new_stage_to_axes.Set(it->second, kv.second);
+      }
+    }
+    *out_schedule = std::move(copy);
+    *out_stages = std::move(new_stages);
+    *out_stage_to_axes = std::move(new_stage_to_axes);
+    return true;
+  }
+
+  bool enabled_;
+  LRUCache<ScheduleCheckpoint> schedules_;
+  LRUCache<CachedFeature> features_;
+};
+
 void GetPerStoreFeaturesWorkerFunc(const SearchTask& task, const State& state, int max_n_bufs,
                                    std::vector<float>* feature, std::atomic<int>* error_ct) {
+  FeatureExtractionCache* cache = FeatureExtractionCache::Global();
+  std::vector<std::string> keys;
+  std::string feature_key;
+  if (cache->enabled()) {
+    keys = FeatureExtractionCache::PrefixKeys(task, state);
+    feature_key = keys.back() + "/" + std::to_string(max_n_bufs);
+    if (cache->GetFeature(feature_key, state, feature)) {
+      return;
+    }
+  }
+
   te::Schedule sch;
   Array<te::Tensor> tensors;
 
-  std::tie(sch, tensors) = task->compute_dag.ApplySteps(state->transform_steps);
+  if (cache->enabled()) {
+    std::tie(sch, tensors) = cache->ApplySteps(task, state, keys);
+  } else {
+    std::tie(sch, tensors) = task->compute_dag.ApplySteps(state->transform_steps);
+  }
   sch = sch.normalize_for_feature_extraction();
   auto bounds = te::InferBound(sch);
 
@@ -1328,6 +1612,10 @@ void GetPerStoreFeaturesWorkerFunc(const SearchTask& task, const State& state, i
     const auto& prim_func = (*it).second.as<PrimFuncNode>();
     GetPerStoreFeature(prim_func->body, task->hardware_params->cache_line_bytes, max_n_bufs,
                        feature);
+    // Only successful extractions are cached, a failing state is counted again.
+    if (cache->enabled()) {
+      cache->PutFeature(feature_key, task, state, *feature);
+    }
   } catch (dmlc::Error& e) {
     (*error_ct)++;
   }
@@ -0,0 +1,557 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file auto_scheduler/gbdt_model.cc
+ * \brief A cost model of gradient boosted trees trained with a pairwise ranking loss.
+ *
+ *  The rows of the training set are the stores of the measured states. The score of a state is
+ *  the sum of the predictions for its stores, as in the pack-sum loss of XGBModel. For each
+ *  state a few other states of the same task are drawn, and the logistic loss of the difference
+ *  of their scores is minimized, weighted by the normalized throughput of the faster state.
+ *  The trees are grown level by level on histograms of the features binned by their quantiles.
+ */
+
+#include <dmlc/memory_io.h>
+#include <tvm/auto_scheduler/cost_model.h>
+#include <tvm/auto_scheduler/feature.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/support/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../runtime/file_utils.h"
+
+namespace tvm {
+namespace auto_scheduler {
+
+TVM_REGISTER_OBJECT_TYPE(GBDTModelNode);
+
+namespace {
+
+// The maximum number of buffers in the features, as DEFAULT_MAX_N_BUFS in feature.py.
+constexpr int kMaxNBufs = 5;
+// The maximum number of bins of a feature.
+constexpr int kMaxBins = 64;
+// The number of states drawn to pair with each state.
+constexpr int kPairsPerState = 8;
+// Training stops when the loss has not decreased by this ratio for kEarlyStoppingRounds trees.
+constexpr double kEarlyStoppingRatio = 1e-4;
+constexpr int kEarlyStoppingRounds = 10;
+// One pair out of kValidationInterval is held out to measure the loss of the early stopping.
+constexpr int kValidationInterval = 5;
+// The L2 regularization of the leaf values and the minimum hessian of a leaf.
+constexpr double kLambda = 1.0;
+constexpr double kMinChildWeight = 1e-3;
+// The number of stores walking a tree together in the prediction.
+constexpr int kPredictBlock = 16;
+// The magic number of the model files.
+constexpr uint64_t kGBDTModelMagic = 0x4754424440534154;
+
+/*! \brief The stores of the training set, with their features binned by quantiles. */
+struct BinnedMatrix {
+  int num_rows{0};
+  int num_features{0};
+  /*! \brief The bin of a value of feature f is the number of cuts[f] smaller than the value. */
+  std::vector<std::vector<float>> cuts;
+  /*! \brief The bins in column major order, bins[f * num_rows + r]. */
+  std::vector<uint8_t> bins;
+};
+
+BinnedMatrix BinFeatures(const std::vector<float>& rows, int num_rows, int num_features) {
+  BinnedMatrix ret;
+  ret.num_rows = num_rows;
+  ret.num_features = num_features;
+  ret.cuts.resize(num_features);
+  ret.bins.resize(static_cast<size_t>(num_rows) * num_features);
+  support::parallel_for(0, num_features, [&](int f) {
+    std::vector<float> values(num_rows);
+    for (int r = 0; r < num_rows; ++r) {
+      values[r] = rows[static_cast<size_t>(r) * num_features + f];
+    }
+    std::sort(values.begin(), values.end());
+    std::vector<float>& cuts = ret.cuts[f];
+    for (int b = 1; b < kMaxBins; ++b) {
+      float cut = values[static_cast<size_t>(num_rows - 1) * b / kMaxBins];
+      if ((cuts.empty() || cut > cuts.back()) && cut < values.back()) {
+        cuts.push_back(cut);
+      }
+    }
+    uint8_t* bins = &ret.bins[static_cast<size_t>(f) * num_rows];
+    for (int r = 0; r < num_rows; ++r) {
+      float value = rows[static_cast<size_t>(r) * num_features + f];
+      bins[r] = std::lower_bound(cuts.begin(), cuts.end(), value) - cuts.begin();
+    }
+  });
+  return ret;
+}
+
+/*! \brief A node of the tree being grown, with its stores rows[begin, end). */
+struct GrowingNode {
+  int node;
+  size_t begin, end;
+  double grad, hess;
+};
+
+/*! \brief The best split of a node on a feature, the stores with bin <= bin go to the child. */
+struct Split {
+  double gain{0};
+  int feature{-1};
+  int bin{-1};
+  double left_grad{0}, left_hess{0};
+};
+
+double LeafObjective(double grad, double hess) { return grad * grad / (hess + kLambda); }
+
+int AddNode(GBDTModelNode* model) {
+  int node = static_cast<int>(model->child.size());
+  model->split_feature.push_back(0);
+  model->split_threshold.push_back(std::numeric_limits<float>::infinity());
+  model->child.push_back(node);
+  model->leaf_value.push_back(0);
+  return node;
+}
+
+// Grow a tree on the gradients of the stores, append it to the model and add its predictions to
+// the predictions of the stores.
+void GrowTree(const BinnedMatrix& data, const std::vector<double>& grad,
+              const std::vector<double>& hess, GBDTModelNode* model,
+              std::vector<double>* row_preds) {
+  std::vector<int32_t> rows(data.num_rows);
+  double total_grad = 0, total_hess = 0;
+  for (int r = 0; r < data.num_rows; ++r) {
+    rows[r] = r;
+    total_grad += grad[r];
+    total_hess += hess[r];
+  }
+  model->tree_begin.push_back(static_cast<int32_t>(model->child.size()));
+  std::vector<GrowingNode> level{{AddNode(model), 0, rows.size(), total_grad, total_hess}};
+  std::vector<GrowingNode> leaves;
+  int depth = 0;
+
+  while (!level.empty()) {
+    std::vector<Split> splits(level.size() * data.num_features);
+    if (depth < model->max_depth) {
+      support::parallel_for(0, data.num_features, [&](int f) {
+        const uint8_t* bins = &data.bins[static_cast<size_t>(f) * data.num_rows];
+        int num_bins = static_cast<int>(data.cuts[f].size()) + 1;
+        std::vector<double> hist_grad(num_bins), hist_hess(num_bins);
+        for (size_t n = 0; n < level.size(); ++n) {
+          const GrowingNode& node = level[n];
+          std::fill(hist_grad.begin(), hist_grad.end(), 0.0);
+          std::fill(hist_hess.begin(), hist_hess.end(), 0.0);
+          for (size_t i = node.begin; i < node.end; ++i) {
+            hist_grad[bins[rows[i]]] += grad[rows[i]];
+            hist_hess[bins[rows[i]]] += hess[rows[i]];
+          }
+          Split& best = splits[n * data.num_features + f];
+          double parent = LeafObjective(node.grad, node.hess);
+          double left_grad = 0, left_hess = 0;
+          for (int b = 0; b + 1 < num_bins; ++b) {
+            left_grad += hist_grad[b];
+            left_hess += hist_hess[b];
+            double right_grad = node.grad - left_grad, right_hess = node.hess - left_hess;
+            if (left_hess < kMinChildWeight || right_hess < kMinChildWeight) {
+              continue;
+            }
+            double gain = LeafObjective(left_grad, left_hess) +
+                          LeafObjective(right_grad, right_hess) - parent;
+            if (gain > best.gain) {
+              best = Split{gain, f, b, left_grad, left_hess};
+            }
+          }
+        }
+      });
+    }
+
+    std::vector<GrowingNode> next_level;
+    for (size_t n = 0; n < level.size(); ++n) {
+      const GrowingNode& node = level[n];
+      Split best;
+      for (int f = 0; f < data.num_features; ++f) {
+        if (splits[n * data.num_features + f].gain > best.gain) {
+          best = splits[n * data.num_features + f];
+        }
+      }
+      if (best.feature < 0) {
+        leaves.push_back(node);
+        continue;
+      }
+      const uint8_t* bins = &data.bins[static_cast<size_t>(best.feature) * data.num_rows];
+      auto mid = std::stable_partition(rows.begin() + node.begin, rows.begin() + node.end,
+                                       [&](int32_t r) { return bins[r] <= best.bin; });
+      size_t split = mid - rows.begin();
+      // The children are added next to each other.
+      int left = AddNode(model);
+      AddNode(model);
+      model->split_feature[node.node] = best.feature;
+      model->split_threshold[node.node] = data.cuts[best.feature][best.bin];
+      model->child[node.node] = left;
+      next_level.push_back({left, node.begin, split, best.left_grad, best.left_hess});
+      next_level.push_back({left + 1, split, node.end, node.grad - best.left_grad,
+                            node.hess - best.left_hess});
+    }
+    level = std::move(next_level);
+    if (!level.empty()) {
+      ++depth;
+    }
+  }
+  model->tree_depth.push_back(depth);
+
+  for (const GrowingNode& leaf : leaves) {
+    double value = -leaf.grad / (leaf.hess + kLambda) * model->learning_rate;
+    model->leaf_value[leaf.node] = static_cast<float>(value);
+    for (size_t i = leaf.begin; i < leaf.end; ++i) {
+      (*row_preds)[rows[i]] += value;
+    }
+  }
+}
+
+// Keep only the first num_trees trees of the model.
+void TruncateTrees(GBDTModelNode* model, size_t num_trees) {
+  if (num_trees >= model->tree_begin.size()) {
+    return;
+  }
+  size_t num_nodes = model->tree_begin[num_trees];
+  model->tree_begin.resize(num_trees);
+  model->tree_depth.resize(num_trees);
+  model->split_feature.resize(num_nodes);
+  model->split_threshold.resize(num_nodes);
+  model->child.resize(num_nodes);
+  model->leaf_value.resize(num_nodes);
+}
+
+/*! \brief Two states of the same task, the first one is faster. */
+struct StatePair {
+  int faster, slower;
+  double weight;
+};
+
+// The logistic loss of ranking a pair whose score difference is diff.
+double PairLoss(double diff) {
+  return diff > 0 ? std::log1p(std::exp(-diff)) : std::log1p(std::exp(diff)) - diff;
+}
+
+// Train the trees on the stores of the states, each state being a range of rows. The trees are
+// grown on most of the pairs, and the model keeps the number of trees with the lowest loss on the
+// held out pairs.
+void Train(const std::vector<float>& rows, int num_features,
+           const std::vector<std::pair<size_t, size_t>>& state_rows,
+           const std::vector<StatePair>& pairs, GBDTModelNode* model) {
+  int num_rows = static_cast<int>(rows.size() / num_features);
+  BinnedMatrix data = BinFeatures(rows, num_rows, num_features);
+  std::vector<double> row_preds(num_rows, 0.0), grad(num_rows), hess(num_rows);
+  std::vector<double> state_preds(state_rows.size()), state_grad(state_rows.size()),
+      state_hess(state_rows.size());
+
+  std::vector<StatePair> train_pairs, valid_pairs;
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    if (i % kValidationInterval == kValidationInterval - 1) {
+      valid_pairs.push_back(pairs[i]);
+    } else {
+      train_pairs.push_back(pairs[i]);
+    }
+  }
+  // Too few pairs to hold some out, the early stopping watches the training loss.
+  bool has_valid = !valid_pairs.empty();
+
+  double best_loss = std::numeric_limits<double>::infinity();
+  int best_round = 0;
+  // The loss measured at a round is the one of the trees grown before it.
+  for (int round = 0; round <= model->max_num_trees; ++round) {
+    for (size_t i = 0; i < state_rows.size(); ++i) {
+      state_preds[i] = 0;
+      for (size_t r = state_rows[i].first; r < state_rows[i].second; ++r) {
+        state_preds[i] += row_preds[r];
+      }
+    }
+    std::fill(state_grad.begin(), state_grad.end(), 0.0);
+    std::fill(state_hess.begin(), state_hess.end(), 0.0);
+    double loss = 0;
+    for (const StatePair& pair : train_pairs) {
+      double diff = state_preds[pair.faster] - state_preds[pair.slower];
+      // p is the probability that the model ranks the pair wrong.
+      double p = 1.0 / (1.0 + std::exp(diff));
+      loss += pair.weight * PairLoss(diff);
+      state_grad[pair.faster] -= pair.weight * p;
+      state_grad[pair.slower] += pair.weight * p;
+      state_hess[pair.faster] += pair.weight * p * (1 - p);
+      state_hess[pair.slower] += pair.weight * p * (1 - p);
+    }
+    if (has_valid) {
+      loss = 0;
+      for (const StatePair& pair : valid_pairs) {
+        loss += pair.weight * PairLoss(state_preds[pair.faster] - state_preds[pair.slower]);
+      }
+    }
+    if (loss < best_loss * (1 - kEarlyStoppingRatio)) {
+      best_loss = loss;
+      best_round = round;
+    } else if (round - best_round >= kEarlyStoppingRounds) {
+      break;
+    }
+    if (round == model->max_num_trees) {
+      break;
+    }
+    for (size_t i = 0; i < state_rows.size(); ++i) {
+      for (size_t r = state_rows[i].first; r < state_rows[i].second; ++r) {
+        grad[r] = state_grad[i];
+        hess[r] = state_hess[i];
+      }
+    }
+    GrowTree(data, grad, hess, model, &row_preds);
+  }
+  // The trees after the best round did not improve the loss. One tree is kept at least, a model
+  // without trees falls back to random predictions.
+  TruncateTrees(model, std::max(best_round, 1));
+}
+
+}  // namespace
+
+GBDTModel::GBDTModel(int max_depth, int max_num_trees, double learning_rate,
+                     int num_warmup_sample, int seed, bool adaptive_training, String model_file) {
+  ICHECK(max_depth > 0 && max_depth < 30) << "Invalid max_depth: " << max_depth;
+  auto node = make_object<GBDTModelNode>();
+  node->max_depth = max_depth;
+  node->max_num_trees = max_num_trees;
+  node->learning_rate = learning_rate;
+  node->num_warmup_sample = num_warmup_sample;
+  node->adaptive_training = adaptive_training;
+  node->model_file = std::move(model_file);
+  node->rand_gen = std::mt19937(seed);
+  data_ = std::move(node);
+}
+
+void GBDTModelNode::Update(const Array<MeasureInput>& new_inputs,
+                           const Array<MeasureResult>& new_results) {
+  if (new_inputs.empty()) {
+    return;
+  }
+  ICHECK_EQ(new_inputs.size(), new_results.size());
+  for (size_t i = 0; i < new_inputs.size(); ++i) {
+    inputs.push_back(new_inputs[i]);
+    results.push_back(new_results[i]);
+  }
+  if (adaptive_training && inputs.size() - last_train_length < last_train_length / 5) {
+    // Train less often when there are many measured states, as XGBModel.
+    return;
+  }
+  last_train_length = inputs.size();
+
+  // The normalized throughputs change with the measured states, only the features are kept.
+  std::vector<std::vector<float>> new_features;
+  std::vector<float> throughputs;
+  std::vector<int> task_ids;
+  size_t n_cached = features.size();
+  GetPerStoreFeaturesFromMeasurePairs(inputs, results, n_cached, kMaxNBufs, &new_features,
+                                      &throughputs, &task_ids);
+  std::move(features.begin(), features.begin() + std::min(n_cached, new_features.size()),
+            new_features.begin());
+  features = std::move(new_features);
+
+  // Gather the stores of the states that were lowered.
+  std::vector<std::string> names;
+  GetPerStoreFeatureName(kMaxNBufs, &names);
+  int n_features = static_cast<int>(names.size());
+  std::vector<float> rows;
+  std::vector<std::pair<size_t, size_t>> state_rows;
+  std::vector<float> state_throughputs;
+  std::vector<std::vector<int>> task_states;
+  for (size_t i = 0; i < features.size(); ++i) {
+    const std::vector<float>& feature = features[i];
+    if (feature.empty() || feature[0] == 0) {
+      continue;
+    }
+    size_t n_stores = static_cast<size_t>(feature[0]);
+    ICHECK_EQ(feature.size(), 1 + n_stores * n_features);
+    size_t row_begin = rows.size() / n_features;
+    rows.insert(rows.end(), feature.begin() + 1, feature.end());
+    if (task_ids[i] >= static_cast<int>(task_states.size())) {
+      task_states.resize(task_ids[i] + 1);
+    }
+    task_states[task_ids[i]].push_back(static_cast<int>(state_rows.size()));
+    state_rows.emplace_back(row_begin, row_begin + n_stores);
+    state_throughputs.push_back(throughputs[i]);
+  }
+
+  std::vector<StatePair> pairs;
+  for (const std::vector<int>& states : task_states) {
+    if (states.size() < 2) {
+      continue;
+    }
+    std::uniform_int_distribution<size_t> dist(0, states.size() - 1);
+    for (int i : states) {
+      for (int k = 0; k < kPairsPerState; ++k) {
+        int j = states[dist(rand_gen)];
+        if (state_throughputs[i] > state_throughputs[j]) {
+          pairs.push_back({i, j, state_throughputs[i]});
+        } else if (state_throughputs[i] < state_throughputs[j]) {
+          pairs.push_back({j, i, state_throughputs[j]});
+        }
+      }
+    }
+  }
+  if (pairs.empty()) {
+    return;
+  }
+
+  num_features = n_features;
+  tree_begin.clear();
+  tree_depth.clear();
+  split_feature.clear();
+  split_threshold.clear();
+  child.clear();
+  leaf_value.clear();
+  Train(rows, n_features, state_rows, pairs, this);
+
+  if (!model_file.empty()) {
+    Save(model_file);
+  }
+}
+
+void GBDTModelNode::Predict(const SearchTask& task, const Array<State>& states,
+                            std::vector<float>* scores) {
+  std::vector<std::vector<float>> state_features;
+  GetPerStoreFeaturesFromStates(states, task, 0, kMaxNBufs, &state_features);
+  scores->assign(states.size(), 0.0f);
+
+  bool use_trees =
+      !tree_begin.empty() && static_cast<int>(inputs.size()) > num_warmup_sample;
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  for (size_t i = 0; i < states.size(); ++i) {
+    const std::vector<float>& feature = state_features[i];
+    if (feature.empty() || feature[0] == 0) {
+      // The state failed to be lowered.
+      (*scores)[i] = -std::numeric_limits<float>::infinity();
+    } else if (!use_trees) {
+      (*scores)[i] = dist(rand_gen);
+    }
+  }
+  if (!use_trees) {
+    return;
+  }
+
+  // The stores of a state walk the trees in blocks. The inner loops over the block have no
+  // branch, so they are vectorized into gathers.
+  support::parallel_for(0, states.size(), [&](int i) {
+    const std::vector<float>& feature = state_features[i];
+    if (feature.empty() || feature[0] == 0) {
+      return;
+    }
+    int n_stores = static_cast<int>(feature[0]);
+    ICHECK_EQ(feature.size(), 1 + static_cast<size_t>(n_stores) * num_features)
+        << "The features do not match the ones of the model";
+    const float* rows = feature.data() + 1;
+    double sum = 0;
+    int32_t nodes[kPredictBlock];
+    int32_t offsets[kPredictBlock];
+    for (int block = 0; block < n_stores; block += kPredictBlock) {
+      int n = std::min(kPredictBlock, n_stores - block);
+      for (int r = 0; r < n; ++r) {
+        offsets[r] = (block + r) * num_features;
+      }
+      for (size_t t = 0; t < tree_begin.size(); ++t) {
+        for (int r = 0; r < n; ++r) {
+          nodes[r] = tree_begin[t];
+        }
+        for (int d = 0; d < tree_depth[t]; ++d) {
+          for (int r = 0; r < n; ++r) {
+            int32_t node = nodes[r];
+            nodes[r] = child[node] + (rows[offsets[r] + split_feature[node]] >
+                                      split_threshold[node]);
+          }
+        }
+        for (int r = 0; r < n; ++r) {
+          sum += leaf_value[nodes[r]];
+        }
+      }
+    }
+    // The search takes scores as weights of selection, map them to (0, 1).
+    (*scores)[i] = static_cast<float>(1.0 / (1.0 + std::exp(-sum)));
+  });
+}
+
+void GBDTModelNode::Save(const std::string& file_name) const {
+  std::string blob;
+  dmlc::MemoryStringStream strm(&blob);
+  strm.Write(kGBDTModelMagic);
+  strm.Write(num_features);
+  strm.Write(tree_begin);
+  strm.Write(tree_depth);
+  strm.Write(split_feature);
+  strm.Write(split_threshold);
+  strm.Write(child);
+  strm.Write(leaf_value);
+  std::ofstream fs(file_name, std::ios::out | std::ios::binary);
+  ICHECK(!fs.fail()) << "Cannot open " << file_name;
+  fs.write(blob.data(), blob.size());
+  ICHECK(!fs.fail()) << "Cannot write " << file_name;
+}
+
+void GBDTModelNode::Load(const std::string& file_name) {
+  std::string blob;
+  runtime::LoadBinaryFromFile(file_name, &blob);
+  dmlc::MemoryStringStream strm(&blob);
+  uint64_t magic;
+  ICHECK(strm.Read(&magic) && magic == kGBDTModelMagic) << "Invalid GBDT model file";
+  ICHECK(strm.Read(&num_features)) << "Invalid GBDT model file";
+  ICHECK(strm.Read(&tree_begin)) << "Invalid GBDT model file";
+  ICHECK(strm.Read(&tree_depth)) << "Invalid GBDT model file";
+  ICHECK(strm.Read(&split_feature)) << "Invalid GBDT model file";
+  ICHECK(strm.Read(&split_threshold)) << "Invalid GBDT model file";
+  ICHECK(strm.Read(&child)) << "Invalid GBDT model file";
+  ICHECK(strm.Read(&leaf_value)) << "Invalid GBDT model file";
+  size_t n_nodes = child.size();
+  ICHECK(tree_depth.size() == tree_begin.size() && split_feature.size() == n_nodes &&
+         split_threshold.size() == n_nodes && leaf_value.size() == n_nodes)
+      << "Invalid GBDT model file";
+  for (size_t i = 0; i < n_nodes; ++i) {
+    bool is_leaf = static_cast<size_t>(child[i]) == i && std::isinf(split_threshold[i]);
+    ICHECK(split_feature[i] >= 0 && split_feature[i] < num_features &&
+           (is_leaf || (child[i] >= 0 && static_cast<size_t>(child[i]) + 1 < n_nodes)))
+        << "Invalid GBDT model file";
+  }
+  for (int32_t begin : tree_begin) {
+    ICHECK(begin >= 0 && static_cast<size_t>(begin) < n_nodes) << "Invalid GBDT model file";
+  }
+  num_warmup_sample = -1;
+}
+
+TVM_REGISTER_GLOBAL("auto_scheduler.GBDTModel")
+    .set_body_typed([](int max_depth, int max_num_trees, double learning_rate,
+                       int num_warmup_sample, int seed, bool adaptive_training,
+                       String model_file) {
+      return GBDTModel(max_depth, max_num_trees, learning_rate, num_warmup_sample, seed,
+                       adaptive_training, model_file);
+    });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.GBDTModelSave")
+    .set_body_typed([](GBDTModel model, String file_name) { model->Save(file_name); });
+
+TVM_REGISTER_GLOBAL("auto_scheduler.GBDTModelLoad")
+    .set_body_typed([](GBDTModel model, String file_name) { model->Load(file_name); });
+
+}  // namespace auto_scheduler
+}  // namespace tvm
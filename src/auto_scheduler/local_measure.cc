@@ -0,0 +1,507 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file auto_scheduler/local_measure.cc
+ * \brief Native implementation of LocalBuilder and LocalRunner.
+ */
+
+#include "local_measure.h"
+
+#include <dmlc/memory_io.h>
+#include <tvm/driver/driver_api.h>
+#include <tvm/ir/transform.h>
+#include <tvm/node/serialization.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
+#include <tvm/tir/transform.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "utils.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace tvm {
+namespace auto_scheduler {
+
+#ifndef _WIN32
+/*! \brief The cost of a failed measurement, as MAX_FLOAT in measure.py. */
+static constexpr double kMaxCost = 1e10;
+
+/*! \brief The name of the function built by tvm.build. */
+static constexpr const char* kFuncName = "default_function";
+
+static bool NativeMeasureEnabled() {
+  const char* env = getenv("TVM_AUTO_SCHEDULER_NATIVE_MEASURE");
+  return env != nullptr && std::string(env) == "1";
+}
+
+// Whether the programs of a task are CPU programs built for the host.
+static bool IsHostCPUTask(const SearchTask& task) {
+  auto is_host = [](const Target& target) {
+    return target->kind->name == "llvm" && !target->GetAttr<String>("mtriple").defined();
+  };
+  return is_host(task->target) && (!task->target_host.defined() || is_host(task->target_host));
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/*! \brief How a task run in a child process ended. */
+enum class ChildStatus : int { kDone, kTimeout, kCrash };
+
+/*! \brief A running child process. */
+struct Child {
+  size_t task;
+  pid_t pid;
+  int fd;
+  std::string output;
+  Clock::time_point deadline;
+};
+
+void WriteAll(int fd, const std::string& data) {
+  size_t pos = 0;
+  while (pos < data.size()) {
+    ssize_t n = write(fd, data.data() + pos, data.size() - pos);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return;
+    pos += n;
+  }
+}
+
+std::string DescribeExit(int status) {
+  if (WIFSIGNALED(status)) {
+    return "The measurement process was killed by signal " + std::to_string(WTERMSIG(status));
+  }
+  return "The measurement process exited with code " + std::to_string(WEXITSTATUS(status));
+}
+
+/*!
+ * \brief Run tasks in forked processes, at most n_parallel at a time.
+ * \param tasks The indices of the tasks.
+ * \param n_parallel The maximum number of processes.
+ * \param timeout The timeout of one task, in seconds.
+ * \param ftask The body of a task, run in the child. It returns the bytes sent to the parent.
+ * \param fdone Called in the parent when a task ends, with its output, or the reason of
+ *  the failure of the process.
+ */
+void RunInChildProcesses(
+    const std::vector<size_t>& tasks, int n_parallel, int timeout,
+    const std::function<std::string(size_t)>& ftask,
+    const std::function<void(size_t, ChildStatus, const std::string&)>& fdone) {
+  std::vector<Child> running;
+  size_t next = 0;
+  n_parallel = std::max(n_parallel, 1);
+  while (next < tasks.size() || !running.empty()) {
+    while (next < tasks.size() && static_cast<int>(running.size()) < n_parallel) {
+      size_t task = tasks[next++];
+      int fds[2];
+      ICHECK_EQ(pipe(fds), 0) << "Cannot create a pipe: " << strerror(errno);
+      pid_t pid = fork();
+      ICHECK_GE(pid, 0) << "Cannot fork: " << strerror(errno);
+      if (pid == 0) {
+        // Skip the exit handlers of the parent, e.g. the ones of Python, on every path.
+        close(fds[0]);
+        runtime::threading::ResetThreadPoolAfterFork();
+        try {
+          WriteAll(fds[1], ftask(task));
+        } catch (...) {
+          _exit(1);
+        }
+        close(fds[1]);
+        _exit(0);
+      }
+      close(fds[1]);
+      running.push_back({task, pid, fds[0], "", Clock::now() + std::chrono::seconds(timeout)});
+    }
+
+    Clock::time_point now = Clock::now();
+    Clock::time_point wake = running[0].deadline;
+    std::vector<pollfd> pfds;
+    for (const Child& child : running) {
+      wake = std::min(wake, child.deadline);
+      pfds.push_back({child.fd, POLLIN, 0});
+    }
+    int wait_ms = static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count() + 1);
+    int ret = poll(pfds.data(), pfds.size(), std::max(wait_ms, 0));
+    ICHECK(ret >= 0 || errno == EINTR) << "poll failed: " << strerror(errno);
+
+    now = Clock::now();
+    std::vector<Child> still_running;
+    for (size_t i = 0; i < running.size(); ++i) {
+      Child& child = running[i];
+      if (ret > 0 && (pfds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+        char buffer[1 << 16];
+        ssize_t n = read(child.fd, buffer, sizeof(buffer));
+        if (n > 0) {
+          child.output.append(buffer, n);
+        } else if (n == 0 || errno != EINTR) {
+          // End of the output, the child is exiting.
+          int status = 0;
+          close(child.fd);
+          waitpid(child.pid, &status, 0);
+          if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+            fdone(child.task, ChildStatus::kDone, child.output);
+          } else {
+            fdone(child.task, ChildStatus::kCrash, DescribeExit(status));
+          }
+          continue;
+        }
+      }
+      // A child that keeps writing must not escape the timeout.
+      if (now >= child.deadline) {
+        kill(child.pid, SIGKILL);
+        close(child.fd);
+        waitpid(child.pid, nullptr, 0);
+        fdone(child.task, ChildStatus::kTimeout, "");
+      } else {
+        still_running.push_back(std::move(child));
+      }
+    }
+    running.swap(still_running);
+  }
+}
+
+double SecondsSince(Clock::time_point begin) {
+  return std::chrono::duration_cast<std::chrono::duration<double>>(Clock::now() - begin).count();
+}
+
+// Run a shell command, return its exit code and append its output to `log`.
+int RunCommand(const std::string& cmd, std::string* log) {
+  FILE* pipe = popen((cmd + " 2>&1").c_str(), "r");
+  if (pipe == nullptr) {
+    *log += "Cannot run " + cmd;
+    return -1;
+  }
+  char buffer[1024];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+    log->append(buffer, n);
+  }
+  return pclose(pipe);
+}
+
+std::string Quote(const std::string& path) { return "'" + path + "'"; }
+
+// The body of a build process, returns the serialized result.
+std::string BuildInChild(const MeasureInput& input, const std::string& dirname) {
+  Clock::time_point begin = Clock::now();
+  const SearchTask& task = input->task;
+  int error_no = static_cast<int>(MeasureErrorNO::kNoError);
+  std::string error_msg;
+  std::string filename;
+  Array<te::Tensor> args;
+
+  te::Schedule sch;
+  try {
+    std::tie(sch, args) = task->compute_dag.ApplySteps(input->state->transform_steps, nullptr,
+                                                       nullptr, task->layout_rewrite_option);
+  } catch (const std::exception& e) {
+    error_no = static_cast<int>(MeasureErrorNO::kInstantiationError);
+    error_msg = e.what();
+  }
+
+  if (error_no == 0) {
+    try {
+      runtime::Module mod;
+      {
+        With<tvm::transform::PassContext> ctx(tvm::transform::PassContext::Create());
+        IRModule lowered = lower(sch, args, kFuncName, {});
+        // The last pass of tvm.lower which the C++ pipeline does not have.
+        lowered = tir::transform::HoistIfThenElse()(lowered);
+        mod = build(lowered, task->target, task->target_host);
+      }
+      std::string objname = dirname + "/tmp_func.o";
+      filename = dirname + "/tmp_func.so";
+      mod->SaveToFile(objname, "o");
+      // As tvm.contrib.cc.create_shared does when the library is loaded,
+      // with the compiler tvm.contrib.cc picks up from CXX.
+      const char* cxx = getenv("CXX");
+      std::string cmd = std::string(cxx != nullptr && cxx[0] != '\0' ? cxx : "g++");
+      cmd += " -shared -fPIC";
+#ifdef __APPLE__
+      cmd += " -undefined dynamic_lookup";
+#endif
+      cmd += " -o " + Quote(filename) + " " + Quote(objname);
+      std::string log;
+      if (RunCommand(cmd, &log) != 0) {
+        LOG(FATAL) << "Compilation error:\n" << log;
+      }
+      remove(objname.c_str());
+    } catch (const std::exception& e) {
+      error_no = static_cast<int>(MeasureErrorNO::kCompileHostError);
+      error_msg = e.what();
+      filename.clear();
+    }
+  }
+
+  std::string blob;
+  dmlc::MemoryStringStream strm(&blob);
+  strm.Write(error_no);
+  strm.Write(error_msg);
+  strm.Write(filename);
+  strm.Write(SecondsSince(begin));
+  SaveBinary(&strm, args);
+  return blob;
+}
+
+// The body of a run process, returns the serialized result.
+std::string RunInChild(const BuildResult& build_result, int number, int repeat,
+                       int min_repeat_ms, bool enable_cpu_cache_flush) {
+  TVMContext ctx{kDLCPU, 0};
+  int error_no = static_cast<int>(MeasureErrorNO::kNoError);
+  std::string error_msg;
+  std::vector<double> costs;
+  PackedFunc time_f;
+  try {
+    runtime::Module mod = runtime::Module::LoadFromFile(build_result->filename);
+    const auto* f_evaluator = runtime::Registry::Get("runtime.RPCTimeEvaluator");
+    ICHECK(f_evaluator != nullptr) << "runtime.RPCTimeEvaluator is not registered";
+    std::string f_preproc = enable_cpu_cache_flush ? "cache_flush_cpu_non_first_arg" : "";
+    time_f = (*f_evaluator)(mod, kFuncName, static_cast<int>(ctx.device_type), ctx.device_id,
+                            number, repeat, min_repeat_ms, f_preproc);
+  } catch (const std::exception& e) {
+    error_no = static_cast<int>(MeasureErrorNO::kCompileDeviceError);
+    error_msg = e.what();
+  }
+
+  if (error_no == 0) {
+    try {
+      std::vector<runtime::NDArray> arrays;
+      const auto* random_fill = runtime::Registry::Get("tvm.contrib.random.random_fill");
+      ICHECK(random_fill != nullptr) << "Please make sure USE_RANDOM is ON in the config.cmake";
+      for (const te::Tensor& arg : build_result->args) {
+        std::vector<int64_t> shape;
+        for (const PrimExpr& dim : arg->shape) {
+          shape.push_back(GetIntImm(dim));
+        }
+        arrays.push_back(runtime::NDArray::Empty(shape, arg->dtype, ctx));
+        (*random_fill)(arrays.back());
+      }
+      std::vector<TVMValue> values(arrays.size());
+      std::vector<int> type_codes(arrays.size());
+      runtime::TVMArgsSetter setter(values.data(), type_codes.data());
+      for (size_t i = 0; i < arrays.size(); ++i) {
+        setter(i, arrays[i]);
+      }
+      runtime::TVMRetValue rv;
+      time_f.CallPacked(runtime::TVMArgs(values.data(), type_codes.data(), values.size()), &rv);
+      std::string results = rv;
+      const double* data = reinterpret_cast<const double*>(results.data());
+      costs.assign(data, data + results.size() / sizeof(double));
+    } catch (const std::exception& e) {
+      error_no = static_cast<int>(MeasureErrorNO::kRuntimeDeviceError);
+      error_msg = e.what();
+    }
+  }
+
+  std::string blob;
+  dmlc::MemoryStringStream strm(&blob);
+  strm.Write(error_no);
+  strm.Write(error_msg);
+  strm.Write(costs);
+  return blob;
+}
+
+void RemoveBuildDir(const std::string& dirname) {
+  remove((dirname + "/tmp_func.o").c_str());
+  remove((dirname + "/tmp_func.so").c_str());
+  rmdir(dirname.c_str());
+}
+
+std::string MakeTempDir() {
+  const char* tmp = getenv("TMPDIR");
+  std::string path = std::string(tmp != nullptr ? tmp : "/tmp") + "/tvm_auto_scheduler_XXXXXX";
+  ICHECK(mkdtemp(&path[0]) != nullptr) << "Cannot create a directory in " << path;
+  return path;
+}
+
+Array<PrimExpr> FailedCosts() { return {FloatImm(DataType::Float(64), kMaxCost)}; }
+
+double Now() {
+  return std::chrono::duration_cast<std::chrono::duration<double>>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+bool CanBuildNatively(const Array<MeasureInput>& inputs, const String& build_func) {
+  if (!NativeMeasureEnabled() || build_func != "default") return false;
+  return std::all_of(inputs.begin(), inputs.end(),
+                     [](const MeasureInput& input) { return IsHostCPUTask(input->task); });
+}
+
+Array<BuildResult> NativeLocalBuild(const Array<MeasureInput>& inputs, int timeout, int n_parallel,
+                                    int verbose) {
+  std::vector<std::string> dirnames;
+  std::vector<size_t> tasks;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    dirnames.push_back(MakeTempDir());
+    tasks.push_back(i);
+  }
+  std::vector<BuildResult> results(inputs.size());
+  auto fdone = [&](size_t i, ChildStatus status, const std::string& output) {
+    if (status == ChildStatus::kDone) {
+      std::string blob = output;
+      dmlc::MemoryStringStream strm(&blob);
+      int error_no;
+      std::string error_msg, filename;
+      double time_cost;
+      ICHECK(strm.Read(&error_no) && strm.Read(&error_msg) && strm.Read(&filename) &&
+             strm.Read(&time_cost));
+      Array<te::Tensor> args = Downcast<Array<te::Tensor>>(LoadBinary(&strm));
+      results[i] = BuildResult(filename, args, error_no, error_msg, time_cost);
+      StdCout(verbose) << (error_no == 0 ? "." : ".E") << std::flush;
+    } else if (status == ChildStatus::kTimeout) {
+      results[i] = BuildResult("", {}, static_cast<int>(MeasureErrorNO::kBuildTimeoutError), "",
+                               timeout);
+      StdCout(verbose) << ".T" << std::flush;
+    } else {
+      results[i] = BuildResult("", {}, static_cast<int>(MeasureErrorNO::kCompileHostError),
+                               output, timeout);
+      StdCout(verbose) << ".E" << std::flush;
+    }
+    if (results[i]->error_no != 0) RemoveBuildDir(dirnames[i]);
+  };
+  RunInChildProcesses(
+      tasks, n_parallel, timeout, [&](size_t i) { return BuildInChild(inputs[i], dirnames[i]); },
+      fdone);
+  return Array<BuildResult>(results);
+}
+
+bool CanRunNatively(const Array<MeasureInput>& inputs, const Array<BuildResult>& build_results) {
+  if (!NativeMeasureEnabled() || inputs.size() != build_results.size()) return false;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const std::string& filename = build_results[i]->filename;
+    bool is_so = filename.size() > 3 && filename.compare(filename.size() - 3, 3, ".so") == 0;
+    if (!IsHostCPUTask(inputs[i]->task) || (build_results[i]->error_no == 0 && !is_so)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Array<MeasureResult> NativeLocalRun(const Array<MeasureInput>& inputs,
+                                    const Array<BuildResult>& build_results, int timeout,
+                                    int number, int repeat, int min_repeat_ms,
+                                    double cooldown_interval, bool enable_cpu_cache_flush,
+                                    int verbose) {
+  std::vector<MeasureResult> results(inputs.size());
+  std::vector<size_t> tasks;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const BuildResult& build_result = build_results[i];
+    if (build_result->error_no != 0) {
+      results[i] = MeasureResult(FailedCosts(), build_result->error_no, build_result->error_msg,
+                                 build_result->time_cost, Now());
+    } else {
+      tasks.push_back(i);
+    }
+  }
+  Clock::time_point begin;
+  auto ftask = [&](size_t i) {
+    return RunInChild(build_results[i], number, repeat, min_repeat_ms, enable_cpu_cache_flush);
+  };
+  auto fdone = [&](size_t i, ChildStatus status, const std::string& output) {
+    const BuildResult& build_result = build_results[i];
+    if (status == ChildStatus::kDone) {
+      std::string blob = output;
+      dmlc::MemoryStringStream strm(&blob);
+      int error_no;
+      std::string error_msg;
+      std::vector<double> costs;
+      ICHECK(strm.Read(&error_no) && strm.Read(&error_msg) && strm.Read(&costs));
+      Array<PrimExpr> cost_exprs;
+      for (double cost : costs) {
+        cost_exprs.push_back(FloatImm(DataType::Float(64), cost));
+      }
+      if (error_no != 0) cost_exprs = FailedCosts();
+      results[i] = MeasureResult(cost_exprs, error_no, error_msg,
+                                 SecondsSince(begin) + build_result->time_cost, Now());
+      StdCout(verbose) << (error_no == 0 ? "*" : "*E") << std::flush;
+    } else if (status == ChildStatus::kTimeout) {
+      results[i] = MeasureResult(FailedCosts(), static_cast<int>(MeasureErrorNO::kRunTimeoutError),
+                                 "", build_result->time_cost + timeout, Now());
+      StdCout(verbose) << "*T" << std::flush;
+    } else {
+      results[i] =
+          MeasureResult(FailedCosts(), static_cast<int>(MeasureErrorNO::kRuntimeDeviceError),
+                        output, build_result->time_cost + timeout, Now());
+      StdCout(verbose) << "*E" << std::flush;
+    }
+    std::string filename = build_result->filename;
+    RemoveBuildDir(filename.substr(0, filename.rfind('/')));
+    std::this_thread::sleep_for(std::chrono::duration<double>(cooldown_interval));
+  };
+  // One program at a time, to not disturb the timing of the others.
+  for (size_t i : tasks) {
+    begin = Clock::now();
+    RunInChildProcesses({i}, 1, timeout, ftask, fdone);
+  }
+  StdCout(verbose) << std::endl;
+  return Array<MeasureResult>(results);
+}
+
+#else
+
+bool CanBuildNatively(const Array<MeasureInput>& inputs, const String& build_func) {
+  return false;
+}
+
+Array<BuildResult> NativeLocalBuild(const Array<MeasureInput>& inputs, int timeout, int n_parallel,
+                                    int verbose) {
+  LOG(FATAL) << "The native LocalBuilder needs fork";
+  return {};
+}
+
+bool CanRunNatively(const Array<MeasureInput>& inputs, const Array<BuildResult>& build_results) {
+  return false;
+}
+
+Array<MeasureResult> NativeLocalRun(const Array<MeasureInput>& inputs,
+                                    const Array<BuildResult>& build_results, int timeout,
+                                    int number, int repeat, int min_repeat_ms,
+                                    double cooldown_interval, bool enable_cpu_cache_flush,
+                                    int verbose) {
+  LOG(FATAL) << "The native LocalRunner needs fork";
+  return {};
+}
+
+#endif  // _WIN32
+
+}  // namespace auto_scheduler
+}  // namespace tvm
@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file auto_scheduler/local_measure.h
+ * \brief Native implementation of LocalBuilder and LocalRunner.
+ *
+ *  The Python implementation builds and runs each program in a process of
+ *  Python multiprocessing. The native one forks the processes itself, so the
+ *  programs are built without pickling and without taking the GIL, with up to
+ *  n_parallel processes at a time. It handles the CPU programs built for the
+ *  host with the default build function, the others go through Python.
+ *  It is opt-in: set TVM_AUTO_SCHEDULER_NATIVE_MEASURE=1 to enable it.
+ */
+
+#ifndef TVM_AUTO_SCHEDULER_LOCAL_MEASURE_H_
+#define TVM_AUTO_SCHEDULER_LOCAL_MEASURE_H_
+
+#include <tvm/auto_scheduler/measure.h>
+
+namespace tvm {
+namespace auto_scheduler {
+
+/*!
+ * \brief Check whether the native builder can build the inputs.
+ * \param inputs The inputs to build.
+ * \param build_func The name of the build function of the LocalBuilder.
+ * \return Whether NativeLocalBuild can be used.
+ */
+bool CanBuildNatively(const Array<MeasureInput>& inputs, const String& build_func);
+
+/*!
+ * \brief Build the inputs to shared libraries in forked processes.
+ *  The arguments have the meaning of the ones of LocalBuilder.
+ */
+Array<BuildResult> NativeLocalBuild(const Array<MeasureInput>& inputs, int timeout, int n_parallel,
+                                    int verbose);
+
+/*!
+ * \brief Check whether the native runner can run the build results.
+ * \param inputs The measured inputs.
+ * \param build_results The build results of the inputs.
+ * \return Whether NativeLocalRun can be used.
+ */
+bool CanRunNatively(const Array<MeasureInput>& inputs, const Array<BuildResult>& build_results);
+
+/*!
+ * \brief Time the build results with the time evaluator, each in a forked process.
+ *  The arguments have the meaning of the ones of LocalRunner.
+ */
+Array<MeasureResult> NativeLocalRun(const Array<MeasureInput>& inputs,
+                                    const Array<BuildResult>& build_results, int timeout,
+                                    int number, int repeat, int min_repeat_ms,
+                                    double cooldown_interval, bool enable_cpu_cache_flush,
+                                    int verbose);
+
+}  // namespace auto_scheduler
+}  // namespace tvm
+
+#endif  // TVM_AUTO_SCHEDULER_LOCAL_MEASURE_H_
@@ -445,6 +445,14 @@ String State::ToStr(bool delete_trivial_loop) const {
   return os.str();
 }
 
+uint64_t State::Fingerprint() const {
+  uint64_t fingerprint = kInitialFingerprint;
+  for (const auto& step : operator->()->transform_steps) {
+    fingerprint = StepFingerprint(fingerprint, step);
+  }
+  return fingerprint;
+}
+
 TVM_STATIC_IR_FUNCTOR(ReprPrinter, vtable)
     .set_dispatch<StageNode>([](const ObjectRef& ref, ReprPrinter* p) {
       const auto& stage = tvm::Downcast<Stage>(ref);
@@ -567,6 +575,10 @@ TVM_REGISTER_GLOBAL("auto_scheduler.StateRfactor")
       return Array<ObjectRef>{state, Integer(res)};
     });
 
+TVM_REGISTER_GLOBAL("auto_scheduler.StateFingerprint").set_body_typed([](State state) {
+  return static_cast<int64_t>(state.Fingerprint());
+});
+
 TVM_REGISTER_GLOBAL("auto_scheduler.StateEqual").set_body_typed([](State state1, State state2) {
   return std::equal_to<State>()(state1, state2);
 });
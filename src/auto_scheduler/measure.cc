@@ -27,6 +27,7 @@
 
 #include <algorithm>
 
+#include "local_measure.h"
 #include "search_policy/empty_policy.h"
 #include "search_policy/sketch_policy.h"
 #include "utils.h"
@@ -115,6 +116,9 @@ LocalBuilder::LocalBuilder(int timeout, int n_parallel, const String& build_func
 }
 
 Array<BuildResult> LocalBuilderNode::Build(const Array<MeasureInput>& inputs, int verbose) {
+  if (CanBuildNatively(inputs, build_func)) {
+    return NativeLocalBuild(inputs, timeout, n_parallel, verbose);
+  }
   if (const auto* f = runtime::Registry::Get("auto_scheduler.local_builder.build")) {
     Array<BuildResult> results = (*f)(inputs, timeout, n_parallel, build_func, verbose);
     return results;
@@ -140,6 +144,10 @@ LocalRunner::LocalRunner(int timeout, int number, int repeat, int min_repeat_ms,
 
 Array<MeasureResult> LocalRunnerNode::Run(const Array<MeasureInput>& inputs,
                                           const Array<BuildResult>& build_results, int verbose) {
+  if (CanRunNatively(inputs, build_results)) {
+    return NativeLocalRun(inputs, build_results, timeout, number, repeat, min_repeat_ms,
+                          cooldown_interval, enable_cpu_cache_flush, verbose);
+  }
   if (const auto* f = runtime::Registry::Get("auto_scheduler.local_runner.run")) {
     Array<MeasureResult> results =
         (*f)(inputs, build_results, timeout, number, repeat, min_repeat_ms, cooldown_interval,
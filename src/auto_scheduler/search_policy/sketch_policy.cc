@@ -191,10 +191,6 @@ State SketchPolicyNode::Search(int n_trials, int early_stopping, int num_measure
       PrintTitle("Search", verbose);
       best_states = SearchOneRound(num_random * 3, &random_states);
 
-      // Infer bound. This is necessary for computing the correct ToStr() for redundancy check
-      best_states = search_task->compute_dag.InferBound(best_states);
-      random_states = search_task->compute_dag.InferBound(random_states);
-
       // Pick `num_measure_per_iter` states to measure, check hash to remove already measured state
       // Also pick some random states to do eps-greedy
       inputs = PickStatesWithEpsGreedy(best_states, random_states, n_trials - ct);
@@ -252,10 +248,6 @@ std::pair<Array<MeasureInput>, Array<MeasureResult>> SketchPolicyNode::ContinueS
   PrintTitle("Search", verbose);
   best_states = SearchOneRound(num_random * 3, &random_states);
 
-  // Infer bound. This is necessary for computing the correct ToStr() for redundancy check
-  best_states = search_task->compute_dag.InferBound(best_states);
-  random_states = search_task->compute_dag.InferBound(random_states);
-
   // Pick `num_measure_per_iter` states to measure, check hash to remove already measured state
   // Also pick some random states to do eps-greedy
   inputs = PickStatesWithEpsGreedy(best_states, random_states, num_measure);
@@ -395,7 +387,7 @@ Array<State> SketchPolicyNode::SampleInitPopulation(const Array<State>& sketches
     rand_gens.push_back(std::mt19937(rand_gen()));
   }
 
-  std::unordered_set<std::string> explored_state_strs;
+  std::unordered_set<uint64_t> explored_states;
   size_t iter = 1;
   size_t unchange_cnt = 0;
   while (static_cast<int>(out_states.size()) < sample_init_min_pop_) {
@@ -441,9 +433,7 @@ Array<State> SketchPolicyNode::SampleInitPopulation(const Array<State>& sketches
       program_cost_model->Predict(search_task, cand_states, &pop_scores);
 
       for (size_t i = 0; i < cand_states.size(); i++) {
-        const auto state_str = cand_states[i].ToStr();
-        if (pop_scores[i] > -1e10 && explored_state_strs.count(state_str) == 0) {
-          explored_state_strs.insert(state_str);
+        if (pop_scores[i] > -1e10 && explored_states.insert(cand_states[i].Fingerprint()).second) {
           out_states.push_back(std::move(cand_states[i]));
           unchange_cnt = 0;  // Reset the counter once we found a valid state
         } else {
@@ -491,6 +481,8 @@ Array<State> SketchPolicyNode::EvolutionarySearch(const Array<State>& init_popul
 
   size_t population = GetIntParam(params, SketchParamKey::EvolutionarySearch::population);
   double mutation_prob = GetDoubleParam(params, SketchParamKey::EvolutionarySearch::mutation_prob);
+  double crossover_ratio =
+      GetDoubleParam(params, SketchParamKey::EvolutionarySearch::crossover_ratio);
   int num_iters = GetIntParam(params, SketchParamKey::EvolutionarySearch::num_iters);
 
   bool is_cost_model_reasonable = !program_cost_model->IsInstance<RandomModelNode>();
@@ -508,12 +500,17 @@ Array<State> SketchPolicyNode::EvolutionarySearch(const Array<State>& init_popul
   Array<State>* pnext = &states_buf2;
 
   // A heap to keep the best states during evolution
-  using StateHeapItem = std::pair<State, float>;
+  struct StateHeapItem {
+    State state;
+    float score;
+    // Kept to remove the state from in_heap when it is evicted.
+    uint64_t fingerprint;
+  };
   auto cmp = [](const StateHeapItem& left, const StateHeapItem& right) {
-    return left.second > right.second;
+    return left.score > right.score;
   };
   std::vector<StateHeapItem> heap;
-  std::unordered_set<std::string> in_heap(measured_states_set_);
+  std::unordered_set<uint64_t> in_heap(measured_states_set_);
   heap.reserve(out_size);
 
   // auxiliary global variables
@@ -522,11 +519,20 @@ Array<State> SketchPolicyNode::EvolutionarySearch(const Array<State>& init_popul
   float max_score = -1e-10;
   pop_scores.reserve(population);
   pop_selection_probs.reserve(population);
-  std::uniform_real_distribution<> dis(0.0, 1.0);
+
+  // The states of the next population are generated in parallel, each with its own random
+  // number generator.
+  std::vector<std::mt19937> rand_gens;
+  rand_gens.reserve(population);
+  for (size_t i = 0; i < population; i++) {
+    rand_gens.push_back(std::mt19937(rand_gen()));
+  }
 
   // mutation rules
   int mutation_success_ct, mutation_fail_ct;
   mutation_success_ct = mutation_fail_ct = 0;
+  int crossover_success_ct, crossover_fail_ct;
+  crossover_success_ct = crossover_fail_ct = 0;
   std::vector<float> rule_weights;
   std::vector<double> rule_selection_probs;
   for (const auto& rule : mutation_rules) {
@@ -541,22 +547,28 @@ Array<State> SketchPolicyNode::EvolutionarySearch(const Array<State>& init_popul
     PruneInvalidState(search_task, pnow);
     program_cost_model->Predict(search_task, *pnow, &pop_scores);
 
+    std::vector<uint64_t> fingerprints(pnow->size());
+    std::vector<uint64_t> structure_hashes(pnow->size());
+    support::parallel_for(0, pnow->size(), [pnow, &fingerprints, &structure_hashes](int i) {
+      fingerprints[i] = (*pnow)[i].Fingerprint();
+      structure_hashes[i] = StateStructureHash((*pnow)[i]);
+    });
+
     for (size_t i = 0; i < pnow->size(); ++i) {
       const State& state = (*pnow)[i];
-      std::string state_str = state.ToStr();
+      uint64_t fingerprint = fingerprints[i];
 
-      if (in_heap.count(state_str) == 0) {
+      if (in_heap.count(fingerprint) == 0) {
         if (static_cast<int>(heap.size()) < out_size) {
-          heap.emplace_back((*pnow)[i], pop_scores[i]);
+          heap.push_back(StateHeapItem{state, pop_scores[i], fingerprint});
           std::push_heap(heap.begin(), heap.end(), cmp);
-          in_heap.insert(state_str);
-        } else if (pop_scores[i] > heap.front().second) {
-          std::string old_state_str = heap.front().first.ToStr();
-          in_heap.erase(old_state_str);
-          in_heap.insert(state_str);
+          in_heap.insert(fingerprint);
+        } else if (pop_scores[i] > heap.front().score) {
+          in_heap.erase(heap.front().fingerprint);
+          in_heap.insert(fingerprint);
 
           std::pop_heap(heap.begin(), heap.end(), cmp);
-          heap.back() = StateHeapItem(state, pop_scores[i]);
+          heap.back() = StateHeapItem{state, pop_scores[i], fingerprint};
           std::push_heap(heap.begin(), heap.end(), cmp);
         }
         if (pop_scores[i] > max_score) {
@@ -571,12 +583,14 @@ Array<State> SketchPolicyNode::EvolutionarySearch(const Array<State>& init_popul
       if (!heap.empty()) {
         StdCout(verbose) << std::fixed << std::setprecision(4) << "\tMax score: " << max_score
                          << std::fixed << std::setprecision(4)
-                         << "\tMin score: " << heap.front().second;
+                         << "\tMin score: " << heap.front().score;
       } else {
         StdCout(verbose) << "\tMax score: N/A\tMin score: N/A";
       }
       StdCout(verbose) << "\t#Pop: " << heap.size() << "\t#M+: " << mutation_success_ct / (k + 1)
-                       << "\t#M-: " << mutation_fail_ct / (k + 1) << std::endl;
+                       << "\t#M-: " << mutation_fail_ct / (k + 1)
+                       << "\t#C+: " << crossover_success_ct / (k + 1)
+                       << "\t#C-: " << crossover_fail_ct / (k + 1) << std::endl;
     }
     if (k == num_iters) {
       break;
@@ -585,22 +599,76 @@ Array<State> SketchPolicyNode::EvolutionarySearch(const Array<State>& init_popul
     // Compute selection probability
     ComputePrefixSumProb(pop_scores, &pop_selection_probs);
 
-    // TODO(merrymercy, comaniac): add crossover.
+    // Group the states by their structures, only the states in the same group can be crossed over
+    std::unordered_map<uint64_t, int> group_ids;
+    std::vector<int> state_groups(pnow->size());
+    std::vector<std::vector<int>> group_states;
+    std::vector<std::vector<double>> group_selection_probs;
+    if (crossover_ratio > 0) {
+      for (size_t i = 0; i < pnow->size(); ++i) {
+        auto res = group_ids.emplace(structure_hashes[i], group_states.size());
+        if (res.second) {
+          group_states.emplace_back();
+        }
+        state_groups[i] = res.first->second;
+        group_states[res.first->second].push_back(i);
+      }
+      group_selection_probs.resize(group_states.size());
+      for (size_t g = 0; g < group_states.size(); ++g) {
+        std::vector<float> group_scores;
+        for (int i : group_states[g]) {
+          group_scores.push_back(pop_scores[i]);
+        }
+        ComputePrefixSumProb(group_scores, &group_selection_probs[g]);
+      }
+    }
 
-    // Do mutation
+    // Do crossover and mutation
+    enum class Origin : int { kCopy = 0, kMutation = 1, kCrossover = 2 };
     while (pnext->size() < population) {
-      State tmp_s = (*pnow)[RandomChoose(pop_selection_probs, &rand_gen)];
+      size_t num_new = population - pnext->size();
+      std::vector<State> new_states(num_new);
+      std::vector<Origin> origins(num_new, Origin::kCopy);
+      support::parallel_for(0, num_new, [&](int index) {
+        std::mt19937* gen = &rand_gens[index];
+        std::uniform_real_distribution<> dis(0.0, 1.0);
+        int p1 = RandomChoose(pop_selection_probs, gen);
+
+        if (dis(*gen) < crossover_ratio) {
+          const std::vector<int>& candidates = group_states[state_groups[p1]];
+          int p2 = candidates[RandomChoose(group_selection_probs[state_groups[p1]], gen)];
+          if (p2 != p1) {
+            // Take more stages from the parent with the higher score
+            float s1 = std::max(pop_scores[p1], 0.0f), s2 = std::max(pop_scores[p2], 0.0f);
+            double p1_prob = s1 + s2 > 0 ? s1 / (s1 + s2) : 0.5;
+            origins[index] = Origin::kCrossover;
+            new_states[index] = CrossoverState(search_task, (*pnow)[p1], (*pnow)[p2], p1_prob, gen);
+            return;
+          }
+        }
 
-      if (dis(rand_gen) < mutation_prob) {
-        const auto& rule = mutation_rules[RandomChoose(rule_selection_probs, &rand_gen)];
-        if (rule->Apply(this, &tmp_s, &rand_gen) == PopulationGenerationRule::ResultKind::kValid) {
-          pnext->push_back(std::move(tmp_s));
-          mutation_success_ct++;
+        State tmp_s = (*pnow)[p1];
+        if (dis(*gen) < mutation_prob) {
+          const auto& rule = mutation_rules[RandomChoose(rule_selection_probs, gen)];
+          origins[index] = Origin::kMutation;
+          if (rule->Apply(this, &tmp_s, gen) == PopulationGenerationRule::ResultKind::kValid) {
+            new_states[index] = std::move(tmp_s);
+          }
         } else {
-          mutation_fail_ct++;
+          new_states[index] = std::move(tmp_s);
+        }
+      });
+
+      for (size_t i = 0; i < num_new; ++i) {
+        bool valid = new_states[i].defined();
+        if (origins[i] == Origin::kMutation) {
+          (valid ? mutation_success_ct : mutation_fail_ct)++;
+        } else if (origins[i] == Origin::kCrossover) {
+          (valid ? crossover_success_ct : crossover_fail_ct)++;
+        }
+        if (valid) {
+          pnext->push_back(std::move(new_states[i]));
         }
-      } else {
-        pnext->push_back(std::move(tmp_s));
       }
     }
 
@@ -611,7 +679,7 @@ Array<State> SketchPolicyNode::EvolutionarySearch(const Array<State>& init_popul
   // Copy best states in the heap to out_states
   std::sort(heap.begin(), heap.end(), cmp);
   for (auto& item : heap) {
-    best_states.push_back(std::move(item.first));
+    best_states.push_back(std::move(item.state));
   }
 
   double duration = std::chrono::duration_cast<std::chrono::duration<double>>(
@@ -660,9 +728,7 @@ Array<MeasureInput> SketchPolicyNode::PickStatesWithEpsGreedy(const Array<State>
     }
 
     // Check if it has already been measured
-    std::string state_str = state.ToStr();
-    if (!measured_states_set_.count(state_str)) {
-      measured_states_set_.insert(std::move(state_str));
+    if (measured_states_set_.insert(state.Fingerprint()).second) {
       measured_states_vector_.push_back(state);
       inputs.push_back(MeasureInput(search_task, state));
     }
@@ -70,6 +70,8 @@ struct SketchParamKey {
     static constexpr const char* num_iters = "evolutionary_search_num_iters";
     /*! \brief The mutation probability.*/
     static constexpr const char* mutation_prob = "evolutionary_search_mutation_prob";
+    /*! \brief The ratio of the population generated by crossover.*/
+    static constexpr const char* crossover_ratio = "evolutionary_search_crossover_ratio";
   };
 
   struct MultiLevelTiling {
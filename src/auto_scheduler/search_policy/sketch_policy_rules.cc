@@ -27,6 +27,7 @@
 
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -1237,5 +1238,70 @@ PopulationGenerationRule::ResultKind MutateParallel::Apply(SketchPolicyNode* pol
   return ResultKind::kValid;
 }
 
+/********** Crossover **********/
+
+uint64_t StateStructureHash(const State& state) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  auto mix = [&hash](uint64_t value) { hash = (hash ^ value) * 0x100000001b3ULL; };
+  for (const auto& step : state->transform_steps) {
+    mix(step->type_index());
+    mix(static_cast<uint64_t>(step->stage_id));
+  }
+  return hash;
+}
+
+State CrossoverState(const SearchTask& task, const State& p1, const State& p2, double p1_prob,
+                     std::mt19937* rand_gen) {
+  const auto& steps1 = p1->transform_steps;
+  const auto& steps2 = p2->transform_steps;
+  if (steps1.size() != steps2.size()) {
+    return State();
+  }
+  for (size_t i = 0; i < steps1.size(); ++i) {
+    if (steps1[i]->type_index() != steps2[i]->type_index() ||
+        steps1[i]->stage_id != steps2[i]->stage_id) {
+      return State();
+    }
+  }
+
+  // Because the steps are aligned, a follow split step still points to a split step of the same
+  // stage, no matter which parent that split step comes from.
+  std::uniform_real_distribution<> dis(0.0, 1.0);
+  std::unordered_map<int, bool> from_p1;
+  bool use_p1 = false, use_p2 = false;
+  State child = task->compute_dag->init_state;
+  for (size_t i = 0; i < steps1.size(); ++i) {
+    auto it = from_p1.find(steps1[i]->stage_id);
+    if (it == from_p1.end()) {
+      it = from_p1.emplace(steps1[i]->stage_id, dis(*rand_gen) < p1_prob).first;
+    }
+    if (it->second) {
+      use_p1 = true;
+      child.CopyOnWrite()->transform_steps.push_back(steps1[i]);
+    } else {
+      use_p2 = true;
+      child.CopyOnWrite()->transform_steps.push_back(steps2[i]);
+    }
+    try {
+      StepApplyToState(child->transform_steps.back(), &child, task->compute_dag);
+    } catch (dmlc::Error& e) {
+      return State();
+    }
+  }
+
+  // All the stages come from the same parent, which is already valid.
+  if (!use_p1 || !use_p2) {
+    return use_p1 ? p1 : p2;
+  }
+
+  // The iterators referred by the steps of one parent may not exist in the other one,
+  // or the combined loops may not be bounded.
+  try {
+    return task->compute_dag.InferBound(child);
+  } catch (dmlc::Error& e) {
+    return State();
+  }
+}
+
 }  // namespace auto_scheduler
 }  // namespace tvm
@@ -239,6 +239,30 @@ DEFINE_MUTATE_POPULATION_RULE(MutateComputeLocation);
 /*! \brief The rule that mutates the value of a randomly selected auto unroll pragma step. */
 DEFINE_MUTATE_POPULATION_RULE(MutateAutoUnroll);
 
+/********** Crossover **********/
+
+/*!
+ * \brief Get a hash of the step kinds and stage ids of a state. The states generated from the
+ * same sketch with the same annotation steps have the same hash and can be crossed over.
+ * \param state The state.
+ * \return The hash.
+ */
+uint64_t StateStructureHash(const State& state);
+
+/*!
+ * \brief Cross over two states. The child takes all the steps of a stage from one of the parents
+ * and is checked with ComputeDAG::InferBound.
+ * \param task The search task.
+ * \param p1 The first parent.
+ * \param p2 The second parent, with the same step kinds and stage ids as the first one.
+ * \param p1_prob The probability to take the steps of a stage from the first parent.
+ * \param rand_gen The random number generator.
+ * \return The child with its bounds inferred, or an undefined state if the parents have
+ * different structures or the child is invalid.
+ */
+State CrossoverState(const SearchTask& task, const State& p1, const State& p2, double p1_prob,
+                     std::mt19937* rand_gen);
+
 }  // namespace auto_scheduler
 }  // namespace tvm
 
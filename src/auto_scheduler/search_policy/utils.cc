@@ -415,6 +415,7 @@ void PruneInvalidState(const SearchTask& task, Array<State>* states) {
 /********** SplitFactorizationMemo **********/
 const Array<Array<Integer>>& SplitFactorizationMemo::GetFactorizationSchemes(
     int extent, int n_lengths, int max_innermost_factor) {
+  std::lock_guard<std::mutex> lock(mutex_);
   QueryKey key = std::make_tuple(extent, n_lengths, max_innermost_factor);
   const auto& it = memory_.find(key);
   if (it != memory_.end()) {
@@ -436,7 +437,7 @@ void SplitFactorizationMemo::DfsEnumerate(int now, int remaining_length, int max
       results_->push_back(tmp_stack_);
     }
   } else {
-    for (const auto& f : GetFactors(remaining_length)) {
+    for (const auto& f : GetFactorsUnlocked(remaining_length)) {
       tmp_stack_.Set(now, Integer(f));
       DfsEnumerate(now + 1, remaining_length / f, max_innermost_factor);
     }
@@ -444,6 +445,11 @@ void SplitFactorizationMemo::DfsEnumerate(int now, int remaining_length, int max
 }
 
 const std::vector<int>& SplitFactorizationMemo::GetFactors(int n) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return GetFactorsUnlocked(n);
+}
+
+const std::vector<int>& SplitFactorizationMemo::GetFactorsUnlocked(int n) {
   auto it = factor_memory_.find(n);
   if (it != factor_memory_.end()) {
     return it->second;
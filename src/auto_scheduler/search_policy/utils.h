@@ -33,6 +33,7 @@
 
 #include <algorithm>
 #include <condition_variable>
+#include <mutex>
 #include <set>
 #include <string>
 #include <tuple>
@@ -663,7 +664,8 @@ inline void PrintTitle(const std::string& title, int verbose) {
 
 /*!
  * \brief Enumerate all possible factorization schemes for splitting an axes.
- * \note This class will memorize the results for reuse.
+ * \note This class will memorize the results for reuse. It is thread-safe, the mutation rules
+ * of the evolutionary search share the one of the policy across threads.
  */
 class SplitFactorizationMemo {
  public:
@@ -675,6 +677,7 @@ class SplitFactorizationMemo {
 
  private:
   void DfsEnumerate(int now, int remaining_length, int max_innermost_factor);
+  const std::vector<int>& GetFactorsUnlocked(int n);
 
   std::unordered_map<QueryKey, Array<Array<Integer>>> memory_;
 
@@ -682,6 +685,8 @@ class SplitFactorizationMemo {
   Array<Integer> tmp_stack_;
   Array<Array<Integer>>* results_;
   std::unordered_map<int, std::vector<int>> factor_memory_;
+  // The references returned to the callers stay valid, since the entries are never erased.
+  std::mutex mutex_;
 };
 
 /*! \brief Get the indexes of SplitStep that processes on spatial iterator. */
@@ -321,6 +321,174 @@ String StepPrintAsPythonAPI(const Step& step, Array<te::Stage>* stages,
   return "";
 }
 
+namespace {
+// Append the bytes of a binary step encoding to a string.
+class StringSink {
+ public:
+  explicit StringSink(std::string* out) : out_(out) {}
+  void Put(char c) { out_->push_back(c); }
+  void Append(const char* data, size_t size) { out_->append(data, size); }
+
+ private:
+  std::string* out_;
+};
+
+// Continue an FNV-1a hash with the bytes of a binary step encoding, without storing them.
+class FNVSink {
+ public:
+  explicit FNVSink(uint64_t h) : h_(h) {}
+  void Put(char c) {
+    h_ ^= static_cast<uint8_t>(c);
+    h_ *= 0x100000001b3ULL;
+  }
+  void Append(const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      Put(data[i]);
+    }
+  }
+  uint64_t hash() const { return h_; }
+
+ private:
+  uint64_t h_;
+};
+
+// Write integers as zigzag varints and strings and arrays with their length before them.
+template <typename Sink>
+class BinaryStepWriter {
+ public:
+  explicit BinaryStepWriter(Sink* sink) : sink_(sink) {}
+
+  void Write(int64_t value) {
+    uint64_t v = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    while (v >= 0x80) {
+      sink_->Put(static_cast<char>(v | 0x80));
+      v >>= 7;
+    }
+    sink_->Put(static_cast<char>(v));
+  }
+
+  void Write(const String& value) {
+    Write(static_cast<int64_t>(value.size()));
+    sink_->Append(value.data(), value.size());
+  }
+
+  void Write(const Array<Integer>& values) {
+    Write(static_cast<int64_t>(values.size()));
+    for (const auto& value : values) {
+      Write(value->value);
+    }
+  }
+
+  void Write(const Array<Optional<Integer>>& values) {
+    Write(static_cast<int64_t>(values.size()));
+    for (const auto& value : values) {
+      // Undefined lengths are written as 0 and the others are shifted by one.
+      Write(value ? value.value()->value + 1 : 0);
+    }
+  }
+
+ private:
+  Sink* sink_;
+};
+
+template <typename Sink>
+void WriteStep(const Step& step, Sink* sink) {
+  BinaryStepWriter<Sink> writer(sink);
+  // The kinds follow the order of the steps in this file.
+  if (auto ps = step.as<AnnotationStepNode>()) {
+    writer.Write(0);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->iter_id);
+    writer.Write(static_cast<int64_t>(ps->annotation));
+  } else if (auto ps = step.as<FuseStepNode>()) {
+    writer.Write(1);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->fused_ids);
+  } else if (auto ps = step.as<PragmaStepNode>()) {
+    writer.Write(2);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->iter_id);
+    writer.Write(ps->pragma_type);
+  } else if (auto ps = step.as<ReorderStepNode>()) {
+    writer.Write(3);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->after_ids);
+  } else if (auto ps = step.as<SplitStepNode>()) {
+    writer.Write(4);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->iter_id);
+    writer.Write(ps->extent ? GetIntImm(ps->extent.value()) : 0);
+    writer.Write(ps->lengths);
+    writer.Write(ps->inner_to_outer);
+  } else if (auto ps = step.as<FollowSplitStepNode>()) {
+    writer.Write(5);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->iter_id);
+    writer.Write(ps->src_step_id);
+    writer.Write(ps->n_split);
+  } else if (auto ps = step.as<FollowFusedSplitStepNode>()) {
+    writer.Write(6);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->iter_id);
+    writer.Write(ps->src_step_ids);
+    writer.Write(ps->level);
+    writer.Write(ps->factor_or_nparts);
+  } else if (auto ps = step.as<StorageAlignStepNode>()) {
+    writer.Write(7);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->iter_id);
+    writer.Write(ps->factor);
+    writer.Write(ps->offset);
+  } else if (auto ps = step.as<ComputeAtStepNode>()) {
+    writer.Write(8);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->target_stage_id);
+    writer.Write(ps->target_iter_id);
+  } else if (auto ps = step.as<ComputeInlineStepNode>()) {
+    writer.Write(9);
+    writer.Write(ps->stage_id);
+  } else if (auto ps = step.as<ComputeRootStepNode>()) {
+    writer.Write(10);
+    writer.Write(ps->stage_id);
+  } else if (auto ps = step.as<CacheReadStepNode>()) {
+    writer.Write(11);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->scope_name);
+    writer.Write(ps->reader_stage_ids);
+  } else if (auto ps = step.as<CacheWriteStepNode>()) {
+    writer.Write(12);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->scope_name);
+  } else if (auto ps = step.as<RfactorStepNode>()) {
+    writer.Write(13);
+    writer.Write(ps->stage_id);
+    writer.Write(ps->iter_id);
+    writer.Write(ps->factor_iter_id);
+  } else {
+    LOG(FATAL) << "Invalid Step: " << step;
+  }
+}
+}  // namespace
+
+void StepWriteToBinary(const Step& step, std::string* out) {
+  StringSink sink(out);
+  WriteStep(step, &sink);
+}
+
+uint64_t StepFingerprint(uint64_t prefix, const Step& step) {
+  // FNV-1a of the binary encoding continued from the prefix, then the finalizer of splitmix64 to
+  // mix all bits. The fields are hashed as they are encoded, the encoding is not stored.
+  FNVSink sink(prefix);
+  WriteStep(step, &sink);
+  uint64_t h = sink.hash();
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
 /********** Steps working on single stage **********/
 
 /********** Annotation **********/
@@ -0,0 +1,573 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file node/binary_serialization.cc
+ * \brief Streaming binary serialization of TVM AST/IR objects.
+ *
+ *  The format is a sequence of records, written in post order so that every
+ *  object only refers to the objects and tensors before it:
+ *
+ *  - uint64 kTVMObjectBinaryMagic, string TVM_VERSION
+ *  - kTensorRecord: int32 ndim, DLDataType dtype, int64[ndim] shape,
+ *    uint64 data bytes, the padding to kAllocAlignment, the raw data
+ *  - kNodeRecord: uint32 type id, followed by the type key the first time
+ *    the id appears, then uint8 kind and the content of the object:
+ *    - kFields: the attributes in VisitAttrs order, objects and tensors as
+ *      uint64 indices
+ *    - kRepr: string repr bytes
+ *    - kArray: uint64 size, uint64 indices of the elements
+ *    - kMap: uint64 size, uint64 indices of the keys and values
+ *  - kEndRecord: uint64 index of the root
+ *
+ *  Object index 0 is None. As the attributes are not named, a file can only
+ *  be loaded by the version of TVM that saved it, SaveJSON is the portable
+ *  format.
+ */
+#include <dmlc/memory_io.h>
+#include <tvm/node/container.h>
+#include <tvm/node/reflection.h>
+#include <tvm/node/serialization.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/serializer.h>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../runtime/file_utils.h"
+#include "../runtime/object_internal.h"
+
+namespace tvm {
+namespace {
+
+constexpr uint64_t kTVMObjectBinaryMagic = 0xF7E58D4F05049CC0;
+
+/*! \brief The types of records. */
+constexpr uint8_t kNodeRecord = 0;
+constexpr uint8_t kTensorRecord = 1;
+constexpr uint8_t kEndRecord = 2;
+
+/*! \brief The kinds of node content. */
+constexpr uint8_t kFields = 0;
+constexpr uint8_t kRepr = 1;
+constexpr uint8_t kArray = 2;
+constexpr uint8_t kMap = 3;
+
+/*! \brief The index of an undefined NDArray field. */
+constexpr uint64_t kNullTensor = std::numeric_limits<uint64_t>::max();
+
+size_t PaddingTo(size_t pos, size_t alignment) { return (alignment - pos % alignment) % alignment; }
+
+// Collect the objects and tensors a node refers to.
+class ChildCollector : public AttrVisitor {
+ public:
+  std::vector<Object*>* children_;
+  std::vector<DLTensor*>* tensors_;
+
+  void Visit(const char* key, double* value) final {}
+  void Visit(const char* key, int64_t* value) final {}
+  void Visit(const char* key, uint64_t* value) final {}
+  void Visit(const char* key, int* value) final {}
+  void Visit(const char* key, bool* value) final {}
+  void Visit(const char* key, std::string* value) final {}
+  void Visit(const char* key, void** value) final {}
+  void Visit(const char* key, DataType* value) final {}
+  void Visit(const char* key, runtime::NDArray* value) final {
+    if (value->defined()) {
+      tensors_->push_back(const_cast<DLTensor*>((*value).operator->()));
+    }
+  }
+  void Visit(const char* key, ObjectRef* value) final {
+    children_->push_back(const_cast<Object*>(value->get()));
+  }
+};
+
+// Write the records of an object graph to a stream.
+class BinaryObjectWriter : public AttrVisitor {
+ public:
+  explicit BinaryObjectWriter(dmlc::Stream* strm) : strm_(strm) {}
+
+  void Save(const ObjectRef& root) {
+    Write(kTVMObjectBinaryMagic);
+    WriteString(TVM_VERSION);
+    Object* root_node = const_cast<Object*>(root.get());
+    if (root_node != nullptr) Index(root_node);
+    Write(kEndRecord);
+    Write(node_index_.at(root_node));
+  }
+
+  void Visit(const char* key, double* value) final { Write(*value); }
+  void Visit(const char* key, int64_t* value) final { Write(*value); }
+  void Visit(const char* key, uint64_t* value) final { Write(*value); }
+  void Visit(const char* key, int* value) final { Write(static_cast<int32_t>(*value)); }
+  void Visit(const char* key, bool* value) final { Write(static_cast<uint8_t>(*value)); }
+  void Visit(const char* key, std::string* value) final { WriteString(*value); }
+  void Visit(const char* key, void** value) final {
+    LOG(FATAL) << "not allowed to serialize a pointer";
+  }
+  void Visit(const char* key, DataType* value) final {
+    DLDataType dtype = *value;
+    Write(dtype);
+  }
+  void Visit(const char* key, runtime::NDArray* value) final {
+    if (!value->defined()) {
+      Write(kNullTensor);
+    } else {
+      Write(tensor_index_.at(const_cast<DLTensor*>((*value).operator->())));
+    }
+  }
+  void Visit(const char* key, ObjectRef* value) final {
+    Write(node_index_.at(const_cast<Object*>(value->get())));
+  }
+
+ private:
+  struct Frame {
+    Object* node;
+    std::vector<Object*> children;
+    std::vector<DLTensor*> tensors;
+    size_t next{0};
+  };
+
+  template <typename T>
+  void Write(const T& value) {
+    strm_->Write(value);
+    pos_ += sizeof(T);
+  }
+
+  void WriteString(const std::string& value) {
+    strm_->Write(value);
+    pos_ += sizeof(uint64_t) + value.size();
+  }
+
+  // Write the records of a node and of everything it depends on, in post order.
+  // The traversal uses its own stack, as the IR of large models is deep.
+  void Index(Object* root) {
+    std::vector<Frame> stack;
+    std::unordered_set<Object*> visiting;
+    auto push = [&](Object* node) {
+      ICHECK(visiting.insert(node).second) << "Cyclic reference detected in the object graph";
+      stack.emplace_back();
+      Frame& frame = stack.back();
+      frame.node = node;
+      GetChildren(node, &frame);
+    };
+    push(root);
+    while (!stack.empty()) {
+      Frame& frame = stack.back();
+      if (frame.next < frame.children.size()) {
+        Object* child = frame.children[frame.next++];
+        if (node_index_.count(child) == 0) push(child);
+        continue;
+      }
+      for (DLTensor* tensor : frame.tensors) {
+        if (tensor_index_.count(tensor) == 0) WriteTensor(tensor);
+      }
+      WriteNode(frame.node);
+      visiting.erase(frame.node);
+      stack.pop_back();
+    }
+  }
+
+  void GetChildren(Object* node, Frame* frame) {
+    if (node->IsInstance<ArrayNode>()) {
+      for (const auto& elem : *static_cast<ArrayNode*>(node)) {
+        frame->children.push_back(const_cast<Object*>(elem.get()));
+      }
+    } else if (node->IsInstance<MapNode>()) {
+      for (const auto& kv : *static_cast<MapNode*>(node)) {
+        frame->children.push_back(const_cast<Object*>(kv.first.get()));
+        frame->children.push_back(const_cast<Object*>(kv.second.get()));
+      }
+    } else if (!reflection_->GetReprBytes(node, nullptr)) {
+      ChildCollector collector;
+      collector.children_ = &frame->children;
+      collector.tensors_ = &frame->tensors;
+      reflection_->VisitAttrs(node, &collector);
+    }
+  }
+
+  void WriteNode(Object* node) {
+    Write(kNodeRecord);
+    auto it = type_index_.find(node->type_index());
+    if (it != type_index_.end()) {
+      Write(it->second);
+    } else {
+      uint32_t type_id = static_cast<uint32_t>(type_index_.size());
+      type_index_[node->type_index()] = type_id;
+      Write(type_id);
+      WriteString(node->GetTypeKey());
+    }
+    std::string repr_bytes;
+    if (node->IsInstance<ArrayNode>()) {
+      ArrayNode* n = static_cast<ArrayNode*>(node);
+      Write(kArray);
+      Write(static_cast<uint64_t>(n->size()));
+      for (const auto& elem : *n) {
+        Write(node_index_.at(const_cast<Object*>(elem.get())));
+      }
+    } else if (node->IsInstance<MapNode>()) {
+      MapNode* n = static_cast<MapNode*>(node);
+      Write(kMap);
+      Write(static_cast<uint64_t>(n->size()));
+      for (const auto& kv : *n) {
+        Write(node_index_.at(const_cast<Object*>(kv.first.get())));
+        Write(node_index_.at(const_cast<Object*>(kv.second.get())));
+      }
+    } else if (reflection_->GetReprBytes(node, &repr_bytes)) {
+      Write(kRepr);
+      WriteString(repr_bytes);
+    } else {
+      Write(kFields);
+      reflection_->VisitAttrs(node, this);
+    }
+    uint64_t index = node_index_.size();
+    node_index_[node] = index;
+  }
+
+  void WriteTensor(DLTensor* tensor) {
+    uint64_t nbytes = runtime::GetDataSize(*tensor);
+    Write(kTensorRecord);
+    Write(tensor->ndim);
+    Write(tensor->dtype);
+    for (int i = 0; i < tensor->ndim; ++i) {
+      Write(tensor->shape[i]);
+    }
+    Write(nbytes);
+    std::vector<char> bytes(PaddingTo(pos_, runtime::kAllocAlignment), 0);
+    strm_->Write(bytes.data(), bytes.size());
+    pos_ += bytes.size();
+    if (DMLC_IO_NO_ENDIAN_SWAP && tensor->ctx.device_type == kDLCPU &&
+        tensor->strides == nullptr) {
+      strm_->Write(static_cast<const char*>(tensor->data) + tensor->byte_offset, nbytes);
+    } else {
+      bytes.resize(nbytes);
+      ICHECK_EQ(TVMArrayCopyToBytes(tensor, bytes.data(), nbytes), 0) << TVMGetLastError();
+      if (!DMLC_IO_NO_ENDIAN_SWAP) {
+        int elem_bytes = (tensor->dtype.bits + 7) / 8;
+        dmlc::ByteSwap(bytes.data(), elem_bytes, nbytes / elem_bytes);
+      }
+      strm_->Write(bytes.data(), nbytes);
+    }
+    pos_ += nbytes;
+    uint64_t index = tensor_index_.size();
+    tensor_index_[tensor] = index;
+  }
+
+  dmlc::Stream* strm_;
+  /*! \brief The number of bytes written, to align the tensor data. */
+  size_t pos_{0};
+  std::unordered_map<Object*, uint64_t> node_index_{{nullptr, 0}};
+  std::unordered_map<DLTensor*, uint64_t> tensor_index_;
+  std::unordered_map<uint32_t, uint32_t> type_index_;
+  ReflectionVTable* reflection_ = ReflectionVTable::Global();
+};
+
+// Read the records of an object graph, each object is complete once read.
+class BinaryObjectReader : public AttrVisitor {
+ public:
+  /*!
+   * \brief Read a stream.
+   * \param strm The stream.
+   * \param stream_size The number of bytes in the stream, if known.
+   */
+  explicit BinaryObjectReader(dmlc::Stream* strm,
+                              size_t stream_size = std::numeric_limits<size_t>::max())
+      : strm_(strm), stream_size_(stream_size) {}
+
+  /*!
+   * \brief Read a mapped file, the tensors are views of the mapping rather than copies.
+   * \param strm The stream of the whole mapping.
+   * \param file The mapped file.
+   */
+  BinaryObjectReader(dmlc::MemoryFixedSizeStream* strm, std::shared_ptr<runtime::MappedFile> file)
+      : strm_(strm), mapped_strm_(strm), file_(std::move(file)), stream_size_(file_->size()) {}
+
+  ObjectRef Load() {
+    uint64_t magic;
+    std::string version;
+    Read(&magic);
+    ICHECK_EQ(magic, kTVMObjectBinaryMagic) << "Invalid object binary format";
+    ReadString(&version);
+    ICHECK_EQ(version, TVM_VERSION) << "The object binary was saved by TVM " << version
+                                    << ", use SaveJSON to exchange objects between versions";
+    while (true) {
+      uint8_t record;
+      Read(&record);
+      if (record == kNodeRecord) {
+        ReadNode();
+      } else if (record == kTensorRecord) {
+        ReadTensor();
+      } else {
+        ICHECK_EQ(record, kEndRecord) << "Invalid object binary format";
+        break;
+      }
+    }
+    uint64_t root;
+    Read(&root);
+    ICHECK_LT(root, nodes_.size()) << "Invalid object binary format";
+    return ObjectRef(nodes_[root]);
+  }
+
+  void Visit(const char* key, double* value) final { Read(value); }
+  void Visit(const char* key, int64_t* value) final { Read(value); }
+  void Visit(const char* key, uint64_t* value) final { Read(value); }
+  void Visit(const char* key, int* value) final {
+    int32_t v;
+    Read(&v);
+    *value = v;
+  }
+  void Visit(const char* key, bool* value) final {
+    uint8_t v;
+    Read(&v);
+    *value = v != 0;
+  }
+  void Visit(const char* key, std::string* value) final { ReadString(value); }
+  void Visit(const char* key, void** value) final {
+    LOG(FATAL) << "not allowed to deserialize a pointer";
+  }
+  void Visit(const char* key, DataType* value) final {
+    DLDataType dtype;
+    Read(&dtype);
+    *value = DataType(dtype);
+  }
+  void Visit(const char* key, runtime::NDArray* value) final {
+    uint64_t index;
+    Read(&index);
+    if (index == kNullTensor) {
+      *value = runtime::NDArray();
+    } else {
+      ICHECK_LT(index, tensors_.size()) << "Invalid object binary format";
+      *value = tensors_[index];
+    }
+  }
+  void Visit(const char* key, ObjectRef* value) final { *value = ObjectRef(ReadNodeIndex()); }
+
+ private:
+  template <typename T>
+  void Read(T* value) {
+    ICHECK(strm_->Read(value)) << "Invalid object binary format";
+    pos_ += sizeof(T);
+  }
+
+  void ReadString(std::string* value) {
+    ICHECK(strm_->Read(value)) << "Invalid object binary format";
+    pos_ += sizeof(uint64_t) + value->size();
+  }
+
+  void ReadBytes(void* data, size_t size) {
+    ICHECK_EQ(strm_->Read(data, size), size) << "Invalid object binary format";
+    pos_ += size;
+  }
+
+  // The bytes left in the stream, the maximum size_t when the stream size is unknown.
+  size_t RemainingBytes() const { return stream_size_ > pos_ ? stream_size_ - pos_ : 0; }
+
+  ObjectPtr<Object> ReadNodeIndex() {
+    uint64_t index;
+    Read(&index);
+    ICHECK_LT(index, nodes_.size()) << "Invalid object binary format";
+    return nodes_[index];
+  }
+
+  void ReadNode() {
+    uint32_t type_id;
+    Read(&type_id);
+    if (type_id == type_keys_.size()) {
+      type_keys_.emplace_back();
+      ReadString(&type_keys_.back());
+    }
+    ICHECK_LT(type_id, type_keys_.size()) << "Invalid object binary format";
+    const std::string& type_key = type_keys_[type_id];
+    uint8_t kind;
+    Read(&kind);
+    if (kind == kArray) {
+      uint64_t size;
+      Read(&size);
+      // Each element is an index, do not trust a size larger than the stream.
+      ICHECK_LE(size, RemainingBytes() / sizeof(uint64_t)) << "Invalid object binary format";
+      std::vector<ObjectRef> container;
+      container.reserve(std::min<uint64_t>(size, kMaxReserve));
+      for (uint64_t i = 0; i < size; ++i) {
+        container.push_back(ObjectRef(ReadNodeIndex()));
+      }
+      Array<ObjectRef> array(container);
+      nodes_.push_back(runtime::ObjectInternal::MoveObjectPtr(&array));
+    } else if (kind == kMap) {
+      uint64_t size;
+      Read(&size);
+      ICHECK_LE(size, RemainingBytes() / (2 * sizeof(uint64_t))) << "Invalid object binary format";
+      std::unordered_map<ObjectRef, ObjectRef, ObjectHash, ObjectEqual> container;
+      for (uint64_t i = 0; i < size; ++i) {
+        ObjectRef key(ReadNodeIndex());
+        container[key] = ObjectRef(ReadNodeIndex());
+      }
+      Map<ObjectRef, ObjectRef> map(container);
+      nodes_.push_back(runtime::ObjectInternal::MoveObjectPtr(&map));
+    } else if (kind == kRepr) {
+      std::string repr_bytes;
+      ReadString(&repr_bytes);
+      nodes_.push_back(reflection_->CreateInitObject(type_key, repr_bytes));
+    } else {
+      ICHECK_EQ(kind, kFields) << "Invalid object binary format";
+      ObjectPtr<Object> node = reflection_->CreateInitObject(type_key);
+      reflection_->VisitAttrs(node.get(), this);
+      nodes_.push_back(std::move(node));
+    }
+  }
+
+  void ReadTensor() {
+    int32_t ndim;
+    DLDataType dtype;
+    uint64_t nbytes;
+    Read(&ndim);
+    Read(&dtype);
+    // Each extent takes 8 bytes, do not trust a rank larger than the stream.
+    ICHECK(ndim >= 0 && static_cast<size_t>(ndim) <= RemainingBytes() / sizeof(int64_t))
+        << "Invalid object binary format";
+    std::vector<int64_t> shape;
+    shape.reserve(std::min<uint64_t>(ndim, kMaxReserve));
+    uint64_t num_elems = 1;
+    for (int32_t i = 0; i < ndim; ++i) {
+      int64_t extent;
+      Read(&extent);
+      shape.push_back(extent);
+      ICHECK_GE(extent, 0) << "Invalid object binary format";
+      uint64_t n = static_cast<uint64_t>(extent);
+      ICHECK(n == 0 || num_elems <= std::numeric_limits<uint64_t>::max() / n)
+          << "Invalid object binary format";
+      num_elems *= n;
+    }
+    Read(&nbytes);
+    // Check the size of the data against the shape before allocating the tensor.
+    uint64_t elem_bytes = (static_cast<uint64_t>(dtype.bits) * dtype.lanes + 7) / 8;
+    ICHECK(elem_bytes != 0 && num_elems <= std::numeric_limits<uint64_t>::max() / elem_bytes &&
+           num_elems * elem_bytes == nbytes)
+        << "Invalid object binary format";
+    size_t padding = PaddingTo(pos_, runtime::kAllocAlignment);
+    char buffer[runtime::kAllocAlignment];
+    ReadBytes(buffer, padding);
+    ICHECK_LE(nbytes, RemainingBytes()) << "Invalid object binary format";
+
+    runtime::NDArray tensor;
+    if (mapped_strm_ != nullptr && DMLC_IO_NO_ENDIAN_SWAP) {
+      tensor = runtime::CreateMappedFileView(file_, pos_, shape, dtype);
+      mapped_strm_->Seek(pos_ + nbytes);
+      pos_ += nbytes;
+    } else {
+      tensor = runtime::NDArray::Empty(shape, dtype, {kDLCPU, 0});
+      ReadBytes(tensor->data, nbytes);
+      if (!DMLC_IO_NO_ENDIAN_SWAP) {
+        int elem_bytes = (dtype.bits + 7) / 8;
+        dmlc::ByteSwap(tensor->data, elem_bytes, nbytes / elem_bytes);
+      }
+    }
+    tensors_.push_back(tensor);
+  }
+
+  // The elements reserved ahead for an array of a stream of unknown size.
+  static constexpr uint64_t kMaxReserve = 1 << 16;
+
+  dmlc::Stream* strm_;
+  dmlc::MemoryFixedSizeStream* mapped_strm_{nullptr};
+  std::shared_ptr<runtime::MappedFile> file_;
+  /*! \brief The number of bytes in the stream, the maximum size_t when unknown. */
+  size_t stream_size_;
+  /*! \brief The number of bytes read, to skip the padding of the tensor data. */
+  size_t pos_{0};
+  std::vector<ObjectPtr<Object>> nodes_{nullptr};
+  std::vector<runtime::NDArray> tensors_;
+  std::vector<std::string> type_keys_;
+  ReflectionVTable* reflection_ = ReflectionVTable::Global();
+};
+
+// Write only stream of a file.
+class FileOutStream : public dmlc::Stream {
+ public:
+  explicit FileOutStream(const std::string& file_name)
+      : fs_(file_name, std::ios::out | std::ios::binary), file_name_(file_name) {
+    ICHECK(!fs_.fail()) << "Cannot open " << file_name;
+  }
+  ~FileOutStream() { fs_.close(); }
+
+  size_t Read(void* ptr, size_t size) final {
+    LOG(FATAL) << "FileOutStream is not readable";
+    return 0;
+  }
+  void Write(const void* ptr, size_t size) final {
+    fs_.write(static_cast<const char*>(ptr), size);
+    ICHECK(!fs_.fail()) << "Cannot write " << file_name_;
+  }
+  using dmlc::Stream::Write;
+
+ private:
+  std::ofstream fs_;
+  std::string file_name_;
+};
+
+}  // namespace
+
+void SaveBinary(dmlc::Stream* strm, const ObjectRef& node) {
+  BinaryObjectWriter(strm).Save(node);
+}
+
+ObjectRef LoadBinary(dmlc::Stream* strm) { return BinaryObjectReader(strm).Load(); }
+
+void SaveBinaryFile(const std::string& file_name, const ObjectRef& node) {
+  FileOutStream strm(file_name);
+  SaveBinary(&strm, node);
+}
+
+ObjectRef LoadBinaryFile(const std::string& file_name) {
+  auto file = std::make_shared<runtime::MappedFile>(file_name);
+  dmlc::MemoryFixedSizeStream strm(file->data(), file->size());
+  return BinaryObjectReader(&strm, file).Load();
+}
+
+TVM_REGISTER_GLOBAL("node.SaveBinary")
+    .set_body([](runtime::TVMArgs args, runtime::TVMRetValue* rv) {
+      ObjectRef node = args[0];
+      std::string blob;
+      dmlc::MemoryStringStream strm(&blob);
+      SaveBinary(&strm, node);
+      // The return value copies the bytes, blob must still be alive.
+      TVMByteArray arr;
+      arr.data = blob.data();
+      arr.size = blob.size();
+      *rv = arr;
+    });
+
+TVM_REGISTER_GLOBAL("node.LoadBinary").set_body_typed([](std::string blob) {
+  dmlc::MemoryStringStream strm(&blob);
+  return BinaryObjectReader(&strm, blob.size()).Load();
+});
+
+TVM_REGISTER_GLOBAL("node.SaveBinaryFile").set_body_typed(SaveBinaryFile);
+
+TVM_REGISTER_GLOBAL("node.LoadBinaryFile").set_body_typed(LoadBinaryFile);
+}  // namespace tvm
@@ -607,8 +607,17 @@ class VMFunctionCompiler : ExprFunctor<void(const Expr& expr)> {
                  [this, call_node](const Array<Expr>& args, const Attrs& attrs,
                                    const Array<Type>& type_arg) {
                    ICHECK_EQ(args.size(), 2);
-                   // Compute the size of the allocation.
-                   this->VisitExpr(args[0]);
+                   // Compute the size of the allocation. A constant size is loaded as an
+                   // immediate, so CoalesceStorage can read and grow it.
+                   const auto* size_const = args[0].as<ConstantNode>();
+                   if (size_const != nullptr && size_const->data->ndim == 0 &&
+                       size_const->data->dtype.code == kDLInt &&
+                       size_const->data->dtype.bits == 64) {
+                     int64_t size = reinterpret_cast<int64_t*>(size_const->data->data)[0];
+                     Emit(Instruction::LoadConsti(size, NewRegister()));
+                   } else {
+                     this->VisitExpr(args[0]);
+                   }
                    auto size_register = last_register_;
 
                    ICHECK(args[1].as<ConstantNode>());
@@ -876,6 +885,16 @@ PackedFunc VMCompiler::GetFunction(const std::string& name, const ObjectPtr<Obje
       }
       *rv = ret;
     });
+  } else if (name == "get_storage_stats") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      auto as_int = [](int64_t value) { return IntImm(DataType::Int(64), value); };
+      Map<String, IntImm> ret;
+      ret.Set("num_storages", as_int(storage_stats_.num_storages));
+      ret.Set("num_coalesced", as_int(storage_stats_.num_coalesced));
+      ret.Set("static_peak_bytes_before", as_int(storage_stats_.static_peak_bytes_before));
+      ret.Set("static_peak_bytes_after", as_int(storage_stats_.static_peak_bytes_after));
+      *rv = ret;
+    });
   } else if (name == "optimize") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       ICHECK_EQ(args.num_args, 3);
@@ -926,6 +945,21 @@ void VMCompiler::Lower(IRModule mod, const TargetsMap& targets, const tvm::Targe
     }
   }
 
+  storage_stats_ = StorageCoalesceStats();
+  transform::PassContext pass_ctx = PassContext::Current();
+  if (pass_ctx->GetConfig<Bool>("relay.vm.coalesce_storage", Bool(false)).value()) {
+    for (auto& vm_func : exec_->functions) {
+      StorageCoalesceStats stats = CoalesceStorage(&vm_func);
+      storage_stats_.num_storages += stats.num_storages;
+      storage_stats_.num_coalesced += stats.num_coalesced;
+      // The peaks are per function, report the largest one.
+      storage_stats_.static_peak_bytes_before =
+          std::max(storage_stats_.static_peak_bytes_before, stats.static_peak_bytes_before);
+      storage_stats_.static_peak_bytes_after =
+          std::max(storage_stats_.static_peak_bytes_after, stats.static_peak_bytes_after);
+    }
+  }
+
 #if USE_RELAY_DEBUG
   for (auto vm_func : exec_->functions) {
     DLOG(INFO) << vm_func << "-------------";
@@ -85,6 +85,30 @@ struct VMCompilerContext {
   std::unordered_map<tir::PrimFunc, size_t, ObjectPtrHash, ObjectPtrEqual> seen_funcs;
 };
 
+/*! \brief The result of the storage coalescing of a VM function. */
+struct StorageCoalesceStats {
+  /*! \brief The number of AllocStorage instructions. */
+  int64_t num_storages{0};
+  /*! \brief The number of storages replaced by a dead one. */
+  int64_t num_coalesced{0};
+  /*!
+   * \brief The peak bytes of the storages of constant size, before and after. The VM frees
+   *  a storage when the function returns, so the peak is the sum of the allocated storages.
+   */
+  int64_t static_peak_bytes_before{0};
+  int64_t static_peak_bytes_after{0};
+};
+
+/*!
+ * \brief Reuse the storages of a function whose live ranges do not overlap.
+ *
+ *  Enabled by the "relay.vm.coalesce_storage" PassContext option.
+ *
+ * \param func The function, rewritten in place.
+ * \return The statistics of the rewrite.
+ */
+StorageCoalesceStats CoalesceStorage(VMFunction* func);
+
 class VMCompiler : public runtime::ModuleNode {
  public:
   virtual ~VMCompiler() {}
@@ -147,6 +171,8 @@ class VMCompiler : public runtime::ModuleNode {
   ObjectPtr<Executable> exec_;
   /*! \brief parameters */
   std::unordered_map<std::string, runtime::NDArray> params_;
+  /*! \brief The storage coalescing statistics of the last lowering. */
+  StorageCoalesceStats storage_stats_;
 };
 
 }  // namespace vm
@@ -0,0 +1,372 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/relay/backend/vm/storage_coalesce.cc
+ * \brief Liveness based reuse of the storages allocated by VM bytecode.
+ *
+ *  A storage is live from its AllocStorage to the last instruction reading a
+ *  register that may refer to it: the storage itself, the tensors allocated
+ *  in it and the values built from them. A storage passed to a call or
+ *  returned escapes and stays live. A later storage on the same device whose
+ *  AllocStorage is dominated by the one of a dead storage reuses it: its
+ *  AllocStorage becomes a Move of the dead storage.
+ *
+ *  Storages of constant size reuse the best fitting dead storage, growing it
+ *  when its size is only read by its AllocStorage. Storages of dynamic size
+ *  reuse a dead storage whose size is the same register, i.e. the same
+ *  symbolic size.
+ *
+ *  The bytecode has no backward jump, loops are recursive calls, so the
+ *  instruction order is a topological order of the control flow graph and
+ *  intervals of instruction indices are conservative live ranges.
+ */
+#include <tvm/ir/transform.h>
+#include <tvm/runtime/vm/bytecode.h>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "compiler.h"
+
+namespace tvm {
+namespace relay {
+namespace vm {
+
+TVM_REGISTER_PASS_CONFIG_OPTION("relay.vm.coalesce_storage", Bool);
+
+namespace {
+/*! \brief The live range end of an escaping storage. */
+constexpr Index kEscaped = std::numeric_limits<Index>::max();
+
+// Call f(reg, escapes) on each register read by the instruction.
+template <typename F>
+void ForEachRead(const Instruction& instr, F f) {
+  switch (instr.op) {
+    case Opcode::Move:
+      f(instr.from, false);
+      break;
+    case Opcode::Ret:
+      f(instr.result, true);
+      break;
+    case Opcode::Invoke:
+      for (Index i = 0; i < instr.num_args; ++i) f(instr.invoke_args_registers[i], true);
+      break;
+    case Opcode::InvokeClosure:
+      f(instr.closure, true);
+      for (Index i = 0; i < instr.num_closure_args; ++i) f(instr.closure_args[i], true);
+      break;
+    case Opcode::InvokePacked:
+      for (Index i = 0; i < instr.arity; ++i) f(instr.packed_args[i], false);
+      break;
+    case Opcode::AllocTensor:
+      f(instr.alloc_tensor.storage, false);
+      f(instr.alloc_tensor.offset, false);
+      break;
+    case Opcode::AllocTensorReg:
+      f(instr.alloc_tensor_reg.storage, false);
+      f(instr.alloc_tensor_reg.offset, false);
+      f(instr.alloc_tensor_reg.shape_register, false);
+      break;
+    case Opcode::AllocADT:
+      for (Index i = 0; i < instr.num_fields; ++i) f(instr.datatype_fields[i], false);
+      break;
+    case Opcode::AllocClosure:
+      for (Index i = 0; i < instr.num_freevar; ++i) f(instr.free_vars[i], false);
+      break;
+    case Opcode::GetField:
+      f(instr.object, false);
+      break;
+    case Opcode::GetTag:
+      f(instr.get_tag.object, false);
+      break;
+    case Opcode::If:
+      f(instr.if_op.test, false);
+      f(instr.if_op.target, false);
+      break;
+    case Opcode::AllocStorage:
+      f(instr.alloc_storage.allocation_size, false);
+      break;
+    case Opcode::ShapeOf:
+      f(instr.shape_of.tensor, false);
+      break;
+    case Opcode::ReshapeTensor:
+      f(instr.reshape_tensor.tensor, false);
+      f(instr.reshape_tensor.newshape, false);
+      break;
+    case Opcode::DeviceCopy:
+      f(instr.src, false);
+      break;
+    default:
+      break;
+  }
+}
+
+bool HasDst(Opcode op) {
+  return op != Opcode::Ret && op != Opcode::Fatal && op != Opcode::Goto && op != Opcode::If &&
+         op != Opcode::InvokePacked;
+}
+
+// Whether the destination may refer to the storages of the registers read.
+bool DstAliasesReads(Opcode op) {
+  switch (op) {
+    case Opcode::Move:
+    case Opcode::Invoke:
+    case Opcode::InvokeClosure:
+    case Opcode::AllocTensor:
+    case Opcode::AllocTensorReg:
+    case Opcode::AllocADT:
+    case Opcode::AllocClosure:
+    case Opcode::GetField:
+    case Opcode::ReshapeTensor:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/*! \brief The basic blocks of a function and their immediate dominators. */
+struct DominatorTree {
+  std::vector<int> block_of;
+  std::vector<int> idom;
+
+  // Build the tree, fails when the function has a backward jump.
+  bool Build(const std::vector<Instruction>& code) {
+    size_t n = code.size();
+    std::vector<bool> leader(n + 1, false);
+    leader[0] = true;
+    for (size_t pc = 0; pc < n; ++pc) {
+      const Instruction& instr = code[pc];
+      if (instr.op == Opcode::If) {
+        if (instr.if_op.true_offset <= 0 || instr.if_op.false_offset <= 0) return false;
+        if (pc + instr.if_op.true_offset > n || pc + instr.if_op.false_offset > n) return false;
+        leader[pc + instr.if_op.true_offset] = true;
+        leader[pc + instr.if_op.false_offset] = true;
+        leader[pc + 1] = true;
+      } else if (instr.op == Opcode::Goto) {
+        if (instr.pc_offset <= 0 || pc + instr.pc_offset > n) return false;
+        leader[pc + instr.pc_offset] = true;
+        leader[pc + 1] = true;
+      } else if (instr.op == Opcode::Ret || instr.op == Opcode::Fatal) {
+        leader[pc + 1] = true;
+      }
+    }
+    block_of.resize(n);
+    std::vector<size_t> block_end;
+    for (size_t pc = 0; pc < n; ++pc) {
+      if (leader[pc] && pc != 0) block_end.push_back(pc - 1);
+      block_of[pc] = static_cast<int>(block_end.size());
+    }
+    if (n != 0) block_end.push_back(n - 1);
+
+    std::vector<std::vector<int>> preds(block_end.size());
+    auto add_edge = [&](int from, size_t to_pc) {
+      if (to_pc < n) preds[block_of[to_pc]].push_back(from);
+    };
+    for (int b = 0; b < static_cast<int>(block_end.size()); ++b) {
+      size_t pc = block_end[b];
+      const Instruction& instr = code[pc];
+      if (instr.op == Opcode::If) {
+        add_edge(b, pc + instr.if_op.true_offset);
+        add_edge(b, pc + instr.if_op.false_offset);
+      } else if (instr.op == Opcode::Goto) {
+        add_edge(b, pc + instr.pc_offset);
+      } else if (instr.op != Opcode::Ret && instr.op != Opcode::Fatal) {
+        add_edge(b, pc + 1);
+      }
+    }
+    // The edges go forward, so the blocks are visited after their predecessors.
+    idom.assign(block_end.size(), -1);
+    if (!idom.empty()) idom[0] = 0;
+    for (size_t b = 1; b < block_end.size(); ++b) {
+      int dom = -1;
+      for (int p : preds[b]) {
+        if (idom[p] < 0) continue;
+        dom = dom < 0 ? p : Intersect(dom, p);
+      }
+      idom[b] = dom;
+    }
+    return true;
+  }
+
+  // Whether the instruction at pc a dominates the one at pc b > a.
+  bool Dominates(size_t a, size_t b) const {
+    int ba = block_of[a];
+    int bb = block_of[b];
+    while (bb > ba) bb = idom[bb];
+    return bb == ba;
+  }
+
+ private:
+  int Intersect(int a, int b) const {
+    while (a != b) {
+      while (a > b) a = idom[a];
+      while (b > a) b = idom[b];
+    }
+    return a;
+  }
+};
+
+/*! \brief A storage allocated by the function. */
+struct StorageInfo {
+  /*! \brief The AllocStorage instruction. */
+  size_t pc;
+  RegName reg;
+  /*! \brief The constant size, -1 when dynamic. */
+  int64_t size;
+  RegName size_reg;
+  /*! \brief The LoadConsti of the size, -1 when dynamic. */
+  int64_t size_pc;
+  Index device_type;
+  Index alignment;
+  /*! \brief The last instruction using the storage. */
+  Index last_use;
+  /*! \brief Whether the storage register is written once, so it can be moved. */
+  bool movable;
+};
+
+/*! \brief A storage kept by the rewritten function, with the storages reusing it. */
+struct Region {
+  int root;
+  int64_t size;
+  Index end;
+};
+
+}  // namespace
+
+StorageCoalesceStats CoalesceStorage(VMFunction* func) {
+  StorageCoalesceStats stats;
+  std::vector<Instruction>& code = func->instructions;
+  DominatorTree dom;
+  if (!dom.Build(code)) return stats;
+
+  size_t num_regs = static_cast<size_t>(func->register_file_size);
+  std::vector<int> num_writes(num_regs, 0), num_reads(num_regs, 0);
+  for (const Instruction& instr : code) {
+    ForEachRead(instr, [&](RegName r, bool) { ++num_reads[r]; });
+    if (HasDst(instr.op)) ++num_writes[instr.dst];
+  }
+
+  // Compute the live range of each storage in one pass, the registers are
+  // written before they are read in instruction order.
+  std::vector<StorageInfo> storages;
+  std::vector<std::vector<int>> alias(num_regs);
+  std::vector<int64_t> const_pc(num_regs, -1);
+  for (size_t pc = 0; pc < code.size(); ++pc) {
+    const Instruction& instr = code[pc];
+    std::vector<int> read_alias;
+    ForEachRead(instr, [&](RegName r, bool escapes) {
+      for (int sid : alias[r]) {
+        Index& last_use = storages[sid].last_use;
+        last_use = escapes ? kEscaped : std::max(last_use, static_cast<Index>(pc));
+        read_alias.push_back(sid);
+      }
+    });
+    if (instr.op == Opcode::LoadConsti && num_writes[instr.dst] == 1) {
+      const_pc[instr.dst] = static_cast<int64_t>(pc);
+    } else if (instr.op == Opcode::AllocStorage) {
+      StorageInfo s;
+      s.pc = pc;
+      s.reg = instr.dst;
+      s.size_reg = instr.alloc_storage.allocation_size;
+      s.size_pc = const_pc[s.size_reg];
+      s.size = s.size_pc >= 0 ? code[s.size_pc].load_consti.val : -1;
+      s.device_type = instr.alloc_storage.device_type;
+      s.alignment = instr.alloc_storage.alignment;
+      s.last_use = static_cast<Index>(pc);
+      s.movable = num_writes[instr.dst] == 1 && (s.size >= 0 || num_writes[s.size_reg] == 1);
+      alias[instr.dst].push_back(static_cast<int>(storages.size()));
+      storages.push_back(s);
+    } else if (DstAliasesReads(instr.op)) {
+      std::vector<int>& dst = alias[instr.dst];
+      dst.insert(dst.end(), read_alias.begin(), read_alias.end());
+      std::sort(dst.begin(), dst.end());
+      dst.erase(std::unique(dst.begin(), dst.end()), dst.end());
+    }
+  }
+
+  std::vector<Region> regions;
+  for (size_t sid = 0; sid < storages.size(); ++sid) {
+    const StorageInfo& s = storages[sid];
+    int best = -1;
+    for (size_t r = 0; r < regions.size() && s.movable; ++r) {
+      const StorageInfo& root = storages[regions[r].root];
+      if (!root.movable || root.device_type != s.device_type ||
+          regions[r].end >= static_cast<Index>(s.pc) || !dom.Dominates(root.pc, s.pc)) {
+        continue;
+      }
+      if (s.size < 0 || root.size < 0) {
+        // Dynamic sizes are only shared within the bucket of their symbolic size.
+        if (s.size < 0 && root.size < 0 && s.size_reg == root.size_reg) {
+          best = static_cast<int>(r);
+          break;
+        }
+        continue;
+      }
+      bool growable = num_reads[root.size_reg] == 1;
+      if (regions[r].size < s.size && !growable) continue;
+      if (best < 0) {
+        best = static_cast<int>(r);
+        continue;
+      }
+      // Prefer the smallest region that fits, then the largest one to grow.
+      int64_t best_size = regions[best].size;
+      int64_t size = regions[r].size;
+      bool best_fits = best_size >= s.size;
+      bool fits = size >= s.size;
+      if ((fits && (!best_fits || size < best_size)) || (!fits && !best_fits && size > best_size)) {
+        best = static_cast<int>(r);
+      }
+    }
+    if (best < 0) {
+      regions.push_back({static_cast<int>(sid), s.size, s.last_use});
+      continue;
+    }
+    Region& region = regions[best];
+    StorageInfo& root = storages[region.root];
+    code[s.pc] = Instruction::Move(root.reg, s.reg);
+    region.end = std::max(region.end, s.last_use);
+    if (s.size > region.size) {
+      region.size = s.size;
+      code[root.size_pc].load_consti.val = s.size;
+    }
+    if (s.alignment > root.alignment) {
+      root.alignment = s.alignment;
+      code[root.pc].alloc_storage.alignment = s.alignment;
+    }
+    ++stats.num_coalesced;
+  }
+
+  // The registers of a frame keep their storages alive until the function
+  // returns, so at the end every storage allocated so far is still held.
+  for (const StorageInfo& s : storages) {
+    if (s.size >= 0) stats.static_peak_bytes_before += s.size;
+  }
+  for (const Region& r : regions) {
+    if (r.size >= 0) stats.static_peak_bytes_after += r.size;
+  }
+  stats.num_storages = static_cast<int64_t>(storages.size());
+  return stats;
+}
+
+}  // namespace vm
+}  // namespace relay
+}  // namespace tvm
@@ -23,19 +23,95 @@
 #include <dmlc/thread_local.h>
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
 #include <tvm/support/logging.h>
 
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
+#include <unordered_map>
 
 #include "workspace_pool.h"
 
 #ifdef __ANDROID__
 #include <android/api-level.h>
 #endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
 
 namespace tvm {
 namespace runtime {
+/*!
+ * \brief Allocator of large buffers that leaves the physical placement to the first touch.
+ *
+ *  malloc may hand out recycled pages that already live on the node of the
+ *  allocating thread. On multi-node hosts with TVM_NUMA_FIRST_TOUCH=1, large
+ *  buffers are instead mapped fresh, so each page lands on the node of the
+ *  worker that first writes it, e.g. the workers producing a graph storage
+ *  entry or the worker owning a thread local workspace.
+ */
+class FirstTouchAllocator {
+ public:
+  // Buffers smaller than this stay with malloc.
+  static constexpr size_t kMinBytes = 1 << 20;
+
+  /*! \return Whether first touch allocation is enabled. */
+  static bool Enabled() {
+#if defined(__linux__)
+    static bool enabled = []() {
+      const char* val = getenv("TVM_NUMA_FIRST_TOUCH");
+      return val != nullptr && atoi(val) != 0 && threading::NumNumaNodes() > 1;
+    }();
+    return enabled;
+#else
+    return false;
+#endif
+  }
+
+  void* Alloc(size_t nbytes) {
+#if defined(__linux__)
+    void* ptr = mmap(nullptr, nbytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) throw std::bad_alloc();
+    std::lock_guard<std::mutex> lock(mutex_);
+    sizes_[ptr] = nbytes;
+    return ptr;
+#else
+    throw std::bad_alloc();
+#endif
+  }
+
+  /*!
+   * \brief Free a buffer if it was allocated by this allocator.
+   * \return Whether the buffer was freed.
+   */
+  bool Free(void* ptr) {
+#if defined(__linux__)
+    size_t nbytes;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = sizes_.find(ptr);
+      if (it == sizes_.end()) return false;
+      nbytes = it->second;
+      sizes_.erase(it);
+    }
+    munmap(ptr, nbytes);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  static FirstTouchAllocator* Global() {
+    static auto* inst = new FirstTouchAllocator();
+    return inst;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<void*, size_t> sizes_;
+};
+
 class CPUDeviceAPI final : public DeviceAPI {
  public:
   void SetDevice(TVMContext ctx) final {}
@@ -46,6 +122,11 @@ class CPUDeviceAPI final : public DeviceAPI {
   }
   void* AllocDataSpace(TVMContext ctx, size_t nbytes, size_t alignment,
                        DLDataType type_hint) final {
+    // mmap returns page aligned memory.
+    if (nbytes >= FirstTouchAllocator::kMinBytes && alignment <= 4096 &&
+        FirstTouchAllocator::Enabled()) {
+      return FirstTouchAllocator::Global()->Alloc(nbytes);
+    }
     void* ptr;
 #if _MSC_VER
     ptr = _aligned_malloc(nbytes, alignment);
@@ -62,6 +143,7 @@ class CPUDeviceAPI final : public DeviceAPI {
   }
 
   void FreeDataSpace(TVMContext ctx, void* ptr) final {
+    if (FirstTouchAllocator::Enabled() && FirstTouchAllocator::Global()->Free(ptr)) return;
 #if _MSC_VER
     _aligned_free(ptr);
 #else
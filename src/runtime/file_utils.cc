@@ -26,8 +26,19 @@
 #include <tvm/runtime/serializer.h>
 #include <tvm/support/logging.h>
 
+#if defined(__linux__) || defined(__APPLE__) || defined(__ANDROID__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TVM_FILE_UTILS_USE_MMAP 1
+#else
+#define TVM_FILE_UTILS_USE_MMAP 0
+#endif
+
 #include <fstream>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace tvm {
@@ -157,5 +168,61 @@ void LoadMetaDataFromFile(const std::string& file_name,
 
 void RemoveFile(const std::string& file_name) { std::remove(file_name.c_str()); }
 
+MappedFile::MappedFile(const std::string& file_name) {
+#if TVM_FILE_UTILS_USE_MMAP
+  int fd = open(file_name.c_str(), O_RDONLY);
+  ICHECK_GE(fd, 0) << "Cannot open " << file_name;
+  struct stat st;
+  int stat_res = fstat(fd, &st);
+  size_ = stat_res == 0 ? static_cast<size_t>(st.st_size) : 0;
+  void* ptr = nullptr;
+  if (size_ != 0) {
+    // The private mapping shares the clean pages with the other processes
+    // mapping the file, a write to a tensor only copies the written page.
+    ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  }
+  // The mapping does not need the descriptor, close it before any check can throw.
+  close(fd);
+  ICHECK_EQ(stat_res, 0) << "Cannot stat " << file_name;
+  ICHECK(ptr != MAP_FAILED) << "Cannot map " << file_name;
+  data_ = static_cast<char*>(ptr);
+#else
+  std::ifstream fs(file_name, std::ios::in | std::ios::binary);
+  ICHECK(!fs.fail()) << "Cannot open " << file_name;
+  fs.seekg(0, std::ios::end);
+  size_ = static_cast<size_t>(fs.tellg());
+  fs.seekg(0, std::ios::beg);
+  // An NDArray gives the buffer the alignment of the device allocations.
+  buffer_ = NDArray::Empty({static_cast<int64_t>(size_)}, {kDLUInt, 8, 1}, {kDLCPU, 0});
+  data_ = static_cast<char*>(buffer_->data);
+  fs.read(data_, size_);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if TVM_FILE_UTILS_USE_MMAP
+  if (data_ != nullptr) munmap(data_, size_);
+#endif
+}
+
+namespace {
+// Free a tensor viewing a mapped file, releasing its reference to the mapping.
+void MappedFileViewDeleter(Object* obj) {
+  auto* ptr = static_cast<NDArray::Container*>(obj);
+  delete static_cast<std::shared_ptr<MappedFile>*>(ptr->manager_ctx);
+  delete ptr;
+}
+}  // namespace
+
+NDArray CreateMappedFileView(const std::shared_ptr<MappedFile>& file, size_t offset,
+                             std::vector<int64_t> shape, DLDataType dtype) {
+  ICHECK_LE(offset, file->size());
+  std::unique_ptr<NDArray::Container> container(
+      new NDArray::Container(file->data() + offset, std::move(shape), dtype, {kDLCPU, 0}));
+  container->manager_ctx = new std::shared_ptr<MappedFile>(file);
+  container->SetDeleter(MappedFileViewDeleter);
+  return NDArray(GetObjectPtr<Object>(container.release()));
+}
+
 }  // namespace runtime
 }  // namespace tvm
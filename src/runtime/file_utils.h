@@ -24,8 +24,13 @@
 #ifndef TVM_RUNTIME_FILE_UTILS_H_
 #define TVM_RUNTIME_FILE_UTILS_H_
 
+#include <tvm/runtime/ndarray.h>
+
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "meta_data.h"
 
@@ -92,6 +97,54 @@ void LoadMetaDataFromFile(const std::string& file_name,
  * \param file_name The file name.
  */
 void RemoveFile(const std::string& file_name);
+
+/*! \brief The content of a whole file, mapped when the platform allows it. */
+class MappedFile {
+ public:
+  /*!
+   * \brief Map a file.
+   * \param file_name The name of the file.
+   */
+  explicit MappedFile(const std::string& file_name);
+  ~MappedFile();
+  // The destructor unmaps the file, a copy would unmap it twice.
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept
+      : data_(other.data_), size_(other.size_), buffer_(std::move(other.buffer_)) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+  MappedFile& operator=(MappedFile&& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(buffer_, other.buffer_);
+    return *this;
+  }
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  char* data_{nullptr};
+  size_t size_{0};
+  /*! \brief The content of the file, when the platform has no mmap. */
+  NDArray buffer_;
+};
+
+/*!
+ * \brief Create a CPU tensor viewing the data of a mapped file.
+ *
+ *  The tensor keeps the mapping alive.
+ *
+ * \param file The mapped file.
+ * \param offset The offset of the data in the file, a multiple of kAllocAlignment.
+ * \param shape The shape of the tensor.
+ * \param dtype The data type of the tensor.
+ * \return The tensor.
+ */
+NDArray CreateMappedFileView(const std::shared_ptr<MappedFile>& file, size_t offset,
+                             std::vector<int64_t> shape, DLDataType dtype);
 }  // namespace runtime
 }  // namespace tvm
 #endif  // TVM_RUNTIME_FILE_UTILS_H_
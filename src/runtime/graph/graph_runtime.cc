@@ -23,17 +23,25 @@
 #include "graph_runtime.h"
 
 #include <tvm/runtime/container.h>
+#include <tvm/runtime/data_type.h>
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/packed_func.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/serializer.h>
+#include <tvm/runtime/threading_backend.h>
 
 #include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <numeric>
+#include <queue>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -48,15 +56,216 @@ inline size_t GetDataAlignment(const DLTensor& arr) {
 }
 }  // namespace details
 
+/*!
+ * \brief Executor threads that run the nodes of a graph as soon as their dependencies are done.
+ *
+ *  The ready nodes are picked in node order, so the execution stays close to
+ *  the sequential order the memory plan was made for.
+ */
+class GraphRuntime::InterOpScheduler {
+ public:
+  InterOpScheduler(int num_executors, int intra_op_threads) {
+    for (int i = 0; i < num_executors; ++i) {
+      // Executor i gets the cores [i * intra_op_threads, (i + 1) * intra_op_threads),
+      // wrapping around when the executors ask for more cores than there are.
+      int first_core = i * intra_op_threads;
+      executors_.emplace_back([this, intra_op_threads, first_core] {
+        this->ExecutorLoop(intra_op_threads, first_core);
+      });
+    }
+  }
+
+  ~InterOpScheduler() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (std::thread& t : executors_) t.join();
+  }
+
+  void Run(const std::vector<std::function<void()>>& execs,
+           const std::vector<std::vector<uint32_t>>& succs,
+           const std::vector<uint32_t>& num_deps) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    execs_ = &execs;
+    succs_ = &succs;
+    pending_ = num_deps;
+    remaining_ = execs.size();
+    error_ = nullptr;
+    for (uint32_t nid = 0; nid < pending_.size(); ++nid) {
+      if (pending_[nid] == 0) ready_.push(nid);
+    }
+    work_cv_.notify_all();
+    done_cv_.wait(lock, [this] { return remaining_ == 0; });
+    execs_ = nullptr;
+    succs_ = nullptr;
+    if (error_ != nullptr) std::rethrow_exception(error_);
+  }
+
+ private:
+  void ExecutorLoop(int intra_op_threads, int first_core) {
+    // The thread pool of this executor only serves the nodes it runs, on its own cores.
+    // In shared thread pool mode all the executors share one pool and
+    // intra_op_threads is the quota of each.
+    const PackedFunc* fconfig = Registry::Get("runtime.config_threadpool");
+    if (fconfig != nullptr) {
+      (*fconfig)(static_cast<int>(threading::ThreadGroup::kBig), intra_op_threads, first_core);
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      work_cv_.wait(lock, [this] { return stop_ || !ready_.empty(); });
+      if (stop_) return;
+      uint32_t nid = ready_.top();
+      ready_.pop();
+      const std::function<void()>& fexec = (*execs_)[nid];
+      // Once a node failed, the remaining nodes are drained without running them.
+      if (fexec && error_ == nullptr) {
+        lock.unlock();
+        try {
+          fexec();
+          lock.lock();
+        } catch (...) {
+          lock.lock();
+          if (error_ == nullptr) error_ = std::current_exception();
+        }
+      }
+      int num_ready = 0;
+      for (uint32_t succ : (*succs_)[nid]) {
+        if (--pending_[succ] == 0) {
+          ready_.push(succ);
+          ++num_ready;
+        }
+      }
+      // This executor takes one of the ready nodes itself.
+      for (int i = 1; i < num_ready; ++i) work_cv_.notify_one();
+      if (--remaining_ == 0) done_cv_.notify_one();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::vector<std::thread> executors_;
+  // The state of the current run, guarded by mutex_.
+  const std::vector<std::function<void()>>* execs_{nullptr};
+  const std::vector<std::vector<uint32_t>>* succs_{nullptr};
+  std::vector<uint32_t> pending_;
+  std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready_;
+  size_t remaining_{0};
+  std::exception_ptr error_;
+  bool stop_{false};
+};
+
+/*!
+ * \brief Activation arenas shared by the instances of a graph.
+ *
+ *  An arena holds one buffer per storage id of the graph, leaving out the
+ *  storage of the parameters. The pool keeps at most one arena per live
+ *  instance, the idle arenas beyond that are freed when an instance goes
+ *  away. The instances own the pool, it is freed with the last of them.
+ */
+class GraphRuntime::ActivationPool {
+ public:
+  /*! \brief The buffer of one storage id, ctx.device_type is 0 for the parameters. */
+  struct StorageEntry {
+    std::vector<int64_t> shape;
+    DLDataType dtype;
+    TVMContext ctx{static_cast<DLDeviceType>(0), 0};
+  };
+
+  explicit ActivationPool(std::vector<StorageEntry> layout) : layout_(std::move(layout)) {}
+
+  std::vector<NDArray> Acquire() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!free_.empty()) {
+        std::vector<NDArray> arena = std::move(free_.back());
+        free_.pop_back();
+        return arena;
+      }
+      ++num_arenas_;
+    }
+    std::vector<NDArray> arena(layout_.size());
+    for (size_t sid = 0; sid < layout_.size(); ++sid) {
+      const StorageEntry& e = layout_[sid];
+      if (e.ctx.device_type == 0) continue;
+      arena[sid] = NDArray::Empty(e.shape, e.dtype, e.ctx);
+    }
+    return arena;
+  }
+
+  void Release(std::vector<NDArray> arena) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(std::move(arena));
+  }
+
+  /*! \brief Register an instance drawing its activations from the pool. */
+  void AddInstance() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++num_instances_;
+  }
+
+  /*! \brief Unregister an instance, which has released its arena, and free the idle surplus. */
+  void RemoveInstance() {
+    std::vector<std::vector<NDArray>> surplus;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --num_instances_;
+      while (num_arenas_ > num_instances_ && !free_.empty()) {
+        surplus.push_back(std::move(free_.back()));
+        free_.pop_back();
+        --num_arenas_;
+      }
+    }
+    // The surplus arenas are freed here, outside the lock.
+  }
+
+  int NumArenas() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_arenas_;
+  }
+
+ private:
+  std::vector<StorageEntry> layout_;
+  std::mutex mutex_;
+  std::vector<std::vector<NDArray>> free_;
+  int num_arenas_{0};
+  int num_instances_{0};
+};
+
+GraphRuntime::~GraphRuntime() {
+  if (activation_pool_ != nullptr) {
+    ReleaseActivations();
+    activation_pool_->RemoveInstance();
+  }
+}
+
 /*!
  * \brief Run all the operations one by one.
  */
 void GraphRuntime::Run() {
+  EnsureActivations();
+  if (inter_op_ != nullptr) {
+    inter_op_->Run(op_execs_, op_succs_, op_num_deps_);
+    return;
+  }
   // setup the array and requirements.
   for (size_t i = 0; i < op_execs_.size(); ++i) {
     if (op_execs_[i]) op_execs_[i]();
   }
 }
+
+void GraphRuntime::SetInterOpParallelism(int num_executors, int intra_op_threads) {
+  ICHECK_GE(num_executors, 1) << "The number of executors must be positive";
+  ICHECK_GE(intra_op_threads, 0) << "The number of intra-op threads must be non-negative";
+  inter_op_ = nullptr;
+  if (num_executors == 1) return;
+  if (intra_op_threads == 0) {
+    intra_op_threads = std::max(1, threading::MaxConcurrency() / num_executors);
+  }
+  inter_op_ = std::make_shared<InterOpScheduler>(num_executors, intra_op_threads);
+}
 /*!
  * \brief Initialize the graph executor with graph and context.
  * \param graph_json The execution graph.
@@ -80,11 +289,17 @@ void GraphRuntime::Init(const std::string& graph_json, tvm::runtime::Module modu
   }
   this->SetupStorage();
   this->SetupOpExecs();
+  this->SetupOpDeps();
   for (size_t i = 0; i < input_nodes_.size(); i++) {
     const uint32_t nid = input_nodes_[i];
     std::string& name = nodes_[nid].name;
     input_map_[name] = i;
   }
+  // The inter-op scheduler is opt-in, e.g. TVM_GRAPH_RUNTIME_INTER_OP_THREADS=4.
+  if (const char* val = getenv("TVM_GRAPH_RUNTIME_INTER_OP_THREADS")) {
+    const char* intra = getenv("TVM_GRAPH_RUNTIME_INTRA_OP_THREADS");
+    this->SetInterOpParallelism(std::max(1, atoi(val)), intra ? atoi(intra) : 0);
+  }
 }
 /*!
  * \brief Get the input index given the name of input.
@@ -105,9 +320,20 @@ int GraphRuntime::GetInputIndex(const std::string& name) {
  */
 void GraphRuntime::SetInput(int index, DLTensor* data_in) {
   ICHECK_LT(static_cast<size_t>(index), input_nodes_.size());
+  EnsureActivations();
   uint32_t eid = this->entry_id(input_nodes_[index], 0);
   data_entry_[eid].CopyFrom(data_in);
 }
+/*!
+ * \brief set index-th input to a parameter value.
+ * \param index The input index.
+ * \param data_in The parameter value.
+ */
+void GraphRuntime::SetParam(int index, DLTensor* data_in) {
+  ICHECK(activation_pool_ == nullptr) << "The parameters of a shared instance are read-only";
+  this->SetInput(index, data_in);
+  param_eids_.insert(this->entry_id(input_nodes_[index], 0));
+}
 /*!
  * \brief set index-th input to the graph without copying the data.
  * \param index The input index.
@@ -115,6 +341,7 @@ void GraphRuntime::SetInput(int index, DLTensor* data_in) {
  */
 void GraphRuntime::SetInputZeroCopy(int index, DLTensor* data_ref) {
   ICHECK_LT(static_cast<size_t>(index), input_nodes_.size());
+  EnsureActivations();
   uint32_t eid = this->entry_id(input_nodes_[index], 0);
   const DLTensor* old_t = data_entry_[eid].operator->();
 
@@ -151,8 +378,9 @@ int GraphRuntime::NumInputs() const { return input_nodes_.size(); }
  *
  * \return NDArray corresponding to given input node index.
  */
-NDArray GraphRuntime::GetInput(int index) const {
+NDArray GraphRuntime::GetInput(int index) {
   ICHECK_LT(static_cast<size_t>(index), input_nodes_.size());
+  EnsureActivations();
   uint32_t eid = this->entry_id(input_nodes_[index], 0);
   return data_entry_[eid];
 }
@@ -162,8 +390,9 @@ NDArray GraphRuntime::GetInput(int index) const {
  *
  * \return NDArray corresponding to given output node index.
  */
-NDArray GraphRuntime::GetOutput(int index) const {
+NDArray GraphRuntime::GetOutput(int index) {
   ICHECK_LT(static_cast<size_t>(index), outputs_.size());
+  EnsureActivations();
   uint32_t eid = this->entry_id(outputs_[index]);
   return data_entry_[eid];
 }
@@ -174,6 +403,7 @@ NDArray GraphRuntime::GetOutput(int index) const {
  */
 void GraphRuntime::CopyOutputTo(int index, DLTensor* data_out) {
   ICHECK_LT(static_cast<size_t>(index), outputs_.size());
+  EnsureActivations();
   uint32_t eid = this->entry_id(outputs_[index]);
 
   // Check the shapes to avoid receiving in different dimension but same size.
@@ -221,7 +451,41 @@ void GraphRuntime::LoadParams(dmlc::Stream* strm) {
     NDArray temp;
     temp.Load(strm);
     data_entry_[eid].CopyFrom(temp);
+    param_eids_.insert(eid);
+  }
+}
+
+void GraphRuntime::LoadParamsFromFile(const std::string& file_name) {
+  bool replaced = false;
+  for (auto& kv : runtime::LoadParamsFromFile(file_name)) {
+    int in_idx = GetInputIndex(kv.first);
+    if (in_idx < 0) continue;
+    uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
+    ICHECK_LT(eid, data_entry_.size());
+    const NDArray& param = kv.second;
+    param_eids_.insert(eid);
+    const DLTensor* old_t = data_entry_[eid].operator->();
+    bool zero_copy = old_t->ctx.device_type == kDLCPU && param->ndim == old_t->ndim &&
+                     std::equal(old_t->shape, old_t->shape + old_t->ndim, param->shape) &&
+                     TypeEqual(old_t->dtype, param->dtype) &&
+                     reinterpret_cast<size_t>(param->data) % kAllocAlignment == 0;
+    if (!zero_copy) {
+      data_entry_[eid].CopyFrom(param);
+      continue;
+    }
+    data_entry_[eid] = param;
+    data_alignment_[eid] = details::GetDataAlignment(*param.operator->());
+    replaced = true;
+    // Release the storage of the parameter if no other entry uses it.
+    int sid = attrs_.storage_id[eid];
+    bool shared = false;
+    for (size_t i = 0; i < data_entry_.size(); ++i) {
+      shared |= i != eid && attrs_.storage_id[i] == sid;
+    }
+    if (!shared) storage_pool_[sid] = NDArray();
   }
+  // The executors hold the data pointers of the replaced entries.
+  if (replaced) this->SetupOpExecs();
 }
 
 void GraphRuntime::ShareParams(const GraphRuntime& other, dmlc::Stream* strm) {
@@ -241,14 +505,93 @@ void GraphRuntime::ShareParams(const GraphRuntime& other, dmlc::Stream* strm) {
     uint32_t eid = this->entry_id(input_nodes_[in_idx], 0);
     ICHECK_LT(eid, data_entry_.size());
     ICHECK_EQ(data_entry_[eid].use_count(), 1);
-    data_entry_[eid] = other.GetInput(GetInputIndex(names[i]));
+    data_entry_[eid] = other.data_entry_[other.entry_id(other.input_nodes_[in_idx], 0)];
     ICHECK_GT(data_entry_[eid].use_count(), 1);
     const DLTensor* tmp = data_entry_[eid].operator->();
     data_alignment_[eid] = details::GetDataAlignment(*tmp);
+    param_eids_.insert(eid);
   }
   this->SetupOpExecs();
 }
 
+Module GraphRuntime::CreateSharedInstance() {
+  std::shared_ptr<ActivationPool> pool = instance_pool_.lock();
+  if (pool == nullptr) {
+    if (activation_pool_ != nullptr) {
+      // An instance creates its siblings.
+      pool = activation_pool_;
+    } else {
+      std::vector<ActivationPool::StorageEntry> layout(storage_pool_.size());
+      std::unordered_set<int> param_sids;
+      for (uint32_t eid : param_eids_) param_sids.insert(attrs_.storage_id[eid]);
+      for (size_t sid = 0; sid < storage_pool_.size(); ++sid) {
+        if (param_sids.count(static_cast<int>(sid))) continue;
+        const NDArray& storage = storage_pool_[sid];
+        ICHECK(storage.defined());
+        layout[sid].shape.assign(storage->shape, storage->shape + storage->ndim);
+        layout[sid].dtype = storage->dtype;
+        layout[sid].ctx = storage->ctx;
+      }
+      pool = std::make_shared<ActivationPool>(std::move(layout));
+    }
+    instance_pool_ = pool;
+  }
+  auto exec = make_object<GraphRuntime>();
+  exec->InitSharedInstance(*this, pool);
+  return Module(exec);
+}
+
+void GraphRuntime::InitSharedInstance(const GraphRuntime& other,
+                                      std::shared_ptr<ActivationPool> pool) {
+  nodes_ = other.nodes_;
+  input_nodes_ = other.input_nodes_;
+  input_map_ = other.input_map_;
+  node_row_ptr_ = other.node_row_ptr_;
+  outputs_ = other.outputs_;
+  attrs_ = other.attrs_;
+  module_ = other.module_;
+  ctxs_ = other.ctxs_;
+  data_alignment_ = other.data_alignment_;
+  param_eids_ = other.param_eids_;
+  activation_pool_ = std::move(pool);
+  activation_pool_->AddInstance();
+  // The parameters are shared, the activations come from the arenas.
+  data_entry_.assign(num_node_entries(), NDArray());
+  for (uint32_t eid : param_eids_) data_entry_[eid] = other.data_entry_[eid];
+  // Bind the executors to an arena once, then give it back until the instance is used.
+  this->AcquireActivations();
+  this->SetupOpExecs();
+  this->SetupOpDeps();
+  this->ReleaseActivations();
+}
+
+void GraphRuntime::AcquireActivations() {
+  arena_ = activation_pool_->Acquire();
+  for (size_t eid = 0; eid < data_entry_.size(); ++eid) {
+    if (param_eids_.count(eid)) continue;
+    int sid = attrs_.storage_id[eid];
+    data_entry_[eid] =
+        arena_[sid].CreateView(attrs_.shape[eid], String2DLDataType(attrs_.dltype[eid]));
+    if (eid < input_dltensors_.size()) {
+      for (DLTensor* t : input_dltensors_[eid]) t->data = data_entry_[eid]->data;
+    }
+  }
+}
+
+void GraphRuntime::ReleaseActivations() {
+  if (activation_pool_ == nullptr || arena_.empty()) return;
+  for (size_t eid = 0; eid < data_entry_.size(); ++eid) {
+    if (!param_eids_.count(eid)) data_entry_[eid] = NDArray();
+  }
+  activation_pool_->Release(std::move(arena_));
+  arena_.clear();
+}
+
+int GraphRuntime::NumActivationArenas() const {
+  auto pool = activation_pool_ != nullptr ? activation_pool_ : instance_pool_.lock();
+  return pool != nullptr ? pool->NumArenas() : 0;
+}
+
 void GraphRuntime::LinkedNDArrayDeleter(Object* container) {
   // container is the NDArray::Container which needs to get deleted.
   // The data member points to global const memory, so it does not need deleting.
@@ -346,6 +689,7 @@ void GraphRuntime::SetupStorage() {
     TVMContext ctx = cit == ctxs_.end() ? ctxs_[0] : *cit;
     if (pit.linked_param.defined()) {
       storage_pool_.push_back(pit.linked_param);
+      param_eids_.insert(pit.param_data_entry);
     } else {
       std::vector<int64_t> shape;
       shape.push_back(static_cast<int64_t>(pit.size + 3) / 4);
@@ -370,7 +714,8 @@ void GraphRuntime::SetupStorage() {
 
 void GraphRuntime::SetupOpExecs() {
   op_execs_.resize(this->GetNumOfNodes());
-  input_dltensors_.resize(num_node_entries());
+  // The executors may be set up again, drop the tensors of the previous ones.
+  input_dltensors_.assign(num_node_entries(), {});
   std::unordered_set<uint32_t> input_node_eids;
   for (size_t i = 0; i < input_nodes_.size(); i++) {
     uint32_t nid = input_nodes_[i];
@@ -398,10 +743,60 @@ void GraphRuntime::SetupOpExecs() {
     for (size_t i = 0; i < inode.inputs.size(); i++) {
       uint32_t eid = this->entry_id(inode.inputs[i]);
       // check if op input is model input
-      if (input_node_eids.count(eid) > 0) {
+      if (input_node_eids.count(eid) > 0 || activation_pool_ != nullptr) {
         input_dltensors_[eid].push_back(static_cast<DLTensor*>(op_args->arg_values[i].v_handle));
       }
     }
+    // A shared instance rebinds all the arguments when it changes arena.
+    for (uint32_t index = 0; activation_pool_ != nullptr && index < inode.param.num_outputs;
+         ++index) {
+      uint32_t eid = this->entry_id(nid, index);
+      input_dltensors_[eid].push_back(
+          static_cast<DLTensor*>(op_args->arg_values[inode.inputs.size() + index].v_handle));
+    }
+  }
+}
+
+void GraphRuntime::SetupOpDeps() {
+  uint32_t num_nodes = this->GetNumOfNodes();
+  op_succs_.assign(num_nodes, {});
+  op_num_deps_.assign(num_nodes, 0);
+  // The last writer and the readers since then of each storage entry.
+  int num_storage = 0;
+  for (int sid : attrs_.storage_id) num_storage = std::max(num_storage, sid + 1);
+  std::vector<int> last_writer(num_storage, -1);
+  std::vector<std::vector<uint32_t>> readers(num_storage);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = nodes_[nid];
+    if (inode.op_type == "null") continue;
+    std::vector<uint32_t> deps;
+    auto add_dep = [&](int dep) {
+      if (dep >= 0 && static_cast<uint32_t>(dep) != nid && nodes_[dep].op_type != "null") {
+        deps.push_back(static_cast<uint32_t>(dep));
+      }
+    };
+    for (const auto& e : inode.inputs) {
+      int sid = attrs_.storage_id[this->entry_id(e)];
+      add_dep(e.node_id);
+      add_dep(last_writer[sid]);
+      readers[sid].push_back(nid);
+    }
+    for (uint32_t dep : inode.control_deps) {
+      add_dep(dep);
+    }
+    for (uint32_t index = 0; index < inode.param.num_outputs; ++index) {
+      int sid = attrs_.storage_id[this->entry_id(nid, index)];
+      add_dep(last_writer[sid]);
+      for (uint32_t reader : readers[sid]) add_dep(reader);
+      last_writer[sid] = nid;
+      readers[sid].clear();
+    }
+    std::sort(deps.begin(), deps.end());
+    deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+    for (uint32_t dep : deps) {
+      op_succs_[dep].push_back(nid);
+    }
+    op_num_deps_[nid] = static_cast<uint32_t>(deps.size());
   }
 }
 
@@ -503,10 +898,29 @@ PackedFunc GraphRuntime::GetFunction(const std::string& name,
         [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->NumInputs(); });
   } else if (name == "run") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->Run(); });
+  } else if (name == "set_inter_op_parallelism") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->SetInterOpParallelism(args[0], args[1]);
+    });
   } else if (name == "load_params") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       this->LoadParams(args[0].operator std::string());
     });
+  } else if (name == "load_params_from_file") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->LoadParamsFromFile(args[0].operator std::string());
+    });
+  } else if (name == "create_shared_instance") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      *rv = this->CreateSharedInstance();
+    });
+  } else if (name == "release_activations") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { this->ReleaseActivations(); });
+  } else if (name == "get_num_activation_arenas") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      *rv = this->NumActivationArenas();
+    });
   } else if (name == "share_params") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       const auto& module = args[0].operator Module();
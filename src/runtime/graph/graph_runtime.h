@@ -34,9 +34,12 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "../param_file.h"
+
 namespace tvm {
 namespace runtime {
 
@@ -47,9 +50,6 @@ namespace runtime {
     ICHECK_EQ(ret, 0) << TVMGetLastError(); \
   }
 
-/*! \brief Magic number for NDArray list file  */
-constexpr uint64_t kTVMNDArrayListMagic = 0xF7E58D4F05049CB7;
-
 /*! \brief operator attributes about tvm op */
 struct TVMOpParam {
   std::string func_name;
@@ -81,6 +81,9 @@ class TVM_DLL GraphRuntime : public ModuleNode {
    */
   virtual PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self);
 
+  /*! \brief Give the activations of a shared instance back to its pool. */
+  ~GraphRuntime();
+
   /*!
    * \return The type key of the executor.
    */
@@ -121,6 +124,14 @@ class TVM_DLL GraphRuntime : public ModuleNode {
    * \param data_ref The input data that is referred.
    */
   void SetInputZeroCopy(int index, DLTensor* data_ref);
+  /*!
+   * \brief set index-th input to a parameter value.
+   *  Unlike the other inputs, the parameters are shared with the instances
+   *  created by CreateSharedInstance.
+   * \param index The input index.
+   * \param data_in The parameter value.
+   */
+  void SetParam(int index, DLTensor* data_in);
   /*!
    * \brief Get the number of outputs
    *
@@ -139,14 +150,14 @@ class TVM_DLL GraphRuntime : public ModuleNode {
    *
    * \return NDArray corresponding to given input node index.
    */
-  NDArray GetInput(int index) const;
+  NDArray GetInput(int index);
   /*!
    * \brief Return NDArray for given output index.
    * \param index The output index.
    *
    * \return NDArray corresponding to given output node index.
    */
-  NDArray GetOutput(int index) const;
+  NDArray GetOutput(int index);
   /*!
    * \brief Copy index-th output to data_out.
    * \param index The output index.
@@ -164,6 +175,16 @@ class TVM_DLL GraphRuntime : public ModuleNode {
    */
   void LoadParams(const std::string& param_blob);
 
+  /*!
+   * \brief Load parameters from a file.
+   *
+   *  The parameters of a file in the aligned format are memory mapped, and
+   *  the ones on CPU are used in place of their entries without a copy.
+   *
+   * \param file_name The name of the parameter file.
+   */
+  void LoadParamsFromFile(const std::string& file_name);
+
   /*!
    * \brief Share parameters from pre-existing GraphRuntime instance.
    * \param other A GraphRuntime instance, previously with |LoadParams| called with the
@@ -180,6 +201,44 @@ class TVM_DLL GraphRuntime : public ModuleNode {
 
   std::string GetNodeName(uint32_t nid) const { return nodes_[nid].name; }
 
+  /*!
+   * \brief Run the independent nodes of the graph concurrently.
+   *
+   *  The nodes are dispatched in dependency order onto a fixed set of executor
+   *  threads. Each executor bounds the parallel loops of the nodes it runs to
+   *  intra_op_threads, which trades inter-op against intra-op parallelism.
+   *  The executors and their thread pools are bound to disjoint ranges of
+   *  intra_op_threads cores, which only overlap when num_executors times
+   *  intra_op_threads exceeds the number of cores.
+   *
+   * \param num_executors The maximum number of nodes running at the same time,
+   *  1 restores the sequential execution.
+   * \param intra_op_threads The number of threads each node may use,
+   *  0 splits the cores evenly among the executors.
+   */
+  void SetInterOpParallelism(int num_executors, int intra_op_threads);
+
+  /*!
+   * \brief Create an instance sharing the graph, the module and the parameters.
+   *
+   *  The instance owns no activation memory when idle. It takes an activation
+   *  arena from a pool shared by all the instances of this runtime when it is
+   *  first used, and gives it back on ReleaseActivations. The parameters must
+   *  be set with LoadParams, ShareParams or SetParam before.
+   *
+   * \return The created instance.
+   */
+  Module CreateSharedInstance();
+
+  /*!
+   * \brief Give the activation arena of a shared instance back to the pool.
+   *  The outputs must be copied out before, as another instance may reuse the arena.
+   */
+  void ReleaseActivations();
+
+  /*! \return The number of activation arenas allocated for the shared instances. */
+  int NumActivationArenas() const;
+
  protected:
   // Memory pool entry.
   struct PoolEntry {
@@ -377,6 +436,25 @@ class TVM_DLL GraphRuntime : public ModuleNode {
   void SetupStorage();
   /*! \brief Setup the executors. */
   void SetupOpExecs();
+  class ActivationPool;
+  /*! \brief Initialize a shared instance of another runtime, drawing from its pool. */
+  void InitSharedInstance(const GraphRuntime& other, std::shared_ptr<ActivationPool> pool);
+  /*! \brief Take an activation arena from the pool and bind the entries to it. */
+  void AcquireActivations();
+  /*! \brief Make sure a shared instance holds its activation arena. */
+  void EnsureActivations() {
+    if (activation_pool_ != nullptr && arena_.empty()) {
+      AcquireActivations();
+    }
+  }
+  /*!
+   * \brief Setup the dependencies between the nodes for the inter-op scheduler.
+   *
+   *  Besides the data dependencies, a node writing a storage entry waits for
+   *  the previous readers and writer of the entry, since the memory plan
+   *  reuses storage under the assumption of sequential execution.
+   */
+  void SetupOpDeps();
   /*!
    * \brief Create an execution function given input.
    * \param attrs The node attributes.
@@ -398,7 +476,7 @@ class TVM_DLL GraphRuntime : public ModuleNode {
   std::vector<uint32_t> input_nodes_;
   /*! \brief Map of input names to input indices. */
   std::unordered_map<std::string, uint32_t> input_map_;
-  /*! \brief Used for quick node input DLTensor* lookup given an input eid. */
+  /*! \brief Used for quick lookup of the op arguments DLTensor* given an eid. */
   std::vector<std::vector<DLTensor*>> input_dltensors_;
   /*! \brief Used for quick entry indexing. */
   std::vector<uint32_t> node_row_ptr_;
@@ -418,6 +496,21 @@ class TVM_DLL GraphRuntime : public ModuleNode {
   std::vector<size_t> data_alignment_;
   /*! \brief Operator on each node. */
   std::vector<std::function<void()>> op_execs_;
+  /*! \brief The nodes waiting for each node. */
+  std::vector<std::vector<uint32_t>> op_succs_;
+  /*! \brief The number of nodes each node waits for. */
+  std::vector<uint32_t> op_num_deps_;
+  class InterOpScheduler;
+  /*! \brief Inter-op parallel scheduler, nullptr for sequential execution. */
+  std::shared_ptr<InterOpScheduler> inter_op_;
+  /*! \brief The entries holding parameters, shared by the shared instances. */
+  std::unordered_set<uint32_t> param_eids_;
+  /*! \brief The pool the activations of this shared instance come from, nullptr otherwise. */
+  std::shared_ptr<ActivationPool> activation_pool_;
+  /*! \brief The pool of the instances created from this runtime, owned by the instances. */
+  std::weak_ptr<ActivationPool> instance_pool_;
+  /*! \brief The activation arena held by this shared instance, indexed by storage id. */
+  std::vector<NDArray> arena_;
   /*! \brief Linked parameter lookup function. */
   PackedFunc lookup_linked_param_;
   /*! \brief Module's _lookup_linked_param function, used by DefaultLookupLinkedParam. */
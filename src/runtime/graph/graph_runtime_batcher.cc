@@ -0,0 +1,231 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file graph_runtime_batcher.cc
+ * \brief Serving front end coalescing concurrent requests into the batch of a graph runtime.
+ */
+#include "./graph_runtime_batcher.h"
+
+#include <tvm/runtime/data_type.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+namespace tvm {
+namespace runtime {
+namespace {
+// The bytes of one row of a dense tensor.
+size_t RowBytes(const DLTensor* t) { return GetDataSize(*t) / static_cast<size_t>(t->shape[0]); }
+
+// Copy rows [from_row, from_row + rows) of from into rows [to_row, to_row + rows) of to.
+// The rows are addressed through byte_offset, both tensors must be compact.
+void CopyRows(const DLTensor* from, int64_t from_row, DLTensor* to, int64_t to_row, int64_t rows) {
+  std::vector<int64_t> shape(to->shape, to->shape + to->ndim);
+  shape[0] = rows;
+  DLTensor src = *from;
+  DLTensor dst = *to;
+  src.shape = shape.data();
+  dst.shape = shape.data();
+  src.byte_offset += from_row * RowBytes(from);
+  dst.byte_offset += to_row * RowBytes(to);
+  NDArray::CopyFromTo(&src, &dst);
+}
+}  // namespace
+
+GraphRuntimeBatcher::GraphRuntimeBatcher(Module runtime, std::vector<int> input_indices,
+                                         int64_t max_latency_us)
+    : runtime_module_(runtime),
+      runtime_(static_cast<GraphRuntime*>(runtime.operator->())),
+      input_indices_(std::move(input_indices)),
+      max_latency_(max_latency_us) {
+  ICHECK(!input_indices_.empty()) << "The graph has no batched input";
+  ICHECK_GE(max_latency_us, 0) << "The latency budget must be non-negative";
+  NDArray first = runtime_->GetInput(input_indices_[0]);
+  ICHECK_GE(first->ndim, 1) << "The batched inputs need a batch dimension";
+  batch_size_ = first->shape[0];
+  for (int index : input_indices_) {
+    NDArray input = runtime_->GetInput(index);
+    ICHECK(input->ndim >= 1 && input->shape[0] == batch_size_)
+        << "Input " << index << " does not have the batch size " << batch_size_;
+    ICHECK(input.IsContiguous()) << "Input " << index << " is not compact";
+    // Allocated once and reused, a batch has at least one row of a request.
+    if (batch_size_ > 1) {
+      std::vector<int64_t> shape(input->shape, input->shape + input->ndim);
+      shape[0] = batch_size_ - 1;
+      NDArray pad = NDArray::Empty(shape, input->dtype, {kDLCPU, 0});
+      std::memset(pad->data, 0, GetDataSize(*pad.operator->()));
+      padding_.push_back(pad);
+    }
+  }
+  for (int i = 0; i < runtime_->NumOutputs(); ++i) {
+    NDArray output = runtime_->GetOutput(i);
+    ICHECK(output->ndim >= 1 && output->shape[0] == batch_size_)
+        << "Output " << i << " does not have the batch size " << batch_size_;
+    ICHECK(output.IsContiguous()) << "Output " << i << " is not compact";
+  }
+  worker_ = std::thread([this] { this->WorkerLoop(); });
+}
+
+GraphRuntimeBatcher::~GraphRuntimeBatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  worker_.join();
+}
+
+Array<NDArray> GraphRuntimeBatcher::Infer(const std::vector<NDArray>& inputs) {
+  ICHECK_EQ(inputs.size(), input_indices_.size())
+      << "Expected " << input_indices_.size() << " batched inputs";
+  Request req;
+  req.inputs = inputs;
+  req.rows = inputs[0]->ndim >= 1 ? inputs[0]->shape[0] : 0;
+  ICHECK(req.rows >= 1 && req.rows <= batch_size_)
+      << "A request must have between 1 and " << batch_size_ << " rows";
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    NDArray expected = runtime_->GetInput(input_indices_[i]);
+    ICHECK(inputs[i]->ndim == expected->ndim && inputs[i]->shape[0] == req.rows &&
+           std::equal(expected->shape + 1, expected->shape + expected->ndim, inputs[i]->shape + 1))
+        << "Input " << i << " does not match the shape of the graph input";
+    ICHECK(TypeEqual(inputs[i]->dtype, expected->dtype))
+        << "Input " << i << " does not match the dtype of the graph input";
+    ICHECK(inputs[i].IsContiguous()) << "Input " << i << " is not compact";
+  }
+  req.arrival = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(mutex_);
+  ICHECK(!stop_) << "The batcher is stopped";
+  queue_.push_back(&req);
+  queued_rows_ += req.rows;
+  ++num_requests_;
+  queue_cv_.notify_all();
+  done_cv_.wait(lock, [&req] { return req.done; });
+  if (req.error != nullptr) std::rethrow_exception(req.error);
+  return Array<NDArray>(req.outputs.begin(), req.outputs.end());
+}
+
+void GraphRuntimeBatcher::WorkerLoop() {
+  while (true) {
+    std::vector<Request*> batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queue_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (stop_) break;
+      // Wait for the batch to fill, up to the budget of the oldest request.
+      auto deadline = queue_.front()->arrival + max_latency_;
+      queue_cv_.wait_until(lock, deadline,
+                           [this] { return stop_ || queued_rows_ >= batch_size_; });
+      if (stop_) break;
+      int64_t rows = 0;
+      while (!queue_.empty() && rows + queue_.front()->rows <= batch_size_) {
+        rows += queue_.front()->rows;
+        batch.push_back(queue_.front());
+        queue_.pop_front();
+      }
+      queued_rows_ -= rows;
+      num_rows_ += rows;
+      ++num_batches_;
+    }
+    RunBatch(batch);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (Request* req : batch) req->done = true;
+    }
+    done_cv_.notify_all();
+  }
+  // Fail the requests left in the queue.
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Request* req : queue_) {
+    req->error = std::make_exception_ptr(dmlc::Error("The batcher is stopped"));
+    req->done = true;
+  }
+  queue_.clear();
+  done_cv_.notify_all();
+}
+
+void GraphRuntimeBatcher::RunBatch(const std::vector<Request*>& batch) {
+  try {
+    for (size_t i = 0; i < input_indices_.size(); ++i) {
+      NDArray input = runtime_->GetInput(input_indices_[i]);
+      DLTensor* dst = const_cast<DLTensor*>(input.operator->());
+      int64_t row = 0;
+      for (Request* req : batch) {
+        CopyRows(req->inputs[i].operator->(), 0, dst, row, req->rows);
+        row += req->rows;
+      }
+      if (row < batch_size_) {
+        CopyRows(padding_[i].operator->(), 0, dst, row, batch_size_ - row);
+      }
+    }
+    runtime_->Run();
+    for (int i = 0; i < runtime_->NumOutputs(); ++i) {
+      NDArray output = runtime_->GetOutput(i);
+      std::vector<int64_t> shape(output->shape, output->shape + output->ndim);
+      int64_t row = 0;
+      for (Request* req : batch) {
+        shape[0] = req->rows;
+        NDArray out = NDArray::Empty(shape, output->dtype, output->ctx);
+        CopyRows(output.operator->(), row, const_cast<DLTensor*>(out.operator->()), 0, req->rows);
+        req->outputs.push_back(out);
+        row += req->rows;
+      }
+    }
+  } catch (...) {
+    for (Request* req : batch) {
+      req->outputs.clear();
+      req->error = std::current_exception();
+    }
+  }
+}
+
+std::string GraphRuntimeBatcher::Stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ostringstream os;
+  os << "{\"num_requests\": " << num_requests_ << ", \"num_batches\": " << num_batches_
+     << ", \"avg_batch_rows\": "
+     << (num_batches_ == 0 ? 0.0 : static_cast<double>(num_rows_) / num_batches_) << "}";
+  return os.str();
+}
+
+PackedFunc GraphRuntimeBatcher::GetFunction(const std::string& name,
+                                            const ObjectPtr<Object>& sptr_to_self) {
+  if (name == "infer") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::vector<NDArray> inputs;
+      for (int i = 0; i < args.num_args; ++i) {
+        inputs.push_back(args[i].operator NDArray());
+      }
+      *rv = this->Infer(inputs);
+    });
+  } else if (name == "get_batch_size") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->BatchSize(); });
+  } else if (name == "get_stats") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->Stats(); });
+  } else {
+    return PackedFunc();
+  }
+}
+
+}  // namespace runtime
+}  // namespace tvm
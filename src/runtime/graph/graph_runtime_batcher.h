@@ -0,0 +1,142 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file graph_runtime_batcher.h
+ * \brief Serving front end coalescing concurrent requests into the batch of a graph runtime.
+ */
+#ifndef TVM_RUNTIME_GRAPH_GRAPH_RUNTIME_BATCHER_H_
+#define TVM_RUNTIME_GRAPH_GRAPH_RUNTIME_BATCHER_H_
+
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/module.h>
+#include <tvm/runtime/ndarray.h>
+#include <tvm/runtime/packed_func.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./graph_runtime.h"
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief Batching front end of a graph runtime compiled for batch size N.
+ *
+ *  Callers submit requests of n <= N rows from any thread and block until
+ *  their rows are computed. A worker thread coalesces the queued requests
+ *  into one batch of the runtime, pads the unused rows with zeros and
+ *  scatters the output rows back to each caller. A batch is launched once it
+ *  is full or once the oldest queued request waited for the latency budget.
+ *
+ *  The first dimension of every batched input and of every output is the batch.
+ *  The rows are copied as contiguous ranges, so the request and graph tensors
+ *  must be compact.
+ */
+class TVM_DLL GraphRuntimeBatcher : public ModuleNode {
+ public:
+  /*!
+   * \brief Construct the batcher.
+   * \param runtime The GraphRuntime module, with its params already set.
+   * \param input_indices The indices of the batched inputs of the runtime.
+   * \param max_latency_us The time the oldest request may wait for the batch to fill.
+   */
+  GraphRuntimeBatcher(Module runtime, std::vector<int> input_indices, int64_t max_latency_us);
+  /*! \brief Fail the pending requests and stop the worker. */
+  ~GraphRuntimeBatcher();
+
+  /*!
+   * \brief Get member function to front-end
+   * \param name The name of the function.
+   * \param sptr_to_self The pointer to the module node.
+   * \return The corresponding member function.
+   */
+  PackedFunc GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) final;
+
+  /*!
+   * \return The type key of the executor.
+   */
+  const char* type_key() const final { return "GraphRuntimeBatcher"; }
+
+  /*!
+   * \brief Run one request, blocking until its batch is done.
+   * \param inputs The batched inputs, all with the same number of rows.
+   * \return The rows of the outputs belonging to this request.
+   */
+  Array<NDArray> Infer(const std::vector<NDArray>& inputs);
+
+  /*! \return The batch size the runtime was compiled for. */
+  int64_t BatchSize() const { return batch_size_; }
+
+  /*! \return The request statistics as a JSON string. */
+  std::string Stats();
+
+ private:
+  /*! \brief A request waiting for its batch. */
+  struct Request {
+    std::vector<NDArray> inputs;
+    int64_t rows;
+    std::chrono::steady_clock::time_point arrival;
+    std::vector<NDArray> outputs;
+    std::exception_ptr error;
+    bool done{false};
+  };
+  /*! \brief The loop of the worker thread. */
+  void WorkerLoop();
+  /*! \brief Gather the requests into the runtime inputs, run it and scatter the outputs. */
+  void RunBatch(const std::vector<Request*>& batch);
+
+  /*! \brief The runtime module, kept alive by the batcher. */
+  Module runtime_module_;
+  /*! \brief The runtime. */
+  GraphRuntime* runtime_;
+  /*! \brief The batched inputs. */
+  std::vector<int> input_indices_;
+  /*! \brief The batch size of the runtime. */
+  int64_t batch_size_;
+  /*! \brief The latency budget. */
+  std::chrono::microseconds max_latency_;
+  /*! \brief Zero rows used to pad each batched input, batch_size_ - 1 rows each. */
+  std::vector<NDArray> padding_;
+  std::mutex mutex_;
+  /*! \brief Signaled when a request is queued or the batcher stops. */
+  std::condition_variable queue_cv_;
+  /*! \brief Signaled when a batch is done. */
+  std::condition_variable done_cv_;
+  std::deque<Request*> queue_;
+  /*! \brief The number of rows in the queue. */
+  int64_t queued_rows_{0};
+  bool stop_{false};
+  int64_t num_requests_{0};
+  int64_t num_batches_{0};
+  int64_t num_rows_{0};
+  std::thread worker_;
+};
+
+}  // namespace runtime
+}  // namespace tvm
+
+#endif  // TVM_RUNTIME_GRAPH_GRAPH_RUNTIME_BATCHER_H_
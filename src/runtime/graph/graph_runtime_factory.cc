@@ -29,8 +29,11 @@
 #include <tvm/runtime/registry.h>
 
 #include <iterator>
+#include <unordered_set>
 #include <vector>
 
+#include "./graph_runtime_batcher.h"
+
 namespace tvm {
 namespace runtime {
 
@@ -64,6 +67,16 @@ PackedFunc GraphRuntimeFactory::GetFunction(
       }
       *rv = this->DebugRuntimeCreate(contexts);
     });
+  } else if (name == "batcher_create") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      ICHECK_GE(args.size(), 2);
+      int64_t max_latency_us = args[0];
+      std::vector<TVMContext> contexts;
+      for (int i = 1; i < args.num_args; ++i) {
+        contexts.emplace_back(args[i].operator TVMContext());
+      }
+      *rv = this->BatcherCreate(contexts, max_latency_us);
+    });
   } else if (name == "remove_params") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       std::unordered_map<std::string, tvm::runtime::NDArray> empty_params{};
@@ -130,6 +143,23 @@ Module GraphRuntimeFactory::DebugRuntimeCreate(const std::vector<TVMContext>& ct
   return mod;
 }
 
+Module GraphRuntimeFactory::BatcherCreate(const std::vector<TVMContext>& ctxs,
+                                          int64_t max_latency_us) {
+  Module mod = this->RuntimeCreate(ctxs);
+  GraphRuntime* runtime = static_cast<GraphRuntime*>(mod.operator->());
+  // The inputs not bound to params are the batched inputs.
+  std::unordered_set<int> param_indices;
+  for (const auto& p : this->params_) {
+    param_indices.insert(runtime->GetInputIndex(p.first));
+  }
+  std::vector<int> input_indices;
+  for (int i = 0; i < runtime->NumInputs(); ++i) {
+    if (param_indices.count(i) == 0) input_indices.push_back(i);
+  }
+  auto exec = make_object<GraphRuntimeBatcher>(mod, input_indices, max_latency_us);
+  return Module(exec);
+}
+
 Module GraphRuntimeFactoryModuleLoadBinary(void* strm) {
   dmlc::Stream* stream = static_cast<dmlc::Stream*>(strm);
   std::string graph_json;
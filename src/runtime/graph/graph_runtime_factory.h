@@ -89,6 +89,15 @@ class TVM_DLL GraphRuntimeFactory : public runtime::ModuleNode {
    */
   Module DebugRuntimeCreate(const std::vector<TVMContext>& ctxs);
 
+  /*!
+   * \brief Create a batching front end over a new runtime module
+   * \param ctxs The context of the host and devices where graph nodes will be
+   *  executed on.
+   * \param max_latency_us The time a request may wait for its batch to fill.
+   * \return created batcher module
+   */
+  Module BatcherCreate(const std::vector<TVMContext>& ctxs, int64_t max_latency_us);
+
   /*!
    * \brief Set params.
    * \param graph_runtime The graph runtime we want to set the params into.
@@ -111,7 +120,7 @@ class TVM_DLL GraphRuntimeFactory : public runtime::ModuleNode {
     for (const auto& key : keys) {
       int in_idx = graph_runtime->GetInputIndex(key);
       if (in_idx >= 0) {
-        graph_runtime->SetInput(in_idx, const_cast<DLTensor*>(value[key].operator->()));
+        graph_runtime->SetParam(in_idx, const_cast<DLTensor*>(value[key].operator->()));
       }
     }
   }
@@ -30,6 +30,15 @@ namespace runtime {
 /*! \brief The current RPC procotol version. */
 constexpr const char* kRPCProtocolVer = "0.7.0";
 
+/*!
+ * \brief The version of the multiplexed protocol a server supports.
+ *
+ *  kInitServer returns it followed by the compression codecs of the server.
+ *  Servers that cannot multiplex return nothing, so the clients keep one
+ *  request in flight per connection with them.
+ */
+constexpr const char* kRPCMultiplexVer = "mux-0.1";
+
 /*! \brief The RPC code */
 enum class RPCCode : int {
   kNone,
@@ -51,6 +60,8 @@ enum class RPCCode : int {
   kDevFreeData,
   kDevStreamSync,
   kCopyAmongRemote,
+  kMultiplex,
+  kCompress,
 };
 
 /*!
@@ -107,6 +118,10 @@ inline const char* RPCCodeToString(RPCCode code) {
       return "kDevStreamSync";
     case RPCCode::kCopyAmongRemote:
       return "kCopyAmongRemote";
+    case RPCCode::kMultiplex:
+      return "kMultiplex";
+    case RPCCode::kCompress:
+      return "kCompress";
     default:
       return "";
   }
@@ -0,0 +1,215 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file param_file.cc
+ * \brief Aligned parameter files that can be memory mapped.
+ */
+#include "param_file.h"
+
+#include <dmlc/memory_io.h>
+#include <tvm/runtime/c_runtime_api.h>
+#include <tvm/runtime/container.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/runtime/registry.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#include "file_utils.h"
+
+namespace tvm {
+namespace runtime {
+namespace {
+size_t RoundUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// Write the header and the table of an aligned file.
+void WriteTable(dmlc::Stream* strm, const std::vector<std::string>& names,
+                const std::vector<const DLTensor*>& arrays, uint64_t alignment,
+                const std::vector<uint64_t>& offsets) {
+  uint64_t header = kTVMNDArrayListAlignedMagic;
+  strm->Write(header);
+  strm->Write(alignment);
+  strm->Write(names);
+  uint64_t sz = static_cast<uint64_t>(arrays.size());
+  strm->Write(sz);
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    const DLTensor* t = arrays[i];
+    strm->Write(t->ndim);
+    strm->Write(t->dtype);
+    strm->WriteArray(t->shape, t->ndim);
+    uint64_t nbytes = GetDataSize(*t);
+    strm->Write(offsets[i]);
+    strm->Write(nbytes);
+  }
+}
+
+std::vector<std::pair<std::string, NDArray>> LoadListFile(const std::string& file_name) {
+  std::string blob;
+  LoadBinaryFromFile(file_name, &blob);
+  dmlc::MemoryStringStream strm(&blob);
+  uint64_t header, reserved;
+  ICHECK(strm.Read(&header)) << "Invalid parameters file format";
+  ICHECK(header == kTVMNDArrayListMagic) << "Invalid parameters file format";
+  ICHECK(strm.Read(&reserved)) << "Invalid parameters file format";
+  std::vector<std::string> names;
+  ICHECK(strm.Read(&names)) << "Invalid parameters file format";
+  uint64_t sz;
+  ICHECK(strm.Read(&sz)) << "Invalid parameters file format";
+  ICHECK(sz == names.size()) << "Invalid parameters file format";
+  std::vector<std::pair<std::string, NDArray>> ret;
+  for (size_t i = 0; i < names.size(); ++i) {
+    NDArray temp;
+    temp.Load(&strm);
+    ret.emplace_back(names[i], temp);
+  }
+  return ret;
+}
+}  // namespace
+
+void SaveParamsToFile(const std::string& file_name, const std::vector<std::string>& names,
+                      const std::vector<const DLTensor*>& arrays, size_t alignment) {
+  ICHECK_EQ(names.size(), arrays.size());
+  ICHECK(alignment >= kAllocAlignment && (alignment & (alignment - 1)) == 0)
+      << "The alignment must be a power of two of at least " << kAllocAlignment;
+  // The table has a fixed size, measure it to place the data after it.
+  std::vector<uint64_t> offsets(arrays.size(), 0);
+  std::string table;
+  {
+    dmlc::MemoryStringStream strm(&table);
+    WriteTable(&strm, names, arrays, alignment, offsets);
+  }
+  size_t offset = RoundUp(table.size(), alignment);
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    offsets[i] = offset;
+    offset = RoundUp(offset + GetDataSize(*arrays[i]), alignment);
+  }
+  table.clear();
+  {
+    dmlc::MemoryStringStream strm(&table);
+    WriteTable(&strm, names, arrays, alignment, offsets);
+  }
+
+  std::ofstream fs(file_name, std::ios::out | std::ios::binary);
+  ICHECK(!fs.fail()) << "Cannot open " << file_name;
+  fs.write(table.data(), table.size());
+  size_t pos = table.size();
+  std::vector<char> bytes;
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    const DLTensor* t = arrays[i];
+    size_t nbytes = GetDataSize(*t);
+    bytes.assign(offsets[i] - pos, 0);
+    fs.write(bytes.data(), bytes.size());
+    if (DMLC_IO_NO_ENDIAN_SWAP && t->ctx.device_type == kDLCPU && t->strides == nullptr) {
+      fs.write(static_cast<const char*>(t->data) + t->byte_offset, nbytes);
+    } else {
+      bytes.resize(nbytes);
+      ICHECK_EQ(TVMArrayCopyToBytes(const_cast<DLTensor*>(t), bytes.data(), nbytes), 0)
+          << TVMGetLastError();
+      if (!DMLC_IO_NO_ENDIAN_SWAP) {
+        dmlc::ByteSwap(bytes.data(), (t->dtype.bits + 7) / 8, nbytes / ((t->dtype.bits + 7) / 8));
+      }
+      fs.write(bytes.data(), nbytes);
+    }
+    pos = offsets[i] + nbytes;
+  }
+  ICHECK(!fs.fail()) << "Cannot write " << file_name;
+}
+
+std::vector<std::pair<std::string, NDArray>> LoadParamsFromFile(const std::string& file_name) {
+  auto file = std::make_shared<MappedFile>(file_name);
+  uint64_t header = 0;
+  if (file->size() >= sizeof(header)) {
+    std::memcpy(&header, file->data(), sizeof(header));
+  }
+  if (header != kTVMNDArrayListAlignedMagic) {
+    return LoadListFile(file_name);
+  }
+  dmlc::MemoryFixedSizeStream strm(file->data(), file->size());
+  uint64_t alignment, sz;
+  std::vector<std::string> names;
+  ICHECK(strm.Read(&header)) << "Invalid parameters file format";
+  ICHECK(strm.Read(&alignment)) << "Invalid parameters file format";
+  ICHECK(strm.Read(&names)) << "Invalid parameters file format";
+  ICHECK(strm.Read(&sz)) << "Invalid parameters file format";
+  ICHECK(sz == names.size()) << "Invalid parameters file format";
+  ICHECK(alignment != 0 && alignment % kAllocAlignment == 0) << "Invalid parameters file format";
+
+  std::vector<std::pair<std::string, NDArray>> ret;
+  for (size_t i = 0; i < names.size(); ++i) {
+    int ndim;
+    DLDataType dtype;
+    uint64_t offset, nbytes;
+    ICHECK(strm.Read(&ndim)) << "Invalid parameters file format";
+    ICHECK(strm.Read(&dtype)) << "Invalid parameters file format";
+    // Bound ndim by the bytes left before allocating the shape.
+    ICHECK(ndim >= 0 && static_cast<size_t>(ndim) <=
+                            (file->size() - std::min(strm.Tell(), file->size())) / sizeof(int64_t))
+        << "Invalid parameters file format";
+    std::vector<int64_t> shape(ndim);
+    if (ndim != 0) {
+      ICHECK(strm.ReadArray(&shape[0], ndim)) << "Invalid parameters file format";
+    }
+    ICHECK(strm.Read(&offset)) << "Invalid parameters file format";
+    ICHECK(strm.Read(&nbytes)) << "Invalid parameters file format";
+    ICHECK(offset % alignment == 0 && offset <= file->size() && nbytes <= file->size() - offset)
+        << "Invalid parameters file format";
+
+    NDArray view = CreateMappedFileView(file, offset, shape, dtype);
+    ICHECK_EQ(GetDataSize(*view.operator->()), nbytes) << "Invalid parameters file format";
+    if (!DMLC_IO_NO_ENDIAN_SWAP) {
+      // The file is little endian, swap a private copy.
+      view = view.CopyTo({kDLCPU, 0});
+      dmlc::ByteSwap(view->data, (dtype.bits + 7) / 8, nbytes / ((dtype.bits + 7) / 8));
+    }
+    ret.emplace_back(names[i], view);
+  }
+  return ret;
+}
+
+TVM_REGISTER_GLOBAL("runtime.SaveParamsToFile").set_body([](TVMArgs args, TVMRetValue* rv) {
+  ICHECK_EQ(args.size() % 2, 0u);
+  // `args` is in the form "file_name, alignment, key, value, key, value, ..."
+  std::string file_name = args[0];
+  int64_t alignment = args[1];
+  std::vector<std::string> names;
+  std::vector<const DLTensor*> arrays;
+  for (int i = 2; i < args.size(); i += 2) {
+    names.emplace_back(args[i].operator String());
+    arrays.emplace_back(args[i + 1].operator DLTensor*());
+  }
+  SaveParamsToFile(file_name, names, arrays, static_cast<size_t>(alignment));
+});
+
+// Returns the names and tensors interleaved, as the runtime has no Map.
+TVM_REGISTER_GLOBAL("runtime.LoadParamsFromFile").set_body_typed([](std::string file_name) {
+  Array<ObjectRef> ret;
+  for (auto& kv : LoadParamsFromFile(file_name)) {
+    ret.push_back(String(kv.first));
+    ret.push_back(kv.second);
+  }
+  return ret;
+});
+
+}  // namespace runtime
+}  // namespace tvm
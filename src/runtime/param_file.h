@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file param_file.h
+ * \brief Aligned parameter files that can be memory mapped.
+ *
+ *  The aligned format extends the NDArray list layout with a table of
+ *  offsets, so that the data of every tensor starts at an aligned offset
+ *  of the file:
+ *
+ *  - uint64 kTVMNDArrayListAlignedMagic
+ *  - uint64 alignment
+ *  - vector<string> names
+ *  - uint64 number of tensors
+ *  - for each tensor: int32 ndim, DLDataType dtype, int64[ndim] shape,
+ *    uint64 data offset, uint64 data bytes
+ *  - the data of the tensors, each at its offset
+ *
+ *  A loaded tensor on CPU is a view of a private file mapping, so the
+ *  processes serving the same model share the pages of the file.
+ */
+#ifndef TVM_RUNTIME_PARAM_FILE_H_
+#define TVM_RUNTIME_PARAM_FILE_H_
+
+#include <tvm/runtime/ndarray.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tvm {
+namespace runtime {
+
+/*! \brief Magic number for NDArray list file  */
+constexpr uint64_t kTVMNDArrayListMagic = 0xF7E58D4F05049CB7;
+
+/*! \brief Magic number of the aligned NDArray list file. */
+constexpr uint64_t kTVMNDArrayListAlignedMagic = 0xF7E58D4F05049CB8;
+
+/*!
+ * \brief Save named tensors in the aligned format.
+ * \param file_name The name of the file.
+ * \param names The names of the tensors.
+ * \param arrays The tensors, on any device.
+ * \param alignment The alignment of the tensor data in the file, a power of two
+ *  that is at least kAllocAlignment.
+ */
+void SaveParamsToFile(const std::string& file_name, const std::vector<std::string>& names,
+                      const std::vector<const DLTensor*>& arrays, size_t alignment);
+
+/*!
+ * \brief Load named tensors from a parameter file.
+ *
+ *  Files in the aligned format are memory mapped and the tensors are views of
+ *  the mapping, which stays alive as long as one of the tensors does. Files in
+ *  the NDArray list format are read and copied.
+ *
+ * \param file_name The name of the file.
+ * \return The names and tensors in file order.
+ */
+std::vector<std::pair<std::string, NDArray>> LoadParamsFromFile(const std::string& file_name);
+
+}  // namespace runtime
+}  // namespace tvm
+#endif  // TVM_RUNTIME_PARAM_FILE_H_
@@ -22,6 +22,9 @@
  */
 #include "rpc_channel.h"
 
+#include <algorithm>
+#include <cstring>
+#include <sstream>
 #include <string>
 
 namespace tvm {
@@ -49,5 +52,114 @@ size_t CallbackChannel::Recv(void* data, size_t size) {
   return bytes->length();
 }
 
+constexpr size_t CompressedChannel::kBlockBytes;
+constexpr int CompressedChannel::kMaxSkipBlocks;
+
+size_t CompressedChannel::Send(const void* data, size_t size) {
+  size_t nbytes = std::min(size, kBlockBytes);
+  uint32_t header[2] = {static_cast<uint32_t>(nbytes), static_cast<uint32_t>(nbytes)};
+  send_buffer_.resize(sizeof(header) + nbytes);
+  char* payload = send_buffer_.data() + sizeof(header);
+
+  size_t wire_bytes = 0;
+  if (nbytes >= kMinCompressBytes && skip_blocks_ == 0) {
+    wire_bytes = codec_.Compress(static_cast<const char*>(data), nbytes, payload,
+                                 nbytes - nbytes / 8);
+    if (wire_bytes != 0) {
+      header[0] = static_cast<uint32_t>(wire_bytes) | kCompressedFlag;
+      skip_backoff_ = 1;
+    } else {
+      skip_blocks_ = skip_backoff_;
+      skip_backoff_ = std::min(skip_backoff_ * 2, kMaxSkipBlocks);
+    }
+  } else if (skip_blocks_ != 0) {
+    --skip_blocks_;
+  }
+  if (wire_bytes == 0) {
+    std::memcpy(payload, data, nbytes);
+    wire_bytes = nbytes;
+    ++raw_blocks_sent_;
+  } else {
+    ++compressed_blocks_sent_;
+  }
+  std::memcpy(send_buffer_.data(), header, sizeof(header));
+  SendAll(send_buffer_.data(), sizeof(header) + wire_bytes);
+
+  raw_bytes_sent_ += nbytes;
+  wire_bytes_sent_ += sizeof(header) + wire_bytes;
+  return nbytes;
+}
+
+size_t CompressedChannel::Recv(void* data, size_t size) {
+  if (recv_offset_ == recv_block_.size()) {
+    uint32_t header[2];
+    if (!RecvAll(header, sizeof(header))) return 0;
+    size_t wire_bytes = header[0] & ~kCompressedFlag;
+    size_t nbytes = header[1];
+    ICHECK(wire_bytes <= kBlockBytes && nbytes <= kBlockBytes)
+        << "RPCError: invalid compressed block";
+    raw_bytes_received_ += nbytes;
+    wire_bytes_received_ += sizeof(header) + wire_bytes;
+
+    if ((header[0] & kCompressedFlag) == 0) {
+      ICHECK_EQ(wire_bytes, nbytes) << "RPCError: invalid compressed block";
+      if (size >= nbytes) {
+        // Receive the block straight into the buffer.
+        ICHECK(RecvAll(data, nbytes)) << "Channel closes before we get neded bytes";
+        recv_block_.clear();
+        recv_offset_ = 0;
+        return nbytes;
+      }
+      recv_block_.resize(nbytes);
+      ICHECK(RecvAll(recv_block_.data(), nbytes)) << "Channel closes before we get neded bytes";
+    } else {
+      recv_wire_.resize(wire_bytes);
+      ICHECK(RecvAll(recv_wire_.data(), wire_bytes))
+          << "Channel closes before we get neded bytes";
+      recv_block_.resize(nbytes);
+      ICHECK(support::LZCodec::Decompress(recv_wire_.data(), wire_bytes, recv_block_.data(),
+                                          nbytes))
+          << "RPCError: invalid compressed block";
+    }
+    recv_offset_ = 0;
+  }
+  size_t n = std::min(size, recv_block_.size() - recv_offset_);
+  std::memcpy(data, recv_block_.data() + recv_offset_, n);
+  recv_offset_ += n;
+  return n;
+}
+
+std::string CompressedChannel::GetStats() const {
+  std::ostringstream os;
+  os << "{\"codec\": \"" << kCodec << "\", \"raw_bytes_sent\": " << raw_bytes_sent_
+     << ", \"wire_bytes_sent\": " << wire_bytes_sent_
+     << ", \"raw_bytes_received\": " << raw_bytes_received_
+     << ", \"wire_bytes_received\": " << wire_bytes_received_
+     << ", \"compressed_blocks_sent\": " << compressed_blocks_sent_
+     << ", \"raw_blocks_sent\": " << raw_blocks_sent_ << "}";
+  return os.str();
+}
+
+void CompressedChannel::SendAll(const void* data, size_t size) {
+  const char* ptr = static_cast<const char*>(data);
+  while (size != 0) {
+    size_t n = channel_->Send(ptr, size);
+    ICHECK_NE(n, 0U) << "Channel closes before we send the data";
+    ptr += n;
+    size -= n;
+  }
+}
+
+bool CompressedChannel::RecvAll(void* data, size_t size) {
+  char* ptr = static_cast<char*>(data);
+  while (size != 0) {
+    size_t n = channel_->Recv(ptr, size);
+    if (n == 0) return false;
+    ptr += n;
+    size -= n;
+  }
+  return true;
+}
+
 }  // namespace runtime
 }  // namespace tvm
@@ -26,7 +26,13 @@
 
 #include <tvm/runtime/packed_func.h>
 
+#include <atomic>
+#include <memory>
+#include <string>
 #include <utility>
+#include <vector>
+
+#include "../../support/lz_codec.h"
 
 namespace tvm {
 namespace runtime {
@@ -94,6 +100,67 @@ class CallbackChannel final : public RPCChannel {
   PackedFunc frecv_;
 };
 
+/*!
+ * \brief Channel that compresses the bytes sent over another channel.
+ *
+ *  The bytes are sent in blocks of at most kBlockBytes:
+ *  - uint32 number of bytes of the block on the wire, with kCompressedFlag set
+ *    when the block is compressed with support::LZCodec
+ *  - uint32 number of bytes of the block once decompressed
+ *  - the bytes of the block
+ *
+ *  A block that does not shrink by an eighth is sent as it is, and the next
+ *  blocks are sent without trying to compress them, for longer after each
+ *  failure, so incompressible data such as float tensors costs little.
+ */
+class CompressedChannel final : public RPCChannel {
+ public:
+  /*! \brief The name of the codec negotiated by the endpoints. */
+  static constexpr const char* kCodec = "lz";
+  /*! \brief The largest block. */
+  static constexpr size_t kBlockBytes = 64 << 10;
+  /*! \brief The smallest block worth compressing. */
+  static constexpr size_t kMinCompressBytes = 256;
+  /*! \brief The most blocks sent without trying to compress them. */
+  static constexpr int kMaxSkipBlocks = 64;
+  /*! \brief The flag of the compressed blocks in their wire size. */
+  static constexpr uint32_t kCompressedFlag = 1U << 31;
+
+  /*!
+   * \brief Constructor.
+   * \param channel The channel carrying the blocks.
+   */
+  explicit CompressedChannel(std::unique_ptr<RPCChannel> channel) : channel_(std::move(channel)) {}
+
+  size_t Send(const void* data, size_t size) final;
+
+  size_t Recv(void* data, size_t size) final;
+
+  /*! \return The counters of the channel as a JSON object. */
+  std::string GetStats() const;
+
+ private:
+  void SendAll(const void* data, size_t size);
+  bool RecvAll(void* data, size_t size);
+
+  // The channel carrying the blocks.
+  std::unique_ptr<RPCChannel> channel_;
+  support::LZCodec codec_;
+  // The header and the bytes of the block sent.
+  std::vector<char> send_buffer_;
+  // The blocks to send before trying to compress again, and the next such count.
+  int skip_blocks_{0};
+  int skip_backoff_{1};
+  // The compressed bytes and the bytes of the block received.
+  std::vector<char> recv_wire_, recv_block_;
+  // The bytes of the block received already read.
+  size_t recv_offset_{0};
+  // The counters, read from any thread.
+  std::atomic<uint64_t> raw_bytes_sent_{0}, wire_bytes_sent_{0};
+  std::atomic<uint64_t> raw_bytes_received_{0}, wire_bytes_received_{0};
+  std::atomic<uint64_t> compressed_blocks_sent_{0}, raw_blocks_sent_{0};
+};
+
 }  // namespace runtime
 }  // namespace tvm
 #endif  // TVM_RUNTIME_RPC_RPC_CHANNEL_H_
@@ -33,8 +33,14 @@
 #include <array>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <memory>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -46,6 +52,10 @@
 namespace tvm {
 namespace runtime {
 
+// The size of the code and the header fields of a kCopyToRemote packet.
+constexpr uint64_t kCopyToRemoteHeaderBytes =
+    sizeof(int32_t) + 3 * sizeof(uint64_t) + sizeof(TVMContext) + sizeof(DLDataType);
+
 /*!
  * Event-driven state-machine based handlers for RPCEndpoint.
  *
@@ -57,12 +67,14 @@ namespace runtime {
 class RPCEndpoint::EventHandler : public dmlc::Stream {
  public:
   EventHandler(support::RingBuffer* reader, support::RingBuffer* writer, std::string name,
-               std::string* remote_key, std::function<void()> flush_writer)
+               std::string* remote_key, std::function<void()> flush_writer,
+               std::function<void(const void*, size_t)> write_direct)
       : reader_(reader),
         writer_(writer),
         name_(name),
         remote_key_(remote_key),
-        flush_writer_(flush_writer) {
+        flush_writer_(flush_writer),
+        write_direct_(write_direct) {
     this->Clear();
 
     if (*remote_key == "%toinit") {
@@ -76,6 +88,7 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
    * \brief Bytes needed to fulfill current request
    */
   size_t BytesNeeded() const {
+    if (state_ == kRecvPayload) return 0;
     if (reader_->bytes_available() < pending_request_bytes_) {
       return pending_request_bytes_ - reader_->bytes_available();
     } else {
@@ -93,7 +106,56 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
   }
 
   /*! \return Whether we are ready to handle next request. */
-  bool Ready() const { return reader_->bytes_available() >= pending_request_bytes_; }
+  bool Ready() const {
+    if (state_ == kRecvPayload) {
+      return payload_remaining_ == 0 || reader_->bytes_available() != 0;
+    }
+    return reader_->bytes_available() >= pending_request_bytes_;
+  }
+
+  /*!
+   * \brief Get the buffer receiving the payload of the current packet.
+   *
+   *  The payload of a bulk copy bypasses the ring buffer, the endpoint can
+   *  receive it from the channel straight into this buffer once the ring
+   *  buffer is empty.
+   *
+   * \param data The buffer.
+   * \return The number of payload bytes still expected, 0 when no payload is expected.
+   */
+  size_t PayloadBuffer(char** data) const {
+    if (state_ != kRecvPayload) return 0;
+    *data = payload_ptr_;
+    return payload_remaining_;
+  }
+
+  /*!
+   * \brief Account for bytes received into the payload buffer.
+   * \param nbytes The number of bytes.
+   */
+  void PayloadReceived(size_t nbytes) {
+    ICHECK_LE(nbytes, payload_remaining_);
+    payload_ptr_ += nbytes;
+    payload_remaining_ -= nbytes;
+  }
+
+  /*!
+   * \brief Receive the data of the next copy ack straight into a buffer.
+   * \param data The buffer, nullptr to receive the data in the ring buffer.
+   * \param nbytes The size of the data.
+   */
+  void ExpectCopyAck(char* data, size_t nbytes) {
+    copy_ack_buffer_ = data;
+    copy_ack_nbytes_ = nbytes;
+  }
+
+  /*!
+   * \brief Serve with the session of another handler.
+   * \param other The handler of the initialized server.
+   */
+  void ShareServingSession(const EventHandler& other) {
+    serving_session_ = other.serving_session_;
+  }
 
   /*! \return Whether we can perform a clean shutdown */
   bool CanCleanShutdown() const { return state_ == kRecvPacketNumBytes; }
@@ -101,6 +163,9 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
   /*! \brief Finish the copy ack stage. */
   void FinishCopyAck() { this->SwitchToState(kRecvPacketNumBytes); }
 
+  /*! \brief Resume serving once the channel is compressed. */
+  void FinishCompress() { this->SwitchToState(kRecvPacketNumBytes); }
+
   /*!
    * \brief Enter the io loop until the next event.
    * \param client_mode Whether we are in the client.
@@ -124,13 +189,23 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
           uint64_t packet_nbytes;
           ICHECK(this->Read(&packet_nbytes));
           if (packet_nbytes != 0) {
-            this->SwitchToState(kProcessPacket);
-            this->RequestBytes(packet_nbytes);
+            packet_nbytes_ = packet_nbytes;
+            // The header tells whether the payload can bypass the ring buffer.
+            this->SwitchToState(kRecvPacketHeader);
+            this->RequestBytes(std::min(packet_nbytes, kCopyToRemoteHeaderBytes));
           } else {
             this->SwitchToState(kRecvPacketNumBytes);
           }
           break;
         }
+        case kRecvPacketHeader: {
+          this->HandlePacketHeader();
+          break;
+        }
+        case kRecvPayload: {
+          this->HandlePayload();
+          break;
+        }
         case kProcessPacket: {
           this->HandleProcessPacket(setreturn);
           break;
@@ -147,6 +222,14 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
           status = RPCCode::kCopyAck;
           break;
         }
+        case kMultiplexReceived: {
+          status = RPCCode::kMultiplex;
+          break;
+        }
+        case kCompressReceived: {
+          status = RPCCode::kCompress;
+          break;
+        }
         case kShutdownReceived: {
           status = RPCCode::kShutdown;
         }
@@ -233,10 +316,14 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
   enum State {
     kInitHeader,
     kRecvPacketNumBytes,
+    kRecvPacketHeader,
+    kRecvPayload,
     kProcessPacket,
     kWaitForAsyncCallback,
     kReturnReceived,
     kCopyAckReceived,
+    kMultiplexReceived,
+    kCompressReceived,
     kShutdownReceived
   };
   // Current state;
@@ -249,6 +336,17 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
   bool async_server_mode_{false};
   // Internal arena
   support::Arena arena_;
+  // The size and the code of the current packet.
+  uint64_t packet_nbytes_{0};
+  RPCCode packet_code_{RPCCode::kNone};
+  // The destination of the payload of the current packet.
+  char* payload_ptr_{nullptr};
+  size_t payload_remaining_{0};
+  // Called once the payload is received.
+  std::function<void()> payload_done_;
+  // The destination of the data of the next copy ack, if not nullptr.
+  char* copy_ack_buffer_{nullptr};
+  size_t copy_ack_nbytes_{0};
 
   // State switcher
   void SwitchToState(State state) {
@@ -286,10 +384,60 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
     }
   }
 
+  // Handler for the first bytes of a packet, up to the header of a copy.
+  void HandlePacketHeader() {
+    uint64_t header_nbytes = std::min(packet_nbytes_, kCopyToRemoteHeaderBytes);
+    this->Read(&packet_code_);
+    if (packet_code_ == RPCCode::kCopyToRemote && header_nbytes == kCopyToRemoteHeaderBytes) {
+      this->HandleCopyToRemote(packet_nbytes_ - header_nbytes);
+    } else if (packet_code_ == RPCCode::kCopyAck && copy_ack_buffer_ != nullptr) {
+      ICHECK_EQ(packet_nbytes_ - sizeof(int32_t), copy_ack_nbytes_)
+          << "RPCError: unexpected size of the copied data";
+      char* data = copy_ack_buffer_;
+      copy_ack_buffer_ = nullptr;
+      // The bytes requested after the code are the start of the data.
+      this->StartPayload(data, copy_ack_nbytes_, [this]() {
+        this->SwitchToState(kCopyAckReceived);
+      });
+    } else {
+      // The rest of the header is already requested.
+      state_ = kProcessPacket;
+      this->RequestBytes(packet_nbytes_ - header_nbytes);
+    }
+  }
+
+  /*!
+   * \brief Receive the rest of the packet into a buffer instead of the ring buffer.
+   * \param data The buffer.
+   * \param nbytes The number of bytes left in the packet.
+   * \param done Called once the bytes are received, switches to the next state.
+   */
+  void StartPayload(char* data, size_t nbytes, std::function<void()> done) {
+    // The bytes already in the ring buffer are the start of the payload.
+    pending_request_bytes_ = 0;
+    payload_ptr_ = data;
+    payload_remaining_ = nbytes;
+    payload_done_ = std::move(done);
+    state_ = kRecvPayload;
+  }
+
+  // Handler for the payload bytes in the ring buffer.
+  void HandlePayload() {
+    size_t nbytes = std::min(reader_->bytes_available(), payload_remaining_);
+    if (nbytes != 0) {
+      reader_->Read(payload_ptr_, nbytes);
+      this->PayloadReceived(nbytes);
+    }
+    if (payload_remaining_ == 0) {
+      std::function<void()> done = std::move(payload_done_);
+      payload_done_ = nullptr;
+      done();
+    }
+  }
+
   // Handler for read code.
   void HandleProcessPacket(RPCSession::FEncodeReturn setreturn) {
-    RPCCode code = RPCCode::kNone;
-    this->Read(&code);
+    RPCCode code = packet_code_;
 
     if (code >= RPCCode::kSyscallCodeStart) {
       this->HandleSyscall(code);
@@ -308,7 +456,8 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
           break;
         }
         case RPCCode::kCopyToRemote: {
-          this->HandleCopyToRemote();
+          // A packet too small to hold the header of a copy.
+          LOG(FATAL) << "RPCError: invalid copy to remote packet";
           break;
         }
         case RPCCode::kException:
@@ -406,7 +555,12 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
 
       this->Write(packet_nbytes);
       this->Write(code);
-      this->WriteArray(data_ptr, num_bytes);
+      if (async_server_mode_) {
+        this->WriteArray(data_ptr, num_bytes);
+      } else {
+        // Send the data from its buffer instead of copying it into the ring buffer.
+        write_direct_(data_ptr, num_bytes);
+      }
       this->SwitchToState(kRecvPacketNumBytes);
     };
 
@@ -438,7 +592,11 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
     }
   }
 
-  void HandleCopyToRemote() {
+  /*!
+   * \brief Handle the header of a copy to remote, the data is received after it.
+   * \param payload_nbytes The number of bytes after the header.
+   */
+  void HandleCopyToRemote(uint64_t payload_nbytes) {
     uint64_t handle, offset, num_bytes;
     TVMContext ctx;
     DLDataType type_hint;
@@ -448,42 +606,45 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
     this->Read(&num_bytes);
     this->Read(&ctx);
     this->Read(&type_hint);
+    ICHECK_EQ(num_bytes, payload_nbytes) << "RPCError: invalid copy to remote packet";
 
     size_t elem_bytes = (type_hint.bits * type_hint.lanes + 7) / 8;
     auto* sess = GetServingSession();
 
     // When session is local, we can directly treat handle
-    // as the cpu pointer without allocating a temp space.
+    // as the cpu pointer and receive the data into it.
     if (ctx.device_type == kDLCPU && sess->IsLocalSession()) {
       char* dptr = reinterpret_cast<char*>(handle) + offset;
-      this->ReadArray(dptr, num_bytes);
-
-      if (!DMLC_IO_NO_ENDIAN_SWAP) {
-        dmlc::ByteSwap(dptr, elem_bytes, num_bytes / elem_bytes);
-      }
-      this->ReturnVoid();
-      this->SwitchToState(kRecvPacketNumBytes);
+      this->StartPayload(dptr, num_bytes, [this, dptr, elem_bytes, num_bytes]() {
+        if (!DMLC_IO_NO_ENDIAN_SWAP) {
+          dmlc::ByteSwap(dptr, elem_bytes, num_bytes / elem_bytes);
+        }
+        this->ReturnVoid();
+        this->SwitchToState(kRecvPacketNumBytes);
+      });
     } else {
+      // The client splits large copies, so the staging buffer stays small.
       char* temp_data = this->ArenaAlloc<char>(num_bytes);
-      this->ReadArray(temp_data, num_bytes);
-
-      if (!DMLC_IO_NO_ENDIAN_SWAP) {
-        dmlc::ByteSwap(temp_data, elem_bytes, num_bytes / elem_bytes);
-      }
-
-      auto on_copy_complete = [this](RPCCode status, TVMArgs args) {
-        if (status == RPCCode::kException) {
-          this->ReturnException(args.values[0].v_str);
-          this->SwitchToState(kRecvPacketNumBytes);
-        } else {
-          this->ReturnVoid();
-          this->SwitchToState(kRecvPacketNumBytes);
+      this->StartPayload(temp_data, num_bytes, [=]() {
+        if (!DMLC_IO_NO_ENDIAN_SWAP) {
+          dmlc::ByteSwap(temp_data, elem_bytes, num_bytes / elem_bytes);
         }
-      };
 
-      this->SwitchToState(kWaitForAsyncCallback);
-      sess->AsyncCopyToRemote(temp_data, 0, reinterpret_cast<void*>(handle), offset, num_bytes, ctx,
-                              type_hint, on_copy_complete);
+        auto on_copy_complete = [this](RPCCode status, TVMArgs args) {
+          if (status == RPCCode::kException) {
+            this->ReturnException(args.values[0].v_str);
+            this->SwitchToState(kRecvPacketNumBytes);
+          } else {
+            this->ReturnVoid();
+            this->SwitchToState(kRecvPacketNumBytes);
+          }
+        };
+
+        this->SwitchToState(kWaitForAsyncCallback);
+        GetServingSession()->AsyncCopyToRemote(temp_data, 0, reinterpret_cast<void*>(handle),
+                                               offset, num_bytes, ctx, type_hint,
+                                               on_copy_complete);
+      });
     }
   }
 
@@ -556,7 +717,16 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
       std::string tkey = mod->type_key();
       ICHECK_EQ(tkey, "rpc") << "Constructor " << constructor_name << " to return an RPCModule";
       serving_session_ = RPCModuleGetSession(mod);
-      this->ReturnVoid();
+      if (async_server_mode_) {
+        this->ReturnVoid();
+      } else {
+        // Tell the client it can multiplex and compress, older clients ignore the values.
+        TVMValue ret_values[2];
+        int ret_tcodes[2] = {kTVMStr, kTVMStr};
+        ret_values[0].v_str = kRPCMultiplexVer;
+        ret_values[1].v_str = CompressedChannel::kCodec;
+        this->ReturnPackedSeq(TVMArgs(ret_values, ret_tcodes, 2));
+      }
     } catch (const std::runtime_error& e) {
       this->ReturnException(e.what());
     }
@@ -585,6 +755,30 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
     }
   }
 
+  void HandleSyscallMultiplex() {
+    RecvPackedSeq();
+    ICHECK(!async_server_mode_) << "Cannot multiplex an event driven server";
+    // The endpoint switches to the multiplexed protocol once the reply is sent.
+    this->ReturnVoid();
+    this->SwitchToState(kMultiplexReceived);
+  }
+
+  void HandleSyscallCompress() {
+    TVMArgs args = RecvPackedSeq();
+    try {
+      ICHECK(!async_server_mode_) << "Cannot compress the channel of an event driven server";
+      std::string codec = args[0];
+      ICHECK_EQ(codec, CompressedChannel::kCodec) << "Unknown compression codec " << codec;
+    } catch (const std::runtime_error& e) {
+      this->ReturnException(e.what());
+      this->SwitchToState(kRecvPacketNumBytes);
+      return;
+    }
+    // The endpoint compresses the channel once the reply is sent.
+    this->ReturnVoid();
+    this->SwitchToState(kCompressReceived);
+  }
+
   // Handler for special syscalls that have a specific RPCCode.
   template <typename F>
   void SysCallHandler(F f) {
@@ -637,18 +831,237 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
   std::string* remote_key_;
   // function to flush the writer.
   std::function<void()> flush_writer_;
+  // function to flush the writer and send bytes after it, bypassing the writer.
+  std::function<void(const void*, size_t)> write_direct_;
+};
+
+/*!
+ * \brief The streams of a multiplexed connection.
+ *
+ *  Once multiplexed, the bytes of the connection are sent in frames:
+ *
+ *  - uint64 stream id
+ *  - uint64 number of bytes n, 0 closes the connection
+ *  - n bytes of the stream
+ *
+ *  Each stream carries the packets of an endpoint of its own, so the requests
+ *  on different streams are in flight at the same time. A client thread
+ *  waiting for its stream reads the frames of all the streams while no other
+ *  thread does, the server reads them in a loop.
+ */
+class RPCEndpoint::Multiplexer : public std::enable_shared_from_this<Multiplexer> {
+ public:
+  explicit Multiplexer(std::unique_ptr<RPCChannel> channel) : channel_(std::move(channel)) {}
+
+  /*! \brief The channel of a stream. */
+  class StreamChannel final : public RPCChannel {
+   public:
+    StreamChannel(std::shared_ptr<Multiplexer> mux, uint64_t id) : mux_(mux), id_(id) {}
+    size_t Send(const void* data, size_t size) final { return mux_->Send(id_, data, size); }
+    size_t Recv(void* data, size_t size) final { return mux_->Recv(id_, data, size); }
+
+   private:
+    std::shared_ptr<Multiplexer> mux_;
+    uint64_t id_;
+  };
+
+  /*!
+   * \brief Create the channel of a stream.
+   * \param id The stream id.
+   * \return The channel.
+   */
+  std::unique_ptr<RPCChannel> OpenStream(uint64_t id) {
+    return std::unique_ptr<RPCChannel>(new StreamChannel(shared_from_this(), id));
+  }
+
+  /*!
+   * \brief Send the bytes of a stream in a frame.
+   * \param id The stream id.
+   * \param data The bytes.
+   * \param size The number of bytes, not 0.
+   * \return The number of bytes sent.
+   */
+  size_t Send(uint64_t id, const void* data, size_t size) {
+    uint64_t header[2] = {id, static_cast<uint64_t>(size)};
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    SendAll(header, sizeof(header));
+    SendAll(data, size);
+    return size;
+  }
+
+  /*!
+   * \brief Receive the bytes of a stream.
+   * \param id The stream id.
+   * \param data The buffer.
+   * \param size The size of the buffer.
+   * \return The number of bytes received, 0 once the connection is closed.
+   */
+  size_t Recv(uint64_t id, void* data, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      Stream& stream = streams_[id];
+      if (!stream.frames.empty()) {
+        const std::string& frame = stream.frames.front();
+        size_t n = std::min(size, frame.size() - stream.offset);
+        std::memcpy(data, frame.data() + stream.offset, n);
+        stream.offset += n;
+        if (stream.offset == frame.size()) {
+          stream.frames.pop_front();
+          stream.offset = 0;
+        }
+        return n;
+      }
+      if (closed_) return 0;
+      if (reading_) {
+        cv_.wait(lock);
+        continue;
+      }
+      // Read a frame on behalf of all the streams.
+      reading_ = true;
+      lock.unlock();
+      uint64_t frame_id = 0;
+      std::string frame;
+      bool received = false;
+      try {
+        received = ReadFrame(&frame_id, &frame);
+      } catch (const dmlc::Error&) {
+        lock.lock();
+        reading_ = false;
+        closed_ = true;
+        cv_.notify_all();
+        throw;
+      }
+      lock.lock();
+      reading_ = false;
+      if (received) {
+        streams_[frame_id].frames.push_back(std::move(frame));
+      } else {
+        closed_ = true;
+      }
+      cv_.notify_all();
+    }
+  }
+
+  /*!
+   * \brief Read the frames until the connection is closed.
+   * \param fopen Called with the id of each new stream, after its first frame is queued.
+   */
+  void Serve(std::function<void(uint64_t)> fopen) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      reading_ = true;
+    }
+    uint64_t id = 0;
+    std::string frame;
+    try {
+      while (ReadFrame(&id, &frame)) {
+        bool is_new = false;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          is_new = streams_.count(id) == 0;
+          streams_[id].frames.push_back(std::move(frame));
+        }
+        cv_.notify_all();
+        if (is_new) fopen(id);
+        frame.clear();
+      }
+    } catch (...) {
+      // Wake the streams blocked in Recv, they see the closed connection.
+      MarkClosed();
+      throw;
+    }
+    MarkClosed();
+  }
+
+  /*! \brief Close the connection, the streams are shut down before. */
+  void Close() {
+    uint64_t header[2] = {0, 0};
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    try {
+      SendAll(header, sizeof(header));
+    } catch (const dmlc::Error&) {
+    }
+  }
+
+ private:
+  // The frames received for a stream.
+  struct Stream {
+    std::deque<std::string> frames;
+    // The bytes of the first frame already received.
+    size_t offset{0};
+  };
+
+  void MarkClosed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reading_ = false;
+    closed_ = true;
+    cv_.notify_all();
+  }
+
+  void SendAll(const void* data, size_t size) {
+    const char* ptr = static_cast<const char*>(data);
+    while (size != 0) {
+      size_t n = channel_->Send(ptr, size);
+      ICHECK_NE(n, 0U) << "Channel closes before we send the data";
+      ptr += n;
+      size -= n;
+    }
+  }
+
+  bool RecvAll(void* data, size_t size) {
+    char* ptr = static_cast<char*>(data);
+    while (size != 0) {
+      size_t n = channel_->Recv(ptr, size);
+      if (n == 0) return false;
+      ptr += n;
+      size -= n;
+    }
+    return true;
+  }
+
+  // Read the next frame, return false once the connection is closed.
+  bool ReadFrame(uint64_t* id, std::string* frame) {
+    uint64_t header[2];
+    if (!RecvAll(header, sizeof(header)) || header[1] == 0) return false;
+    *id = header[0];
+    frame->resize(header[1]);
+    return RecvAll(&(*frame)[0], frame->size());
+  }
+
+  // The connection.
+  std::unique_ptr<RPCChannel> channel_;
+  // Serializes the frames sent.
+  std::mutex send_mutex_;
+  // Protects the fields below.
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::unordered_map<uint64_t, Stream> streams_;
+  // Whether a thread is reading a frame.
+  bool reading_{false};
+  // Whether the connection is closed.
+  bool closed_{false};
 };
 
 RPCCode RPCEndpoint::HandleUntilReturnEvent(bool client_mode, RPCSession::FEncodeReturn setreturn) {
   RPCCode code = RPCCode::kCallFunc;
-  while (code != RPCCode::kReturn && code != RPCCode::kShutdown && code != RPCCode::kCopyAck) {
+  while (code != RPCCode::kReturn && code != RPCCode::kShutdown && code != RPCCode::kCopyAck &&
+         code != RPCCode::kMultiplex && code != RPCCode::kCompress) {
     while (writer_.bytes_available() != 0) {
       writer_.ReadWithCallback(
           [this](const void* data, size_t size) { return channel_->Send(data, size); },
           writer_.bytes_available());
     }
+    char* payload = nullptr;
+    size_t payload_nbytes = handler_->PayloadBuffer(&payload);
     size_t bytes_needed = handler_->BytesNeeded();
-    if (bytes_needed != 0) {
+    if (payload_nbytes != 0 && reader_.bytes_available() == 0) {
+      // Receive the payload of a copy straight into its destination.
+      size_t n = channel_->Recv(payload, payload_nbytes);
+      if (n == 0) {
+        LOG(FATAL) << "Channel closes before we get neded bytes";
+      }
+      handler_->PayloadReceived(n);
+    } else if (bytes_needed != 0) {
       size_t n = reader_.WriteWithCallback(
           [this](void* data, size_t size) { return channel_->Recv(data, size); }, bytes_needed);
       if (n == 0) {
@@ -664,22 +1077,50 @@ RPCCode RPCEndpoint::HandleUntilReturnEvent(bool client_mode, RPCSession::FEncod
   return code;
 }
 
+template <typename F>
+void RPCEndpoint::RunOnStream(F f) {
+  std::shared_ptr<RPCEndpoint> stream;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!idle_streams_.empty()) {
+      stream = std::move(idle_streams_.back());
+      idle_streams_.pop_back();
+    } else {
+      uint64_t id = ++num_streams_;
+      stream = RPCEndpoint::Create(mux_->OpenStream(id), name_ + ":" + std::to_string(id),
+                                   remote_key_);
+    }
+  }
+  try {
+    f(stream.get());
+  } catch (const dmlc::Error&) {
+    // The stream is still in sync after an exception returned by the server.
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_streams_.push_back(std::move(stream));
+    throw;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  idle_streams_.push_back(std::move(stream));
+}
+
 void RPCEndpoint::Init() {
   // callback to flush the writer.
-  auto flush_writer = [this]() {
-    while (writer_.bytes_available() != 0) {
-      size_t n = writer_.ReadWithCallback(
-          [this](const void* data, size_t size) { return channel_->Send(data, size); },
-          writer_.bytes_available());
-      if (n == 0) break;
-    }
-  };
+  auto flush_writer = [this]() { this->FlushWriter(); };
+
+  // callback to flush the writer and send bytes from their buffer.
+  auto write_direct = [this](const void* data, size_t size) { this->WriteDirect(data, size); };
 
   // Event handler
-  handler_ = std::make_shared<EventHandler>(&reader_, &writer_, name_, &remote_key_, flush_writer);
+  handler_ = std::make_shared<EventHandler>(&reader_, &writer_, name_, &remote_key_, flush_writer,
+                                            write_direct);
 
   // Quick function to for syscall remote.
   syscall_remote_ = PackedFunc([this](TVMArgs all_args, TVMRetValue* rv) {
+    if (mux_ != nullptr) {
+      this->RunOnStream(
+          [&](RPCEndpoint* stream) { stream->syscall_remote_.CallPacked(all_args, rv); });
+      return;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     RPCCode code = static_cast<RPCCode>(all_args[0].operator int());
     TVMArgs args(all_args.values + 1, all_args.type_codes + 1, all_args.num_args - 1);
@@ -700,6 +1141,26 @@ void RPCEndpoint::Init() {
   });
 }
 
+void RPCEndpoint::FlushWriter() {
+  while (writer_.bytes_available() != 0) {
+    size_t n = writer_.ReadWithCallback(
+        [this](const void* data, size_t size) { return channel_->Send(data, size); },
+        writer_.bytes_available());
+    if (n == 0) break;
+  }
+}
+
+void RPCEndpoint::WriteDirect(const void* data, size_t size) {
+  this->FlushWriter();
+  const char* ptr = static_cast<const char*>(data);
+  while (size != 0) {
+    size_t n = channel_->Send(ptr, size);
+    ICHECK_NE(n, 0U) << "Channel closes before we send the data";
+    ptr += n;
+    size -= n;
+  }
+}
+
 /*!
  * \brief Create a new RPCEndpoint instance.
  * \param channel RPCChannel used to communicate
@@ -721,6 +1182,13 @@ std::shared_ptr<RPCEndpoint> RPCEndpoint::Create(std::unique_ptr<RPCChannel> cha
 RPCEndpoint::~RPCEndpoint() { this->Shutdown(); }
 
 void RPCEndpoint::Shutdown() {
+  compressed_channel_ = nullptr;
+  if (mux_ != nullptr) {
+    // The streams shut down on the server before the connection closes.
+    idle_streams_.clear();
+    mux_->Close();
+    mux_.reset();
+  }
   if (channel_ != nullptr) {
     RPCCode code = RPCCode::kShutdown;
     uint64_t packet_nbytes = sizeof(code);
@@ -746,14 +1214,71 @@ void RPCEndpoint::ServerLoop() {
   if (const auto* f = Registry::Get("tvm.rpc.server.start")) {
     (*f)();
   }
-  TVMRetValue rv;
-  ICHECK(HandleUntilReturnEvent(false, [](TVMArgs) {}) == RPCCode::kShutdown);
+  RPCCode code = HandleUntilReturnEvent(false, [](TVMArgs) {});
+  if (code == RPCCode::kCompress) {
+    // The reply is the last message sent uncompressed.
+    this->FlushWriter();
+    this->EnableCompression();
+    handler_->FinishCompress();
+    code = HandleUntilReturnEvent(false, [](TVMArgs) {});
+  }
+  if (code == RPCCode::kMultiplex) {
+    this->FlushWriter();
+    this->ServeMultiplexed();
+  } else {
+    ICHECK(code == RPCCode::kShutdown);
+  }
   if (const auto* f = Registry::Get("tvm.rpc.server.shutdown")) {
     (*f)();
   }
   channel_.reset(nullptr);
 }
 
+void RPCEndpoint::EnableCompression() {
+  ICHECK_EQ(reader_.bytes_available(), 0U) << "RPCError: unexpected bytes before compressing";
+  std::unique_ptr<CompressedChannel> channel(new CompressedChannel(std::move(channel_)));
+  compressed_channel_ = channel.get();
+  channel_ = std::move(channel);
+}
+
+std::string RPCEndpoint::GetCompressionStats() {
+  // The counters are atomic, do not wait for the request in flight.
+  return compressed_channel_ != nullptr ? compressed_channel_->GetStats() : "{}";
+}
+
+void RPCEndpoint::ServeMultiplexed() {
+  ICHECK_EQ(reader_.bytes_available(), 0U) << "RPCError: unexpected bytes before multiplexing";
+  mux_ = std::make_shared<Multiplexer>(std::move(channel_));
+  std::vector<std::thread> threads;
+  auto join_streams = [this, &threads]() {
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    mux_.reset();
+  };
+  try {
+    mux_->Serve([this, &threads](uint64_t id) {
+      std::shared_ptr<RPCEndpoint> stream =
+          RPCEndpoint::Create(mux_->OpenStream(id), name_ + ":" + std::to_string(id), remote_key_);
+      stream->handler_->ShareServingSession(*handler_);
+      threads.emplace_back([stream]() {
+        try {
+          stream->HandleUntilReturnEvent(false, [](TVMArgs) {});
+        } catch (const dmlc::Error& e) {
+          LOG(WARNING) << "Server[" << stream->name_ << "]: " << e.what();
+        }
+        // The client closes its streams, do not send it a shutdown.
+        stream->channel_.reset(nullptr);
+      });
+    });
+  } catch (...) {
+    // A joinable thread must not be destroyed. Serve has woken up the streams.
+    join_streams();
+    throw;
+  }
+  join_streams();
+}
+
 int RPCEndpoint::ServerAsyncIOEventHandler(const std::string& in_bytes, int event_flag) {
   RPCCode code = RPCCode::kNone;
   if (in_bytes.length() != 0) {
@@ -771,6 +1296,30 @@ int RPCEndpoint::ServerAsyncIOEventHandler(const std::string& in_bytes, int even
   return 1;
 }
 
+/*!
+ * \brief Select the codec of a compressed channel.
+ * \param wanted The comma separated codecs the client accepts, by preference.
+ * \param offered The comma separated codecs the server supports.
+ * \return The first wanted codec that is offered, empty if there is none.
+ */
+static std::string SelectCodec(const std::string& wanted, const std::string& offered) {
+  auto split = [](const std::string& list) {
+    std::vector<std::string> items;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+      size_t end = std::min(list.find(',', begin), list.size());
+      if (end != begin) items.push_back(list.substr(begin, end - begin));
+      begin = end + 1;
+    }
+    return items;
+  };
+  std::vector<std::string> supported = split(offered);
+  for (const std::string& codec : split(wanted)) {
+    if (std::find(supported.begin(), supported.end(), codec) != supported.end()) return codec;
+  }
+  return "";
+}
+
 void RPCEndpoint::InitRemoteSession(TVMArgs args) {
   std::lock_guard<std::mutex> lock(mutex_);
   RPCCode code = RPCCode::kInitServer;
@@ -788,14 +1337,55 @@ void RPCEndpoint::InitRemoteSession(TVMArgs args) {
   handler_->WriteArray(protocol_ver.data(), length);
   handler_->SendPackedSeq(args.values, args.type_codes, args.num_args, true);
 
+  // Servers that can multiplex return their multiplexed protocol version and the
+  // comma separated codecs they support.
+  std::string mux_ver, codecs;
+  code = HandleUntilReturnEvent(true, [&mux_ver, &codecs](TVMArgs args) {
+    if (args.size() == 2 && args.type_codes[0] == kTVMStr && args.type_codes[1] == kTVMStr) {
+      mux_ver = args[0].operator std::string();
+      codecs = args[1].operator std::string();
+    }
+  });
+  ICHECK(code == RPCCode::kReturn) << "code=" << static_cast<int>(code);
+
+  const char* wanted_codecs = getenv("TVM_RPC_COMPRESSION");
+  std::string codec = wanted_codecs != nullptr ? SelectCodec(wanted_codecs, codecs) : "";
+  if (!codec.empty()) {
+    code = RPCCode::kCompress;
+    TVMValue value;
+    int tcode = kTVMStr;
+    value.v_str = codec.c_str();
+    packet_nbytes = sizeof(code) + handler_->PackedSeqGetNumBytes(&value, &tcode, 1, true);
+    handler_->Write(packet_nbytes);
+    handler_->Write(code);
+    handler_->SendPackedSeq(&value, &tcode, 1, true);
+    code = HandleUntilReturnEvent(true, [](TVMArgs args) {});
+    ICHECK(code == RPCCode::kReturn) << "code=" << static_cast<int>(code);
+    this->EnableCompression();
+  }
+
+  const char* enable_mux = getenv("TVM_RPC_MULTIPLEX");
+  if (mux_ver != kRPCMultiplexVer || enable_mux == nullptr || atoi(enable_mux) == 0) return;
+  code = RPCCode::kMultiplex;
+  packet_nbytes = sizeof(code) + handler_->PackedSeqGetNumBytes(nullptr, nullptr, 0, true);
+  handler_->Write(packet_nbytes);
+  handler_->Write(code);
+  handler_->SendPackedSeq(nullptr, nullptr, 0, true);
   code = HandleUntilReturnEvent(true, [](TVMArgs args) {});
   ICHECK(code == RPCCode::kReturn) << "code=" << static_cast<int>(code);
+  ICHECK_EQ(reader_.bytes_available(), 0U) << "RPCError: unexpected bytes before multiplexing";
+  mux_ = std::make_shared<Multiplexer>(std::move(channel_));
 }
 
 // Get remote function with name
 void RPCEndpoint::CallFunc(RPCSession::PackedFuncHandle h, const TVMValue* arg_values,
                            const int* arg_type_codes, int num_args,
                            RPCSession::FEncodeReturn encode_return) {
+  if (mux_ != nullptr) {
+    return this->RunOnStream([&](RPCEndpoint* stream) {
+      stream->CallFunc(h, arg_values, arg_type_codes, num_args, encode_return);
+    });
+  }
   std::lock_guard<std::mutex> lock(mutex_);
 
   handler_->ValidateArguments(arg_values, arg_type_codes, num_args);
@@ -817,50 +1407,120 @@ void RPCEndpoint::CallFunc(RPCSession::PackedFuncHandle h, const TVMValue* arg_v
 
 void RPCEndpoint::CopyToRemote(void* from, size_t from_offset, void* to, size_t to_offset,
                                size_t data_size, TVMContext ctx_to, DLDataType type_hint) {
+  if (mux_ != nullptr) {
+    return this->RunOnStream([&](RPCEndpoint* stream) {
+      stream->CopyToRemote(from, from_offset, to, to_offset, data_size, ctx_to, type_hint);
+    });
+  }
   std::lock_guard<std::mutex> lock(mutex_);
   RPCCode code = RPCCode::kCopyToRemote;
   uint64_t handle = reinterpret_cast<uint64_t>(to);
-  uint64_t offset = static_cast<uint64_t>(to_offset);
-  uint64_t size = static_cast<uint64_t>(data_size);
-
-  uint64_t packet_nbytes = sizeof(code) + sizeof(handle) + sizeof(offset) + sizeof(size) +
-                           sizeof(ctx_to) + sizeof(type_hint) + data_size;
-
-  handler_->Write(packet_nbytes);
-  handler_->Write(code);
-  handler_->Write(handle);
-  handler_->Write(offset);
-  handler_->Write(size);
-  handler_->Write(ctx_to);
-  handler_->Write(type_hint);
-  handler_->WriteArray(reinterpret_cast<char*>(from) + from_offset, data_size);
-
-  ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kReturn);
+  size_t chunk_size = CopyChunkSize(type_hint);
+  char* data = reinterpret_cast<char*>(from) + from_offset;
+  int in_flight = 0;
+
+  try {
+    // Send the chunks without waiting for the previous ones to be written,
+    // each one straight from the source.
+    size_t begin = 0;
+    do {
+      uint64_t offset = static_cast<uint64_t>(to_offset + begin);
+      uint64_t size = static_cast<uint64_t>(std::min(chunk_size, data_size - begin));
+      uint64_t packet_nbytes = sizeof(code) + sizeof(handle) + sizeof(offset) + sizeof(size) +
+                               sizeof(ctx_to) + sizeof(type_hint) + size;
+
+      handler_->Write(packet_nbytes);
+      handler_->Write(code);
+      handler_->Write(handle);
+      handler_->Write(offset);
+      handler_->Write(size);
+      handler_->Write(ctx_to);
+      handler_->Write(type_hint);
+      WriteDirect(data + begin, size);
+      begin += size;
+
+      if (++in_flight == kMaxCopiesInFlight) {
+        --in_flight;
+        ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kReturn);
+      }
+    } while (begin < data_size);
+    for (; in_flight != 0; --in_flight) {
+      ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kReturn);
+    }
+  } catch (const dmlc::Error&) {
+    // Consume the replies of the chunks still in flight to keep the channel usable.
+    for (; in_flight != 0; --in_flight) {
+      try {
+        HandleUntilReturnEvent(true, [](TVMArgs) {});
+      } catch (const dmlc::Error&) {
+      }
+    }
+    throw;
+  }
 }
 
 void RPCEndpoint::CopyFromRemote(void* from, size_t from_offset, void* to, size_t to_offset,
                                  size_t data_size, TVMContext ctx_from, DLDataType type_hint) {
+  if (mux_ != nullptr) {
+    return this->RunOnStream([&](RPCEndpoint* stream) {
+      stream->CopyFromRemote(from, from_offset, to, to_offset, data_size, ctx_from, type_hint);
+    });
+  }
   std::lock_guard<std::mutex> lock(mutex_);
   RPCCode code = RPCCode::kCopyFromRemote;
   uint64_t handle = reinterpret_cast<uint64_t>(from);
-  uint64_t offset = static_cast<uint64_t>(from_offset);
-  uint64_t size = static_cast<uint64_t>(data_size);
+  size_t chunk_size = CopyChunkSize(type_hint);
+  char* data = reinterpret_cast<char*>(to) + to_offset;
+  size_t num_chunks = std::max<size_t>((data_size + chunk_size - 1) / chunk_size, 1);
+  size_t num_requested = 0, num_received = 0;
+
+  // Request the next chunk.
+  auto request = [&]() {
+    uint64_t offset = static_cast<uint64_t>(from_offset + num_requested * chunk_size);
+    uint64_t size =
+        static_cast<uint64_t>(std::min(chunk_size, data_size - num_requested * chunk_size));
+    uint64_t packet_nbytes = sizeof(code) + sizeof(handle) + sizeof(offset) + sizeof(size) +
+                             sizeof(ctx_from) + sizeof(type_hint);
 
-  uint64_t packet_nbytes = sizeof(code) + sizeof(handle) + sizeof(offset) + sizeof(size) +
-                           sizeof(ctx_from) + sizeof(type_hint);
+    handler_->Write(packet_nbytes);
+    handler_->Write(code);
+    handler_->Write(handle);
+    handler_->Write(offset);
+    handler_->Write(size);
+    handler_->Write(ctx_from);
+    handler_->Write(type_hint);
+    ++num_requested;
+  };
+  // Receive the next chunk straight into its destination, the replies come in order.
+  auto receive = [&]() {
+    size_t begin = num_received * chunk_size;
+    handler_->ExpectCopyAck(data + begin, std::min(chunk_size, data_size - begin));
+    ++num_received;
+    RPCCode status = HandleUntilReturnEvent(true, [](TVMArgs) {});
+    handler_->ExpectCopyAck(nullptr, 0);
+    ICHECK(status == RPCCode::kCopyAck);
+    handler_->FinishCopyAck();
+  };
 
-  handler_->Write(packet_nbytes);
-  handler_->Write(code);
-  handler_->Write(handle);
-  handler_->Write(offset);
-  handler_->Write(size);
-  handler_->Write(ctx_from);
-  handler_->Write(type_hint);
-
-  TVMRetValue rv;
-  ICHECK(HandleUntilReturnEvent(true, [](TVMArgs) {}) == RPCCode::kCopyAck);
-  handler_->ReadArray(reinterpret_cast<char*>(to) + to_offset, data_size);
-  handler_->FinishCopyAck();
+  try {
+    while (num_received < num_chunks) {
+      while (num_requested < num_chunks &&
+             num_requested - num_received < static_cast<size_t>(kMaxCopiesInFlight)) {
+        request();
+      }
+      receive();
+    }
+  } catch (const dmlc::Error&) {
+    handler_->ExpectCopyAck(nullptr, 0);
+    // Consume the replies of the chunks still in flight to keep the channel usable.
+    while (num_received < num_requested) {
+      try {
+        receive();
+      } catch (const dmlc::Error&) {
+      }
+    }
+    throw;
+  }
 }
 
 // SysCallEventHandler functions
@@ -960,11 +1620,18 @@ void RPCEndpoint::EventHandler::HandleSyscall(RPCCode code) {
     case RPCCode::kCopyAmongRemote:
       SysCallHandler(RPCCopyAmongRemote);
       break;
+    case RPCCode::kMultiplex:
+      this->HandleSyscallMultiplex();
+      break;
+    case RPCCode::kCompress:
+      this->HandleSyscallCompress();
+      break;
     default:
       LOG(FATAL) << "Unknown event " << static_cast<int>(code);
   }
 
-  if (state_ != kWaitForAsyncCallback) {
+  if (state_ != kWaitForAsyncCallback && state_ != kMultiplexReceived &&
+      state_ != kCompressReceived) {
     ICHECK_EQ(state_, kRecvPacketNumBytes);
   }
 }
@@ -1038,6 +1705,9 @@ class RPCClientSession : public RPCSession, public DeviceAPI {
 
   bool IsLocalSession() const final { return false; }
 
+  /*! \return The client endpoint of the session. */
+  const std::shared_ptr<RPCEndpoint>& endpoint() const { return endpoint_; }
+
  private:
   std::shared_ptr<RPCEndpoint> endpoint_;
 };
@@ -1046,5 +1716,11 @@ std::shared_ptr<RPCSession> CreateClientSession(std::shared_ptr<RPCEndpoint> end
   return std::make_shared<RPCClientSession>(endpoint);
 }
 
+TVM_REGISTER_GLOBAL("rpc.GetCompressionStats").set_body_typed([](Module mod) {
+  auto sess = std::dynamic_pointer_cast<RPCClientSession>(RPCModuleGetSession(mod));
+  ICHECK(sess != nullptr) << "Expect the session of an RPC client";
+  return sess->endpoint()->GetCompressionStats();
+});
+
 }  // namespace runtime
 }  // namespace tvm
@@ -26,10 +26,12 @@
 
 #include <tvm/runtime/packed_func.h>
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "../../support/ring_buffer.h"
 #include "../minrpc/rpc_reference.h"
@@ -111,6 +113,13 @@ class RPCEndpoint {
    *  }
    * \endcode
    *
+   *  When TVM_RPC_COMPRESSION lists a codec the server supports, such as lz,
+   *  the bytes sent afterwards are compressed with the first such codec of the
+   *  comma separated list. When TVM_RPC_MULTIPLEX=1 and the server
+   *  supports it, the connection is multiplexed afterwards: each concurrent
+   *  request runs on a stream of its own, so the calls and copies of several
+   *  threads are in flight at once.
+   *
    * \param session_constructor_args Optional sequence of the remote sesssion constructor.
    */
   void InitRemoteSession(TVMArgs session_constructor_args);
@@ -158,6 +167,8 @@ class RPCEndpoint {
    */
   template <typename... Args>
   inline TVMRetValue SysCallRemote(RPCCode fcode, Args&&... args);
+  /*! \return The counters of the compressed channel as a JSON object, empty if not compressed. */
+  std::string GetCompressionStats();
   /*!
    * \brief Create a RPC session with given channel.
    * \param channel The communication channel.
@@ -171,9 +182,35 @@ class RPCEndpoint {
 
  private:
   class EventHandler;
+  class Multiplexer;
   // Handle events until receives a return
   // Also flushes channels so that the function advances.
   RPCCode HandleUntilReturnEvent(bool client_mode, RPCSession::FEncodeReturn setreturn);
+  // Send the buffered bytes to the channel.
+  void FlushWriter();
+  // Send the buffered bytes, then the given bytes without copying them to the buffer.
+  void WriteDirect(const void* data, size_t size);
+  // The size of the chunks of a bulk copy, a multiple of the element size.
+  static size_t CopyChunkSize(DLDataType type_hint) {
+    size_t elem_bytes = std::max((type_hint.bits * type_hint.lanes + 7) / 8, 1);
+    return std::max(kCopyChunkBytes / elem_bytes, size_t(1)) * elem_bytes;
+  }
+  /*!
+   * \brief The bytes of a bulk copy sent per packet.
+   *
+   *  A copy is split in packets, so the server stages one packet of a copy to
+   *  a device at a time and copies it while receiving the next one.
+   */
+  static constexpr size_t kCopyChunkBytes = 1 << 20;
+  /*! \brief The packets of a copy sent before waiting for the reply to the first one. */
+  static constexpr int kMaxCopiesInFlight = 8;
+  // Compress the bytes sent and received from now on.
+  void EnableCompression();
+  // Serve each stream of a multiplexed connection in a thread.
+  void ServeMultiplexed();
+  // Run a request on an idle stream of a multiplexed client.
+  template <typename F>
+  void RunOnStream(F f);
   // Initalization
   void Init();
   // Shutdown
@@ -192,6 +229,14 @@ class RPCEndpoint {
   std::string name_;
   // The remote key
   std::string remote_key_;
+  // The compressed channel under the endpoint or its streams, if any.
+  CompressedChannel* compressed_channel_{nullptr};
+  // The connection shared by the streams, once multiplexed.
+  std::shared_ptr<Multiplexer> mux_;
+  // The client endpoints of the idle streams.
+  std::vector<std::shared_ptr<RPCEndpoint>> idle_streams_;
+  // The number of streams opened by the client.
+  uint64_t num_streams_{0};
 };
 
 /*!
@@ -31,10 +31,19 @@
 #if TVM_THREADPOOL_USE_OPENMP
 #include <omp.h>
 #endif
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <sstream>
@@ -58,8 +67,74 @@ uint32_t GetSpinCount() {
   return atoi(val);
 }
 
+// Lower bound of the adaptive spin count, parking right away is rarely a win.
+constexpr uint32_t kMinSpinCount = 64;
+
+bool UseAdaptiveSpin() {
+  const char* val = getenv("TVM_THREAD_POOL_ADAPTIVE_SPIN");
+  return val == nullptr || atoi(val) != 0;
+}
+
+int64_t NowNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+#if defined(__linux__)
+void FutexWait(std::atomic<int32_t>* addr, int32_t expected) {
+  syscall(SYS_futex, reinterpret_cast<int32_t*>(addr), FUTEX_WAIT_PRIVATE, expected, nullptr,
+          nullptr, 0);
+}
+
+void FutexWake(std::atomic<int32_t>* addr, int32_t count) {
+  syscall(SYS_futex, reinterpret_cast<int32_t*>(addr), FUTEX_WAKE_PRIVATE, count, nullptr,
+          nullptr, 0);
+}
+#endif
+
+// TVMBackendParallelBarrier needs all the tasks of a job to run at once,
+// which a chunked launch cannot guarantee, so chunking is opt-in.
+constexpr int kDefaultChunkFactor = 1;
+
+int GetChunkFactor() {
+  const char* val = getenv("TVM_THREAD_POOL_CHUNK_FACTOR");
+  if (!val) {
+    return kDefaultChunkFactor;
+  }
+  return std::max(atoi(val), 1);
+}
+
 }  // namespace
 
+/*! \brief The kind of thread pool backing TVMBackendParallelLaunch. */
+enum class ThreadPoolKind : int {
+  /*! \brief Static assignment of task i to worker i through SPSC queues. */
+  kSpsc = 0,
+  /*! \brief Per-worker deques with work stealing and nested launches. */
+  kWorkStealing = 1,
+  /*! \brief One process-wide work-stealing pool shared by all application threads. */
+  kShared = 2,
+};
+
+ThreadPoolKind ParseThreadPoolKind(const std::string& name) {
+  if (name == "spsc") return ThreadPoolKind::kSpsc;
+  if (name == "work_stealing") return ThreadPoolKind::kWorkStealing;
+  if (name == "shared") return ThreadPoolKind::kShared;
+  LOG(FATAL) << "Unknown thread pool kind " << name
+             << ", candidates are: spsc, work_stealing, shared";
+  return ThreadPoolKind::kSpsc;
+}
+
+/*! \return The global thread pool kind, initialized from envvar TVM_THREAD_POOL_KIND. */
+std::atomic<int>* GlobalThreadPoolKind() {
+  static std::atomic<int> kind([]() {
+    const char* val = getenv("TVM_THREAD_POOL_KIND");
+    return static_cast<int>(val ? ParseThreadPoolKind(val) : ThreadPoolKind::kSpsc);
+  }());
+  return &kind;
+}
+
 // stride in the page, fit to cache line.
 constexpr int kSyncStride = 64 / sizeof(std::atomic<int>);
 
@@ -78,10 +153,11 @@ class ParallelLauncher {
     // reshape
     if (static_cast<size_t>(num_task) > par_errors_.size()) {
       par_errors_.resize(num_task + 1);
-      if (need_sync) {
-        delete[] sync_counter_;
-        sync_counter_ = new std::atomic<int>[num_task * kSyncStride];
-      }
+    }
+    if (need_sync && num_task > sync_counter_size_) {
+      delete[] sync_counter_;
+      sync_counter_ = new std::atomic<int>[num_task * kSyncStride];
+      sync_counter_size_ = num_task;
     }
     if (need_sync) {
       for (int i = 0; i < num_task; ++i) {
@@ -117,6 +193,8 @@ class ParallelLauncher {
   }
   // Signal that one job has finished.
   void SignalJobFinish() { num_pending_.fetch_sub(1); }
+  // Whether all the jobs have finished.
+  bool Finished() const { return num_pending_.load(std::memory_order_acquire) == 0; }
   // Get thread local version of the store.
   static ParallelLauncher* ThreadLocal() { return dmlc::ThreadLocalStore<ParallelLauncher>::Get(); }
   // The parallel lambda
@@ -136,11 +214,30 @@ class ParallelLauncher {
   std::atomic<bool> has_error_;
   // The counter page.
   std::atomic<int32_t>* sync_counter_{nullptr};
+  // The number of tasks the counter page can host.
+  int sync_counter_size_{0};
   // The error message
   std::vector<std::string> par_errors_;
 };
 
-/*! \brief Lock-free single-producer-single-consumer queue for each thread */
+/*! \brief Wake-up statistics of the pool workers. */
+struct WakeStats {
+  /*! \brief Number of waits for work served while spinning. */
+  uint64_t spin_hits{0};
+  /*! \brief Number of waits for work that parked the worker. */
+  uint64_t parks{0};
+  /*! \brief Accumulated time between a push and the parked worker resuming. */
+  uint64_t wake_latency_ns{0};
+};
+
+/*!
+ * \brief Lock-free single-producer-single-consumer queue for each thread
+ *
+ *  An empty queue spins for a while before it parks the consumer. The spin
+ *  count adapts to the inter-launch gap seen by the consumer: it spins about
+ *  twice the average gap when that fits in the maximum spin count, and parks
+ *  almost immediately otherwise. On Linux the consumer parks on a futex.
+ */
 class SpscTaskQueue {
  public:
   /*! \brief The task entry */
@@ -161,9 +258,16 @@ class SpscTaskQueue {
     while (!Enqueue(input)) {
       tvm::runtime::threading::Yield();
     }
-    if (pending_.fetch_add(1) == -1) {
+    // The timestamp is published by the increment of pending_, so a consumer
+    // woken by it never reads the one of an earlier push.
+    wake_begin_ns_.store(NowNanoseconds(), std::memory_order_release);
+    if (pending_.fetch_add(1, std::memory_order_acq_rel) == -1) {
+#if defined(__linux__)
+      FutexWake(&pending_, 1);
+#else
       std::unique_lock<std::mutex> lock(mutex_);
       cv_.notify_one();
+#endif
     }
   }
 
@@ -177,13 +281,29 @@ class SpscTaskQueue {
     // Busy wait a bit when the queue is empty.
     // If a new task comes to the queue quickly, this wait avoid the worker from sleeping.
     // The default spin count is set by following the typical omp convention
-    for (uint32_t i = 0; i < spin_count && pending_.load() == 0; ++i) {
+    uint32_t spin_limit = adaptive_spin_ ? std::min(spin_count, adaptive_spin_count_) : spin_count;
+    int64_t spin_begin = NowNanoseconds();
+    uint32_t i = 0;
+    for (; i < spin_limit && pending_.load() == 0; ++i) {
       tvm::runtime::threading::Yield();
     }
+    int64_t spin_end = NowNanoseconds();
+    double gap = i;
     if (pending_.fetch_sub(1) == 0) {
-      std::unique_lock<std::mutex> lock(mutex_);
-      cv_.wait(lock, [this] { return pending_.load() >= 0 || exit_now_.load(); });
+      Park();
+      int64_t wake_end = NowNanoseconds();
+      stats_.parks.fetch_add(1, std::memory_order_relaxed);
+      stats_.wake_latency_ns.fetch_add(
+          std::max<int64_t>(wake_end - wake_begin_ns_.load(std::memory_order_acquire), 0),
+          std::memory_order_relaxed);
+      gap += (wake_end - spin_end) / ns_per_spin_;
+    } else {
+      stats_.spin_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (i != 0) {
+      ns_per_spin_ = 0.875 * ns_per_spin_ + 0.125 * (spin_end - spin_begin) / i;
     }
+    if (adaptive_spin_) UpdateSpinCount(gap, spin_count);
     if (exit_now_.load(std::memory_order_relaxed)) {
       return false;
     }
@@ -199,12 +319,61 @@ class SpscTaskQueue {
    * \brief Signal to terminate the worker.
    */
   void SignalForKill() {
+#if defined(__linux__)
+    exit_now_.store(true);
+    // change the futex word so that a consumer about to park does not miss the signal
+    pending_.fetch_add(1);
+    FutexWake(&pending_, 1);
+#else
     std::lock_guard<std::mutex> lock(mutex_);
     exit_now_.store(true);
     cv_.notify_all();
+#endif
+  }
+
+  /*!
+   * \brief Accumulate the wake-up statistics of the queue.
+   * \param stats The statistics to be updated.
+   * \param reset Whether to reset the counters of the queue.
+   */
+  void CollectStats(WakeStats* stats, bool reset) {
+    stats->spin_hits += reset ? stats_.spin_hits.exchange(0) : stats_.spin_hits.load();
+    stats->parks += reset ? stats_.parks.exchange(0) : stats_.parks.load();
+    stats->wake_latency_ns +=
+        reset ? stats_.wake_latency_ns.exchange(0) : stats_.wake_latency_ns.load();
   }
 
  protected:
+  /*! \brief Block the consumer until a task is pushed or the queue is killed. */
+  void Park() {
+#if defined(__linux__)
+    while (true) {
+      int32_t pending = pending_.load();
+      if (pending >= 0 || exit_now_.load()) break;
+      FutexWait(&pending_, pending);
+    }
+#else
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return pending_.load() >= 0 || exit_now_.load(); });
+#endif
+  }
+
+  /*!
+   * \brief Learn the inter-launch gap and update the spin count.
+   * \param gap The last gap, in spin iterations.
+   * \param spin_count The maximum spin count.
+   */
+  void UpdateSpinCount(double gap, uint32_t spin_count) {
+    avg_gap_ = avg_gap_ < 0 ? gap : 0.875 * avg_gap_ + 0.125 * gap;
+    // Spinning cannot hide gaps longer than the maximum spin count, park early for those.
+    double target = 2 * avg_gap_;
+    if (target <= spin_count) {
+      adaptive_spin_count_ = std::max(kMinSpinCount, static_cast<uint32_t>(target));
+    } else {
+      adaptive_spin_count_ = kMinSpinCount;
+    }
+  }
+
   /*!
    * \brief Lock-free enqueue.
    * \param input The task to be enqueued.
@@ -241,13 +410,31 @@ class SpscTaskQueue {
   std::atomic<uint32_t> tail_;
 
   cache_line_pad_t pad3_;
-  // pending tasks in the queue
-  std::atomic<int8_t> pending_{0};
+  // pending tasks in the queue, negative when the consumer is parked.
+  // It is 32 bits wide to serve as a futex word.
+  std::atomic<int32_t> pending_{0};
 
   cache_line_pad_t pad4_;
   // signal for exit now
   std::atomic<bool> exit_now_{false};
 
+  // time at which the producer woke up the parked consumer
+  std::atomic<int64_t> wake_begin_ns_{0};
+
+  // consumer side state of the adaptive spin.
+  bool adaptive_spin_{UseAdaptiveSpin()};
+  uint32_t adaptive_spin_count_{std::numeric_limits<uint32_t>::max()};
+  // average inter-launch gap in spin iterations, negative before the first pop.
+  double avg_gap_{-1};
+  // average duration of one spin iteration.
+  double ns_per_spin_{100};
+  // wake-up statistics, written by the consumer only.
+  struct {
+    std::atomic<uint64_t> spin_hits{0};
+    std::atomic<uint64_t> parks{0};
+    std::atomic<uint64_t> wake_latency_ns{0};
+  } stats_;
+
   // internal mutex
   std::mutex mutex_;
   // cv for consumer
@@ -311,17 +498,36 @@ class ThreadPool {
     return res;
   }
 
-  static ThreadPool* ThreadLocal() { return dmlc::ThreadLocalStore<ThreadPool>::Get(); }
+  static ThreadPool* ThreadLocal() {
+    std::unique_ptr<ThreadPool>& pool = LocalSlot();
+    if (pool == nullptr) pool.reset(new ThreadPool());
+    return pool.get();
+  }
+
+  /*! \return The pool owned by the calling thread, nullptr until its first launch. */
+  static std::unique_ptr<ThreadPool>& LocalSlot() {
+    static thread_local std::unique_ptr<ThreadPool> pool;
+    return pool;
+  }
 
-  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads) {
+  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads,
+                                 int first_core) {
     // this will also reset the affinity of the ThreadGroup
     // may use less than the MaxConcurrency number of workers
-    num_workers_used_ = threads_->Configure(mode, nthreads, exclude_worker0_);
+    num_workers_used_ = threads_->Configure(mode, nthreads, exclude_worker0_, first_core);
     // if MaxConcurrency restricted the number of workers (e.g., due to
     // hyperthreading), respect the restriction
     num_workers_used_ = std::min(num_workers_, num_workers_used_);
   }
 
+  WakeStats GetStats(bool reset) {
+    WakeStats stats;
+    for (std::unique_ptr<SpscTaskQueue>& q : queues_) {
+      q->CollectStats(&stats, reset);
+    }
+    return stats;
+  }
+
  private:
   // Internal worker function.
   void RunWorker(int worker_id) {
@@ -352,11 +558,446 @@ class ThreadPool {
   std::unique_ptr<tvm::runtime::threading::ThreadGroup> threads_;
 };
 
+/*!
+ * \brief Thread pool with per-worker task deques and work stealing.
+ *
+ *  Unlike ThreadPool, tasks are not bound to a worker: idle workers steal them
+ *  from each other. With TVM_THREAD_POOL_CHUNK_FACTOR above 1, a launch splits
+ *  the job into num_workers * chunk_factor chunks, so a single slow chunk does
+ *  not stall the whole launch. A task may
+ *  itself call TVMBackendParallelLaunch; the nested tasks are pushed onto the
+ *  calling worker's deque and the caller keeps executing tasks until its
+ *  own job finishes.
+ *
+ *  TVMBackendParallelBarrier requires all tasks of a job to run concurrently,
+ *  so it is only available for top-level launches that are not chunked, which
+ *  is the default.
+ *
+ *  In shared mode a single pool serves every application thread. Each
+ *  top-level launch is admitted with a number of workers bounded by the fair
+ *  share of the pool among the concurrent launches and by the calling
+ *  thread's quota, so concurrent sessions do not oversubscribe the cores.
+ *  A launch with an explicit num_task above that number is admitted the same
+ *  way, its tasks are run in turn by the admitted number of pool tasks.
+ *  While it waits, an application thread only runs the tasks of its own launch,
+ *  so a session never spends its time on the work of another one.
+ */
+class WorkStealingThreadPool {
+ public:
+  /*! \brief The task entry, it runs the tasks task_id, task_id + stride, ... of the job. */
+  struct Task {
+    ParallelLauncher* launcher;
+    int32_t task_id;
+    int32_t stride;
+  };
+
+  explicit WorkStealingThreadPool(bool shared = false)
+      : num_workers_(tvm::runtime::threading::MaxConcurrency()),
+        chunk_factor_(GetChunkFactor()),
+        spin_count_(GetSpinCount()),
+        shared_(shared) {
+    for (int i = 0; i < num_workers_; ++i) {
+      deques_.emplace_back(std::unique_ptr<TaskDeque>(new TaskDeque()));
+    }
+    // worker 0 is always the thread that owns the pool,
+    // in shared mode its deque is shared by all application threads.
+    threads_ = std::unique_ptr<tvm::runtime::threading::ThreadGroup>(
+        new tvm::runtime::threading::ThreadGroup(
+            num_workers_, [this](int worker_id) { this->RunWorker(worker_id); },
+            true /* include_main_thread */));
+    num_workers_used_ = threads_->Configure(threading::ThreadGroup::kBig, 0, true);
+    free_workers_.store(num_workers_used_ - 1);
+  }
+  ~WorkStealingThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      exit_now_.store(true);
+      cv_.notify_all();
+    }
+    threads_.reset();
+  }
+
+  int Launch(FTVMParallelLambda flambda, void* cdata, int num_task, int need_sync) {
+    WorkerContext* ctx = WorkerContext::ThreadLocal();
+    // Launches from the owning thread run as worker 0 of this pool.
+    int worker_id = ctx->pool == this ? ctx->worker_id : 0;
+    bool nested = ctx->pool != nullptr || ctx->depth != 0;
+    bool admitted = shared_ && !nested;
+    int num_workers = num_workers_used_;
+    int granted = 0;
+    if (admitted) {
+      granted = AdmitLaunch(ctx->quota);
+      num_workers = granted + 1;
+    }
+    // Chunking would let idle workers beyond the admitted ones join a shared launch.
+    bool chunked = num_task == 0 && chunk_factor_ > 1 && !shared_;
+    if (num_task == 0) {
+      num_task = (nested || !chunked) ? num_workers : num_workers * chunk_factor_;
+    }
+    bool sync = need_sync != 0 && !nested && !chunked && num_task <= num_workers;
+    // An admitted launch never runs on more threads than it was admitted with.
+    int num_runs = admitted ? std::min(num_task, num_workers) : num_task;
+
+    ParallelLauncher* launcher = ctx->AcquireLauncher();
+    launcher->Init(flambda, cdata, num_task, sync);
+    if (nested) {
+      // Keep nested tasks local, other workers steal them when idle.
+      for (int i = num_runs - 1; i >= 0; --i) {
+        deques_[worker_id]->PushBack(Task{launcher, i, num_runs});
+      }
+    } else {
+      // Spread the top-level tasks round-robin so every worker starts with local work.
+      for (int i = num_runs - 1; i >= 0; --i) {
+        deques_[i % num_workers_used_]->PushBack(Task{launcher, i, num_runs});
+      }
+    }
+    NotifyPush(num_runs);
+    // Help executing tasks until the job finishes.
+    Task task;
+    while (!launcher->Finished()) {
+      if (admitted ? TryPopOf(launcher, &task) : TryPop(worker_id, &task)) {
+        RunTask(task);
+      } else {
+        tvm::runtime::threading::Yield();
+      }
+    }
+    int res = launcher->WaitForJobs();
+    ctx->ReleaseLauncher();
+    if (admitted) {
+      FinishLaunch(granted);
+    }
+    return res;
+  }
+
+  static WorkStealingThreadPool* ThreadLocal() {
+    WorkerContext* ctx = WorkerContext::ThreadLocal();
+    // Nested launches from a worker go to the pool the worker belongs to.
+    if (ctx->pool != nullptr) return ctx->pool;
+    std::unique_ptr<WorkStealingThreadPool>& pool = LocalSlot();
+    if (pool == nullptr) pool.reset(new WorkStealingThreadPool());
+    return pool.get();
+  }
+
+  /*! \return The pool owned by the calling thread, nullptr until its first launch. */
+  static std::unique_ptr<WorkStealingThreadPool>& LocalSlot() {
+    static thread_local std::unique_ptr<WorkStealingThreadPool> pool;
+    return pool;
+  }
+
+  /*! \return The process-wide pool used in shared mode. */
+  static WorkStealingThreadPool* Global() {
+    WorkStealingThreadPool* pool = GlobalSlot()->load(std::memory_order_acquire);
+    if (pool != nullptr) return pool;
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    pool = GlobalSlot()->load(std::memory_order_relaxed);
+    if (pool == nullptr) {
+      // Never destroyed, the workers may still be running at exit.
+      pool = new WorkStealingThreadPool(true);
+      GlobalSlot()->store(pool, std::memory_order_release);
+    }
+    return pool;
+  }
+
+  /*! \return The slot of the process-wide pool, nullptr until its first use. */
+  static std::atomic<WorkStealingThreadPool*>* GlobalSlot() {
+    static std::atomic<WorkStealingThreadPool*> pool{nullptr};
+    return &pool;
+  }
+
+  /*! \brief Forget the pools of the calling thread after fork, their workers are gone. */
+  static void ResetAfterFork() {
+    WorkerContext* ctx = WorkerContext::ThreadLocal();
+    ctx->pool = nullptr;
+    ctx->depth = 0;
+    LocalSlot().release();
+    GlobalSlot()->store(nullptr, std::memory_order_release);
+  }
+
+  void UpdateWorkerConfiguration(threading::ThreadGroup::AffinityMode mode, int nthreads,
+                                 int first_core) {
+    if (shared_) {
+      // The shared pool is not reconfigured by one session,
+      // nthreads becomes the number of cores the calling thread may use.
+      SetSessionQuota(nthreads);
+      return;
+    }
+    num_workers_used_ = threads_->Configure(mode, nthreads, true, first_core);
+    num_workers_used_ = std::min(num_workers_, num_workers_used_);
+  }
+
+  /*!
+   * \brief Set the maximum number of cores, including the calling thread,
+   *  used by launches from the calling thread in shared mode.
+   * \param quota The quota, 0 means the fair share of the pool.
+   */
+  static void SetSessionQuota(int quota) {
+    ICHECK_GE(quota, 0) << "The core quota must be non-negative";
+    WorkerContext::ThreadLocal()->quota = quota;
+  }
+
+  WakeStats GetStats(bool reset) {
+    WakeStats stats;
+    stats.spin_hits = reset ? stats_.spin_hits.exchange(0) : stats_.spin_hits.load();
+    stats.parks = reset ? stats_.parks.exchange(0) : stats_.parks.load();
+    stats.wake_latency_ns =
+        reset ? stats_.wake_latency_ns.exchange(0) : stats_.wake_latency_ns.load();
+    return stats;
+  }
+
+ private:
+  /*! \brief Per-thread state: the pool a worker belongs to and its launcher stack. */
+  struct WorkerContext {
+    // The pool this thread is a worker of, nullptr for application threads.
+    WorkStealingThreadPool* pool{nullptr};
+    // The worker id inside the pool.
+    int worker_id{0};
+    // The current parallel launch nesting depth.
+    int depth{0};
+    // The number of cores launches from this thread may use in shared mode, 0 for no limit.
+    int quota{0};
+    // One launcher per nesting depth, they stay alive across launches.
+    std::vector<std::unique_ptr<ParallelLauncher>> launchers;
+
+    ParallelLauncher* AcquireLauncher() {
+      if (static_cast<size_t>(depth) == launchers.size()) {
+        launchers.emplace_back(new ParallelLauncher());
+      }
+      return launchers[depth++].get();
+    }
+    void ReleaseLauncher() { --depth; }
+
+    static WorkerContext* ThreadLocal() { return dmlc::ThreadLocalStore<WorkerContext>::Get(); }
+  };
+
+  /*!
+   * \brief Task deque of one worker.
+   *  The owner pushes and pops at the back, thieves steal from the front.
+   *  The critical sections are a few instructions long, so a mutex is enough.
+   */
+  class TaskDeque {
+   public:
+    void PushBack(const Task& task) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(task);
+    }
+    bool PopBack(Task* task) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (tasks_.empty()) return false;
+      *task = tasks_.back();
+      tasks_.pop_back();
+      return true;
+    }
+    bool StealFront(Task* task) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (tasks_.empty()) return false;
+      *task = tasks_.front();
+      tasks_.pop_front();
+      return true;
+    }
+    // Take the most recently pushed task of a launch.
+    bool TakeOf(const ParallelLauncher* launcher, Task* task) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto it = tasks_.rbegin(); it != tasks_.rend(); ++it) {
+        if (it->launcher == launcher) {
+          *task = *it;
+          tasks_.erase(std::next(it).base());
+          return true;
+        }
+      }
+      return false;
+    }
+
+   protected:
+    // the cache line padding avoids false sharing between the deques
+    char pad_[kL1CacheBytes];
+    std::mutex mutex_;
+    std::deque<Task> tasks_;
+  };
+
+  /*!
+   * \brief Admit a top-level launch of the shared pool.
+   * \param quota The core quota of the calling session, 0 for no limit.
+   * \return The number of workers reserved for the launch besides the caller.
+   */
+  int AdmitLaunch(int quota) {
+    int active = num_active_launches_.fetch_add(1) + 1;
+    int limit = std::max(num_workers_used_ / active, 1);
+    if (quota != 0) limit = std::min(limit, quota);
+    int want = limit - 1;
+    int free = free_workers_.load();
+    while (want > 0 && !free_workers_.compare_exchange_weak(free, free - std::min(want, free))) {
+    }
+    return std::max(std::min(want, free), 0);
+  }
+
+  void FinishLaunch(int granted) {
+    free_workers_.fetch_add(granted);
+    num_active_launches_.fetch_sub(1);
+  }
+
+  // Pop from the local deque first, then try to steal from the others.
+  bool TryPop(int worker_id, Task* task) {
+    if (num_queued_.load(std::memory_order_acquire) == 0) return false;
+    bool found = deques_[worker_id]->PopBack(task);
+    for (int i = 1; !found && i < num_workers_; ++i) {
+      found = deques_[(worker_id + i) % num_workers_]->StealFront(task);
+    }
+    if (found) num_queued_.fetch_sub(1);
+    return found;
+  }
+
+  // Pop a task of the given launch from any deque.
+  bool TryPopOf(const ParallelLauncher* launcher, Task* task) {
+    if (num_queued_.load(std::memory_order_acquire) == 0) return false;
+    for (int i = 0; i < num_workers_; ++i) {
+      if (deques_[i]->TakeOf(launcher, task)) {
+        num_queued_.fetch_sub(1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void NotifyPush(int num_task) {
+    wake_begin_ns_.store(NowNanoseconds(), std::memory_order_relaxed);
+    num_queued_.fetch_add(num_task);
+    if (num_sleeping_.load() != 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_all();
+    }
+  }
+
+  void RunTask(const Task& task) {
+    ParallelLauncher* launcher = task.launcher;
+    // The launcher may be reused as soon as its last task signals, read it before.
+    int32_t num_task = launcher->env.num_task;
+    for (int32_t i = task.task_id; i < num_task; i += task.stride) {
+      if ((*launcher->flambda)(i, &(launcher->env), launcher->cdata) == 0) {
+        launcher->SignalJobFinish();
+      } else {
+        launcher->SignalJobError(i);
+      }
+    }
+  }
+
+  // Internal worker function.
+  void RunWorker(int worker_id) {
+    WorkerContext* ctx = WorkerContext::ThreadLocal();
+    ctx->pool = this;
+    ctx->worker_id = worker_id;
+    Task task;
+    while (!exit_now_.load(std::memory_order_relaxed)) {
+      if (TryPop(worker_id, &task)) {
+        RunTask(task);
+        continue;
+      }
+      // Busy wait a bit before sleeping, new jobs usually arrive quickly.
+      for (uint32_t i = 0; i < spin_count_ && num_queued_.load() == 0 && !exit_now_.load(); ++i) {
+        tvm::runtime::threading::Yield();
+      }
+      if (num_queued_.load() == 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        num_sleeping_.fetch_add(1);
+        cv_.wait(lock, [this] { return num_queued_.load() != 0 || exit_now_.load(); });
+        num_sleeping_.fetch_sub(1);
+        stats_.parks.fetch_add(1, std::memory_order_relaxed);
+        stats_.wake_latency_ns.fetch_add(
+            std::max<int64_t>(NowNanoseconds() - wake_begin_ns_.load(std::memory_order_relaxed),
+                              0),
+            std::memory_order_relaxed);
+      } else {
+        stats_.spin_hits.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  int num_workers_;
+  // number of workers used (can be restricted with affinity pref)
+  int num_workers_used_;
+  // number of chunks per worker when the runtime picks the number of tasks
+  int chunk_factor_;
+  // number of iterations to spin before sleep
+  uint32_t spin_count_;
+  // whether the pool is shared by all application threads
+  bool shared_;
+  // number of workers not reserved by an admitted launch in shared mode
+  std::atomic<int> free_workers_{0};
+  // number of admitted top-level launches in shared mode
+  std::atomic<int> num_active_launches_{0};
+  std::vector<std::unique_ptr<TaskDeque>> deques_;
+  // total number of tasks sitting in the deques
+  std::atomic<int> num_queued_{0};
+  // time of the last push, the start of the wake latency of the parked workers
+  std::atomic<int64_t> wake_begin_ns_{0};
+  // wake-up statistics of the workers
+  struct {
+    std::atomic<uint64_t> spin_hits{0};
+    std::atomic<uint64_t> parks{0};
+    std::atomic<uint64_t> wake_latency_ns{0};
+  } stats_;
+  // number of workers waiting on cv_
+  std::atomic<int> num_sleeping_{0};
+  // signal for exit now
+  std::atomic<bool> exit_now_{false};
+  // internal mutex
+  std::mutex mutex_;
+  // cv for idle workers
+  std::condition_variable cv_;
+  std::unique_ptr<tvm::runtime::threading::ThreadGroup> threads_;
+};
+
 TVM_REGISTER_GLOBAL("runtime.config_threadpool").set_body([](TVMArgs args, TVMRetValue* rv) {
   threading::ThreadGroup::AffinityMode mode =
       static_cast<threading::ThreadGroup::AffinityMode>(static_cast<int>(args[0]));
   int nthreads = args[1];
-  ThreadPool::ThreadLocal()->UpdateWorkerConfiguration(mode, nthreads);
+  // The optional first core confines the pool of the calling thread to a range of cores.
+  int first_core = -1;
+  if (args.size() > 2) first_core = args[2];
+  switch (static_cast<ThreadPoolKind>(GlobalThreadPoolKind()->load())) {
+    case ThreadPoolKind::kWorkStealing:
+      WorkStealingThreadPool::ThreadLocal()->UpdateWorkerConfiguration(mode, nthreads, first_core);
+      break;
+    case ThreadPoolKind::kShared:
+      WorkStealingThreadPool::Global()->UpdateWorkerConfiguration(mode, nthreads, first_core);
+      break;
+    default:
+      ThreadPool::ThreadLocal()->UpdateWorkerConfiguration(mode, nthreads, first_core);
+  }
+});
+
+TVM_REGISTER_GLOBAL("runtime.thread_pool_stats").set_body_typed([](bool reset) {
+  // Report on the pool that serves the launches of the calling thread.
+  WakeStats stats;
+  switch (static_cast<ThreadPoolKind>(GlobalThreadPoolKind()->load())) {
+    case ThreadPoolKind::kWorkStealing:
+      stats = WorkStealingThreadPool::ThreadLocal()->GetStats(reset);
+      break;
+    case ThreadPoolKind::kShared:
+      stats = WorkStealingThreadPool::Global()->GetStats(reset);
+      break;
+    default:
+      stats = ThreadPool::ThreadLocal()->GetStats(reset);
+  }
+  double avg_wake_us = stats.parks == 0 ? 0.0 : stats.wake_latency_ns / 1e3 / stats.parks;
+  std::ostringstream os;
+  os << "{\"spin_hits\": " << stats.spin_hits << ", \"parks\": " << stats.parks
+     << ", \"avg_wake_latency_us\": " << avg_wake_us << "}";
+  return os.str();
+});
+
+namespace threading {
+
+void ResetThreadPoolAfterFork() {
+  // Joining the pools would wait for workers that were not forked, leak them instead.
+  ThreadPool::LocalSlot().release();
+  WorkStealingThreadPool::ResetAfterFork();
+}
+
+}  // namespace threading
+
+TVM_REGISTER_GLOBAL("runtime.config_threadpool_kind").set_body_typed([](std::string kind) {
+  GlobalThreadPoolKind()->store(static_cast<int>(ParseThreadPoolKind(kind)));
 });
 
 }  // namespace runtime
@@ -364,6 +1005,18 @@ TVM_REGISTER_GLOBAL("runtime.config_threadpool").set_body([](TVMArgs args, TVMRe
 
 int TVMBackendParallelLaunch(FTVMParallelLambda flambda, void* cdata, int num_task) {
 #if !TVM_THREADPOOL_USE_OPENMP
+  using tvm::runtime::ThreadPoolKind;
+  using tvm::runtime::WorkStealingThreadPool;
+  switch (static_cast<ThreadPoolKind>(
+      tvm::runtime::GlobalThreadPoolKind()->load(std::memory_order_relaxed))) {
+    case ThreadPoolKind::kWorkStealing:
+      return WorkStealingThreadPool::ThreadLocal()->Launch(flambda, cdata, num_task, 1);
+    case ThreadPoolKind::kShared:
+      // workers of the shared pool resolve to it through their thread local context
+      return WorkStealingThreadPool::Global()->Launch(flambda, cdata, num_task, 1);
+    default:
+      break;
+  }
   int res = tvm::runtime::ThreadPool::ThreadLocal()->Launch(flambda, cdata, num_task, 1);
   return res;
 #else
@@ -387,6 +1040,9 @@ int TVMBackendParallelBarrier(int task_id, TVMParallelGroupEnv* penv) {
   using tvm::runtime::kSyncStride;
   int num_task = penv->num_task;
   std::atomic<int>* sync_counter = reinterpret_cast<std::atomic<int>*>(penv->sync_handle);
+  ICHECK(sync_counter != nullptr)
+      << "TVMBackendParallelBarrier is not supported in nested or chunked work-stealing "
+      << "launches, unset TVM_THREAD_POOL_CHUNK_FACTOR to disable chunking";
   int old_counter = sync_counter[task_id * kSyncStride].fetch_add(1, std::memory_order_release);
   for (int i = 0; i < num_task; ++i) {
     if (i != task_id) {
@@ -25,13 +25,16 @@
 #include <tvm/support/logging.h>
 
 #include <algorithm>
+#include <string>
 #include <thread>
+#include <vector>
 #if defined(__linux__) || defined(__ANDROID__)
 #include <fstream>
 #include <sstream>
 #else
 #endif
 #if defined(__linux__)
+#include <dirent.h>
 #include <sched.h>
 #endif
 #if defined(__hexagon__)
@@ -42,6 +45,74 @@ namespace tvm {
 namespace runtime {
 namespace threading {
 
+/*! \brief The NUMA topology of the system, read from sysfs on Linux. */
+struct NumaTopology {
+  /*! \brief The CPU ids of each node. */
+  std::vector<std::vector<unsigned int>> node_cpus;
+  /*! \brief The node of each CPU id. */
+  std::vector<int> cpu_node;
+
+  static const NumaTopology& Global() {
+    static NumaTopology inst = Init();
+    return inst;
+  }
+
+ private:
+  static NumaTopology Init() {
+    NumaTopology topo;
+#if defined(__linux__)
+    // The node ids may have gaps, e.g. with offline nodes, list the directory.
+    std::vector<int> node_ids;
+    if (DIR* dir = opendir("/sys/devices/system/node")) {
+      while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+            name.find_first_not_of("0123456789", 4) == std::string::npos) {
+          node_ids.push_back(std::stoi(name.substr(4)));
+        }
+      }
+      closedir(dir);
+    }
+    std::sort(node_ids.begin(), node_ids.end());
+    for (int node : node_ids) {
+      std::ostringstream filepath;
+      filepath << "/sys/devices/system/node/node" << node << "/cpulist";
+      std::ifstream ifs(filepath.str());
+      if (ifs.fail()) continue;
+      std::string cpulist;
+      std::getline(ifs, cpulist);
+      std::vector<unsigned int> cpus = ParseCPUList(cpulist);
+      // Memory-only nodes have no CPU to run workers on.
+      if (!cpus.empty()) topo.node_cpus.push_back(std::move(cpus));
+    }
+    for (size_t node = 0; node < topo.node_cpus.size(); ++node) {
+      for (unsigned int cpu : topo.node_cpus[node]) {
+        if (cpu >= topo.cpu_node.size()) topo.cpu_node.resize(cpu + 1, 0);
+        topo.cpu_node[cpu] = static_cast<int>(node);
+      }
+    }
+#endif
+    return topo;
+  }
+
+  // Parse a cpulist such as "0-3,8-11".
+  static std::vector<unsigned int> ParseCPUList(const std::string& cpulist) {
+    std::vector<unsigned int> cpus;
+    std::istringstream is(cpulist);
+    std::string range;
+    while (std::getline(is, range, ',')) {
+      if (range.empty()) continue;
+      size_t dash = range.find('-');
+      unsigned int begin = std::stoul(range.substr(0, dash));
+      unsigned int end = dash == std::string::npos ? begin : std::stoul(range.substr(dash + 1));
+      for (unsigned int cpu = begin; cpu <= end; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    }
+    return cpus;
+  }
+};
+
 class ThreadGroup::Impl {
  public:
   Impl(int num_workers, std::function<void(int)> worker_callback, bool exclude_worker0)
@@ -60,10 +131,12 @@ class ThreadGroup::Impl {
     }
   }
 
-  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0) {
+  int Configure(AffinityMode mode, int nthreads, bool exclude_worker0, int first_core) {
     int num_workers_used = 0;
     if (mode == kLittle) {
       num_workers_used = little_count_;
+    } else if (mode == kNuma) {
+      num_workers_used = threading::MaxConcurrency();
     } else if (mode == kBig) {
       num_workers_used = big_count_;
     } else {
@@ -83,7 +156,11 @@ class ThreadGroup::Impl {
     const char* val = getenv("TVM_BIND_THREADS");
     if (val == nullptr || atoi(val) == 1) {
       // Do not set affinity if there are more workers than found cores
-      if (sorted_order_.size() >= static_cast<unsigned int>(num_workers_)) {
+      if (mode == kNuma && NumNumaNodes() > 1) {
+        SetNumaAffinity(exclude_worker0, num_workers_used);
+      } else if (first_core >= 0 && !sorted_order_.empty()) {
+        SetRangeAffinity(exclude_worker0, mode == kLittle, first_core, num_workers_used);
+      } else if (sorted_order_.size() >= static_cast<unsigned int>(num_workers_)) {
         SetAffinity(exclude_worker0, mode == kLittle);
       } else {
         LOG(WARNING) << "The thread affinity cannot be set when the number of workers"
@@ -140,6 +217,71 @@ class ThreadGroup::Impl {
 #endif
   }
 
+  // bind the workers to the cores of their NUMA node,
+  // consecutive workers share a node so that a parallel job stays node local.
+  // The nodes are split among the num_workers_used workers that get tasks,
+  // the idle workers beyond them share the node of the last one.
+  void SetNumaAffinity(bool exclude_worker0, int num_workers_used) {
+#if defined(__linux__)
+    const NumaTopology& topo = NumaTopology::Global();
+    int num_nodes = static_cast<int>(topo.node_cpus.size());
+    num_workers_used = std::max(num_workers_used, 1);
+    auto fbind = [&](pthread_t thread, int worker_id) {
+      int node = std::min(worker_id, num_workers_used - 1) * num_nodes / num_workers_used;
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      for (unsigned int cpu : topo.node_cpus[node]) {
+        CPU_SET(cpu, &cpuset);
+      }
+      pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
+    };
+    for (unsigned i = 0; i < threads_.size(); ++i) {
+      fbind(threads_[i].native_handle(), i + exclude_worker0);
+    }
+    if (exclude_worker0) {
+      // main thread runs the tasks of worker 0
+      fbind(pthread_self(), 0);
+    }
+#endif
+  }
+
+  // bind the workers to the num_workers_used cores starting at first_core in the
+  // preferred order, the idle workers and the main thread share those cores,
+  // so that thread groups configured with disjoint ranges do not compete.
+  void SetRangeAffinity(bool exclude_worker0, bool reverse, int first_core,
+                        int num_workers_used) {
+#if defined(__linux__) || defined(__ANDROID__)
+    size_t num_cores = sorted_order_.size();
+    int range = std::max(num_workers_used, 1);
+    auto fcore = [&](int index) {
+      size_t k = static_cast<size_t>(first_core + index) % num_cores;
+      return reverse ? sorted_order_[num_cores - k - 1] : sorted_order_[k];
+    };
+    for (unsigned i = 0; i < threads_.size(); ++i) {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(fcore((i + exclude_worker0) % range), &cpuset);
+#if defined(__ANDROID__)
+      sched_setaffinity(threads_[i].native_handle(), sizeof(cpu_set_t), &cpuset);
+#else
+      pthread_setaffinity_np(threads_[i].native_handle(), sizeof(cpu_set_t), &cpuset);
+#endif
+    }
+    if (exclude_worker0) {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      for (int i = 0; i < range; ++i) {
+        CPU_SET(fcore(i), &cpuset);
+      }
+#if defined(__ANDROID__)
+      sched_setaffinity(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#else
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#endif
+    }
+#endif
+  }
+
   void SetMasterThreadFullCpuAffinity(bool reverse) {
 #if defined(__linux__) || defined(__ANDROID__)
     cpu_set_t cpuset;
@@ -231,8 +373,9 @@ ThreadGroup::ThreadGroup(int num_workers, std::function<void(int)> worker_callba
 ThreadGroup::~ThreadGroup() { delete impl_; }
 void ThreadGroup::Join() { impl_->Join(); }
 
-int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0) {
-  return impl_->Configure(mode, nthreads, exclude_worker0);
+int ThreadGroup::Configure(AffinityMode mode, int nthreads, bool exclude_worker0,
+                           int first_core) {
+  return impl_->Configure(mode, nthreads, exclude_worker0, first_core);
 }
 
 void Yield() { std::this_thread::yield(); }
@@ -265,6 +408,21 @@ int MaxConcurrency() {
   return std::max(max_concurrency, 1);
 }
 
+int NumNumaNodes() {
+  return std::max(static_cast<int>(NumaTopology::Global().node_cpus.size()), 1);
+}
+
+int CurrentNumaNode() {
+#if defined(__linux__)
+  const NumaTopology& topo = NumaTopology::Global();
+  int cpu = sched_getcpu();
+  if (cpu >= 0 && static_cast<size_t>(cpu) < topo.cpu_node.size()) {
+    return topo.cpu_node[cpu];
+  }
+#endif
+  return 0;
+}
+
 }  // namespace threading
 }  // namespace runtime
 }  // namespace tvm
@@ -24,19 +24,25 @@
 
 #include <dmlc/memory_io.h>
 #include <tvm/runtime/c_runtime_api.h>
+#include <tvm/runtime/device_api.h>
 #include <tvm/runtime/registry.h>
 #include <tvm/runtime/vm/executable.h>
 #include <tvm/runtime/vm/vm.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <sstream>
 #include <utility>
 #include <vector>
 
+#include "../file_utils.h"
 #include "serialize_utils.h"
 
 namespace tvm {
@@ -52,6 +58,97 @@ VMInstructionSerializer SerializeInstruction(const Instruction& instr);
 // Helper to deserialize a serialized vm instruction.
 Instruction DeserializeInstruction(const VMInstructionSerializer& instr);
 
+/*!
+ * \brief The content of an executable file with a section table, and the
+ *  location of the constants and of the code not loaded yet.
+ */
+class Executable::LazySections {
+ public:
+  /*! \brief Map the file, the constants on CPU are views of the mapping. */
+  explicit LazySections(std::shared_ptr<MappedFile> file)
+      : file_(std::move(file)), data_(file_->data()), size_(file_->size()) {}
+
+  /*! \brief Keep a copy of an in-memory file, the constants are copied from it. */
+  explicit LazySections(std::string code)
+      : code_(std::move(code)), data_(&code_[0]), size_(code_.size()) {}
+
+  /*! \brief A stream reading the bytes [offset, offset + size) of the file. */
+  dmlc::MemoryFixedSizeStream Stream(uint64_t offset, uint64_t size, const char* section) const {
+    ICHECK(offset <= size_ && size <= size_ - offset)
+        << "Invalid VM file format in the " << section << " section.";
+    return dmlc::MemoryFixedSizeStream(data_ + offset, static_cast<size_t>(size));
+  }
+
+  /*! \brief The size of the file. */
+  size_t size() const { return size_; }
+
+  /*! \brief Load a constant from the constant data section. */
+  NDArray LoadConstant(Index const_index) const {
+    const ConstantEntry& entry = constants[const_index];
+    uint64_t offset = const_data_offset + entry.offset;
+    ICHECK(offset <= size_ && entry.nbytes <= size_ - offset)
+        << "Invalid VM file format in the constant section.";
+    int64_t elem_bytes = (entry.dtype.bits * entry.dtype.lanes + 7) / 8;
+    NDArray ret;
+    if (file_ != nullptr && DMLC_IO_NO_ENDIAN_SWAP && offset % kAllocAlignment == 0) {
+      ret = CreateMappedFileView(file_, offset, entry.shape, entry.dtype);
+    } else {
+      ret = NDArray::Empty(entry.shape, entry.dtype, {kDLCPU, 0});
+      std::memcpy(ret->data, data_ + offset, entry.nbytes);
+      if (!DMLC_IO_NO_ENDIAN_SWAP) {
+        dmlc::ByteSwap(ret->data, elem_bytes, entry.nbytes / elem_bytes);
+      }
+    }
+    ICHECK_EQ(GetDataSize(*ret.operator->()), entry.nbytes)
+        << "Invalid VM file format in the constant section.";
+    return ret;
+  }
+
+  /*! \brief Decode the instructions of a function from the code section. */
+  std::vector<Instruction> DecodeFunction(Index func_index) const {
+    const CodeEntry& entry = code[func_index];
+    auto strm = Stream(code_offset + entry.offset, entry.size, "code");
+    std::vector<Instruction> instructions;
+    instructions.reserve(entry.num_instructions);
+    for (size_t i = 0; i < entry.num_instructions; ++i) {
+      VMInstructionSerializer instr;
+      STREAM_CHECK(instr.Load(&strm), "code/instruction");
+      instructions.push_back(DeserializeInstruction(instr));
+    }
+    return instructions;
+  }
+
+  /*! \brief The location of a constant in the constant data section. */
+  struct ConstantEntry {
+    std::vector<int64_t> shape;
+    DLDataType dtype;
+    uint64_t offset;
+    uint64_t nbytes;
+  };
+  /*! \brief The location of the instructions of a function in the code section. */
+  struct CodeEntry {
+    uint64_t offset;
+    uint64_t size;
+    size_t num_instructions;
+  };
+
+  std::vector<ConstantEntry> constants;
+  std::vector<CodeEntry> code;
+  uint64_t const_data_offset{0};
+  uint64_t code_offset{0};
+  /*! \brief Whether each constant and each function is loaded. */
+  std::unique_ptr<std::atomic<bool>[]> const_loaded;
+  std::unique_ptr<std::atomic<bool>[]> func_loaded;
+  /*! \brief Serializes the loading of the constants and functions. */
+  std::mutex mutex;
+
+ private:
+  std::shared_ptr<MappedFile> file_;
+  std::string code_;
+  char* data_;
+  size_t size_;
+};
+
 PackedFunc Executable::GetFunction(const std::string& name, const ObjectPtr<Object>& sptr_to_self) {
   if (name == "get_lib") {
     return PackedFunc(
@@ -63,6 +160,12 @@ PackedFunc Executable::GetFunction(const std::string& name, const ObjectPtr<Obje
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->Stats(); });
   } else if (name == "save") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = this->Save(); });
+  } else if (name == "save_to_file") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      std::string path = args[0];
+      int64_t alignment = args[1];
+      this->SaveToFile(path, static_cast<size_t>(alignment));
+    });
   } else if (name == "get_function_arity") {
     return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
       std::string func_name = args[0];
@@ -108,7 +211,7 @@ std::string Executable::GetBytecode() const {
   std::ostringstream oss;
 
   for (size_t i = 0; i < functions.size(); ++i) {
-    const auto& func = functions[i];
+    const auto& func = GetVMFunction(i);
     // Print the header of the function format.
     oss << "VM Function[" << i << "]: " << func.name << "(";
     for (const auto& param : func.params) {
@@ -144,8 +247,8 @@ std::string Executable::Stats() const {
 
   // Get the number of constants and the shape of each of them.
   oss << "  Constant shapes (# " << constants.size() << "): [";
-  for (const auto& it : constants) {
-    const auto constant = Downcast<NDArray>(it);
+  for (size_t i = 0; i < constants.size(); ++i) {
+    const auto constant = Downcast<NDArray>(GetConstant(i));
     const auto& shape = constant.Shape();
 
     // Scalar
@@ -241,14 +344,10 @@ void Executable::SaveGlobalSection(dmlc::Stream* strm) {
 }
 
 void Executable::SaveConstantSection(dmlc::Stream* strm) {
-  std::vector<DLTensor*> arrays;
-  for (const auto& obj : this->constants) {
-    const auto cell = Downcast<runtime::NDArray>(obj);
-    arrays.push_back(const_cast<DLTensor*>(cell.operator->()));
-  }
   strm->Write(static_cast<uint64_t>(this->constants.size()));
-  for (const auto& it : arrays) {
-    runtime::SaveDLTensor(strm, it);
+  for (size_t i = 0; i < this->constants.size(); ++i) {
+    const auto cell = Downcast<runtime::NDArray>(GetConstant(i));
+    runtime::SaveDLTensor(strm, cell.operator->());
   }
 
   // Save the const to device mapping.
@@ -453,7 +552,8 @@ VMInstructionSerializer SerializeInstruction(const Instruction& instr) {
 void Executable::SaveCodeSection(dmlc::Stream* strm) {
   // Save the number of functions.
   strm->Write(static_cast<uint64_t>(this->functions.size()));
-  for (const auto& func : this->functions) {
+  for (size_t i = 0; i < this->functions.size(); ++i) {
+    const auto& func = GetVMFunction(i);
     // Save the function info.
     VMFunctionSerializer func_format(func.name, func.register_file_size, func.instructions.size(),
                                      func.params, func.params_device_type);
@@ -480,6 +580,11 @@ void LoadHeader(dmlc::Stream* strm) {
 }
 
 runtime::Module Executable::Load(const std::string& code, const runtime::Module lib) {
+  uint64_t magic = 0;
+  if (code.size() >= sizeof(magic)) std::memcpy(&magic, code.data(), sizeof(magic));
+  if (magic == kTVMVMExecutableMagic) {
+    return LoadSections(std::make_shared<LazySections>(code), lib);
+  }
   auto exec = make_object<Executable>();
   exec->lib = lib;
   exec->code_ = code;
@@ -771,6 +876,289 @@ void Executable::LoadCodeSection(dmlc::Stream* strm) {
   }
 }
 
+ObjectRef Executable::GetConstant(Index const_index) const {
+  ICHECK_LT(static_cast<size_t>(const_index), constants.size());
+  if (lazy_ != nullptr && !lazy_->const_loaded[const_index].load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(lazy_->mutex);
+    if (!lazy_->const_loaded[const_index].load(std::memory_order_relaxed)) {
+      // The entries of a lazily loaded executable are only written here, once.
+      const_cast<Executable*>(this)->constants[const_index] = lazy_->LoadConstant(const_index);
+      lazy_->const_loaded[const_index].store(true, std::memory_order_release);
+    }
+  }
+  return constants[const_index];
+}
+
+const VMFunction& Executable::GetVMFunction(Index func_index) const {
+  ICHECK_LT(static_cast<size_t>(func_index), functions.size());
+  if (lazy_ != nullptr && !lazy_->func_loaded[func_index].load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(lazy_->mutex);
+    if (!lazy_->func_loaded[func_index].load(std::memory_order_relaxed)) {
+      const_cast<Executable*>(this)->functions[func_index].instructions =
+          lazy_->DecodeFunction(func_index);
+      lazy_->func_loaded[func_index].store(true, std::memory_order_release);
+    }
+  }
+  return functions[func_index];
+}
+
+bool Executable::IsFunctionLoaded(Index func_index) const {
+  ICHECK_LT(static_cast<size_t>(func_index), functions.size());
+  // Pairs with the release store in GetVMFunction, which publishes the instructions.
+  return lazy_ == nullptr || lazy_->func_loaded[func_index].load(std::memory_order_acquire);
+}
+
+namespace {
+size_t RoundUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// Write the header and the section table of an executable file.
+void WriteSectionTable(dmlc::Stream* strm, uint64_t alignment,
+                       const std::vector<std::pair<VMSectionKind, std::string>>& sections,
+                       const std::vector<uint64_t>& offsets) {
+  uint64_t header = kTVMVMExecutableMagic;
+  uint64_t format_version = kTVMVMExecutableFormatVersion;
+  strm->Write(header);
+  strm->Write(format_version);
+  std::string version = TVM_VERSION;
+  strm->Write(version);
+  strm->Write(alignment);
+  strm->Write(static_cast<uint64_t>(sections.size()));
+  for (size_t i = 0; i < sections.size(); ++i) {
+    strm->Write(static_cast<uint64_t>(sections[i].first));
+    strm->Write(offsets[i]);
+    strm->Write(static_cast<uint64_t>(sections[i].second.size()));
+  }
+}
+}  // namespace
+
+void Executable::SaveToFile(const std::string& path, size_t alignment) {
+  ICHECK(alignment >= kAllocAlignment && (alignment & (alignment - 1)) == 0)
+      << "The alignment must be a power of two of at least " << kAllocAlignment;
+  std::vector<std::pair<VMSectionKind, std::string>> sections;
+  auto add_section = [&sections](VMSectionKind kind) -> std::string* {
+    sections.emplace_back(kind, std::string());
+    return &sections.back().second;
+  };
+  {
+    dmlc::MemoryStringStream strm(add_section(VMSectionKind::kGlobals));
+    SaveGlobalSection(&strm);
+  }
+  {
+    dmlc::MemoryStringStream strm(add_section(VMSectionKind::kPrimitives));
+    SavePrimitiveOpNames(&strm);
+  }
+
+  // The table of the constants, and their data at aligned offsets of the data section.
+  std::string table, data;
+  {
+    dmlc::MemoryStringStream strm(&table);
+    strm.Write(static_cast<uint64_t>(constants.size()));
+    for (size_t i = 0; i < constants.size(); ++i) {
+      NDArray constant = Downcast<NDArray>(GetConstant(i));
+      const DLTensor* t = constant.operator->();
+      uint64_t nbytes = GetDataSize(*t);
+      uint64_t offset = RoundUp(data.size(), alignment);
+      data.resize(offset + nbytes, 0);
+      if (DMLC_IO_NO_ENDIAN_SWAP && t->ctx.device_type == kDLCPU && t->strides == nullptr) {
+        std::memcpy(&data[offset], static_cast<const char*>(t->data) + t->byte_offset, nbytes);
+      } else {
+        ICHECK_EQ(TVMArrayCopyToBytes(const_cast<DLTensor*>(t), &data[offset], nbytes), 0)
+            << TVMGetLastError();
+        if (!DMLC_IO_NO_ENDIAN_SWAP) {
+          size_t elem_bytes = (t->dtype.bits * t->dtype.lanes + 7) / 8;
+          dmlc::ByteSwap(&data[offset], elem_bytes, nbytes / elem_bytes);
+        }
+      }
+      strm.Write(t->ndim);
+      strm.Write(t->dtype);
+      strm.WriteArray(t->shape, t->ndim);
+      strm.Write(static_cast<uint64_t>(const_device_type[i]));
+      strm.Write(offset);
+      strm.Write(nbytes);
+    }
+  }
+  sections.emplace_back(VMSectionKind::kConstants, std::move(table));
+  sections.emplace_back(VMSectionKind::kConstantData, std::move(data));
+
+  // The headers of the functions, and their instructions in the code section.
+  std::string headers, code;
+  {
+    dmlc::MemoryStringStream header_strm(&headers);
+    dmlc::MemoryStringStream code_strm(&code);
+    header_strm.Write(static_cast<uint64_t>(functions.size()));
+    for (size_t i = 0; i < functions.size(); ++i) {
+      const auto& func = GetVMFunction(i);
+      VMFunctionSerializer func_format(func.name, func.register_file_size,
+                                       func.instructions.size(), func.params,
+                                       func.params_device_type);
+      func_format.Save(&header_strm);
+      uint64_t offset = code.size();
+      for (const auto& instr : func.instructions) {
+        SerializeInstruction(instr).Save(&code_strm);
+      }
+      header_strm.Write(offset);
+      header_strm.Write(static_cast<uint64_t>(code.size() - offset));
+    }
+  }
+  sections.emplace_back(VMSectionKind::kFunctions, std::move(headers));
+  sections.emplace_back(VMSectionKind::kCode, std::move(code));
+
+  // The table has a fixed size, measure it to place the sections after it.
+  std::vector<uint64_t> offsets(sections.size(), 0);
+  std::string header;
+  {
+    dmlc::MemoryStringStream strm(&header);
+    WriteSectionTable(&strm, alignment, sections, offsets);
+  }
+  size_t offset = RoundUp(header.size(), alignment);
+  for (size_t i = 0; i < sections.size(); ++i) {
+    offsets[i] = offset;
+    offset = RoundUp(offset + sections[i].second.size(), alignment);
+  }
+  header.clear();
+  {
+    dmlc::MemoryStringStream strm(&header);
+    WriteSectionTable(&strm, alignment, sections, offsets);
+  }
+
+  std::ofstream fs(path, std::ios::out | std::ios::binary);
+  ICHECK(!fs.fail()) << "Cannot open " << path;
+  fs.write(header.data(), header.size());
+  size_t pos = header.size();
+  std::string padding;
+  for (size_t i = 0; i < sections.size(); ++i) {
+    padding.assign(offsets[i] - pos, 0);
+    fs.write(padding.data(), padding.size());
+    fs.write(sections[i].second.data(), sections[i].second.size());
+    pos = offsets[i] + sections[i].second.size();
+  }
+  ICHECK(!fs.fail()) << "Cannot write " << path;
+}
+
+runtime::Module Executable::LoadFromFile(const std::string& path, const runtime::Module lib) {
+  return LoadSections(std::make_shared<LazySections>(std::make_shared<MappedFile>(path)), lib);
+}
+
+runtime::Module Executable::LoadSections(std::shared_ptr<LazySections> sections,
+                                         const runtime::Module lib) {
+  auto exec = make_object<Executable>();
+  exec->lib = lib;
+  exec->lazy_ = sections;
+
+  auto strm = sections->Stream(0, sections->size(), "header");
+  uint64_t header, format_version, alignment, num_sections;
+  STREAM_CHECK(strm.Read(&header), "header");
+  STREAM_CHECK(header == kTVMVMExecutableMagic, "header");
+  STREAM_CHECK(strm.Read(&format_version), "header");
+  ICHECK_LE(format_version, kTVMVMExecutableFormatVersion)
+      << "The VM file format version " << format_version << " is newer than the supported "
+      << kTVMVMExecutableFormatVersion;
+  std::string version;
+  STREAM_CHECK(strm.Read(&version), "version");
+  STREAM_CHECK(version == TVM_VERSION, "version");
+  STREAM_CHECK(strm.Read(&alignment), "header");
+  STREAM_CHECK(strm.Read(&num_sections), "header");
+  // Bound the counts read from the file by the bytes left, before allocating anything.
+  auto remaining = [](dmlc::MemoryFixedSizeStream& strm, uint64_t size) {
+    return size - std::min<uint64_t>(strm.Tell(), size);
+  };
+  STREAM_CHECK(num_sections <= remaining(strm, sections->size()) / (3 * sizeof(uint64_t)),
+               "header");
+  std::vector<uint64_t> table(num_sections * 3);
+  if (num_sections != 0) {
+    STREAM_CHECK(strm.ReadArray(table.data(), table.size()), "header");
+  }
+
+  for (uint64_t i = 0; i < num_sections; ++i) {
+    uint64_t kind = table[i * 3], offset = table[i * 3 + 1], size = table[i * 3 + 2];
+    STREAM_CHECK(offset <= sections->size() && size <= sections->size() - offset, "header");
+    switch (static_cast<VMSectionKind>(kind)) {
+      case VMSectionKind::kGlobals: {
+        auto section = sections->Stream(offset, size, "global");
+        exec->LoadGlobalSection(&section);
+        break;
+      }
+      case VMSectionKind::kPrimitives: {
+        auto section = sections->Stream(offset, size, "primitive name");
+        exec->LoadPrimitiveOpNames(&section);
+        break;
+      }
+      case VMSectionKind::kConstants: {
+        auto section = sections->Stream(offset, size, "constant");
+        uint64_t num_constants;
+        STREAM_CHECK(section.Read(&num_constants), "constant");
+        for (uint64_t c = 0; c < num_constants; ++c) {
+          LazySections::ConstantEntry entry;
+          int ndim;
+          uint64_t device_type;
+          STREAM_CHECK(section.Read(&ndim), "constant");
+          STREAM_CHECK(section.Read(&entry.dtype), "constant");
+          STREAM_CHECK(ndim >= 0 && static_cast<uint64_t>(ndim) <=
+                                        remaining(section, size) / sizeof(int64_t),
+                       "constant");
+          entry.shape.resize(ndim);
+          if (ndim != 0) {
+            STREAM_CHECK(section.ReadArray(entry.shape.data(), ndim), "constant");
+          }
+          STREAM_CHECK(section.Read(&device_type), "constant");
+          STREAM_CHECK(section.Read(&entry.offset), "constant");
+          STREAM_CHECK(section.Read(&entry.nbytes), "constant");
+          sections->constants.push_back(std::move(entry));
+          exec->const_device_type.push_back(static_cast<Index>(device_type));
+        }
+        exec->constants.resize(num_constants);
+        break;
+      }
+      case VMSectionKind::kConstantData: {
+        sections->const_data_offset = offset;
+        break;
+      }
+      case VMSectionKind::kFunctions: {
+        auto section = sections->Stream(offset, size, "code");
+        uint64_t num_funcs;
+        STREAM_CHECK(section.Read(&num_funcs), "code");
+        // Each function is followed by at least the offset and size of its code.
+        STREAM_CHECK(num_funcs <= remaining(section, size) / (2 * sizeof(uint64_t)), "code");
+        exec->functions.resize(num_funcs);
+        sections->code.resize(num_funcs);
+        for (uint64_t f = 0; f < num_funcs; ++f) {
+          VMFunctionSerializer loaded_func;
+          LazySections::CodeEntry entry;
+          STREAM_CHECK(loaded_func.Load(&section), "code/function");
+          STREAM_CHECK(section.Read(&entry.offset), "code/function");
+          STREAM_CHECK(section.Read(&entry.size), "code/function");
+          entry.num_instructions = loaded_func.num_instructions;
+          // Each instruction takes at least its opcode.
+          STREAM_CHECK(entry.num_instructions <= entry.size / sizeof(Index), "code/function");
+          // The instructions are decoded when the function is first invoked.
+          auto it = exec->global_map.find(loaded_func.name);
+          ICHECK(it != exec->global_map.end());
+          ICHECK_LT(it->second, num_funcs);
+          exec->functions[it->second] =
+              VMFunction(loaded_func.name, loaded_func.params, {}, loaded_func.register_file_size,
+                         loaded_func.params_device_type);
+          sections->code[it->second] = entry;
+        }
+        break;
+      }
+      case VMSectionKind::kCode: {
+        sections->code_offset = offset;
+        break;
+      }
+      default:
+        // A section of a newer writer this loader does not need.
+        break;
+    }
+  }
+  sections->const_loaded.reset(new std::atomic<bool>[exec->constants.size()]);
+  for (size_t i = 0; i < exec->constants.size(); ++i) sections->const_loaded[i] = false;
+  sections->func_loaded.reset(new std::atomic<bool>[exec->functions.size()]);
+  for (size_t i = 0; i < exec->functions.size(); ++i) sections->func_loaded[i] = false;
+  return runtime::Module(exec);
+}
+
 TVM_REGISTER_GLOBAL("runtime.GetNumOfGlobals").set_body([](TVMArgs args, TVMRetValue* rv) {
   runtime::Module mod = args[0];
   const auto* exec = dynamic_cast<Executable*>(mod.operator->());
@@ -821,6 +1209,11 @@ TVM_REGISTER_GLOBAL("runtime.Load_Executable")
       return Executable::Load(code, lib);
     });
 
+TVM_REGISTER_GLOBAL("runtime.Load_ExecutableFromFile")
+    .set_body_typed([](std::string path, runtime::Module lib) {
+      return Executable::LoadFromFile(path, lib);
+    });
+
 }  // namespace vm
 }  // namespace runtime
 }  // namespace tvm
@@ -21,6 +21,7 @@
  * \file tvm/runtime/vm/memory_manager.cc
  * \brief Allocate and manage memory for the runtime.
  */
+#include <tvm/runtime/registry.h>
 #include <tvm/runtime/vm/memory_manager.h>
 
 #include <memory>
@@ -174,6 +175,23 @@ NDArray Allocator::Empty(std::vector<int64_t> shape, DLDataType dtype, DLContext
   return NDArray(GetObjectPtr<Object>(container));
 }
 
+TVM_REGISTER_GLOBAL("runtime.GetPooledAllocatorStats").set_body_typed([](TVMContext ctx) {
+  auto* alloc = MemoryManager::GetAllocator(ctx);
+  ICHECK_EQ(alloc->type(), kPooled) << "The allocator of " << DeviceName(ctx.device_type) << "("
+                                    << ctx.device_id << ") is not a pooled allocator";
+  return static_cast<PooledAllocator*>(alloc)->Stats();
+});
+
+TVM_REGISTER_GLOBAL("runtime.SetPooledAllocatorHighWater")
+    .set_body_typed([](TVMContext ctx, int64_t max_cached_bytes) {
+      auto* alloc = MemoryManager::GetOrCreateAllocator(ctx, kPooled);
+      ICHECK_EQ(alloc->type(), kPooled)
+          << "The allocator of " << DeviceName(ctx.device_type) << "(" << ctx.device_id
+          << ") is not a pooled allocator";
+      ICHECK_GE(max_cached_bytes, 0);
+      static_cast<PooledAllocator*>(alloc)->SetHighWater(static_cast<size_t>(max_cached_bytes));
+    });
+
 }  // namespace vm
 }  // namespace runtime
 }  // namespace tvm
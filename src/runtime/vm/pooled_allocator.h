@@ -26,8 +26,15 @@
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/vm/memory_manager.h>
 
+#include <algorithm>
 #include <atomic>
+#include <limits>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <iterator>
+#include <sstream>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -35,65 +42,364 @@ namespace tvm {
 namespace runtime {
 namespace vm {
 
+/*!
+ * \brief Caching allocator with size classes and per-thread caches.
+ *
+ *  Requests are rounded up to a size class; classes are page multiples up to
+ *  four pages and then four classes per power of two, so the rounding wastes
+ *  at most a quarter of a request. A freed buffer can serve any request of
+ *  its class, and a request that finds its class empty takes the smallest
+ *  cached buffer of a larger class up to twice its size.
+ *
+ *  Small buffers are first cached per thread, behind a lock that only the
+ *  owning thread takes except while the pool flushes the thread caches or
+ *  reads their statistics. The thread caches count their bytes and hits
+ *  themselves, the shared counters are only touched when a request spills to
+ *  the shared pool. The cached memory of the shared pool is released back to
+ *  the device, largest buffers first, once it grows beyond the high-water
+ *  mark. Setting the high-water mark flushes the thread caches first, so it
+ *  reaches every cached buffer, and destroying the allocator detaches them.
+ */
 class PooledAllocator final : public Allocator {
  public:
   static constexpr size_t kDefaultPageSize = 4096;
+  /*! \brief Buffers up to this size go through the thread caches. */
+  static constexpr size_t kThreadCacheMaxSize = 256 << 10;
+  /*! \brief Maximum number of bytes cached by a thread. */
+  static constexpr size_t kThreadCacheMaxBytes = 4 << 20;
+  /*! \brief A request may reuse a cached buffer up to this many times its size. */
+  static constexpr size_t kMaxReuseRatio = 2;
 
   explicit PooledAllocator(TVMContext ctx, size_t page_size = kDefaultPageSize)
-      : Allocator(kPooled), page_size_(page_size), used_memory_(0), ctx_(ctx) {}
+      : Allocator(kPooled), pool_(ctx, page_size) {}
 
-  ~PooledAllocator() { ReleaseAll(); }
+  ~PooledAllocator() {
+    pool_.DetachThreadCaches();
+    pool_.ReleaseAll();
+  }
 
   Buffer Alloc(size_t nbytes, size_t alignment, DLDataType type_hint) override {
-    std::lock_guard<std::mutex> lock(mu_);
-    size_t size = ((nbytes + page_size_ - 1) / page_size_) * page_size_;
-    auto&& it = memory_pool_.find(size);
-    if (it != memory_pool_.end() && !it->second.empty()) {
-      auto&& pool = it->second;
-      auto ret = pool.back();
-      pool.pop_back();
-      return ret;
-    }
+    size_t size = pool_.SizeClass(nbytes);
     Buffer buf;
-    buf.ctx = ctx_;
+    if (size <= kThreadCacheMaxSize) {
+      if (GetThreadCache()->Pop(size, &buf)) return buf;
+    } else {
+      pool_.num_allocs.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (pool_.Pop(size, &buf)) {
+      pool_.num_pool_hits.fetch_add(1, std::memory_order_relaxed);
+      return buf;
+    }
+    buf.ctx = pool_.ctx;
     buf.size = size;
-    buf.data = DeviceAPI::Get(ctx_)->AllocDataSpace(ctx_, size, alignment, type_hint);
-    used_memory_.fetch_add(size, std::memory_order_relaxed);
-    DLOG(INFO) << "allocate " << size << " B, used memory " << used_memory_ << " B";
+    buf.data = DeviceAPI::Get(pool_.ctx)->AllocDataSpace(pool_.ctx, size, alignment, type_hint);
+    pool_.used_memory.fetch_add(size, std::memory_order_relaxed);
+    DLOG(INFO) << "allocate " << size << " B, used memory " << pool_.used_memory << " B";
     return buf;
   }
 
   void Free(const Buffer& buffer) override {
-    std::lock_guard<std::mutex> lock(mu_);
-    if (memory_pool_.find(buffer.size) == memory_pool_.end()) {
-      memory_pool_.emplace(buffer.size, std::vector<Buffer>{});
-    }
-    memory_pool_.at(buffer.size).push_back(buffer);
+    if (buffer.size <= kThreadCacheMaxSize && GetThreadCache()->Push(buffer)) return;
+    pool_.Push(buffer);
     DLOG(INFO) << "reclaim buffer " << buffer.size;
   }
 
-  size_t UsedMemory() const override { return used_memory_.load(std::memory_order_relaxed); }
+  size_t UsedMemory() const override { return pool_.used_memory.load(std::memory_order_relaxed); }
+
+  /*!
+   * \brief Set the high-water mark of the cached memory of the shared pool.
+   * \param max_cached_bytes The maximum number of cached bytes.
+   */
+  void SetHighWater(size_t max_cached_bytes) {
+    pool_.max_cached_bytes.store(max_cached_bytes);
+    pool_.FlushThreadCaches();
+    pool_.Trim();
+  }
+
+  /*! \return The allocator statistics as a JSON string. */
+  std::string Stats() {
+    ThreadCacheStats thread_stats = pool_.GetThreadCacheStats();
+    size_t used = pool_.used_memory.load();
+    size_t cached = pool_.cached_bytes.load() + thread_stats.bytes;
+    size_t num_allocs = pool_.num_allocs.load() + thread_stats.num_allocs;
+    size_t num_thread_cache_hits = pool_.num_thread_cache_hits.load() + thread_stats.num_hits;
+    size_t num_hits = pool_.num_pool_hits.load() + num_thread_cache_hits;
+    std::ostringstream os;
+    os << "{\"used_memory\": " << used << ", \"cached_bytes\": " << cached
+       << ", \"fragmentation\": " << (used == 0 ? 0.0 : static_cast<double>(cached) / used)
+       << ", \"num_allocs\": " << num_allocs
+       << ", \"hit_rate\": " << (num_allocs == 0 ? 0.0 : static_cast<double>(num_hits) / num_allocs)
+       << ", \"thread_cache_hits\": " << num_thread_cache_hits
+       << ", \"trimmed_bytes\": " << pool_.trimmed_bytes.load() << "}";
+    return os.str();
+  }
 
  private:
-  void ReleaseAll() {
-    std::lock_guard<std::mutex> lock(mu_);
-    for (auto const& it : memory_pool_) {
-      auto const& pool = it.second;
-      for (auto const& buf : pool) {
-        DeviceAPI::Get(buf.ctx)->FreeDataSpace(buf.ctx, buf.data);
+  class ThreadCache;
+
+  /*! \brief The counters of the thread caches, summed when the statistics are read. */
+  struct ThreadCacheStats {
+    size_t bytes{0};
+    size_t num_allocs{0};
+    size_t num_hits{0};
+  };
+
+  /*! \brief The pool shared by all threads, it outlives every thread cache attached to it. */
+  struct Pool {
+    Pool(TVMContext ctx, size_t page_size) : ctx(ctx), page_size(page_size), id(NextId()) {}
+
+    // The ids are never reused, unlike the addresses of destroyed pools.
+    static uint64_t NextId() {
+      static std::atomic<uint64_t> next_id{0};
+      return next_id.fetch_add(1);
+    }
+
+    size_t SizeClass(size_t nbytes) const {
+      size_t pages = std::max<size_t>((nbytes + page_size - 1) / page_size, 1);
+      if (pages > 4) {
+        size_t step = 1;
+        while ((step << 2) <= pages) step <<= 1;
+        pages = (pages + step - 1) / step * step;
       }
+      return pages * page_size;
     }
-    memory_pool_.clear();
-    used_memory_ = 0;
-    DLOG(INFO) << "release all buffers";
+
+    bool Pop(size_t size, Buffer* buf) {
+      std::lock_guard<std::mutex> lock(mu);
+      for (auto it = free_lists.lower_bound(size);
+           it != free_lists.end() && it->first <= size * kMaxReuseRatio; ++it) {
+        if (it->second.empty()) continue;
+        *buf = it->second.back();
+        it->second.pop_back();
+        cached_bytes.fetch_sub(buf->size, std::memory_order_relaxed);
+        return true;
+      }
+      return false;
+    }
+
+    void Push(const Buffer& buffer) {
+      {
+        std::lock_guard<std::mutex> lock(mu);
+        free_lists[buffer.size].push_back(buffer);
+        cached_bytes.fetch_add(buffer.size, std::memory_order_relaxed);
+      }
+      if (cached_bytes.load(std::memory_order_relaxed) > max_cached_bytes.load()) Trim();
+    }
+
+    // Release the largest cached buffers until the cache fits the high-water mark.
+    void Trim() {
+      std::lock_guard<std::mutex> lock(mu);
+      size_t limit = max_cached_bytes.load();
+      for (auto it = free_lists.rbegin(); it != free_lists.rend() && cached_bytes > limit; ++it) {
+        while (!it->second.empty() && cached_bytes > limit) {
+          Buffer buf = it->second.back();
+          it->second.pop_back();
+          DeviceAPI::Get(buf.ctx)->FreeDataSpace(buf.ctx, buf.data);
+          cached_bytes.fetch_sub(buf.size);
+          used_memory.fetch_sub(buf.size);
+          trimmed_bytes.fetch_add(buf.size);
+        }
+      }
+    }
+
+    // Release all the cached buffers, the buffers still in use stay in used_memory.
+    void ReleaseAll() {
+      FlushThreadCaches();
+      std::lock_guard<std::mutex> lock(mu);
+      for (auto const& it : free_lists) {
+        for (auto const& buf : it.second) {
+          DeviceAPI::Get(buf.ctx)->FreeDataSpace(buf.ctx, buf.data);
+          cached_bytes.fetch_sub(buf.size);
+          used_memory.fetch_sub(buf.size);
+        }
+      }
+      free_lists.clear();
+      DLOG(INFO) << "release all buffers";
+    }
+
+    // Move the buffers of all the thread caches to the shared free lists.
+    void FlushThreadCaches() {
+      std::vector<Buffer> bufs;
+      for (const auto& cache : ThreadCaches()) cache->TakeAll(&bufs);
+      std::lock_guard<std::mutex> lock(mu);
+      for (const Buffer& buf : bufs) {
+        free_lists[buf.size].push_back(buf);
+        cached_bytes.fetch_add(buf.size);
+      }
+    }
+
+    ThreadCacheStats GetThreadCacheStats() {
+      ThreadCacheStats stats;
+      for (const auto& cache : ThreadCaches()) cache->AddStats(&stats);
+      return stats;
+    }
+
+    // Return the buffers of all the thread caches and detach them, before the pool is destroyed.
+    void DetachThreadCaches() {
+      std::unordered_map<ThreadCache*, std::shared_ptr<ThreadCache>> caches;
+      {
+        std::lock_guard<std::mutex> lock(caches_mu);
+        caches.swap(thread_caches);
+      }
+      for (const auto& kv : caches) kv.second->Detach(this);
+    }
+
+    void AddThreadCache(const std::shared_ptr<ThreadCache>& cache) {
+      std::lock_guard<std::mutex> lock(caches_mu);
+      thread_caches[cache.get()] = cache;
+    }
+
+    void RemoveThreadCache(ThreadCache* cache) {
+      std::lock_guard<std::mutex> lock(caches_mu);
+      thread_caches.erase(cache);
+    }
+
+    // A snapshot of the attached thread caches. The caches are not locked while caches_mu is
+    // held, a thread cache takes caches_mu under its own lock when its thread exits.
+    std::vector<std::shared_ptr<ThreadCache>> ThreadCaches() {
+      std::lock_guard<std::mutex> lock(caches_mu);
+      std::vector<std::shared_ptr<ThreadCache>> caches;
+      for (const auto& kv : thread_caches) caches.push_back(kv.second);
+      return caches;
+    }
+
+    TVMContext ctx;
+    size_t page_size;
+    /*! \brief The key of the thread caches of the pool. */
+    uint64_t id;
+    std::mutex mu;
+    /*! \brief The cached buffers of each size class. */
+    std::map<size_t, std::vector<Buffer>> free_lists;
+    /*! \brief The attached thread caches of this pool, guarded by caches_mu. */
+    std::mutex caches_mu;
+    std::unordered_map<ThreadCache*, std::shared_ptr<ThreadCache>> thread_caches;
+    std::atomic<size_t> used_memory{0};
+    std::atomic<size_t> cached_bytes{0};
+    std::atomic<size_t> max_cached_bytes{std::numeric_limits<size_t>::max()};
+    /*! \brief The counters of the requests that bypass the thread caches or were detached. */
+    std::atomic<size_t> num_allocs{0};
+    std::atomic<size_t> num_pool_hits{0};
+    std::atomic<size_t> num_thread_cache_hits{0};
+    std::atomic<size_t> trimmed_bytes{0};
+  };
+
+  /*!
+   * \brief The small buffers cached by one thread for one allocator.
+   *  It points to its pool until the thread exits or the pool detaches it.
+   */
+  class ThreadCache {
+   public:
+    explicit ThreadCache(Pool* pool) : pool_(pool) {}
+
+    bool Pop(size_t size, Buffer* buf) {
+      std::lock_guard<std::mutex> lock(mu_);
+      ++num_allocs_;
+      auto it = bins_.find(size);
+      if (it == bins_.end() || it->second.empty()) return false;
+      *buf = it->second.back();
+      it->second.pop_back();
+      bytes_ -= buf->size;
+      ++num_hits_;
+      return true;
+    }
+
+    bool Push(const Buffer& buf) {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (bytes_ + buf.size > kThreadCacheMaxBytes) return false;
+      bins_[buf.size].push_back(buf);
+      bytes_ += buf.size;
+      return true;
+    }
+
+    /*!
+     * \brief Move all the cached buffers out of the cache.
+     * \param bufs The buffers are appended to it.
+     */
+    void TakeAll(std::vector<Buffer>* bufs) {
+      std::lock_guard<std::mutex> lock(mu_);
+      TakeAllLocked(bufs);
+    }
+
+    void AddStats(ThreadCacheStats* stats) {
+      std::lock_guard<std::mutex> lock(mu_);
+      stats->bytes += bytes_;
+      stats->num_allocs += num_allocs_;
+      stats->num_hits += num_hits_;
+    }
+
+    /*! \brief Return the buffers and the counters to the pool and stop pointing to it. */
+    void Detach(Pool* pool) {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (pool_ != pool) return;
+      DetachLocked();
+    }
+
+    /*! \brief Called when the thread exits. */
+    void Release() {
+      std::lock_guard<std::mutex> lock(mu_);
+      if (pool_ == nullptr) return;
+      // The pool waits for this lock to detach the cache, so it is alive until then.
+      pool_->RemoveThreadCache(this);
+      DetachLocked();
+    }
+
+    /*! \return Whether the pool has detached the cache. */
+    bool Detached() {
+      std::lock_guard<std::mutex> lock(mu_);
+      return pool_ == nullptr;
+    }
+
+   private:
+    void TakeAllLocked(std::vector<Buffer>* bufs) {
+      for (auto& it : bins_) {
+        bufs->insert(bufs->end(), it.second.begin(), it.second.end());
+      }
+      bins_.clear();
+      bytes_ = 0;
+    }
+
+    void DetachLocked() {
+      std::vector<Buffer> bufs;
+      TakeAllLocked(&bufs);
+      for (const Buffer& buf : bufs) pool_->Push(buf);
+      pool_->num_allocs.fetch_add(num_allocs_);
+      pool_->num_thread_cache_hits.fetch_add(num_hits_);
+      num_allocs_ = num_hits_ = 0;
+      pool_ = nullptr;
+    }
+
+    Pool* pool_;
+    // Only contended while the pool flushes, detaches or reads the cache.
+    std::mutex mu_;
+    std::unordered_map<size_t, std::vector<Buffer>> bins_;
+    size_t bytes_{0};
+    size_t num_allocs_{0};
+    size_t num_hits_{0};
+  };
+
+  /*! \brief The thread caches of a thread, released when the thread exits. */
+  struct ThreadCacheMap {
+    ~ThreadCacheMap() {
+      for (auto& kv : caches) kv.second->Release();
+    }
+    std::unordered_map<uint64_t, std::shared_ptr<ThreadCache>> caches;
+  };
+
+  ThreadCache* GetThreadCache() {
+    static thread_local ThreadCacheMap map;
+    auto it = map.caches.find(pool_.id);
+    if (it != map.caches.end()) return it->second.get();
+    // The caches of destroyed allocators are dropped when the thread meets a new allocator.
+    for (auto iter = map.caches.begin(); iter != map.caches.end();) {
+      iter = iter->second->Detached() ? map.caches.erase(iter) : std::next(iter);
+    }
+    auto cache = std::make_shared<ThreadCache>(&pool_);
+    pool_.AddThreadCache(cache);
+    map.caches[pool_.id] = cache;
+    return cache.get();
   }
 
- private:
-  size_t page_size_;
-  std::atomic<size_t> used_memory_;
-  std::unordered_map<size_t, std::vector<Buffer> > memory_pool_;
-  std::mutex mu_;
-  TVMContext ctx_;
+  Pool pool_;
 };
 
 }  // namespace vm
@@ -24,6 +24,7 @@
 
 #include "vm.h"
 
+#include <dmlc/json.h>
 #include <tvm/runtime/registry.h>
 
 #include <algorithm>
@@ -31,6 +32,7 @@
 #include <iomanip>
 #include <memory>
 #include <numeric>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -38,6 +40,58 @@
 namespace tvm {
 namespace runtime {
 namespace vm {
+namespace {
+const char* OpcodeName(Opcode op) {
+  // The names in the order of Opcode.
+  static const char* names[] = {"Move", "Ret", "Invoke", "InvokeClosure", "InvokePacked",
+                                "AllocTensor", "AllocTensorReg", "AllocADT", "AllocClosure",
+                                "GetField", "If", "LoadConst", "Goto", "GetTag", "LoadConsti",
+                                "Fatal", "AllocStorage", "ShapeOf", "ReshapeTensor", "DeviceCopy"};
+  size_t index = static_cast<size_t>(op);
+  return index < sizeof(names) / sizeof(names[0]) ? names[index] : "Unknown";
+}
+
+void AppendShape(const std::vector<int64_t>& shape, DLDataType dtype, std::ostringstream* os) {
+  if (os->tellp() > 0) *os << ", ";
+  *os << DLDataType2String(dtype) << "[";
+  for (size_t i = 0; i < shape.size(); ++i) {
+    *os << (i == 0 ? "" : ", ") << shape[i];
+  }
+  *os << "]";
+}
+
+// Append the shapes of the tensors of an object, the fields of an ADT in order.
+void AppendShapes(const ObjectRef& obj, std::ostringstream* os) {
+  if (obj.as<ADTObj>()) {
+    ADT adt = Downcast<ADT>(obj);
+    for (size_t i = 0; i < adt.size(); ++i) AppendShapes(adt[i], os);
+  } else if (const auto* array = obj.as<NDArray::ContainerType>()) {
+    const DLTensor& t = array->dl_tensor;
+    AppendShape(std::vector<int64_t>(t.shape, t.shape + t.ndim), t.dtype, os);
+  }
+}
+
+// The integers of a tensor on CPU, empty for a tensor on a device.
+std::vector<int64_t> ReadIntegers(const ObjectRef& obj) {
+  const auto* array = obj.as<NDArray::ContainerType>();
+  std::vector<int64_t> values;
+  if (array == nullptr || array->dl_tensor.ctx.device_type != kDLCPU) return values;
+  const DLTensor& t = array->dl_tensor;
+  int64_t size = 1;
+  for (int i = 0; i < t.ndim; ++i) size *= t.shape[i];
+  const char* data = static_cast<const char*>(t.data) + t.byte_offset;
+  for (int64_t i = 0; i < size; ++i) {
+    if (t.dtype.bits == 64) {
+      values.push_back(reinterpret_cast<const int64_t*>(data)[i]);
+    } else if (t.dtype.bits == 32) {
+      values.push_back(reinterpret_cast<const int32_t*>(data)[i]);
+    } else {
+      return {};
+    }
+  }
+  return values;
+}
+}  // namespace
 
 PackedFunc VirtualMachineDebug::GetFunction(const std::string& name,
                                             const ObjectPtr<Object>& sptr_to_self) {
@@ -88,6 +142,26 @@ PackedFunc VirtualMachineDebug::GetFunction(const std::string& name,
       op_durations_.clear();
       op_invokes_.clear();
     });
+  } else if (name == "start_trace") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      trace_events_.clear();
+      allocated_samples_.clear();
+      copied_samples_.clear();
+      allocated_bytes_ = 0;
+      copied_bytes_ = 0;
+      call_stack_.clear();
+      has_running_ = false;
+      trace_start_ = Clock::now();
+      trace_instructions_ = true;
+    });
+  } else if (name == "stop_trace") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { trace_instructions_ = false; });
+  } else if (name == "get_trace") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = GetTrace(); });
+  } else if (name == "get_trace_summary") {
+    return PackedFunc(
+        [sptr_to_self, this](TVMArgs args, TVMRetValue* rv) { *rv = GetTraceSummary(); });
   } else {
     return VirtualMachine::GetFunction(name, sptr_to_self);
   }
@@ -102,6 +176,13 @@ void VirtualMachineDebug::LoadExecutable(const Executable* exec) {
   }
 }
 
+void VirtualMachineDebug::SetAsyncExecution(int num_workers, int intra_op_threads) {
+  if (num_workers > 0) {
+    LOG(WARNING) << "The profiling VM ignores the asynchronous execution, it runs synchronously";
+  }
+  VirtualMachine::SetAsyncExecution(0, 0);
+}
+
 void VirtualMachineDebug::InvokePacked(Index packed_index, const PackedFunc& func, Index arg_count,
                                        Index output_size, const std::vector<ObjectRef>& args) {
   ICHECK(exec_);
@@ -131,6 +212,226 @@ void VirtualMachineDebug::InvokePacked(Index packed_index, const PackedFunc& fun
   op_invokes_[packed_index] += 1;
 }
 
+void VirtualMachineDebug::BeginInstruction(const Instruction& instr) {
+  size_t depth = frames_.size();
+  if (call_stack_.empty() && !has_running_) {
+    // The first instruction of an invocation.
+    base_depth_ = depth - 1;
+  }
+  EndInstruction(depth - base_depth_);
+  if (call_stack_.size() < depth - base_depth_) {
+    TraceEvent call;
+    call.name = CurrentFunctionName();
+    call.cat = "function";
+    call.ts = TraceTime();
+    call_stack_.push_back(std::move(call));
+  }
+  // The event is described before it starts, to leave the bookkeeping out of its duration.
+  running_ = DescribeInstruction(instr);
+  running_.args["function"] = call_stack_.back().name;
+  running_.args["pc"] = std::to_string(pc_);
+  running_sync_ctx_ = {kDLCPU, 0};
+  if (instr.op == Opcode::DeviceCopy) {
+    running_sync_ctx_ = GetContext(instr.dst_device_type);
+  }
+  has_running_ = true;
+  running_.ts = TraceTime();
+}
+
+void VirtualMachineDebug::EndRunLoop() { EndInstruction(0); }
+
+void VirtualMachineDebug::EndInstruction(size_t depth) {
+  if (has_running_) {
+    if (running_sync_ctx_.device_type != kDLCPU) {
+      TVMSynchronize(running_sync_ctx_.device_type, running_sync_ctx_.device_id, nullptr);
+    }
+    running_.dur = TraceTime() - running_.ts;
+    trace_events_.push_back(std::move(running_));
+    has_running_ = false;
+  }
+  while (call_stack_.size() > depth) {
+    TraceEvent call = std::move(call_stack_.back());
+    call_stack_.pop_back();
+    call.dur = TraceTime() - call.ts;
+    trace_events_.push_back(std::move(call));
+  }
+}
+
+VirtualMachineDebug::TraceEvent VirtualMachineDebug::DescribeInstruction(const Instruction& instr) {
+  TraceEvent event;
+  event.name = OpcodeName(instr.op);
+  event.cat = "interpreter";
+  const std::vector<ObjectRef>& regs = frames_.back().register_file;
+  std::ostringstream shapes;
+  switch (instr.op) {
+    case Opcode::InvokePacked: {
+      event.name = packed_index_map_[instr.packed_index];
+      event.cat = event.name.find("shape_func") != std::string::npos ? "shape_func" : "kernel";
+      for (Index i = 0; i < instr.arity; ++i) AppendShapes(regs[instr.packed_args[i]], &shapes);
+      event.args["shapes"] = shapes.str();
+      break;
+    }
+    case Opcode::Invoke:
+    case Opcode::InvokeClosure: {
+      event.cat = "call";
+      Index func_index = instr.func_index;
+      if (instr.op == Opcode::InvokeClosure) {
+        func_index = Downcast<VMClosure>(regs[instr.closure])->func_index;
+      }
+      event.args["callee"] = exec_->functions[func_index].name;
+      break;
+    }
+    case Opcode::AllocStorage: {
+      event.cat = "alloc";
+      // The size may still be written by a shape function running asynchronously,
+      // the VM waits for it right after anyway.
+      WaitForData(regs[instr.alloc_storage.allocation_size]);
+      std::vector<int64_t> size = ReadIntegers(regs[instr.alloc_storage.allocation_size]);
+      event.args["device_type"] = std::to_string(instr.alloc_storage.device_type);
+      if (size.size() == 1) {
+        event.args["bytes"] = std::to_string(size[0]);
+        allocated_bytes_ += size[0];
+        allocated_samples_.emplace_back(TraceTime(), allocated_bytes_);
+      }
+      break;
+    }
+    case Opcode::AllocTensor: {
+      event.cat = "alloc";
+      const auto& alloc = instr.alloc_tensor;
+      std::vector<int64_t> shape(alloc.shape, alloc.shape + alloc.ndim);
+      AppendShape(shape, alloc.dtype, &shapes);
+      event.args["shapes"] = shapes.str();
+      break;
+    }
+    case Opcode::AllocTensorReg: {
+      event.cat = "alloc";
+      const auto& alloc = instr.alloc_tensor_reg;
+      WaitForData(regs[alloc.shape_register]);
+      AppendShape(ReadIntegers(regs[alloc.shape_register]), alloc.dtype, &shapes);
+      event.args["shapes"] = shapes.str();
+      break;
+    }
+    case Opcode::DeviceCopy: {
+      event.cat = "copy";
+      AppendShapes(regs[instr.src], &shapes);
+      event.args["shapes"] = shapes.str();
+      event.args["src_device_type"] = std::to_string(instr.src_device_type);
+      event.args["dst_device_type"] = std::to_string(instr.dst_device_type);
+      if (const auto* src = regs[instr.src].as<NDArray::ContainerType>()) {
+        int64_t nbytes = GetDataSize(src->dl_tensor);
+        event.args["bytes"] = std::to_string(nbytes);
+        copied_bytes_ += nbytes;
+        copied_samples_.emplace_back(TraceTime(), copied_bytes_);
+      }
+      break;
+    }
+    case Opcode::ShapeOf:
+      AppendShapes(regs[instr.shape_of.tensor], &shapes);
+      event.args["shapes"] = shapes.str();
+      break;
+    case Opcode::ReshapeTensor:
+      AppendShapes(regs[instr.reshape_tensor.tensor], &shapes);
+      event.args["shapes"] = shapes.str();
+      break;
+    default:
+      break;
+  }
+  return event;
+}
+
+const std::string& VirtualMachineDebug::CurrentFunctionName() {
+  auto it = function_names_.find(code_);
+  if (it == function_names_.end()) {
+    std::string name = "unknown";
+    for (size_t i = 0; i < exec_->functions.size(); ++i) {
+      // The functions still being decoded cannot be the running one.
+      if (!exec_->IsFunctionLoaded(i)) continue;
+      const VMFunction& func = exec_->functions[i];
+      if (func.instructions.data() == code_) name = func.name;
+    }
+    it = function_names_.emplace(code_, name).first;
+  }
+  return it->second;
+}
+
+double VirtualMachineDebug::TraceTime() const {
+  return std::chrono::duration<double, std::micro>(Clock::now() - trace_start_).count();
+}
+
+std::string VirtualMachineDebug::GetTrace() const {
+  std::ostringstream os;
+  dmlc::JSONWriter writer(&os);
+  writer.BeginArray();
+  for (const auto& event : trace_events_) {
+    writer.WriteArraySeperator();
+    writer.BeginObject(false);
+    writer.WriteObjectKeyValue("name", event.name);
+    writer.WriteObjectKeyValue("cat", event.cat);
+    writer.WriteObjectKeyValue("ph", std::string("X"));
+    writer.WriteObjectKeyValue("ts", event.ts);
+    writer.WriteObjectKeyValue("dur", event.dur);
+    writer.WriteObjectKeyValue("pid", 0);
+    writer.WriteObjectKeyValue("tid", 0);
+    writer.WriteObjectKeyValue("args", event.args);
+    writer.EndObject();
+  }
+  // The cumulative bytes as counter events, drawn as a graph over the timeline.
+  auto write_counter = [&writer](const std::string& name,
+                                 const std::vector<std::pair<double, int64_t>>& samples) {
+    for (const auto& sample : samples) {
+      writer.WriteArraySeperator();
+      writer.BeginObject(false);
+      writer.WriteObjectKeyValue("name", name);
+      writer.WriteObjectKeyValue("ph", std::string("C"));
+      writer.WriteObjectKeyValue("ts", sample.first);
+      writer.WriteObjectKeyValue("pid", 0);
+      writer.WriteObjectKeyValue("args", std::map<std::string, int64_t>{{"bytes", sample.second}});
+      writer.EndObject();
+    }
+  };
+  write_counter("allocated", allocated_samples_);
+  write_counter("copied", copied_samples_);
+  writer.EndArray();
+  return os.str();
+}
+
+std::string VirtualMachineDebug::GetTraceSummary() const {
+  // (category, name) -> (count, total duration)
+  std::map<std::pair<std::string, std::string>, std::pair<int64_t, double>> totals;
+  std::map<std::string, double> category_totals;
+  for (const auto& event : trace_events_) {
+    if (event.cat == "function") continue;
+    auto& total = totals[{event.cat, event.name}];
+    total.first += 1;
+    total.second += event.dur;
+    category_totals[event.cat] += event.dur;
+  }
+  std::vector<std::pair<std::pair<std::string, std::string>, std::pair<int64_t, double>>> rows(
+      totals.begin(), totals.end());
+  std::sort(rows.begin(), rows.end(),
+            [](const decltype(rows)::value_type& lhs, const decltype(rows)::value_type& rhs) {
+              return lhs.second.second > rhs.second.second;
+            });
+  std::ostringstream os;
+  os << std::setw(12) << std::left << "#Category"
+     << "\t" << std::setw(30) << std::left << "#Name"
+     << "\t" << std::setw(10) << std::left << "#Count"
+     << "\t"
+     << "#Duration(us)" << std::endl;
+  for (const auto& row : rows) {
+    os << std::setw(12) << std::left << row.first.first << "\t" << std::setw(30) << std::left
+       << row.first.second << "\t" << std::setw(10) << std::left << row.second.first << "\t"
+       << row.second.second << std::endl;
+  }
+  os << std::endl;
+  for (const auto& kv : category_totals) {
+    os << "Total " << kv.first << ": " << kv.second << " us." << std::endl;
+  }
+  os << "Bytes allocated: " << allocated_bytes_ << "\tBytes copied: " << copied_bytes_
+     << std::endl;
+  return os.str();
+}
+
 runtime::Module CreateVirtualMachineDebug(const Executable* exec) {
   auto vm = make_object<VirtualMachineDebug>();
   vm->LoadExecutable(exec);
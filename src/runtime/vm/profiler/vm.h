@@ -27,9 +27,12 @@
 
 #include <tvm/runtime/vm/vm.h>
 
+#include <chrono>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace tvm {
@@ -44,15 +47,76 @@ class VirtualMachineDebug : public VirtualMachine {
 
   void LoadExecutable(const Executable* exec) final;
 
+  /*!
+   * \brief Keep the execution synchronous. The kernels are timed and their statistics updated on
+   *  the VM thread, the asynchronous workers would only let the submission be measured.
+   */
+  void SetAsyncExecution(int num_workers, int intra_op_threads) final;
+
   ~VirtualMachineDebug() {}
 
  private:
+  using Clock = std::chrono::high_resolution_clock;
+
+  /*! \brief A complete event of the Chrome trace format. */
+  struct TraceEvent {
+    std::string name;
+    /*! \brief kernel, shape_func, alloc, copy, call or interpreter. */
+    std::string cat;
+    /*! \brief The start and the duration, in microseconds since the trace started. */
+    double ts;
+    double dur;
+    std::map<std::string, std::string> args;
+  };
+
   void InvokePacked(Index packed_index, const PackedFunc& func, Index arg_count, Index output_size,
                     const std::vector<ObjectRef>& args) final;
 
+  void BeginInstruction(const Instruction& instr) final;
+
+  void EndRunLoop() final;
+
+  /*! \brief Complete the event of the running instruction and the functions returned from. */
+  void EndInstruction(size_t depth);
+
+  /*! \brief Describe an instruction from the registers of the current frame. */
+  TraceEvent DescribeInstruction(const Instruction& instr);
+
+  /*! \brief The name of the function running the current code. */
+  const std::string& CurrentFunctionName();
+
+  /*! \brief Microseconds since the trace started. */
+  double TraceTime() const;
+
+  /*! \brief The trace in the Chrome trace event format. */
+  std::string GetTrace() const;
+
+  /*! \brief The total duration and count of the trace events per category and name. */
+  std::string GetTraceSummary() const;
+
   std::unordered_map<Index, std::string> packed_index_map_;
   std::unordered_map<Index, std::vector<double>> op_durations_;
   std::unordered_map<Index, int> op_invokes_;
+
+  /*! \brief The completed events of the trace. */
+  std::vector<TraceEvent> trace_events_;
+  /*! \brief The samples of the allocated and copied byte counters, as (time, bytes). */
+  std::vector<std::pair<double, int64_t>> allocated_samples_;
+  std::vector<std::pair<double, int64_t>> copied_samples_;
+  int64_t allocated_bytes_{0};
+  int64_t copied_bytes_{0};
+  Clock::time_point trace_start_;
+  /*! \brief The event of the running instruction, if has_running_ is set. */
+  TraceEvent running_;
+  bool has_running_{false};
+  /*! \brief The context to synchronize before completing the running instruction. */
+  TVMContext running_sync_ctx_{kDLCPU, 0};
+  /*! \brief The events of the functions being called, the outermost first. */
+  std::vector<TraceEvent> call_stack_;
+  /*! \brief The number of frames below the outermost traced function. */
+  size_t base_depth_{0};
+  /*! \brief The function names by the address of their code. */
+  std::unordered_map<const Instruction*, std::string> function_names_;
 };
 
 }  // namespace vm
@@ -39,6 +39,33 @@ namespace vm {
 /*! \brief The magic number for the serialized VM bytecode file  */
 constexpr uint64_t kTVMVMBytecodeMagic = 0xD225DE2F4214151D;
 
+/*! \brief The magic number of the VM executable file with a section table. */
+constexpr uint64_t kTVMVMExecutableMagic = 0xD225DE2F4214151E;
+
+/*! \brief The version of the section table format, bumped on incompatible changes. */
+constexpr uint64_t kTVMVMExecutableFormatVersion = 1;
+
+/*!
+ * \brief The sections of the VM executable file.
+ *
+ *  A loader skips the kinds it does not know, so new sections can be added
+ *  without bumping the format version.
+ */
+enum class VMSectionKind : uint64_t {
+  /*! \brief The names of the globals, in function index order. */
+  kGlobals = 0,
+  /*! \brief The names of the primitive functions, in packed index order. */
+  kPrimitives = 1,
+  /*! \brief The shape, type, device and data location of each constant. */
+  kConstants = 2,
+  /*! \brief The data of the constants, each at an aligned offset. */
+  kConstantData = 3,
+  /*! \brief The header and the code location of each function. */
+  kFunctions = 4,
+  /*! \brief The serialized instructions of the functions. */
+  kCode = 5,
+};
+
 template <typename T>
 static inline size_t VectorHash(size_t key, const std::vector<T>& values) {
   for (const auto& it : values) {
@@ -24,19 +24,34 @@
 
 #include <dmlc/memory_io.h>
 #include <tvm/runtime/container.h>
+#include <tvm/runtime/device_api.h>
 #include <tvm/runtime/memory.h>
 #include <tvm/runtime/object.h>
+#include <tvm/runtime/threading_backend.h>
 #include <tvm/runtime/vm/vm.h>
 #include <tvm/support/logging.h>
 
 #include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 using namespace tvm::runtime;
 
+// Dispatch the instructions with computed goto where the compiler supports it.
+#if defined(__GNUC__) || defined(__clang__)
+#define TVM_VM_USE_COMPUTED_GOTO 1
+#else
+#define TVM_VM_USE_COMPUTED_GOTO 0
+#endif
+
 namespace tvm {
 namespace runtime {
 namespace vm {
@@ -111,6 +126,259 @@ std::vector<int64_t> ToShape(NDArray shape_tensor) {
   return shape;
 }
 
+/*!
+ * \brief Worker threads running the kernels and the device copies of a VM asynchronously.
+ *
+ *  The tasks touching the same buffer run in submission order: a task waits
+ *  for the last writer of the buffers it reads, and for the last writer and
+ *  the readers of the buffers it writes. The tensors allocated from a storage
+ *  are tracked as the storage, as the memory plan reuses it across tensors.
+ *  Only the VM thread submits and waits, the workers only run the tasks.
+ */
+class VirtualMachine::AsyncExecutor {
+ public:
+  AsyncExecutor(int num_workers, int intra_op_threads) {
+    for (int i = 0; i < num_workers; ++i) {
+      workers_.emplace_back(
+          [this, intra_op_threads] { this->WorkerLoop(&compute_queue_, intra_op_threads); });
+    }
+    // The copy thread is the stream of the device copies.
+    workers_.emplace_back([this] { this->WorkerLoop(&copy_queue_, 0); });
+  }
+
+  ~AsyncExecutor() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& t : workers_) t.join();
+    for (const auto& kv : streams_) {
+      DeviceAPI::Get(kv.first)->FreeStream(kv.first, kv.second);
+    }
+  }
+
+  /*! \brief Run a kernel on a worker, or inline when one of its arguments is not on CPU. */
+  void SubmitPacked(VirtualMachine* vm, Index packed_index, const PackedFunc& func,
+                    Index arg_count, Index output_size, const std::vector<ObjectRef>& args) {
+    std::vector<const Object*> reads, writes;
+    bool on_cpu = true;
+    for (Index i = 0; i < arg_count; ++i) {
+      auto* keys = i >= arg_count - output_size ? &writes : &reads;
+      ForEachArray(args[i], [&](const NDArray& array) {
+        keys->push_back(KeyOf(array));
+        on_cpu = on_cpu && array->ctx.device_type == kDLCPU;
+      });
+    }
+    if (!on_cpu) {
+      // The device kernels are ordered by the default stream of the device,
+      // only the pending work of the host is waited for.
+      for (const Object* key : reads) Wait(key, false);
+      for (const Object* key : writes) Wait(key, true);
+      vm->InvokePacked(packed_index, func, arg_count, output_size, args);
+      return;
+    }
+    std::vector<ObjectRef> task_args(args.begin(), args.begin() + arg_count);
+    const PackedFunc* pf = &func;
+    Submit(&compute_queue_, reads, writes,
+           [vm, packed_index, pf, arg_count, output_size, task_args]() {
+             vm->InvokePacked(packed_index, *pf, arg_count, output_size, task_args);
+           });
+  }
+
+  /*! \brief Allocate the destination of a device copy and copy into it on the copy thread. */
+  NDArray SubmitCopy(const NDArray& src, DLContext dst_ctx) {
+    NDArray dst = NDArray::Empty(src.Shape(), src->dtype, dst_ctx);
+    DLContext ctx = src->ctx.device_type != kDLCPU ? src->ctx : dst_ctx;
+    TVMStreamHandle stream = nullptr;
+    if (ctx.device_type == kDLGPU || ctx.device_type == kDLVulkan) {
+      TVMStreamHandle& copy_stream = streams_[ctx];
+      if (copy_stream == nullptr) copy_stream = DeviceAPI::Get(ctx)->CreateStream(ctx);
+      stream = copy_stream;
+      if (src->ctx.device_type != kDLCPU) {
+        // The copy stream waits for the kernels issued before on the default stream.
+        DeviceAPI::Get(ctx)->SyncStreamFromTo(ctx, nullptr, stream);
+      }
+    }
+    Submit(&copy_queue_, {KeyOf(src)}, {KeyOf(dst)}, [src, dst, ctx, stream]() {
+      NDArray::CopyFromTo(src.operator->(), const_cast<DLTensor*>(dst.operator->()), stream);
+      if (ctx.device_type != kDLCPU) DeviceAPI::Get(ctx)->StreamSync(ctx, stream);
+    });
+    return dst;
+  }
+
+  /*! \brief Track a tensor created from a storage or as a view as the memory it uses. */
+  void Alias(const ObjectRef& obj, const ObjectRef& base) { alias_[obj.get()] = KeyOf(base); }
+
+  /*! \brief Wait for the pending writes of the tensors in obj, before reading them on host. */
+  void WaitForData(const ObjectRef& obj) {
+    ForEachArray(obj, [this](const NDArray& array) { this->Wait(KeyOf(array), false); });
+  }
+
+  /*! \brief Wait for all the submitted tasks and rethrow the first error of the tasks. */
+  void Sync() {
+    std::exception_ptr error = Drain();
+    if (error != nullptr) std::rethrow_exception(error);
+  }
+
+  /*!
+   * \brief Wait for all the submitted tasks.
+   * \return The first error of the tasks, nullptr if none failed.
+   */
+  std::exception_ptr Drain() {
+    for (auto& done : inflight_) done.wait();
+    inflight_.clear();
+    pending_.clear();
+    alias_.clear();
+    std::exception_ptr error;
+    std::swap(error, error_);
+    failed_ = false;
+    return error;
+  }
+
+ private:
+  struct Task {
+    std::function<void()> run;
+    std::vector<std::shared_future<void>> deps;
+    std::promise<void> done;
+  };
+
+  /*! \brief The pending tasks of a buffer. */
+  struct Pending {
+    std::shared_future<void> writer;
+    std::vector<std::shared_future<void>> readers;
+  };
+
+  template <typename F>
+  static void ForEachArray(const ObjectRef& obj, F f) {
+    if (const auto* adt = obj.as<ADTObj>()) {
+      for (size_t i = 0; i < adt->size; ++i) ForEachArray((*adt)[i], f);
+    } else if (obj->IsInstance<NDArray::ContainerType>()) {
+      f(Downcast<NDArray>(obj));
+    }
+  }
+
+  const Object* KeyOf(const ObjectRef& obj) const {
+    auto it = alias_.find(obj.get());
+    return it != alias_.end() ? it->second : obj.get();
+  }
+
+  void Wait(const Object* key, bool for_write) {
+    auto it = pending_.find(key);
+    if (it == pending_.end()) return;
+    if (it->second.writer.valid()) it->second.writer.wait();
+    if (for_write) {
+      for (auto& reader : it->second.readers) reader.wait();
+    }
+  }
+
+  void Submit(std::deque<Task>* queue, const std::vector<const Object*>& reads,
+              const std::vector<const Object*>& writes, std::function<void()> run) {
+    Task task;
+    task.run = std::move(run);
+    for (const Object* key : reads) {
+      const Pending& p = pending_[key];
+      if (p.writer.valid()) task.deps.push_back(p.writer);
+    }
+    for (const Object* key : writes) {
+      const Pending& p = pending_[key];
+      if (p.writer.valid()) task.deps.push_back(p.writer);
+      task.deps.insert(task.deps.end(), p.readers.begin(), p.readers.end());
+    }
+    std::shared_future<void> done = task.done.get_future().share();
+    for (const Object* key : reads) {
+      auto& readers = pending_[key].readers;
+      // The weights are read by every iteration of a loop, forget the finished readers.
+      if (readers.size() >= kMaxReaders) {
+        readers.erase(std::remove_if(readers.begin(), readers.end(),
+                                     [](const std::shared_future<void>& f) {
+                                       return f.wait_for(std::chrono::seconds(0)) ==
+                                              std::future_status::ready;
+                                     }),
+                      readers.end());
+      }
+      readers.push_back(done);
+    }
+    for (const Object* key : writes) {
+      Pending& p = pending_[key];
+      p.writer = done;
+      p.readers.clear();
+    }
+    inflight_.push_back(done);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue->push_back(std::move(task));
+    }
+    cv_.notify_all();
+  }
+
+  void WorkerLoop(std::deque<Task>* queue, int intra_op_threads) {
+    if (intra_op_threads > 0) {
+      // The thread pool of this worker only serves the kernels it runs.
+      const PackedFunc* fconfig = Registry::Get("runtime.config_threadpool");
+      if (fconfig != nullptr) {
+        (*fconfig)(static_cast<int>(threading::ThreadGroup::kBig), intra_op_threads);
+      }
+    }
+    while (true) {
+      Task task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this, queue] { return stop_ || !queue->empty(); });
+        if (queue->empty()) return;
+        task = std::move(queue->front());
+        queue->pop_front();
+      }
+      // The queues are in submission order and a task only depends on earlier
+      // tasks, so the earliest unfinished task is always able to run.
+      for (auto& dep : task.deps) dep.wait();
+      // Once a task failed, the remaining tasks are drained without running them.
+      if (!failed_) {
+        try {
+          task.run();
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (error_ == nullptr) error_ = std::current_exception();
+          failed_ = true;
+        }
+      }
+      // Release the buffers of the task before the VM thread sees it done.
+      task.run = nullptr;
+      task.done.set_value();
+    }
+  }
+
+  static constexpr size_t kMaxReaders = 16;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_{false};
+  std::deque<Task> compute_queue_;
+  std::deque<Task> copy_queue_;
+  std::atomic<bool> failed_{false};
+  std::exception_ptr error_;
+  /*! \brief The streams of the device copies. */
+  std::unordered_map<DLContext, TVMStreamHandle> streams_;
+  /*! \brief The pending tasks of each buffer, only used by the VM thread. */
+  std::unordered_map<const Object*, Pending> pending_;
+  /*! \brief The buffer each storage tensor or view uses, only used by the VM thread. */
+  std::unordered_map<const Object*, const Object*> alias_;
+  std::vector<std::shared_future<void>> inflight_;
+  std::vector<std::thread> workers_;
+};
+
+void VirtualMachine::SetAsyncExecution(int num_workers, int intra_op_threads) {
+  ICHECK_GE(num_workers, 0) << "The number of workers must be non-negative";
+  ICHECK_GE(intra_op_threads, 0) << "The number of intra-op threads must be non-negative";
+  if (async_ != nullptr) async_->Drain();
+  async_ = nullptr;
+  if (num_workers == 0) return;
+  if (intra_op_threads == 0) {
+    intra_op_threads = std::max(1, threading::MaxConcurrency() / num_workers);
+  }
+  async_ = std::make_shared<AsyncExecutor>(num_workers, intra_op_threads);
+}
+
 PackedFunc VirtualMachine::GetFunction(const std::string& name,
                                        const ObjectPtr<Object>& sptr_to_self) {
   if (name == "invoke") {
@@ -120,7 +388,7 @@ PackedFunc VirtualMachine::GetFunction(const std::string& name,
       auto git = exec_->global_map.find(func_name);
       ICHECK(git != exec_->global_map.end())
           << "Cannot find function " << func_name << " in the executable";
-      auto func = exec_->functions[git->second];
+      const auto& func = exec_->GetVMFunction(git->second);
       if (func.params.empty()) {
         *rv = Invoke(func, {});
       } else {
@@ -152,29 +420,76 @@ PackedFunc VirtualMachine::GetFunction(const std::string& name,
       std::string func_name = args[0];
       auto gvit = exec_->global_map.find(func_name);
       ICHECK(gvit != exec_->global_map.end()) << "Cannot find function " << func_name;
-      auto func_index = gvit->second;
-      const auto& vm_func = exec_->functions[func_index];
-      const auto& param_names = vm_func.params;
-      ICHECK_EQ(args.size() - 1, param_names.size())
-          << "The number of provided parameters doesn't match the number of arguments";
-      ICHECK_EQ(param_names.size(), vm_func.params_device_type.size())
-          << "The number of provided parameters doesn't match the number of assigned devices";
-      std::vector<ObjectRef> func_args(param_names.size());
-      for (int i = 1; i < args.size(); ++i) {
-        Index device_type = vm_func.params_device_type[i - 1];
-        DLContext ctx = GetContext(device_type);
-        ObjectRef obj = CopyTo(args[i], ctx);
-        func_args[i - 1] = obj;
-      }
+      std::vector<ObjectRef> func_args = ConvertInputs(exec_->GetVMFunction(gvit->second), args, 1);
       inputs_.erase(func_name);
       inputs_.emplace(func_name, func_args);
     });
+  } else if (name == "invoke_with_args") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      ICHECK(exec_) << "The executable is not created yet.";
+      std::string func_name = args[0];
+      auto git = exec_->global_map.find(func_name);
+      ICHECK(git != exec_->global_map.end())
+          << "Cannot find function " << func_name << " in the executable";
+      const auto& func = exec_->GetVMFunction(git->second);
+      *rv = InvokeOnContext(func, ConvertInputs(func, args, 1));
+    });
+  } else if (name == "set_async_execution") {
+    return PackedFunc([sptr_to_self, this](TVMArgs args, TVMRetValue* rv) {
+      this->SetAsyncExecution(args[0], args[1]);
+    });
   } else {
     LOG(FATAL) << "Unknown packed function: " << name;
     return PackedFunc([sptr_to_self, name](TVMArgs args, TVMRetValue* rv) {});
   }
 }
 
+std::vector<ObjectRef> VirtualMachine::ConvertInputs(const VMFunction& vm_func, TVMArgs args,
+                                                    int offset) const {
+  const auto& param_names = vm_func.params;
+  ICHECK_EQ(args.size() - offset, param_names.size())
+      << "The number of provided parameters doesn't match the number of arguments";
+  ICHECK_EQ(param_names.size(), vm_func.params_device_type.size())
+      << "The number of provided parameters doesn't match the number of assigned devices";
+  std::vector<ObjectRef> func_args(param_names.size());
+  for (int i = offset; i < args.size(); ++i) {
+    Index device_type = vm_func.params_device_type[i - offset];
+    DLContext ctx = GetContext(device_type);
+    ObjectRef obj = CopyTo(args[i], ctx);
+    func_args[i - offset] = obj;
+  }
+  return func_args;
+}
+
+ObjectPtr<VirtualMachine> VirtualMachine::CreateContext() const {
+  auto vm = make_object<VirtualMachine>();
+  vm->exec_ = exec_;
+  vm->packed_funcs_ = packed_funcs_;
+  vm->ctxs_ = ctxs_;
+  vm->allocators_ = allocators_;
+  vm->const_pool_ = const_pool_;
+  return vm;
+}
+
+ObjectRef VirtualMachine::InvokeOnContext(const VMFunction& func,
+                                          const std::vector<ObjectRef>& args) {
+  ObjectPtr<VirtualMachine> context;
+  {
+    std::lock_guard<std::mutex> lock(context_mutex_);
+    if (!idle_contexts_.empty()) {
+      context = std::move(idle_contexts_.back());
+      idle_contexts_.pop_back();
+    }
+  }
+  if (context == nullptr) context = CreateContext();
+  // A context whose invocation throws is dropped with its frames.
+  ObjectRef ret = context->Invoke(func, args);
+  context->return_register_ = ObjectRef();
+  std::lock_guard<std::mutex> lock(context_mutex_);
+  idle_contexts_.push_back(std::move(context));
+  return ret;
+}
+
 inline TVMContext VirtualMachine::GetContext(Index device_type) const {
   ICHECK_GE(ctxs_.size(), device_type) << "ctxs_ list doesn't contain device:" << device_type;
 
@@ -185,8 +500,7 @@ inline TVMContext VirtualMachine::GetContext(Index device_type) const {
 }
 
 void VirtualMachine::PushFrame(Index arg_count, Index ret_pc, const VMFunction& vm_func) {
-  auto frame = VMFrame(ret_pc, func_index_, arg_count, code_, vm_func.register_file_size);
-  frames_.push_back(frame);
+  frames_.emplace_back(ret_pc, func_index_, arg_count, code_, vm_func.register_file_size);
 }
 
 Index VirtualMachine::PopFrame() {
@@ -217,7 +531,14 @@ ObjectRef VirtualMachine::Invoke(const VMFunction& func, const std::vector<Objec
   DLOG(INFO) << "Executing Function: " << std::endl << func;
 
   InvokeGlobal(func, args);
-  RunLoop();
+  try {
+    RunLoop();
+  } catch (...) {
+    if (trace_instructions_) EndRunLoop();
+    // The tasks still hold the buffers of the failed invocation.
+    if (async_ != nullptr) async_->Drain();
+    throw;
+  }
   return return_register_;
 }
 
@@ -227,7 +548,7 @@ ObjectRef VirtualMachine::Invoke(const std::string& name, const std::vector<Obje
   ICHECK(it != exec_->global_map.end()) << "Cannot find function " << name << " in the executable";
   auto func_index_ = it->second;
   DLOG(INFO) << "Invoke Global " << name << " at index " << func_index_;
-  return Invoke(exec_->functions[func_index_], args);
+  return Invoke(exec_->GetVMFunction(func_index_), args);
 }
 
 void VirtualMachine::InvokePacked(Index packed_index, const PackedFunc& func, Index arg_count,
@@ -241,43 +562,53 @@ void VirtualMachine::InvokePacked(Index packed_index, const PackedFunc& func, In
     }
   }
 
-  std::vector<TVMValue> values(arity);
-  std::vector<int> codes(arity);
-  runtime::TVMArgsSetter setter(values.data(), codes.data());
+  // The buffers only grow, so the steady state does not allocate. They are
+  // per thread, as the asynchronous workers call InvokePacked concurrently.
+  static thread_local std::vector<TVMValue> packed_values;
+  static thread_local std::vector<int> packed_codes;
+  if (packed_values.size() < arity) {
+    packed_values.resize(arity);
+    packed_codes.resize(arity);
+  }
+  TVMValue* values = packed_values.data();
+  int* codes = packed_codes.data();
+  // The registers keep the arrays alive during the call, pass the handles without copying them.
+  auto set_array = [&](int idx, const ObjectRef& obj) {
+    ICHECK(obj->IsInstance<NDArray::ContainerType>())
+        << "Expected an NDArray argument, but received: " << obj->GetTypeKey();
+    auto* container = static_cast<NDArray::Container*>(const_cast<Object*>(obj.get()));
+    values[idx].v_handle = &container->dl_tensor;
+    codes[idx] = kTVMNDArrayHandle;
+  };
   int idx = 0;
   bool is_empty_output = false;
   for (Index i = 0; i < arg_count; i++) {
     if (const auto* dt_cell = args[i].as<ADTObj>()) {
       for (size_t fi = 0; fi < dt_cell->size; ++fi) {
-        auto obj = (*dt_cell)[fi];
-        auto nd_array = Downcast<NDArray>(obj);
-        setter(idx++, nd_array);
+        set_array(idx++, (*dt_cell)[fi]);
       }
     } else {
-      auto nd_array = Downcast<NDArray>(args[i]);
+      set_array(idx, args[i]);
       // We can safely skip CallPacked if there is only one
       // output and it is empty.
       if (i == arg_count - 1 && output_size == 1) {
-        for (const auto& dim : nd_array.Shape()) {
-          if (!dim) {
-            is_empty_output = true;
-            break;
-          }
-        }
+        const DLTensor* t = static_cast<const DLTensor*>(values[idx].v_handle);
+        is_empty_output = std::find(t->shape, t->shape + t->ndim, 0) != t->shape + t->ndim;
       }
-      setter(idx++, nd_array);
+      ++idx;
     }
   }
 
   if (!is_empty_output) {
     TVMRetValue rv;
-    func.CallPacked(TVMArgs(values.data(), codes.data(), arity), &rv);
+    func.CallPacked(TVMArgs(values, codes, static_cast<int>(arity)), &rv);
   }
 }
 
 void VirtualMachine::LoadExecutable(const Executable* exec) {
   ICHECK(exec) << "The executable is not created yet.";
   exec_ = exec;
+  const_pool_ = std::make_shared<VMConstantPool>(exec_->constants.size());
 
   runtime::Module lib = exec_->lib;
   // Get the list of packed functions.
@@ -313,6 +644,26 @@ void VirtualMachine::Init(const std::vector<TVMContext>& ctxs,
     ctxs_[dev_type] = ctxs[i];
     allocators_[dev_type] = alloc;
   }
+  // The asynchronous execution is opt-in, e.g. TVM_VM_ASYNC_WORKERS=2.
+  if (const char* val = getenv("TVM_VM_ASYNC_WORKERS")) {
+    const char* intra = getenv("TVM_VM_ASYNC_INTRA_OP_THREADS");
+    this->SetAsyncExecution(std::max(0, atoi(val)), intra ? std::max(0, atoi(intra)) : 0);
+  }
+}
+
+NDArray VirtualMachine::GetScalarConst(int64_t value, DLDataType dtype) {
+  auto& cache = dtype.bits == 64 ? scalar_i64_cache_ : scalar_i32_cache_;
+  auto it = cache.find(value);
+  if (it != cache.end()) return it->second;
+  ICHECK(dtype.code == kDLInt && (dtype.bits == 32 || dtype.bits == 64));
+  NDArray tensor = NDArray::Empty({1}, dtype, {kDLCPU, 0});
+  if (dtype.bits == 64) {
+    reinterpret_cast<int64_t*>(tensor->data)[0] = value;
+  } else {
+    reinterpret_cast<int32_t*>(tensor->data)[0] = static_cast<int32_t>(value);
+  }
+  cache.emplace(value, tensor);
+  return tensor;
 }
 
 inline void VirtualMachine::WriteRegister(Index r, const ObjectRef& val) {
@@ -323,9 +674,14 @@ inline ObjectRef VirtualMachine::ReadRegister(Index r) const {
   return frames_.back().register_file[r];
 }
 
+void VirtualMachine::WaitForData(const ObjectRef& obj) const {
+  if (async_ != nullptr) async_->WaitForData(obj);
+}
+
 inline int64_t VirtualMachine::LoadScalarInt(Index r) const {
   int64_t result = 0;
   const auto& obj = ReadRegister(r);
+  if (async_ != nullptr) async_->WaitForData(obj);
   NDArray array = Downcast<NDArray>(CopyTo(obj, {kDLCPU, 0}));
 
   switch (array->dtype.bits) {
@@ -360,226 +716,277 @@ void VirtualMachine::RunLoop() {
   ICHECK(this->code_);
   pc_ = 0;
   Index frame_start = frames_.size();
+  // A call that threw in a previous invocation left its arguments behind.
+  call_args_.clear();
+  const Instruction* instr = nullptr;
+#if TVM_VM_USE_COMPUTED_GOTO
+  // The handlers in the order of Opcode, each handler jumps to the next one directly.
+  // A computed goto does not destroy the locals of the scopes it leaves, so the
+  // handlers dispatch after the end of their scope.
+  static const void* dispatch_table[] = {
+      &&op_Move, &&op_Ret, &&op_Invoke, &&op_InvokeClosure, &&op_InvokePacked, &&op_AllocTensor,
+      &&op_AllocTensorReg, &&op_AllocADT, &&op_AllocClosure, &&op_GetField, &&op_If,
+      &&op_LoadConst, &&op_Goto, &&op_GetTag, &&op_LoadConsti, &&op_Fatal, &&op_AllocStorage,
+      &&op_ShapeOf, &&op_ReshapeTensor, &&op_DeviceCopy};
+  constexpr size_t kNumOpcodes = sizeof(dispatch_table) / sizeof(dispatch_table[0]);
+  static_assert(static_cast<size_t>(Opcode::DeviceCopy) + 1 == kNumOpcodes,
+                "The dispatch table must list every opcode");
+#define TVM_VM_HANDLER(name) op_##name:
+#define TVM_VM_DISPATCH()                                             \
+  do {                                                                \
+    instr = &code_[pc_];                                              \
+    DLOG(INFO) << "Executing(" << pc_ << "): " << *instr;             \
+    if (trace_instructions_) BeginInstruction(*instr);                \
+    size_t opcode = static_cast<size_t>(instr->op);                   \
+    if (opcode >= kNumOpcodes) goto unknown_opcode;                   \
+    goto* dispatch_table[opcode];                                     \
+  } while (0)
+#else
+#define TVM_VM_HANDLER(name)
+#define TVM_VM_DISPATCH() goto main_loop
+#endif
   while (true) {
+#if !TVM_VM_USE_COMPUTED_GOTO
   main_loop:
-    auto const& instr = code_[this->pc_];
-    DLOG(INFO) << "Executing(" << pc_ << "): " << instr;
+#endif
+    instr = &code_[pc_];
+    DLOG(INFO) << "Executing(" << pc_ << "): " << *instr;
+    if (trace_instructions_) BeginInstruction(*instr);
 
-    switch (instr.op) {
-      case Opcode::Move: {
+    switch (instr->op) {
+      case Opcode::Move:
+      TVM_VM_HANDLER(Move) {
         ObjectRef from_obj;
-        from_obj = ReadRegister(instr.from);
-        WriteRegister(instr.dst, from_obj);
+        from_obj = ReadRegister(instr->from);
+        WriteRegister(instr->dst, from_obj);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::Fatal: {
+      TVM_VM_DISPATCH();
+      case Opcode::Fatal:
+      TVM_VM_HANDLER(Fatal) {
         throw std::runtime_error("VM encountered fatal error");
       }
-      case Opcode::LoadConst: {
-        auto constant_obj = exec_->constants[instr.const_index];
+      case Opcode::LoadConst:
+      TVM_VM_HANDLER(LoadConst) {
         // We cache the allocated object in the constant pool. To measure, the
         // first iteration will set the pool up. The other iterations will
         // directly reuse the allocated objects.
-        if (const_pool_.size() <= static_cast<size_t>(instr.const_index)) {
-          const_pool_.resize(instr.const_index + 1);
-        }
-
-        if (!const_pool_[instr.const_index].defined()) {
-          TVMContext ctx = GetContext(exec_->const_device_type[instr.const_index]);
-          const_pool_[instr.const_index] = CopyTo(constant_obj, ctx);
-        }
-        WriteRegister(instr.dst, const_pool_[instr.const_index]);
+        Index const_index = instr->const_index;
+        WriteRegister(instr->dst, const_pool_->Get(const_index, [this, const_index]() {
+          TVMContext ctx = GetContext(exec_->const_device_type[const_index]);
+          return CopyTo(exec_->GetConstant(const_index), ctx);
+        }));
         pc_++;
-        goto main_loop;
       }
-      case Opcode::LoadConsti: {
-        auto tensor = NDArray::Empty({1}, {kDLInt, 64, 1}, {kDLCPU, 0});
-        reinterpret_cast<int64_t*>(tensor->data)[0] = instr.load_consti.val;
-        WriteRegister(instr.dst, tensor);
+      TVM_VM_DISPATCH();
+      case Opcode::LoadConsti:
+      TVM_VM_HANDLER(LoadConsti) {
+        WriteRegister(instr->dst, GetScalarConst(instr->load_consti.val, {kDLInt, 64, 1}));
         pc_++;
-        goto main_loop;
       }
-      case Opcode::Invoke: {
-        std::vector<ObjectRef> args;
-        for (Index i = 0; i < instr.num_args; ++i) {
-          args.push_back(ReadRegister(instr.invoke_args_registers[i]));
+      TVM_VM_DISPATCH();
+      case Opcode::Invoke:
+      TVM_VM_HANDLER(Invoke) {
+        for (Index i = 0; i < instr->num_args; ++i) {
+          call_args_.push_back(ReadRegister(instr->invoke_args_registers[i]));
         }
-        InvokeGlobal(exec_->functions[instr.func_index], args);
-        frames_.back().caller_return_register = instr.dst;
-        goto main_loop;
+        InvokeGlobal(exec_->GetVMFunction(instr->func_index), call_args_);
+        call_args_.clear();
+        frames_.back().caller_return_register = instr->dst;
       }
-      case Opcode::InvokePacked: {
-        DLOG(INFO) << "InvokedPacked " << instr.packed_index << " arity=" << instr.arity;
-        ICHECK_LE(instr.packed_index, packed_funcs_.size());
-        const auto& func = packed_funcs_[instr.packed_index];
-        const auto& arity = instr.arity;
-        std::vector<ObjectRef> args;
+      TVM_VM_DISPATCH();
+      case Opcode::InvokePacked:
+      TVM_VM_HANDLER(InvokePacked) {
+        DLOG(INFO) << "InvokedPacked " << instr->packed_index << " arity=" << instr->arity;
+        ICHECK_LE(instr->packed_index, packed_funcs_.size());
+        const auto& func = packed_funcs_[instr->packed_index];
+        const auto& arity = instr->arity;
         for (Index i = 0; i < arity; ++i) {
-          DLOG(INFO) << "arg" << i << " $" << instr.packed_args[i];
-          auto arg = ReadRegister(instr.packed_args[i]);
-          args.push_back(arg);
+          DLOG(INFO) << "arg" << i << " $" << instr->packed_args[i];
+          call_args_.push_back(ReadRegister(instr->packed_args[i]));
         }
 
         // We no longer need to write the registers back, we write directly
         // through the registers mutably.
-        InvokePacked(instr.packed_index, func, arity, instr.output_size, args);
+        if (async_ != nullptr) {
+          async_->SubmitPacked(this, instr->packed_index, func, arity, instr->output_size,
+                               call_args_);
+        } else {
+          InvokePacked(instr->packed_index, func, arity, instr->output_size, call_args_);
+        }
+        // Drop the references, the buffer keeps its capacity.
+        call_args_.clear();
         pc_++;
-        goto main_loop;
       }
-      case Opcode::InvokeClosure: {
-        auto object = ReadRegister(instr.closure);
+      TVM_VM_DISPATCH();
+      case Opcode::InvokeClosure:
+      TVM_VM_HANDLER(InvokeClosure) {
+        auto object = ReadRegister(instr->closure);
         const auto* closure = object.as<VMClosureObj>();
 
-        std::vector<ObjectRef> args;
         for (auto free_var : closure->free_vars) {
-          args.push_back(free_var);
+          call_args_.push_back(free_var);
         }
-        for (Index i = 0; i < instr.num_closure_args; ++i) {
-          args.push_back(ReadRegister(instr.closure_args[i]));
+        for (Index i = 0; i < instr->num_closure_args; ++i) {
+          call_args_.push_back(ReadRegister(instr->closure_args[i]));
         }
-        InvokeGlobal(exec_->functions[closure->func_index], args);
-        frames_.back().caller_return_register = instr.dst;
-        goto main_loop;
+        InvokeGlobal(exec_->GetVMFunction(closure->func_index), call_args_);
+        call_args_.clear();
+        frames_.back().caller_return_register = instr->dst;
       }
-      case Opcode::GetField: {
-        auto object = ReadRegister(instr.object);
+      TVM_VM_DISPATCH();
+      case Opcode::GetField:
+      TVM_VM_HANDLER(GetField) {
+        auto object = ReadRegister(instr->object);
         const auto& tuple = Downcast<ADT>(object);
-        auto field = tuple[instr.field_index];
-        WriteRegister(instr.dst, field);
+        auto field = tuple[instr->field_index];
+        WriteRegister(instr->dst, field);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::GetTag: {
-        auto object = ReadRegister(instr.get_tag.object);
+      TVM_VM_DISPATCH();
+      case Opcode::GetTag:
+      TVM_VM_HANDLER(GetTag) {
+        auto object = ReadRegister(instr->get_tag.object);
         const auto& adt = Downcast<ADT>(object);
-        auto tag = adt.tag();
-        auto tag_tensor = NDArray::Empty({1}, {kDLInt, 32, 1}, {kDLCPU, 0});
-        reinterpret_cast<int32_t*>(tag_tensor->data)[0] = tag;
-        WriteRegister(instr.dst, tag_tensor);
+        WriteRegister(instr->dst, GetScalarConst(adt.tag(), {kDLInt, 32, 1}));
         pc_++;
-        goto main_loop;
       }
-      case Opcode::Goto: {
-        pc_ += instr.pc_offset;
-        goto main_loop;
+      TVM_VM_DISPATCH();
+      case Opcode::Goto:
+      TVM_VM_HANDLER(Goto) {
+        pc_ += instr->pc_offset;
       }
-      case Opcode::If: {
-        int32_t test_val = LoadScalarInt(instr.if_op.test);
-        int32_t target_val = LoadScalarInt(instr.if_op.target);
+      TVM_VM_DISPATCH();
+      case Opcode::If:
+      TVM_VM_HANDLER(If) {
+        int32_t test_val = LoadScalarInt(instr->if_op.test);
+        int32_t target_val = LoadScalarInt(instr->if_op.target);
 
         if (test_val == target_val) {
-          ICHECK_NE(instr.if_op.true_offset, 0);
-          pc_ += instr.if_op.true_offset;
+          ICHECK_NE(instr->if_op.true_offset, 0);
+          pc_ += instr->if_op.true_offset;
         } else {
-          ICHECK_NE(instr.if_op.false_offset, 0);
-          pc_ += instr.if_op.false_offset;
+          ICHECK_NE(instr->if_op.false_offset, 0);
+          pc_ += instr->if_op.false_offset;
         }
 
-        goto main_loop;
       }
-      case Opcode::AllocTensor: {
-        auto shape = std::vector<int64_t>(instr.alloc_tensor.ndim);
+      TVM_VM_DISPATCH();
+      case Opcode::AllocTensor:
+      TVM_VM_HANDLER(AllocTensor) {
+        auto shape = std::vector<int64_t>(instr->alloc_tensor.ndim);
 
-        for (uint32_t i = 0; i < instr.alloc_tensor.ndim; ++i) {
-          shape[i] = instr.alloc_tensor.shape[i];
+        for (uint32_t i = 0; i < instr->alloc_tensor.ndim; ++i) {
+          shape[i] = instr->alloc_tensor.shape[i];
         }
 
-        auto storage_obj = ReadRegister(instr.alloc_tensor.storage);
-        auto offset = LoadScalarInt(instr.alloc_tensor.offset);
+        auto storage_obj = ReadRegister(instr->alloc_tensor.storage);
+        auto offset = LoadScalarInt(instr->alloc_tensor.offset);
         auto storage = Downcast<Storage>(storage_obj);
-        auto obj = storage->AllocNDArray(offset, shape, instr.alloc_tensor.dtype);
+        auto obj = storage->AllocNDArray(offset, shape, instr->alloc_tensor.dtype);
+        if (async_ != nullptr) async_->Alias(obj, storage);
 
-        WriteRegister(instr.dst, obj);
+        WriteRegister(instr->dst, obj);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::AllocTensorReg: {
+      TVM_VM_DISPATCH();
+      case Opcode::AllocTensorReg:
+      TVM_VM_HANDLER(AllocTensorReg) {
         DLContext cpu_ctx = GetContext(static_cast<Index>(kDLCPU));
-        auto shape_obj = ReadRegister(instr.alloc_tensor_reg.shape_register);
+        auto shape_obj = ReadRegister(instr->alloc_tensor_reg.shape_register);
+        if (async_ != nullptr) async_->WaitForData(shape_obj);
         NDArray shape_tensor = Downcast<NDArray>(CopyTo(shape_obj, cpu_ctx));
         auto shape = ToShape(shape_tensor);
-        auto storage_obj = ReadRegister(instr.alloc_tensor_reg.storage);
+        auto storage_obj = ReadRegister(instr->alloc_tensor_reg.storage);
         auto storage = Downcast<Storage>(storage_obj);
-        auto offset = LoadScalarInt(instr.alloc_tensor.offset);
-        auto obj = storage->AllocNDArray(offset, shape, instr.alloc_tensor_reg.dtype);
+        auto offset = LoadScalarInt(instr->alloc_tensor.offset);
+        auto obj = storage->AllocNDArray(offset, shape, instr->alloc_tensor_reg.dtype);
+        if (async_ != nullptr) async_->Alias(obj, storage);
 
-        WriteRegister(instr.dst, obj);
+        WriteRegister(instr->dst, obj);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::AllocADT: {
+      TVM_VM_DISPATCH();
+      case Opcode::AllocADT:
+      TVM_VM_HANDLER(AllocADT) {
         std::vector<ObjectRef> fields;
-        for (Index i = 0; i < instr.num_fields; ++i) {
-          fields.push_back(ReadRegister(instr.datatype_fields[i]));
+        for (Index i = 0; i < instr->num_fields; ++i) {
+          fields.push_back(ReadRegister(instr->datatype_fields[i]));
         }
-        ObjectRef obj = ADT(instr.constructor_tag, fields);
-        WriteRegister(instr.dst, obj);
+        ObjectRef obj = ADT(instr->constructor_tag, fields);
+        WriteRegister(instr->dst, obj);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::AllocClosure: {
+      TVM_VM_DISPATCH();
+      case Opcode::AllocClosure:
+      TVM_VM_HANDLER(AllocClosure) {
         std::vector<ObjectRef> free_vars;
-        for (Index i = 0; i < instr.num_freevar; i++) {
-          free_vars.push_back(ReadRegister(instr.free_vars[i]));
+        for (Index i = 0; i < instr->num_freevar; i++) {
+          free_vars.push_back(ReadRegister(instr->free_vars[i]));
         }
-        WriteRegister(instr.dst, VMClosure(instr.func_index, free_vars));
+        WriteRegister(instr->dst, VMClosure(instr->func_index, free_vars));
         pc_++;
-        goto main_loop;
       }
-      case Opcode::AllocStorage: {
-        auto size = LoadScalarInt(instr.alloc_storage.allocation_size);
-        auto alignment = instr.alloc_storage.alignment;
+      TVM_VM_DISPATCH();
+      case Opcode::AllocStorage:
+      TVM_VM_HANDLER(AllocStorage) {
+        auto size = LoadScalarInt(instr->alloc_storage.allocation_size);
+        auto alignment = instr->alloc_storage.alignment;
 
         DLOG(INFO) << "AllocStorage: allocation_size=" << size << ", alignment=" << alignment
-                   << ", dtype_hint=" << DLDataType2String(instr.alloc_storage.dtype_hint)
-                   << ", device_type=" << instr.alloc_storage.device_type;
+                   << ", dtype_hint=" << DLDataType2String(instr->alloc_storage.dtype_hint)
+                   << ", device_type=" << instr->alloc_storage.device_type;
 
         auto storage_obj = SimpleObjAllocator().make_object<StorageObj>();
-        auto dev_type = instr.alloc_storage.device_type;
+        auto dev_type = instr->alloc_storage.device_type;
         ICHECK_LT(static_cast<size_t>(dev_type), allocators_.size())
             << "Memory allocator for device " << dev_type << " has not been initialized";
         auto* alloc = allocators_[dev_type];
         ICHECK(alloc) << "Did you forget to init the VirtualMachine with contexts?";
-        storage_obj->buffer = alloc->Alloc(size, alignment, instr.alloc_storage.dtype_hint);
+        storage_obj->buffer = alloc->Alloc(size, alignment, instr->alloc_storage.dtype_hint);
         Storage storage(storage_obj);
-        WriteRegister(instr.dst, storage);
+        WriteRegister(instr->dst, storage);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::ShapeOf: {
-        auto input = ReadRegister(instr.shape_of.tensor);
+      TVM_VM_DISPATCH();
+      case Opcode::ShapeOf:
+      TVM_VM_HANDLER(ShapeOf) {
+        auto input = ReadRegister(instr->shape_of.tensor);
         NDArray input_array = Downcast<NDArray>(input);
         int ndim = input_array->ndim;
         auto out_tensor = NDArray::Empty({ndim}, {kDLInt, 64, 1}, {kDLCPU, 0});
         for (int i = 0; i < ndim; ++i) {
           reinterpret_cast<int64_t*>(out_tensor->data)[i] = input_array->shape[i];
         }
-        WriteRegister(instr.dst, out_tensor);
+        WriteRegister(instr->dst, out_tensor);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::Ret: {
+      TVM_VM_DISPATCH();
+      case Opcode::Ret:
+      TVM_VM_HANDLER(Ret) {
         // If we have hit the point from which we started
         // running, we should return to the caller breaking
         // the dispatch loop.
-        return_register_ = ReadRegister(instr.result);
+        return_register_ = ReadRegister(instr->result);
         auto caller_return_register = frames_.back().caller_return_register;
 
         if (PopFrame() == frame_start) {
+          if (async_ != nullptr) async_->Sync();
+          if (trace_instructions_) EndRunLoop();
           return;
-          // Otherwise we are just returning from a local call.
-        } else {
-          WriteRegister(caller_return_register, return_register_);
-          goto main_loop;
         }
+        // Otherwise we are just returning from a local call.
+        WriteRegister(caller_return_register, return_register_);
       }
-      case Opcode::ReshapeTensor: {
+      TVM_VM_DISPATCH();
+      case Opcode::ReshapeTensor:
+      TVM_VM_HANDLER(ReshapeTensor) {
         DLContext cpu_ctx = GetContext(static_cast<Index>(kDLCPU));
-        auto tensor_obj = ReadRegister(instr.reshape_tensor.tensor);
+        auto tensor_obj = ReadRegister(instr->reshape_tensor.tensor);
         NDArray tensor_arr = Downcast<NDArray>(tensor_obj);
         // Read the shape from shape tensor
-        auto shape_obj = ReadRegister(instr.reshape_tensor.newshape);
+        auto shape_obj = ReadRegister(instr->reshape_tensor.newshape);
+        if (async_ != nullptr) async_->WaitForData(shape_obj);
         NDArray shape_tensor = Downcast<NDArray>(CopyTo(shape_obj, cpu_ctx));
         const DLTensor* dl_tensor = shape_tensor.operator->();
         ICHECK_EQ(dl_tensor->dtype.code, 0u);
@@ -589,29 +996,37 @@ void VirtualMachine::RunLoop() {
         std::vector<int64_t> shape(dims, dims + ndim);
         // Reshape the input tensor
         auto out_tensor = tensor_arr.CreateView(shape, tensor_arr->dtype);
-        WriteRegister(instr.dst, out_tensor);
+        if (async_ != nullptr) async_->Alias(out_tensor, tensor_arr);
+        WriteRegister(instr->dst, out_tensor);
         pc_++;
-        goto main_loop;
       }
-      case Opcode::DeviceCopy: {
-        auto tensor_src = ReadRegister(instr.src);
+      TVM_VM_DISPATCH();
+      case Opcode::DeviceCopy:
+      TVM_VM_HANDLER(DeviceCopy) {
+        auto tensor_src = ReadRegister(instr->src);
         NDArray src_data = Downcast<NDArray>(tensor_src);
         DLContext src_ctx = src_data->ctx;
-        ICHECK_EQ(static_cast<Index>(src_ctx.device_type), instr.src_device_type);
+        ICHECK_EQ(static_cast<Index>(src_ctx.device_type), instr->src_device_type);
 
         DLContext dst_ctx;
-        dst_ctx.device_type = static_cast<DLDeviceType>(instr.dst_device_type);
+        dst_ctx.device_type = static_cast<DLDeviceType>(instr->dst_device_type);
         dst_ctx.device_id = 0;
 
-        NDArray dst_data = src_data.CopyTo(dst_ctx);
-        WriteRegister(instr.dst, dst_data);
+        NDArray dst_data =
+            async_ != nullptr ? async_->SubmitCopy(src_data, dst_ctx) : src_data.CopyTo(dst_ctx);
+        WriteRegister(instr->dst, dst_data);
         pc_++;
-        goto main_loop;
       }
+      TVM_VM_DISPATCH();
       default:
-        LOG(FATAL) << "Unknown instruction opcode: " << int(instr.op);
+#if TVM_VM_USE_COMPUTED_GOTO
+      unknown_opcode:
+#endif
+        LOG(FATAL) << "Unknown instruction opcode: " << int(instr->op);
     }
   }
+#undef TVM_VM_HANDLER
+#undef TVM_VM_DISPATCH
 }
 
 runtime::Module CreateVirtualMachine(const Executable* exec) {
@@ -23,7 +23,15 @@
  */
 #include "workspace_pool.h"
 
+#include <tvm/support/logging.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace tvm {
 namespace runtime {
@@ -31,17 +39,44 @@ namespace runtime {
 // page size.
 constexpr size_t kWorkspacePageSize = 4 << 10;
 
-class WorkspacePool::Pool {
+/*!
+ * \brief Recorder of the workspace requests, enabled by envvar TVM_WORKSPACE_POOL_TRACE=<file>.
+ *
+ *  Each line is either "a <pool> <size> <ptr>" or "f <pool> <ptr>", the trace
+ *  can be replayed by tests/cpp/workspace_pool_test.cc to benchmark the pool.
+ */
+class WorkspaceTrace {
  public:
-  // constructor
-  Pool() {
-    // safe guard header on each list.
-    Entry e;
-    e.data = nullptr;
-    e.size = 0;
-    free_list_.push_back(e);
-    allocated_.push_back(e);
+  static WorkspaceTrace* Global() {
+    // NOTE: explicitly use new to avoid exit-time destruction of global state
+    static auto* inst = new WorkspaceTrace();
+    return inst;
+  }
+  bool enabled() const { return enabled_; }
+  void RecordAlloc(const void* pool, size_t size, const void* ptr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    os_ << "a " << pool << ' ' << size << ' ' << ptr << '\n';
   }
+  void RecordFree(const void* pool, const void* ptr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    os_ << "f " << pool << ' ' << ptr << '\n';
+  }
+
+ private:
+  WorkspaceTrace() {
+    const char* path = getenv("TVM_WORKSPACE_POOL_TRACE");
+    if (path != nullptr) {
+      os_.open(path);
+      enabled_ = os_.is_open();
+    }
+  }
+  bool enabled_{false};
+  std::mutex mutex_;
+  std::ofstream os_;
+};
+
+class WorkspacePool::Pool {
+ public:
   // allocate from pool
   void* Alloc(TVMContext ctx, DeviceAPI* device, size_t nbytes) {
     // Allocate align to page.
@@ -52,34 +87,16 @@ class WorkspacePool::Pool {
     type.code = kDLUInt;
     type.bits = 8;
     type.lanes = 1;
-    if (free_list_.size() == 2) {
-      e = free_list_.back();
-      free_list_.pop_back();
-      if (e.size < nbytes) {
-        // resize the page
+    if (!PopBestFit(nbytes, &e)) {
+      // No free page fits, release the largest pages so that the pool
+      // keeps its footprint while it adapts to the bigger request.
+      size_t released = 0;
+      while (released < nbytes && PopLargest(&e)) {
         device->FreeDataSpace(ctx, e.data);
-        e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
-        e.size = nbytes;
+        released += e.size;
       }
-    } else if (free_list_.size() == 1) {
       e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
       e.size = nbytes;
-    } else {
-      if (free_list_.back().size >= nbytes) {
-        // find smallest fit
-        auto it = free_list_.end() - 2;
-        for (; it->size >= nbytes; --it) {
-        }
-        e = *(it + 1);
-        free_list_.erase(it + 1);
-      } else {
-        // resize the page
-        e = free_list_.back();
-        free_list_.pop_back();
-        device->FreeDataSpace(ctx, e.data);
-        e.data = device->AllocDataSpace(ctx, nbytes, kTempAllocaAlignment, type);
-        e.size = nbytes;
-      }
     }
     allocated_.push_back(e);
     return e.data;
@@ -87,39 +104,29 @@ class WorkspacePool::Pool {
   // free resource back to pool
   void Free(void* data) {
     Entry e;
-    if (allocated_.back().data == data) {
+    if (!allocated_.empty() && allocated_.back().data == data) {
       // quick path, last allocated.
       e = allocated_.back();
       allocated_.pop_back();
     } else {
       int index = static_cast<int>(allocated_.size()) - 2;
-      for (; index > 0 && allocated_[index].data != data; --index) {
+      for (; index >= 0 && allocated_[index].data != data; --index) {
       }
-      ICHECK_GT(index, 0) << "trying to free things that has not been allocated";
+      ICHECK_GE(index, 0) << "trying to free things that has not been allocated";
       e = allocated_[index];
       allocated_.erase(allocated_.begin() + index);
     }
-    if (free_list_.back().size < e.size) {
-      free_list_.push_back(e);
-    } else if (free_list_.size() == 2) {
-      free_list_.push_back(free_list_.back());
-      free_list_[1] = e;
-    } else {
-      size_t i = free_list_.size() - 1;
-      free_list_.resize(free_list_.size() + 1);
-      for (; e.size < free_list_[i].size; --i) {
-        free_list_[i + 1] = free_list_[i];
-      }
-      free_list_[i + 1] = e;
-    }
+    buckets_[BucketIndex(e.size)].push_back(e);
   }
   // Release all resources
   void Release(TVMContext ctx, DeviceAPI* device) {
-    ICHECK_EQ(allocated_.size(), 1);
-    for (size_t i = 1; i < free_list_.size(); ++i) {
-      device->FreeDataSpace(ctx, free_list_[i].data);
+    ICHECK_EQ(allocated_.size(), 0);
+    for (auto& bucket : buckets_) {
+      for (const Entry& e : bucket) {
+        device->FreeDataSpace(ctx, e.data);
+      }
+      bucket.clear();
     }
-    free_list_.clear();
   }
 
  private:
@@ -128,9 +135,58 @@ class WorkspacePool::Pool {
     void* data;
     size_t size;
   };
-  /*! \brief List of free items, sorted from small to big size */
-  std::vector<Entry> free_list_;
-  /*! \brief List of allocated items */
+  /*! \brief number of free list buckets, bucket i hosts the sizes in [2^i, 2^(i+1)) */
+  static constexpr int kNumBuckets = 64;
+
+  static int BucketIndex(size_t size) {
+    int index = 0;
+    while (size >>= 1) ++index;
+    return index;
+  }
+  // Pop the smallest free page that is at least nbytes large.
+  bool PopBestFit(size_t nbytes, Entry* e) {
+    for (int b = BucketIndex(nbytes); b < kNumBuckets; ++b) {
+      std::vector<Entry>& bucket = buckets_[b];
+      int best = -1;
+      for (int i = static_cast<int>(bucket.size()) - 1; i >= 0; --i) {
+        if (bucket[i].size >= nbytes && (best == -1 || bucket[i].size < bucket[best].size)) {
+          best = i;
+        }
+      }
+      if (best != -1) {
+        *e = bucket[best];
+        bucket[best] = bucket.back();
+        bucket.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+  // Pop the largest free page.
+  bool PopLargest(Entry* e) {
+    for (int b = kNumBuckets - 1; b >= 0; --b) {
+      std::vector<Entry>& bucket = buckets_[b];
+      if (bucket.empty()) continue;
+      auto it = std::max_element(bucket.begin(), bucket.end(),
+                                 [](const Entry& x, const Entry& y) { return x.size < y.size; });
+      *e = *it;
+      *it = bucket.back();
+      bucket.pop_back();
+      return true;
+    }
+    return false;
+  }
+  /*!
+   * \brief Free pages bucketed by the power of two of their size.
+   *  Only the bucket of the request and the first non-empty larger bucket are scanned,
+   *  so a lookup stays cheap however many pages the pool holds.
+   */
+  std::array<std::vector<Entry>, kNumBuckets> buckets_;
+  /*!
+   * \brief List of allocated items, in allocation order.
+   *  The release order is usually the reverse of the allocation order,
+   *  so the lookup starts from the back.
+   */
   std::vector<Entry> allocated_;
 };
 
@@ -156,11 +212,18 @@ void* WorkspacePool::AllocWorkspace(TVMContext ctx, size_t size) {
   if (array_[ctx.device_id] == nullptr) {
     array_[ctx.device_id] = new Pool();
   }
-  return array_[ctx.device_id]->Alloc(ctx, device_, size);
+  void* ptr = array_[ctx.device_id]->Alloc(ctx, device_, size);
+  if (WorkspaceTrace::Global()->enabled()) {
+    WorkspaceTrace::Global()->RecordAlloc(array_[ctx.device_id], size, ptr);
+  }
+  return ptr;
 }
 
 void WorkspacePool::FreeWorkspace(TVMContext ctx, void* ptr) {
   ICHECK(static_cast<size_t>(ctx.device_id) < array_.size() && array_[ctx.device_id] != nullptr);
+  if (WorkspaceTrace::Global()->enabled()) {
+    WorkspaceTrace::Global()->RecordFree(array_[ctx.device_id], ptr);
+  }
   array_[ctx.device_id]->Free(ptr);
 }
 
@@ -0,0 +1,215 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file lz_codec.h
+ * \brief A fast LZ77 block codec in the style of LZ4, for data sent over slow links.
+ */
+#ifndef TVM_SUPPORT_LZ_CODEC_H_
+#define TVM_SUPPORT_LZ_CODEC_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace tvm {
+namespace support {
+/*!
+ * \brief LZ77 codec of independent blocks.
+ *
+ *  A compressed block is a sequence of:
+ *  - a token, the number of literals in the high 4 bits and the match length
+ *    minus kMinMatch in the low 4 bits, 15 meaning that the length continues
+ *  - the extra bytes of the literal length, each adding up to 255
+ *  - the literals
+ *  - the uint16 little endian offset of the match, absent in the last sequence
+ *  - the extra bytes of the match length
+ *
+ *  The last kLastLiterals bytes of a block are always literals.
+ */
+class LZCodec {
+ public:
+  /*! \brief The shortest match. */
+  static const int kMinMatch = 4;
+  /*! \brief The literals ending a block. */
+  static const int kLastLiterals = 5;
+  /*! \brief The farthest match. */
+  static const int kMaxOffset = 65535;
+
+  LZCodec() : table_(kTableSize) {}
+
+  /*!
+   * \brief Compress a block.
+   * \param src The bytes.
+   * \param size The number of bytes.
+   * \param dst The output buffer.
+   * \param capacity The size of the output buffer, compression gives up
+   *  as soon as the output does not fit.
+   * \return The size of the compressed block, 0 when it does not fit.
+   */
+  size_t Compress(const char* src, size_t size, char* dst, size_t capacity) {
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* ip = base;
+    const uint8_t* anchor = base;
+    const uint8_t* end = base + size;
+    uint8_t* op = reinterpret_cast<uint8_t*>(dst);
+    uint8_t* oend = op + capacity;
+
+    if (size > kMinMatch + kLastLiterals + 8) {
+      std::fill(table_.begin(), table_.end(), 0);
+      // A match starts before this and ends before the last literals.
+      const uint8_t* match_limit = end - kLastLiterals;
+      const uint8_t* search_limit = end - kLastLiterals - 8;
+      size_t misses = 0;
+      while (ip < search_limit) {
+        uint32_t seq = Read32(ip);
+        uint32_t& entry = table_[Hash(seq)];
+        const uint8_t* ref = entry != 0 ? base + entry - 1 : nullptr;
+        bool found = ref != nullptr && ip - ref <= kMaxOffset && Read32(ref) == seq;
+        entry = static_cast<uint32_t>(ip - base) + 1;
+        if (!found) {
+          // Skip faster through data that does not compress.
+          ip += 1 + (misses++ >> 6);
+          continue;
+        }
+        misses = 0;
+        size_t length = kMinMatch;
+        while (ip + length < match_limit && ip[length] == ref[length]) ++length;
+        op = EmitSequence(anchor, ip - anchor, op, oend, ip - ref, length);
+        if (op == nullptr) return 0;
+        ip += length;
+        anchor = ip;
+      }
+    }
+    op = EmitSequence(anchor, end - anchor, op, oend, 0, 0);
+    if (op == nullptr) return 0;
+    return op - reinterpret_cast<uint8_t*>(dst);
+  }
+
+  /*!
+   * \brief Decompress a block.
+   * \param src The compressed block.
+   * \param size The size of the compressed block.
+   * \param dst The output buffer.
+   * \param out_size The size of the block once decompressed.
+   * \return Whether the block is valid and decompresses to exactly out_size bytes.
+   */
+  static bool Decompress(const char* src, size_t size, char* dst, size_t out_size) {
+    const uint8_t* ip = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* iend = ip + size;
+    uint8_t* base = reinterpret_cast<uint8_t*>(dst);
+    uint8_t* op = base;
+    uint8_t* oend = base + out_size;
+
+    while (ip < iend) {
+      uint8_t token = *ip++;
+      size_t literals = token >> 4;
+      if (literals == 15 && !ReadLength(&ip, iend, &literals)) return false;
+      if (static_cast<size_t>(iend - ip) < literals) return false;
+      if (static_cast<size_t>(oend - op) < literals) return false;
+      if (literals != 0) std::memcpy(op, ip, literals);
+      ip += literals;
+      op += literals;
+      // The last sequence has no match.
+      if (ip == iend) break;
+
+      if (iend - ip < 2) return false;
+      size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+      ip += 2;
+      if (offset == 0 || offset > static_cast<size_t>(op - base)) return false;
+      size_t length = token & 15;
+      if (length == 15 && !ReadLength(&ip, iend, &length)) return false;
+      length += kMinMatch;
+      if (static_cast<size_t>(oend - op) < length) return false;
+      const uint8_t* ref = op - offset;
+      if (offset >= length) {
+        std::memcpy(op, ref, length);
+        op += length;
+      } else {
+        // The match overlaps the bytes it produces.
+        for (size_t i = 0; i < length; ++i) *op++ = *ref++;
+      }
+    }
+    return op == oend;
+  }
+
+ private:
+  static const int kHashBits = 12;
+  static const size_t kTableSize = size_t(1) << kHashBits;
+
+  static uint32_t Read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  static uint32_t Hash(uint32_t seq) { return (seq * 2654435761U) >> (32 - kHashBits); }
+
+  // Write a length of 15 or more as the extra bytes after the token.
+  static uint8_t* WriteLength(size_t length, uint8_t* op, uint8_t* oend) {
+    for (length -= 15; length >= 255; length -= 255) {
+      if (op == oend) return nullptr;
+      *op++ = 255;
+    }
+    if (op == oend) return nullptr;
+    *op++ = static_cast<uint8_t>(length);
+    return op;
+  }
+
+  static bool ReadLength(const uint8_t** ip, const uint8_t* iend, size_t* length) {
+    uint8_t byte;
+    do {
+      if (*ip == iend) return false;
+      byte = *(*ip)++;
+      *length += byte;
+    } while (byte == 255);
+    return true;
+  }
+
+  // Write a sequence, a match of length 0 ends the block.
+  static uint8_t* EmitSequence(const uint8_t* literals, size_t num_literals, uint8_t* op,
+                               uint8_t* oend, size_t offset, size_t length) {
+    if (op == oend) return nullptr;
+    uint8_t* token = op++;
+    *token = static_cast<uint8_t>(std::min<size_t>(num_literals, 15) << 4);
+    if (num_literals >= 15 && (op = WriteLength(num_literals, op, oend)) == nullptr) {
+      return nullptr;
+    }
+    if (static_cast<size_t>(oend - op) < num_literals) return nullptr;
+    if (num_literals != 0) std::memcpy(op, literals, num_literals);
+    op += num_literals;
+    if (length == 0) return op;
+
+    if (oend - op < 2) return nullptr;
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    length -= kMinMatch;
+    *token |= static_cast<uint8_t>(std::min<size_t>(length, 15));
+    if (length >= 15 && (op = WriteLength(length, op, oend)) == nullptr) return nullptr;
+    return op;
+  }
+
+  // The positions plus one of the last sequences with each hash, 0 if none.
+  std::vector<uint32_t> table_;
+};
+
+}  // namespace support
+}  // namespace tvm
+#endif  // TVM_SUPPORT_LZ_CODEC_H_
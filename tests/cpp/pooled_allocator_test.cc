@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/device_api.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../src/runtime/vm/pooled_allocator.h"
+
+using namespace tvm::runtime;
+using tvm::runtime::vm::Buffer;
+using tvm::runtime::vm::PooledAllocator;
+
+namespace {
+
+TVMContext CPUContext() {
+  TVMContext ctx;
+  ctx.device_type = kDLCPU;
+  ctx.device_id = 0;
+  return ctx;
+}
+
+DLDataType Float32() {
+  DLDataType dtype;
+  dtype.code = kDLFloat;
+  dtype.bits = 32;
+  dtype.lanes = 1;
+  return dtype;
+}
+
+bool HasField(const std::string& stats, const std::string& field) {
+  return stats.find(field) != std::string::npos;
+}
+
+}  // namespace
+
+TEST(PooledAllocator, ThreadCacheHits) {
+  PooledAllocator alloc(CPUContext());
+  Buffer buf = alloc.Alloc(1000, 64, Float32());
+  alloc.Free(buf);
+  Buffer again = alloc.Alloc(1000, 64, Float32());
+  EXPECT_EQ(again.data, buf.data);
+  alloc.Free(again);
+  std::string stats = alloc.Stats();
+  EXPECT_TRUE(HasField(stats, "\"num_allocs\": 2")) << stats;
+  EXPECT_TRUE(HasField(stats, "\"thread_cache_hits\": 1")) << stats;
+  EXPECT_TRUE(HasField(stats, "\"cached_bytes\": 4096")) << stats;
+  // The high-water mark reaches the buffer cached by this thread.
+  alloc.SetHighWater(0);
+  stats = alloc.Stats();
+  EXPECT_TRUE(HasField(stats, "\"cached_bytes\": 0")) << stats;
+  EXPECT_TRUE(HasField(stats, "\"used_memory\": 0")) << stats;
+}
+
+TEST(PooledAllocator, ExitedThreadsReturnTheirBuffers) {
+  PooledAllocator alloc(CPUContext());
+  std::atomic<int> num_allocated{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&alloc, &num_allocated]() {
+      Buffer buf = alloc.Alloc(1000, 64, Float32());
+      // Hold the buffer until every thread has its own.
+      num_allocated.fetch_add(1);
+      while (num_allocated.load() < 4) std::this_thread::yield();
+      alloc.Free(buf);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  std::string stats = alloc.Stats();
+  EXPECT_TRUE(HasField(stats, "\"num_allocs\": 4")) << stats;
+  EXPECT_TRUE(HasField(stats, "\"used_memory\": 16384")) << stats;
+  EXPECT_TRUE(HasField(stats, "\"cached_bytes\": 16384")) << stats;
+}
+
+TEST(PooledAllocator, DestroyedAllocatorDetachesThreadCaches) {
+  // The cache of a destroyed allocator must not serve a new allocator, even at the same address.
+  for (int i = 0; i < 4; ++i) {
+    std::unique_ptr<PooledAllocator> alloc(new PooledAllocator(CPUContext()));
+    Buffer buf = alloc->Alloc(1000, 64, Float32());
+    alloc->Free(buf);
+    std::string stats = alloc->Stats();
+    EXPECT_TRUE(HasField(stats, "\"num_allocs\": 1")) << stats;
+    EXPECT_TRUE(HasField(stats, "\"thread_cache_hits\": 0")) << stats;
+  }
+}
@@ -20,7 +20,12 @@
 #include <dmlc/logging.h>
 #include <gtest/gtest.h>
 
+#include <random>
+#include <string>
+#include <vector>
+
 #include "../../src/support/hexdump.h"
+#include "../../src/support/lz_codec.h"
 
 namespace tvm {
 namespace test {
@@ -43,6 +48,49 @@ TEST(HexDumpTests, Unaligned) {
                               "\x01\x23\x45\x67\x89\xab\xcd\xef\x01"));
 }
 
+// Compress a block and check that it decompresses to the same bytes.
+size_t CheckLZRoundTrip(const std::string& data) {
+  ::tvm::support::LZCodec codec;
+  std::vector<char> compressed(data.size() + data.size() / 255 + 16);
+  size_t size = codec.Compress(data.data(), data.size(), compressed.data(), compressed.size());
+  EXPECT_NE(size, 0U);
+  std::vector<char> decompressed(data.size() + 1);
+  EXPECT_TRUE(::tvm::support::LZCodec::Decompress(compressed.data(), size, decompressed.data(),
+                                                  data.size()));
+  EXPECT_EQ(data, std::string(decompressed.data(), data.size()));
+  // A truncated block is rejected.
+  if (size > 1) {
+    EXPECT_FALSE(::tvm::support::LZCodec::Decompress(compressed.data(), size - 1,
+                                                     decompressed.data(), data.size()));
+  }
+  return size;
+}
+
+TEST(LZCodecTests, RoundTrip) {
+  std::mt19937 rng(0);
+  CheckLZRoundTrip("");
+  CheckLZRoundTrip("a");
+  EXPECT_LT(CheckLZRoundTrip(std::string(1 << 16, '\0')), 512U);
+  std::string text;
+  while (text.size() < (1 << 16)) text += "x = y + " + std::to_string(rng() % 100) + ";\n";
+  EXPECT_LT(CheckLZRoundTrip(text), text.size() / 2);
+  for (size_t size = 0; size < 200; ++size) {
+    std::string data(size, 'a');
+    for (char& c : data) c = "ab"[rng() % 2];
+    CheckLZRoundTrip(data);
+  }
+}
+
+TEST(LZCodecTests, Incompressible) {
+  std::mt19937 rng(0);
+  std::string data(1 << 16, '\0');
+  for (char& c : data) c = static_cast<char>(rng());
+  ::tvm::support::LZCodec codec;
+  std::vector<char> compressed(data.size());
+  // Compression gives up when the output does not fit.
+  EXPECT_EQ(codec.Compress(data.data(), data.size(), compressed.data(), data.size() * 7 / 8), 0U);
+}
+
 }  // namespace test
 }  // namespace tvm
 
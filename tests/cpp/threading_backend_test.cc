@@ -19,10 +19,16 @@
 
 #include <gtest/gtest.h>
 #include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/registry.h>
+#include <tvm/runtime/threading_backend.h>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
 constexpr size_t N = 128;
 
@@ -64,6 +70,208 @@ TEST(ThreadingBackend, TVMBackendParallelLaunchMultipleThreads) {
   }
 }
 
+// Each task waits for the others, so a launch of two tasks needs a worker.
+static FTVMParallelLambda rendezvous_task = [](int task_id, TVMParallelGroupEnv* penv,
+                                               void* cdata) -> int {
+  auto* count = reinterpret_cast<std::atomic<int>*>(cdata);
+  count->fetch_add(1);
+  while (count->load() < penv->num_task) {
+    std::this_thread::yield();
+  }
+  return 0;
+};
+
+static double GetStat(const std::string& stats, const std::string& key) {
+  size_t pos = stats.find("\"" + key + "\": ");
+  EXPECT_NE(pos, std::string::npos) << key << " is missing in " << stats;
+  return pos == std::string::npos ? -1 : std::stod(stats.substr(pos + key.size() + 4));
+}
+
+TEST(ThreadingBackend, ThreadPoolStats) {
+  const auto* fstats = tvm::runtime::Registry::Get("runtime.thread_pool_stats");
+  ASSERT_TRUE(fstats != nullptr);
+  if (tvm::runtime::threading::MaxConcurrency() < 2) {
+    // Without workers the main thread runs every task and the queues stay unused.
+    return;
+  }
+  (*fstats)(true);
+  // A worker only parks once its spin runs out, so wait on the parks counter,
+  // doubling the gap between launches until a launch wakes a parked worker.
+  std::string stats;
+  auto gap = std::chrono::microseconds(100);
+  for (int i = 0; i < 15; ++i) {
+    std::atomic<int> count(0);
+    EXPECT_EQ(TVMBackendParallelLaunch(rendezvous_task, &count, 2), 0);
+    std::string current = (*fstats)(false);
+    stats = current;
+    if (GetStat(stats, "parks") > 0) break;
+    std::this_thread::sleep_for(gap);
+    gap *= 2;
+  }
+  EXPECT_GT(GetStat(stats, "spin_hits") + GetStat(stats, "parks"), 0) << stats;
+  EXPECT_GT(GetStat(stats, "parks"), 0) << stats;
+  EXPECT_GE(GetStat(stats, "avg_wake_latency_us"), 0) << stats;
+}
+
+TEST(ThreadingBackend, NumaAffinityMode) {
+  using tvm::runtime::threading::ThreadGroup;
+  EXPECT_GE(tvm::runtime::threading::NumNumaNodes(), 1);
+  EXPECT_GE(tvm::runtime::threading::CurrentNumaNode(), 0);
+  EXPECT_LT(tvm::runtime::threading::CurrentNumaNode(), tvm::runtime::threading::NumNumaNodes());
+  const auto* fconfig = tvm::runtime::Registry::Get("runtime.config_threadpool");
+  ASSERT_TRUE(fconfig != nullptr);
+  (*fconfig)(static_cast<int>(ThreadGroup::kNuma), 0);
+  std::atomic<size_t> acc(0);
+  EXPECT_EQ(TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0), 0);
+  EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+  (*fconfig)(static_cast<int>(ThreadGroup::kBig), 0);
+}
+
+TEST(ThreadingBackend, CoreRangeAffinity) {
+  using tvm::runtime::threading::ThreadGroup;
+  const auto* fconfig = tvm::runtime::Registry::Get("runtime.config_threadpool");
+  ASSERT_TRUE(fconfig != nullptr);
+  int num_threads = std::max(tvm::runtime::threading::MaxConcurrency() / 2, 1);
+  // The second half of the cores, as the second of two inter-op executors gets.
+  (*fconfig)(static_cast<int>(ThreadGroup::kBig), num_threads, num_threads);
+  std::atomic<size_t> acc(0);
+  EXPECT_EQ(TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0), 0);
+  EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+  (*fconfig)(static_cast<int>(ThreadGroup::kBig), 0);
+}
+
+static FTVMParallelLambda nested_launch_task = [](int task_id, TVMParallelGroupEnv* penv,
+                                                  void* cdata) -> int {
+  auto* data = reinterpret_cast<std::atomic<size_t>*>(cdata);
+  return TVMBackendParallelLaunch(atomic_add_task_id, data + task_id + 1, 0);
+};
+
+static void SetThreadPoolKind(const std::string& kind) {
+  const auto* fconfig = tvm::runtime::Registry::Get("runtime.config_threadpool_kind");
+  ASSERT_TRUE(fconfig != nullptr);
+  (*fconfig)(kind);
+}
+
+TEST(ThreadingBackend, WorkStealingParallelLaunch) {
+  SetThreadPoolKind("work_stealing");
+  for (int num_task : {0, 1, 3, 64}) {
+    std::atomic<size_t> acc(0);
+    EXPECT_EQ(TVMBackendParallelLaunch(atomic_add_task_id, &acc, num_task), 0);
+    EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+  }
+  SetThreadPoolKind("spsc");
+}
+
+TEST(ThreadingBackend, WorkStealingNestedParallelLaunch) {
+  SetThreadPoolKind("work_stealing");
+  constexpr int num_outer = 8;
+  std::vector<std::atomic<size_t>> acc(num_outer + 1);
+  for (auto& v : acc) v.store(0);
+  EXPECT_EQ(TVMBackendParallelLaunch(nested_launch_task, acc.data(), num_outer), 0);
+  for (int i = 1; i <= num_outer; ++i) {
+    EXPECT_EQ(acc[i].load(std::memory_order_relaxed), N * (N - 1) / 2);
+  }
+  SetThreadPoolKind("spsc");
+}
+
+static FTVMParallelLambda barrier_task = [](int task_id, TVMParallelGroupEnv* penv,
+                                            void* cdata) -> int {
+  auto* arrived = reinterpret_cast<std::vector<std::atomic<int>>*>(cdata);
+  (*arrived)[task_id].store(1);
+  TVMBackendParallelBarrier(task_id, penv);
+  // Every task reached the barrier before any left it.
+  for (int i = 0; i < penv->num_task; ++i) {
+    if ((*arrived)[i].load() != 1) return -1;
+  }
+  return 0;
+};
+
+TEST(ThreadingBackend, WorkStealingBarrier) {
+  SetThreadPoolKind("work_stealing");
+  // The launches where the runtime picks the number of tasks are not chunked by default.
+  std::vector<std::atomic<int>> arrived(tvm::runtime::threading::MaxConcurrency());
+  for (int i = 0; i < 3; ++i) {
+    for (auto& v : arrived) v.store(0);
+    EXPECT_EQ(TVMBackendParallelLaunch(barrier_task, &arrived, 0), 0);
+  }
+  SetThreadPoolKind("spsc");
+}
+
+TEST(ThreadingBackend, WorkStealingThreadPoolStats) {
+  const auto* fstats = tvm::runtime::Registry::Get("runtime.thread_pool_stats");
+  ASSERT_TRUE(fstats != nullptr);
+  if (tvm::runtime::threading::MaxConcurrency() < 2) return;
+  SetThreadPoolKind("work_stealing");
+  (*fstats)(true);
+  // A worker records a wake-up when it waited for the task, retry until one did.
+  double num_waits = 0;
+  for (int i = 0; i < 1000 && num_waits == 0; ++i) {
+    std::atomic<int> count(0);
+    EXPECT_EQ(TVMBackendParallelLaunch(rendezvous_task, &count, 2), 0);
+    std::string stats = (*fstats)(false);
+    num_waits = GetStat(stats, "spin_hits") + GetStat(stats, "parks");
+  }
+  EXPECT_GT(num_waits, 0);
+  SetThreadPoolKind("spsc");
+}
+
+TEST(ThreadingBackend, SharedPoolMultipleSessions) {
+  SetThreadPoolKind("shared");
+  const auto* fconfig = tvm::runtime::Registry::Get("runtime.config_threadpool");
+  ASSERT_TRUE(fconfig != nullptr);
+  size_t num_sessions = 4;
+  std::vector<std::unique_ptr<std::thread>> ts;
+  for (size_t i = 0; i < num_sessions; ++i) {
+    ts.emplace_back(new std::thread([&, i]() {
+      // session i may use at most i + 1 cores, session 0 runs serially.
+      (*fconfig)(1, static_cast<int>(i + 1));
+      for (size_t j = 0; j < 16; ++j) {
+        std::atomic<size_t> acc(0);
+        EXPECT_EQ(TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0), 0);
+        EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+      }
+    }));
+  }
+  for (auto& t : ts) {
+    t->join();
+  }
+  SetThreadPoolKind("spsc");
+}
+
+struct ConcurrencyCounter {
+  std::atomic<int> running{0};
+  std::atomic<int> max_running{0};
+  std::atomic<int> num_calls{0};
+};
+
+static FTVMParallelLambda count_concurrency_task = [](int task_id, TVMParallelGroupEnv* penv,
+                                                      void* cdata) -> int {
+  auto* counter = reinterpret_cast<ConcurrencyCounter*>(cdata);
+  int running = counter->running.fetch_add(1) + 1;
+  int max_running = counter->max_running.load();
+  while (running > max_running &&
+         !counter->max_running.compare_exchange_weak(max_running, running)) {
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  counter->num_calls.fetch_add(1);
+  counter->running.fetch_sub(1);
+  return 0;
+};
+
+TEST(ThreadingBackend, SharedPoolExplicitNumTask) {
+  SetThreadPoolKind("shared");
+  const auto* fconfig = tvm::runtime::Registry::Get("runtime.config_threadpool");
+  ASSERT_TRUE(fconfig != nullptr);
+  // An explicit num_task above the quota is still admitted with the quota.
+  (*fconfig)(1, 2);
+  ConcurrencyCounter counter;
+  EXPECT_EQ(TVMBackendParallelLaunch(count_concurrency_task, &counter, 16), 0);
+  EXPECT_EQ(counter.num_calls.load(), 16);
+  EXPECT_LE(counter.max_running.load(), 2);
+  (*fconfig)(1, 0);
+  SetThreadPoolKind("spsc");
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   testing::FLAGS_gtest_death_test_style = "threadsafe";
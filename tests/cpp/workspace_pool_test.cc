@@ -0,0 +1,183 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/runtime/device_api.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../../src/runtime/workspace_pool.h"
+
+using namespace tvm::runtime;
+
+namespace {
+
+TVMContext CPUContext() {
+  TVMContext ctx;
+  ctx.device_type = kDLCPU;
+  ctx.device_id = 0;
+  return ctx;
+}
+
+/*! \brief One request of an alloc/free sequence. */
+struct WorkspaceEvent {
+  bool alloc;
+  size_t size;
+  std::string ptr;
+};
+
+// Load a trace recorded with TVM_WORKSPACE_POOL_TRACE, keeping the events of its first pool.
+std::vector<WorkspaceEvent> LoadTrace(const std::string& path) {
+  std::vector<WorkspaceEvent> events;
+  std::ifstream is(path);
+  std::string line, first_pool;
+  while (std::getline(is, line)) {
+    std::istringstream ls(line);
+    std::string op, pool;
+    WorkspaceEvent ev;
+    ls >> op >> pool;
+    if (first_pool.empty()) first_pool = pool;
+    if (pool != first_pool) continue;
+    ev.alloc = op == "a";
+    ev.size = 0;
+    if (ev.alloc) ls >> ev.size;
+    ls >> ev.ptr;
+    events.push_back(ev);
+  }
+  return events;
+}
+
+// A kernel-like pattern: nested buffers of mixed sizes, mostly freed in reverse order.
+std::vector<WorkspaceEvent> SyntheticTrace() {
+  const size_t sizes[] = {64, 4096, 1 << 16, 512, 1 << 20, 128, 24576, 3 << 12};
+  std::vector<WorkspaceEvent> events;
+  for (int iter = 0; iter < 16; ++iter) {
+    for (int i = 0; i < 8; ++i) {
+      events.push_back({true, sizes[(i + iter) % 8], std::to_string(i)});
+    }
+    // free one buffer out of order, then the rest in reverse order.
+    events.push_back({false, 0, "3"});
+    for (int i = 7; i >= 0; --i) {
+      if (i != 3) events.push_back({false, 0, std::to_string(i)});
+    }
+  }
+  return events;
+}
+
+void Replay(WorkspacePool* pool, const std::vector<WorkspaceEvent>& events) {
+  TVMContext ctx = CPUContext();
+  std::unordered_map<std::string, void*> live;
+  for (const WorkspaceEvent& ev : events) {
+    if (ev.alloc) {
+      live[ev.ptr] = pool->AllocWorkspace(ctx, ev.size);
+    } else {
+      auto it = live.find(ev.ptr);
+      if (it == live.end()) continue;
+      pool->FreeWorkspace(ctx, it->second);
+      live.erase(it);
+    }
+  }
+  for (auto& kv : live) pool->FreeWorkspace(ctx, kv.second);
+}
+
+}  // namespace
+
+TEST(WorkspacePool, ReuseFreedPage) {
+  TVMContext ctx = CPUContext();
+  WorkspacePool pool(kDLCPU, DeviceAPI::Get(ctx));
+  void* a = pool.AllocWorkspace(ctx, 1000);
+  pool.FreeWorkspace(ctx, a);
+  // requests of the same page count reuse the page.
+  void* b = pool.AllocWorkspace(ctx, 4000);
+  EXPECT_EQ(a, b);
+  pool.FreeWorkspace(ctx, b);
+}
+
+TEST(WorkspacePool, OutOfOrderFree) {
+  TVMContext ctx = CPUContext();
+  WorkspacePool pool(kDLCPU, DeviceAPI::Get(ctx));
+  std::vector<void*> ptrs;
+  for (size_t i = 1; i <= 16; ++i) {
+    ptrs.push_back(pool.AllocWorkspace(ctx, i * 1000));
+    static_cast<char*>(ptrs.back())[i * 1000 - 1] = 1;
+  }
+  for (size_t i = 0; i < ptrs.size(); i += 2) pool.FreeWorkspace(ctx, ptrs[i]);
+  for (size_t i = 1; i < ptrs.size(); i += 2) pool.FreeWorkspace(ctx, ptrs[i]);
+  // all pages are free again, so a second round does not need new pages.
+  for (size_t i = 1; i <= 16; ++i) {
+    void* p = pool.AllocWorkspace(ctx, i * 1000);
+    EXPECT_NE(std::find(ptrs.begin(), ptrs.end(), p), ptrs.end());
+    pool.FreeWorkspace(ctx, p);
+  }
+}
+
+TEST(WorkspacePool, BestFit) {
+  TVMContext ctx = CPUContext();
+  WorkspacePool pool(kDLCPU, DeviceAPI::Get(ctx));
+  void* small = pool.AllocWorkspace(ctx, 4096);
+  void* medium = pool.AllocWorkspace(ctx, 16384);
+  void* large = pool.AllocWorkspace(ctx, 1 << 20);
+  pool.FreeWorkspace(ctx, large);
+  pool.FreeWorkspace(ctx, medium);
+  pool.FreeWorkspace(ctx, small);
+  // the smallest free page that fits is picked.
+  void* p = pool.AllocWorkspace(ctx, 8192);
+  EXPECT_EQ(p, medium);
+  void* q = pool.AllocWorkspace(ctx, 4096);
+  EXPECT_EQ(q, small);
+  pool.FreeWorkspace(ctx, q);
+  pool.FreeWorkspace(ctx, p);
+  // a request larger than every free page still succeeds.
+  void* r = pool.AllocWorkspace(ctx, 4 << 20);
+  static_cast<char*>(r)[(4 << 20) - 1] = 1;
+  pool.FreeWorkspace(ctx, r);
+}
+
+// Replay an alloc/free sequence and report the time per request. A sequence
+// captured from a model with TVM_WORKSPACE_POOL_TRACE=<file> can be replayed
+// by setting TVM_WORKSPACE_POOL_TRACE_REPLAY=<file>.
+TEST(WorkspacePool, ReplayBenchmark) {
+  const char* path = getenv("TVM_WORKSPACE_POOL_TRACE_REPLAY");
+  std::vector<WorkspaceEvent> events = path ? LoadTrace(path) : SyntheticTrace();
+  ASSERT_FALSE(events.empty());
+  TVMContext ctx = CPUContext();
+  WorkspacePool pool(kDLCPU, DeviceAPI::Get(ctx));
+  // warm up the pool, as the pages are kept across kernel invocations.
+  Replay(&pool, events);
+  const int repeat = 100;
+  auto tbegin = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < repeat; ++i) Replay(&pool, events);
+  auto tend = std::chrono::high_resolution_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(tend - tbegin).count();
+  LOG(INFO) << "WorkspacePool replay of " << events.size()
+            << " requests: " << ns / (repeat * events.size()) << " ns/request";
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  return RUN_ALL_TESTS();
+}
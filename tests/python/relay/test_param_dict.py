@@ -39,6 +39,43 @@ def test_save_load():
     np.testing.assert_equal(param2["y"].asnumpy(), y)
 
 
+def test_save_load_param_file():
+    x = np.random.uniform(size=(10, 2)).astype("float32")
+    y = np.arange(7).astype("int8")
+    params = {"x": x, "y": y}
+    temp = utils.tempdir()
+    path = temp.relpath("params.bin")
+    relay.save_param_file(params, path, alignment=128)
+    param2 = relay.load_param_file(path)
+    assert len(param2) == 2
+    np.testing.assert_equal(param2["x"].asnumpy(), x)
+    np.testing.assert_equal(param2["y"].asnumpy(), y)
+    for arr in param2.values():
+        assert arr.handle.contents.data % 128 == 0
+    # the files written from save_param_dict bytes are read as well.
+    legacy = temp.relpath("legacy.params")
+    with open(legacy, "wb") as f:
+        f.write(relay.save_param_dict(params))
+    np.testing.assert_equal(relay.load_param_file(legacy)["x"].asnumpy(), x)
+
+
+def test_graph_runtime_param_file():
+    x = relay.var("x", shape=(4, 8))
+    w = relay.var("w", shape=(4, 8))
+    func = relay.Function([x, w], relay.add(x, w))
+    w_np = np.random.uniform(size=(4, 8)).astype("float32")
+    with tvm.transform.PassContext(opt_level=3):
+        graph, lib, _ = relay.build(func, target="llvm")
+    temp = utils.tempdir()
+    path = temp.relpath("params.bin")
+    relay.save_param_file({"w": w_np}, path)
+    mod = graph_runtime.create(graph, lib, tvm.cpu(0))
+    mod.load_params_from_file(path)
+    x_np = np.random.uniform(size=(4, 8)).astype("float32")
+    mod.run(x=x_np)
+    tvm.testing.assert_allclose(mod.get_output(0).asnumpy(), x_np + w_np)
+
+
 def test_ndarray_reflection():
     # Make two `NDArrayWrapper`s that point to the same underlying array.
     np_array = np.random.uniform(size=(10, 2)).astype("float32")
@@ -91,5 +128,7 @@ def test_bigendian_rpc_param():
 
 if __name__ == "__main__":
     test_save_load()
+    test_save_load_param_file()
+    test_graph_runtime_param_file()
     test_ndarray_reflection()
     test_bigendian_rpc_param()
@@ -14,6 +14,8 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License.
+import json
+
 import numpy as np
 import pytest
 
@@ -799,5 +801,115 @@ def test_constant_shape_with_external_codegen():
     assert "shape_func" in opt_mod.astext(False)
 
 
+def test_vm_pooled_allocator_stats():
+    x = relay.var("x", shape=(10, 10))
+    mod = tvm.IRModule.from_expr(relay.Function([x], x + x))
+    exe = relay.vm.compile(mod, "llvm")
+    ctx = tvm.cpu()
+    vm = runtime.vm.VirtualMachine(exe, ctx, memory_cfg="pooled")
+    x_np = np.random.uniform(size=(10, 10)).astype("float32")
+    for _ in range(3):
+        tvm.testing.assert_allclose(vm.invoke("main", x_np).asnumpy(), x_np + x_np)
+    stats = json.loads(tvm.get_global_func("runtime.GetPooledAllocatorStats")(ctx))
+    assert stats["num_allocs"] >= 3
+    # the buffers of the first invocation are reused by the next ones
+    assert stats["hit_rate"] > 0
+    # the results are dropped, so their buffers sit in the caches
+    assert stats["used_memory"] > 0
+    assert stats["cached_bytes"] > 0
+    tvm.get_global_func("runtime.SetPooledAllocatorHighWater")(ctx, 0)
+    trimmed = json.loads(tvm.get_global_func("runtime.GetPooledAllocatorStats")(ctx))
+    # trimming reaches the buffers cached by the threads as well
+    assert trimmed["cached_bytes"] == 0
+    assert trimmed["used_memory"] == stats["used_memory"] - stats["cached_bytes"]
+
+
+def test_vm_invoke_with_args_concurrent():
+    import threading
+
+    x = relay.var("x", shape=(16,))
+    w = relay.const(np.arange(16).astype("float32"))
+    mod = tvm.IRModule.from_expr(relay.Function([x], relay.nn.relu(x * w) + w))
+    exe = relay.vm.compile(mod, "llvm")
+    vm = runtime.vm.VirtualMachine(exe, tvm.cpu())
+    w_np = np.arange(16).astype("float32")
+
+    errors = []
+
+    def worker(seed):
+        # an exception would only end the thread, record it for the main thread
+        try:
+            rng = np.random.RandomState(seed)
+            for _ in range(20):
+                x_np = rng.uniform(-1, 1, size=(16,)).astype("float32")
+                out = vm.invoke_with_args("main", x_np).asnumpy()
+                tvm.testing.assert_allclose(out, np.maximum(x_np * w_np, 0) + w_np, rtol=1e-5)
+        except Exception as err:
+            errors.append(err)
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    assert not errors
+    # the stateful interface still works next to the concurrent one.
+    x_np = np.ones((16,), "float32")
+    tvm.testing.assert_allclose(vm.run(x_np).asnumpy(), x_np * w_np + w_np)
+
+
+def test_vm_coalesce_storage():
+    x = relay.var("x", shape=(8, 16))
+    y = x
+    for i in range(6):
+        y = relay.nn.softmax(y * relay.const(float(i + 1)))
+    mod = tvm.IRModule.from_expr(relay.Function([x], y))
+    x_np = np.random.uniform(size=(8, 16)).astype("float32")
+    expected = veval(mod, x_np).asnumpy()
+
+    with tvm.transform.PassContext(opt_level=3, config={"relay.vm.coalesce_storage": True}):
+        comp = relay.vm.VMCompiler()
+        comp.lower(mod, "llvm")
+        comp.codegen()
+    stats = comp.get_storage_stats()
+    assert stats["num_storages"] > 0
+    # each intermediate of the chain is dead once the next one is computed
+    assert stats["num_coalesced"] > 0
+    assert stats["static_peak_bytes_after"] < stats["static_peak_bytes_before"]
+    vm = runtime.vm.VirtualMachine(comp.get_exec(), tvm.cpu())
+    tvm.testing.assert_allclose(vm.run(x_np).asnumpy(), expected, rtol=1e-5)
+
+
+def test_vm_async_execution():
+    # The device copies to a simulated second context on CPU overlap with the
+    # independent branch, the If reads a result of the workers on host.
+    x = relay.var("x", shape=(16, 16))
+    y = relay.var("y", shape=(16, 16))
+    a = relay.nn.relu(relay.nn.dense(x, y))
+    b = relay.device_copy(relay.exp(y), tvm.cpu(), tvm.cpu())
+    c = relay.tanh(b) + relay.sigmoid(x)
+    cond = relay.greater(relay.sum(x), relay.const(0.0))
+    d = relay.If(cond, a + c, a - c)
+    out = relay.Tuple([d, relay.device_copy(c, tvm.cpu(), tvm.cpu())])
+    mod = tvm.IRModule.from_expr(relay.Function([x, y], out))
+    exe = relay.vm.compile(mod, "llvm")
+    assert "device_copy" in exe.bytecode
+
+    sync_vm = runtime.vm.VirtualMachine(exe, tvm.cpu())
+    async_vm = runtime.vm.VirtualMachine(exe, tvm.cpu())
+    async_vm.set_async_execution(2)
+    rng = np.random.RandomState(0)
+    for _ in range(4):
+        x_np = rng.uniform(-1, 1, size=(16, 16)).astype("float32")
+        y_np = rng.uniform(-1, 1, size=(16, 16)).astype("float32")
+        expected = sync_vm.run(x_np, y_np)
+        res = async_vm.run(x_np, y_np)
+        for i in range(2):
+            tvm.testing.assert_allclose(res[i].asnumpy(), expected[i].asnumpy(), rtol=1e-5)
+    async_vm.set_async_execution(0)
+    res = async_vm.run(x_np, y_np)
+    tvm.testing.assert_allclose(res[0].asnumpy(), expected[0].asnumpy(), rtol=1e-5)
+
+
 if __name__ == "__main__":
     pytest.main([__file__])
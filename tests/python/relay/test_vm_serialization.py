@@ -146,6 +146,66 @@ def test_save_load():
     tvm.testing.assert_allclose(res.asnumpy(), x_data + x_data)
 
 
+def test_save_load_file():
+    x = relay.var("x", shape=(10, 10))
+    w = relay.const(np.random.rand(10, 10).astype("float32"))
+    mod = tvm.IRModule()
+    f1 = relay.GlobalVar("f1")
+    mod[f1] = relay.Function([x], relay.nn.relu(x) * w)
+    y = relay.var("y", shape=(10, 10))
+    mod["main"] = relay.Function([y], f1(y) + w)
+    x_data = np.random.rand(10, 10).astype("float32")
+    expected = (np.maximum(x_data, 0) * w.data.asnumpy()) + w.data.asnumpy()
+
+    exe = create_exec(mod)
+    tmp = utils.tempdir()
+    path = tmp.relpath("exec.vmx")
+    exe.save_to_file(path, alignment=256)
+    lib = exe.lib
+
+    # The mapped file, and the same file read into memory.
+    mapped = _vm.Executable.load_exec_from_file(path, lib)
+    in_memory = _vm.Executable.load_exec(open(path, "rb").read(), lib)
+    for des_exec in [mapped, in_memory]:
+        res = _vm.VirtualMachine(des_exec, tvm.cpu()).run(x_data)
+        tvm.testing.assert_allclose(res.asnumpy(), expected, rtol=1e-5)
+        assert des_exec.bytecode == exe.bytecode
+
+    # A lazily loaded executable saves to both formats.
+    code, _ = mapped.save()
+    res = _vm.VirtualMachine(_vm.Executable.load_exec(code, lib), tvm.cpu()).run(x_data)
+    tvm.testing.assert_allclose(res.asnumpy(), expected, rtol=1e-5)
+    mapped.save_to_file(tmp.relpath("exec2.vmx"))
+    des_exec = _vm.Executable.load_exec_from_file(tmp.relpath("exec2.vmx"), lib)
+    res = _vm.VirtualMachine(des_exec, tvm.cpu()).run(x_data)
+    tvm.testing.assert_allclose(res.asnumpy(), expected, rtol=1e-5)
+
+
+def test_load_corrupted_file():
+    x = relay.var("x", shape=(10, 10))
+    mod = tvm.IRModule.from_expr(relay.Function([x], x + relay.const(1.0)))
+    exe = create_exec(mod)
+    tmp = utils.tempdir()
+    path = tmp.relpath("exec.vmx")
+    exe.save_to_file(path)
+    code = bytearray(open(path, "rb").read())
+
+    # The header: magic, format version, TVM version string, alignment, number of sections.
+    version_size = int.from_bytes(code[16:24], "little")
+    num_sections_pos = 24 + version_size + 8
+    corrupted = code[:]
+    corrupted[num_sections_pos : num_sections_pos + 8] = (1 << 60).to_bytes(8, "little")
+    with pytest.raises(tvm.TVMError):
+        _vm.Executable.load_exec(bytes(corrupted), exe.lib)
+
+    # A section table entry pointing past the end of the file.
+    corrupted = code[:]
+    entry_pos = num_sections_pos + 8
+    corrupted[entry_pos + 8 : entry_pos + 16] = (len(code) + 1).to_bytes(8, "little")
+    with pytest.raises(tvm.TVMError):
+        _vm.Executable.load_exec(bytes(corrupted), exe.lib)
+
+
 def test_const():
     c = relay.const(1.0, "float32")
     x = relay.var("x", shape=(10, 10), dtype="float32")
@@ -78,6 +78,43 @@ def test_xgb_model():
         model.load(fp.name)
 
 
+def test_gbdt_model():
+    task, inputs, _ = get_sample_records(100)
+    states = [x.state for x in inputs]
+
+    # costs the features can explain: the sum of one of the features over the stores
+    features = auto_scheduler.feature.get_per_store_features_from_states(states, task)
+    sums = np.array([np.sum(feature, axis=0) for feature in features])
+    column = sums[:, np.argmax(np.var(sums, axis=0))]
+    costs = 1.0 + column / np.max(np.abs(column))
+    results = [auto_scheduler.MeasureResult([cost], 0, "", 0.1, 0) for cost in costs]
+
+    n_train = 70
+    model = auto_scheduler.GBDTModel(num_warmup_sample=-1)
+    model.update(inputs[:n_train], results[:n_train])
+    preds = np.array(model.predict(task, states))
+    assert len(preds) == len(inputs)
+
+    # test ranking quality on the held out records
+    test_costs, test_preds = costs[n_train:], preds[n_train:]
+    faster = test_costs[:, None] < test_costs[None, :]
+    accuracy = np.mean((test_preds[:, None] > test_preds[None, :])[faster])
+    assert accuracy >= 0.6
+
+    # test loading a record file
+    with tempfile.NamedTemporaryFile() as fp:
+        auto_scheduler.save_records(fp.name, inputs, results)
+        model.update_from_file(fp.name)
+
+    # test model serialization
+    with tempfile.NamedTemporaryFile() as fp:
+        model.save(fp.name)
+        loaded = auto_scheduler.GBDTModel()
+        loaded.load(fp.name)
+        np.testing.assert_equal(loaded.predict(task, states), model.predict(task, states))
+
+
 if __name__ == "__main__":
     test_random_model()
     test_xgb_model()
+    test_gbdt_model()
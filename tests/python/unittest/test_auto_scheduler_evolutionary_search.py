@@ -18,7 +18,10 @@
 
 import tvm
 import pytest
-from test_auto_scheduler_common import matmul_auto_scheduler_test
+from test_auto_scheduler_common import (
+    matmul_auto_scheduler_test,
+    double_matmul_auto_scheduler_test,
+)
 from tvm import auto_scheduler, te
 from tvm.auto_scheduler.cost_model.cost_model import PythonBasedModel
 
@@ -116,6 +119,38 @@ def test_mutate_parallel():
     assert found
 
 
+def test_crossover():
+    """
+    The test case runs evo search without mutation and checks whether the crossover
+    generates new valid states by combining the stages of the initial states.
+    """
+
+    class MockCostModel(PythonBasedModel):
+        def predict(self, task, states):
+            return [1] * len(states)
+
+    task = auto_scheduler.SearchTask(
+        func=double_matmul_auto_scheduler_test, args=(64,), target="llvm"
+    )
+    params = {
+        "evolutionary_search_population": 256,
+        "evolutionary_search_mutation_prob": 0.0,
+        "evolutionary_search_crossover_ratio": 1.0,
+    }
+    policy = auto_scheduler.SketchPolicy(
+        task, program_cost_model=MockCostModel(), params=params, verbose=0
+    )
+    states = policy.sample_initial_population()
+    init_fingerprints = set(state.fingerprint() for state in states)
+
+    # The heap keeps all the distinct states since they have the same score
+    new_states = policy.evolutionary_search(states, 1024)
+    assert any(state.fingerprint() not in init_fingerprints for state in new_states)
+    for state in new_states:
+        task.compute_dag.apply_steps_from_state(state)
+
+
 if __name__ == "__main__":
     test_mutate_tile_size()
     test_mutate_parallel()
+    test_crossover()
@@ -20,10 +20,15 @@
 import math
 import tempfile
 
+import numpy as np
+
 import tvm
 from tvm import te, auto_scheduler
 
-from test_auto_scheduler_common import matmul_auto_scheduler_test
+from test_auto_scheduler_common import (
+    matmul_auto_scheduler_test,
+    conv2d_nchw_bn_relu_auto_scheduler_test,
+)
 
 
 def fequal(a, b):
@@ -200,7 +205,35 @@ def test_gpu_feature():
         assert fequal(fea_dicts[0]["is_gpu"], 1.0)
 
 
+def test_cached_features():
+    target = tvm.target.Target("llvm")
+    task = auto_scheduler.SearchTask(
+        func=conv2d_nchw_bn_relu_auto_scheduler_test,
+        args=(1, 14, 14, 32, 32, 3, 1, 1),
+        target=target,
+    )
+    policy = auto_scheduler.SketchPolicy(task, verbose=0)
+    parents = policy.sample_initial_population()[:8]
+    children = policy.evolutionary_search(parents, 8)
+
+    # The children replay their steps from the schedules cached for the parents,
+    # and the second extraction hits the features cached for the whole states.
+    auto_scheduler.feature.get_per_store_features_from_states(parents, task)
+    cached = auto_scheduler.feature.get_per_store_features_from_states(children, task)
+    cached_again = auto_scheduler.feature.get_per_store_features_from_states(children, task)
+
+    for i, state in enumerate(children):
+        # A new task does not share the caches of the others.
+        fresh_task = auto_scheduler.SearchTask(
+            compute_dag=task.compute_dag, workload_key=task.workload_key, target=target
+        )
+        fresh = auto_scheduler.feature.get_per_store_features_from_states([state], fresh_task)
+        np.testing.assert_equal(np.array(cached[i]), np.array(fresh[0]))
+        np.testing.assert_equal(np.array(cached_again[i]), np.array(fresh[0]))
+
+
 if __name__ == "__main__":
     test_cpu_matmul()
     test_cpu_fusion()
     test_gpu_feature()
+    test_cached_features()
@@ -17,6 +17,8 @@
 
 """Test loop state and schedule primitives"""
 
+import tempfile
+
 import numpy as np
 
 import tvm
@@ -514,9 +516,39 @@ def test_rfactor():
     assert s2[C].iters[2].range.extent == 16
 
 
+def test_state_fingerprint():
+    A, B, C = matmul_auto_scheduler_test(N=512, M=512, K=512)
+    dag = auto_scheduler.ComputeDAG([A, B, C])
+
+    def make_state(factor):
+        s = dag.get_init_state()
+        i, j, k = s[C].iters
+        io, ii = s.split(C, i, [factor])
+        s.reorder(C, [io, j, k, ii])
+        s.parallel(C, io)
+        s.pragma(C, io, "auto_unroll_max_step$16")
+        return s
+
+    s1, s2, s3 = make_state(16), make_state(16), make_state(8)
+    assert s1.fingerprint() == s2.fingerprint()
+    assert s1.fingerprint() != s3.fingerprint()
+    assert dag.get_init_state().fingerprint() != s1.fingerprint()
+
+    # The fingerprint only depends on the steps, so it survives the log records.
+    task = auto_scheduler.SearchTask(compute_dag=dag, workload_key="test", target="llvm")
+    inp = auto_scheduler.measure.MeasureInput(task, s1)
+    res = auto_scheduler.measure.MeasureResult([0.1], 0, "", 0.2, 1)
+    with tempfile.NamedTemporaryFile() as fp:
+        auto_scheduler.save_records(fp.name, [inp], [res])
+        inputs, _ = auto_scheduler.RecordReader(fp.name).read_lines()
+    loaded = dag.infer_bound_from_state(inputs[0].state)
+    assert loaded.fingerprint() == s1.fingerprint()
+
+
 if __name__ == "__main__":
     test_split_fuse_reorder_annotation()
     test_compute_at_root_inline()
     test_cache_read_write()
     test_follow_split_follow_fused_split()
     test_rfactor()
+    test_state_fingerprint()
@@ -17,6 +17,7 @@
 
 """ Test measurement and log serialization. """
 import json
+import os
 
 import multiprocessing
 import tvm
@@ -257,6 +258,34 @@ def test_measure_local_builder_runner():
         assert mress[0].error_no == 0
 
 
+def test_measure_native_local_builder_runner():
+    if not tvm.testing.device_enabled("llvm"):
+        return
+
+    task = auto_scheduler.SearchTask(
+        func=matmul_auto_scheduler_test, args=(128, 128, 128), target="llvm"
+    )
+    minp = auto_scheduler.MeasureInput(task, task.compute_dag.init_state)
+
+    min_costs = {}
+    for native in ["1", "0"]:
+        os.environ["TVM_AUTO_SCHEDULER_NATIVE_MEASURE"] = native
+        try:
+            bress = auto_scheduler.LocalBuilder(n_parallel=2).build([minp, minp])
+            assert [res.error_no for res in bress] == [0, 0]
+            assert bress[0].filename.endswith(".so" if native == "1" else ".tar")
+            assert [str(x.dtype) for x in bress[0].args] == ["float32"] * 3
+            mress = auto_scheduler.LocalRunner(timeout=60).run([minp, minp], bress)
+            assert [res.error_no for res in mress] == [0, 0]
+            assert all(not os.path.exists(res.filename) for res in bress)
+        finally:
+            del os.environ["TVM_AUTO_SCHEDULER_NATIVE_MEASURE"]
+        min_costs[native] = min(cost.value for res in mress for cost in res.costs)
+
+    # Both paths measure the same program.
+    assert 0.2 < min_costs["1"] / min_costs["0"] < 5
+
+
 def test_dag_measure_local_builder_runner():
     if not tvm.testing.device_enabled("llvm"):
         return
@@ -363,6 +392,7 @@ if __name__ == "__main__":
     test_recover_measure_input()
     test_workload_dis_factor()
     test_measure_local_builder_runner()
+    test_measure_native_local_builder_runner()
     test_dag_measure_local_builder_runner()
     test_measure_local_builder_rpc_runner()
     test_measure_target_host()
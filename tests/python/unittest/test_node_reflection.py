@@ -14,9 +14,12 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License.
-import tvm
+import numpy as np
 import pytest
-from tvm import te
+
+import tvm
+from tvm import relay, te
+from tvm.contrib import utils
 
 
 def test_const_saveload_json():
@@ -116,6 +119,34 @@ def test_string():
     tvm.ir.assert_structural_equal(s1, s2)
 
 
+def test_binary_saveload():
+    data = np.random.uniform(size=(3, 17)).astype("float32")
+    x = relay.var("x", shape=(3, 17))
+    w = relay.const(data)
+    y = relay.add(relay.multiply(x, w), w)
+    mod = tvm.IRModule.from_expr(relay.Function([x], relay.Tuple([y, relay.const(1, "int8")])))
+    mod = relay.transform.InferType()(mod)
+    mod = mod.with_attr("names", tvm.runtime.convert({"a": [1, 2.5], "b": "xy\x01z"}))
+
+    mod2 = tvm.ir.load_binary(tvm.ir.save_binary(mod))
+    tvm.ir.assert_structural_equal(mod, mod2)
+    tvm.ir.assert_structural_equal(mod2, tvm.ir.load_json(tvm.ir.save_json(mod)))
+
+    temp = utils.tempdir()
+    path = temp.relpath("mod.bin")
+    tvm.ir.save_binary(mod, path)
+    mod3 = tvm.ir.load_binary(file_name=path)
+    tvm.ir.assert_structural_equal(mod, mod3)
+    const = mod3["main"].body.fields[0].args[1]
+    np.testing.assert_equal(const.data.asnumpy(), data)
+
+    s = tvm.runtime.String("xy\x01z")
+    tvm.ir.assert_structural_equal(s, tvm.ir.load_binary(tvm.ir.save_binary(s)))
+    assert tvm.ir.load_binary(tvm.ir.save_binary(None)) is None
+    with pytest.raises(tvm.error.TVMError):
+        tvm.ir.load_binary(tvm.ir.save_binary(mod)[:100])
+
+
 def test_pass_config():
     cfg = tvm.transform.PassContext(
         opt_level=1,
@@ -156,6 +187,7 @@ if __name__ == "__main__":
     test_make_node()
     test_make_smap()
     test_const_saveload_json()
+    test_binary_saveload()
     test_make_sum()
     test_pass_config()
     test_dict()
@@ -120,5 +120,123 @@ def test_graph_simple():
     check_sharing()
 
 
+@tvm.testing.requires_llvm
+def test_graph_inter_op_parallel():
+    from tvm import relay
+
+    # Two branches joined at the end, the memory plan reuses buffers across them.
+    x = relay.var("x", shape=(4, 16))
+    branches = []
+    for i in range(2):
+        y = x
+        for j in range(3):
+            y = relay.nn.relu(relay.add(y, relay.const(float(i + j))))
+        branches.append(relay.exp(y * relay.const(0.1)))
+    func = relay.Function([x], relay.concatenate(branches, axis=1))
+    with tvm.transform.PassContext(opt_level=0):
+        graph, lib, _ = relay.build(func, target="llvm")
+
+    a = np.random.uniform(-1, 1, size=(4, 16)).astype("float32")
+    ref = graph_runtime.create(graph, lib, tvm.cpu(0))
+    ref.run(x=a)
+    expected = ref.get_output(0).asnumpy()
+
+    mod = graph_runtime.create(graph, lib, tvm.cpu(0))
+    mod.set_inter_op_parallelism(2, 1)
+    for _ in range(10):
+        mod.run(x=a)
+        tvm.testing.assert_allclose(mod.get_output(0).asnumpy(), expected, rtol=1e-5)
+    # back to the sequential execution.
+    mod.set_inter_op_parallelism(1)
+    mod.run(x=a)
+    tvm.testing.assert_allclose(mod.get_output(0).asnumpy(), expected, rtol=1e-5)
+
+
+@tvm.testing.requires_llvm
+def test_graph_batcher():
+    import threading
+    from tvm import relay
+
+    batch = 4
+    x = relay.var("x", shape=(batch, 8))
+    w = relay.var("w", shape=(8,))
+    func = relay.Function([x, w], relay.nn.relu(x * w + relay.const(1.0)))
+    w_np = np.random.uniform(size=(8,)).astype("float32")
+    lib = relay.build(func, target="llvm", params={"w": w_np})
+    batcher = graph_runtime.create_batcher(lib, tvm.cpu(0), max_latency_us=50000)
+    assert batcher.batch_size == batch
+
+    num_requests = 6
+    inputs = [
+        np.random.uniform(-1, 1, size=(1 + i % 2, 8)).astype("float32") for i in range(num_requests)
+    ]
+    results = [None] * num_requests
+
+    def request(i):
+        results[i] = batcher.infer(tvm.nd.array(inputs[i]))[0].asnumpy()
+
+    threads = [threading.Thread(target=request, args=(i,)) for i in range(num_requests)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    for i in range(num_requests):
+        tvm.testing.assert_allclose(results[i], np.maximum(inputs[i] * w_np + 1.0, 0), rtol=1e-5)
+    stats = json.loads(batcher.stats())
+    assert stats["num_requests"] == num_requests
+    # 9 rows do not fit into fewer than 3 batches of 4.
+    assert stats["num_batches"] >= 3
+
+
+@tvm.testing.requires_llvm
+def test_graph_shared_instance():
+    from tvm import relay
+
+    x = relay.var("x", shape=(2, 8))
+    w = relay.var("w", shape=(8,))
+    func = relay.Function([x, w], relay.exp(relay.nn.relu(x * w) * relay.const(0.5)))
+    w_np = np.random.uniform(size=(8,)).astype("float32")
+    lib = relay.build(func, target="llvm", params={"w": w_np})
+    proto = graph_runtime.GraphModule(lib["default"](tvm.cpu(0)))
+
+    instances = [proto.create_shared_instance() for _ in range(4)]
+    # the instances hold no activations until they run.
+    assert proto.get_num_activation_arenas() == 1
+    for inst in instances:
+        a = np.random.uniform(size=(2, 8)).astype("float32")
+        inst.run(x=a)
+        out = inst.get_output(0).asnumpy()
+        tvm.testing.assert_allclose(out, np.exp(np.maximum(a * w_np, 0) * 0.5), rtol=1e-5)
+        inst.release_activations()
+    # used one after the other, the instances share one arena.
+    assert proto.get_num_activation_arenas() == 1
+
+    a = np.random.uniform(size=(2, 8)).astype("float32")
+    instances[0].set_input(x=a)
+    instances[1].set_input(x=a)
+    assert proto.get_num_activation_arenas() == 2
+    instances[0].run()
+    instances[1].run()
+    expected = np.exp(np.maximum(a * w_np, 0) * 0.5)
+    tvm.testing.assert_allclose(instances[0].get_output(0).asnumpy(), expected, rtol=1e-5)
+    tvm.testing.assert_allclose(instances[1].get_output(0).asnumpy(), expected, rtol=1e-5)
+
+    # the idle arenas beyond the live instances are freed, all of them with the last one.
+    instances[0].release_activations()
+    instances[1].release_activations()
+    del instances[1:], inst
+    assert proto.get_num_activation_arenas() == 1
+    del instances
+    assert proto.get_num_activation_arenas() == 0
+    # a new instance starts a new pool.
+    inst = proto.create_shared_instance()
+    inst.run(x=a)
+    tvm.testing.assert_allclose(inst.get_output(0).asnumpy(), expected, rtol=1e-5)
+    assert proto.get_num_activation_arenas() == 1
+
+
 if __name__ == "__main__":
     test_graph_simple()
+    test_graph_inter_op_parallel()
+    test_graph_batcher()
+    test_graph_shared_instance()
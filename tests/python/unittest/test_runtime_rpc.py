@@ -22,6 +22,7 @@ import stat
 import logging
 import time
 import multiprocessing
+import threading
 
 import pytest
 import numpy as np
@@ -156,6 +157,108 @@ def test_rpc_large_array():
     np.testing.assert_equal(b.asnumpy(), b_np)
 
 
+@tvm.testing.requires_rpc
+def test_rpc_chunked_copy():
+    # copies larger than a packet are split and pipelined
+    server = rpc.Server("localhost")
+    remote = rpc.connect(server.host, server.port)
+    ctx = remote.cpu(0)
+    for dtype, size in [("float32", (1 << 20) * 3 + 7), ("float64", 1 << 18), ("int8", 1000001)]:
+        x_np = np.random.uniform(-10, 10, size=size).astype(dtype)
+        x = tvm.nd.array(x_np, ctx)
+        np.testing.assert_equal(x.asnumpy(), x_np)
+        x.copyfrom(x_np[::-1].copy())
+        np.testing.assert_equal(x.asnumpy(), x_np[::-1])
+
+
+@tvm.register_func("rpc.test.sleep")
+def remote_sleep(seconds, x):
+    time.sleep(seconds)
+    return x + 1
+
+
+_multiplex_barrier = threading.Barrier(4)
+
+
+@tvm.register_func("rpc.test.barrier")
+def remote_barrier(x):
+    # returns only once four calls are in flight at the same time
+    _multiplex_barrier.wait(timeout=60)
+    return x + 1
+
+
+@tvm.testing.requires_rpc
+def test_rpc_multiplex():
+    # requests of several threads are in flight at once on a multiplexed session
+    server = rpc.Server("localhost")
+    os.environ["TVM_RPC_MULTIPLEX"] = "1"
+    try:
+        remote = rpc.connect(server.host, server.port)
+    finally:
+        del os.environ["TVM_RPC_MULTIPLEX"]
+    fsleep = remote.get_function("rpc.test.sleep")
+    fbarrier = remote.get_function("rpc.test.barrier")
+    ctx = remote.cpu(0)
+    results = {}
+
+    def worker(i):
+        x_np = np.random.uniform(size=(1 << 20) + i).astype("float32")
+        x = tvm.nd.array(x_np, ctx)
+        # the barrier breaks and raises unless the four calls overlap
+        results[i] = (fbarrier(i), np.array_equal(x.asnumpy(), x_np))
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(4)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert results == {i: (i + 1, True) for i in range(4)}
+
+    # the session stays usable after an error on one of the streams
+    with pytest.raises(tvm.error.RPCError):
+        remote.get_function("rpc.test.except")("abc")
+    assert fsleep(0, 10) == 11
+
+
+@tvm.testing.requires_rpc
+def test_rpc_compression():
+    server = rpc.Server("localhost")
+    os.environ["TVM_RPC_COMPRESSION"] = "lz"
+    try:
+        remote = rpc.connect(server.host, server.port)
+    finally:
+        del os.environ["TVM_RPC_COMPRESSION"]
+    ctx = remote.cpu(0)
+
+    # zeros compress well
+    x_np = np.zeros((1 << 20) + 3, dtype="float32")
+    x = tvm.nd.array(x_np, ctx)
+    np.testing.assert_equal(x.asnumpy(), x_np)
+    stats = remote.compression_stats()
+    assert stats["wire_bytes_sent"] * 10 < stats["raw_bytes_sent"]
+    assert stats["wire_bytes_received"] * 10 < stats["raw_bytes_received"]
+
+    # random floats are sent as they are
+    y_np = np.random.uniform(size=1 << 20).astype("float32")
+    y = tvm.nd.array(y_np, ctx)
+    np.testing.assert_equal(y.asnumpy(), y_np)
+    new_stats = remote.compression_stats()
+    assert new_stats["raw_blocks_sent"] > stats["raw_blocks_sent"]
+    assert remote.get_function("rpc.test.addone")(10) == 11
+
+    # the counters are empty when the channel is not compressed
+    assert rpc.connect(server.host, server.port).compression_stats() == {}
+
+    # the first codec the server supports is picked from a list
+    for codecs, expected in [("zstd,lz", "lz"), ("zstd", None)]:
+        os.environ["TVM_RPC_COMPRESSION"] = codecs
+        try:
+            stats = rpc.connect(server.host, server.port).compression_stats()
+        finally:
+            del os.environ["TVM_RPC_COMPRESSION"]
+        assert stats.get("codec") == expected
+
+
 @tvm.testing.requires_rpc
 def test_rpc_echo():
     def check(remote):
@@ -543,3 +646,6 @@ if __name__ == "__main__":
     test_rpc_tracker_register()
     test_rpc_tracker_request()
     test_rpc_large_array()
+    test_rpc_chunked_copy()
+    test_rpc_multiplex()
+    test_rpc_compression()
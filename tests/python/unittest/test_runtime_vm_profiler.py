@@ -14,8 +14,13 @@
 # KIND, either express or implied.  See the License for the
 # specific language governing permissions and limitations
 # under the License.
+import json
+import os
+
 import numpy as np
 
+import tvm
+import tvm.testing
 from tvm.runtime import profiler_vm
 from tvm import relay
 from tvm.relay.testing import resnet, enabled_targets
@@ -36,5 +41,66 @@ def test_basic():
         print("\n{}".format(vm.get_stat(False)))
 
 
+def test_trace():
+    if not profiler_vm.enabled():
+        return
+
+    x = relay.var("x", shape=(relay.Any(), 4), dtype="float32")
+    mod = tvm.IRModule.from_expr(relay.Function([x], relay.nn.relu(x) + relay.const(1.0)))
+    exe = relay.vm.compile(mod, "llvm")
+    vm = profiler_vm.VirtualMachineProfiler(exe, tvm.cpu())
+    data = np.random.rand(3, 4).astype("float32")
+
+    vm.start_trace()
+    res = vm.invoke("main", [data])
+    vm.stop_trace()
+    vm.invoke("main", [data])
+    tvm.testing.assert_allclose(res.asnumpy(), np.maximum(data, 0) + 1)
+
+    events = json.loads(vm.get_trace())
+    spans = [e for e in events if e["ph"] == "X"]
+    assert all(e["dur"] >= 0 for e in spans)
+    cats = {e["cat"] for e in spans}
+    assert {"kernel", "shape_func", "alloc", "function"} <= cats
+    assert [e["name"] for e in spans if e["cat"] == "function"] == ["main"]
+    kernels = [e for e in spans if e["cat"] == "kernel"]
+    assert any("float32[3, 4]" in e["args"]["shapes"] for e in kernels)
+    allocs = [e for e in spans if e["name"] == "AllocStorage"]
+    assert allocs and all(int(e["args"]["bytes"]) > 0 for e in allocs)
+    counters = [e for e in events if e["ph"] == "C" and e["name"] == "allocated"]
+    assert counters[-1]["args"]["bytes"] == sum(int(e["args"]["bytes"]) for e in allocs)
+    assert "kernel" in vm.get_trace_summary()
+
+
+def test_async_execution():
+    if not profiler_vm.enabled():
+        return
+
+    x = relay.var("x", shape=(8, 4), dtype="float32")
+    mod = tvm.IRModule.from_expr(relay.Function([x], relay.nn.relu(x) + relay.const(1.0)))
+    exe = relay.vm.compile(mod, "llvm")
+    data = np.random.rand(8, 4).astype("float32")
+
+    # the profiler stays synchronous, whether async is asked by the environment or the API
+    os.environ["TVM_VM_ASYNC_WORKERS"] = "2"
+    try:
+        vm = profiler_vm.VirtualMachineProfiler(exe, tvm.cpu())
+    finally:
+        del os.environ["TVM_VM_ASYNC_WORKERS"]
+    vm.set_async_execution(2)
+    vm.start_trace()
+    for _ in range(4):
+        res = vm.invoke("main", [data])
+        tvm.testing.assert_allclose(res.asnumpy(), np.maximum(data, 0) + 1)
+    vm.stop_trace()
+
+    kernels = [e for e in json.loads(vm.get_trace()) if e["ph"] == "X" and e["cat"] == "kernel"]
+    assert len(kernels) >= 4 and all(e["dur"] >= 0 for e in kernels)
+    stat = vm.get_stat()
+    assert "fused" in stat
+
+
 if __name__ == "__main__":
     test_basic()
+    test_trace()
+    test_async_execution()